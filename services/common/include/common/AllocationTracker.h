@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace quasar {
+
+// Allocation accounting for the instrumented builds (quasar_alloc_tracker:
+// engine_core_tracked, hft_gateway_allocation_tests).
+// AllocationTracker.cpp interposes malloc/calloc/realloc/free and the aligned
+// variants (operator new reaches them through libstdc++), keeping per-thread
+// counters. Code on the latency path marks itself with QUASAR_HOT_REGION; once
+// the tracker is armed after warm-up, any allocation made by a thread inside a
+// hot region is recorded as a violation. In the regular build the markers
+// compile to nothing and nothing is interposed.
+
+struct AllocationCounters {
+    uint64_t allocations{0};
+    uint64_t deallocations{0};
+    uint64_t bytes{0};
+};
+
+class AllocationTracker {
+public:
+    // Counters of the calling thread since it started
+    static AllocationCounters thread_counters();
+
+    // Start/stop treating hot-region allocations as violations
+    static void arm();
+    static void disarm();
+    static bool is_armed();
+
+    static uint64_t violation_count();
+    // Name of the most recent region that allocated while armed, or nullptr
+    static const char* last_violation();
+    static void reset_violations();
+};
+
+// Counts the allocations made by the current thread while in scope
+class HotRegion {
+public:
+    explicit HotRegion(const char* name);
+    ~HotRegion();
+
+    HotRegion(const HotRegion&) = delete;
+    HotRegion& operator=(const HotRegion&) = delete;
+
+    uint64_t allocations() const;
+    uint64_t bytes() const;
+    const char* name() const { return name_; }
+
+private:
+    const char* name_;
+    AllocationCounters start_;
+};
+
+} // namespace quasar
+
+#ifdef QUASAR_ALLOCATION_TRACKING
+#define QUASAR_HOT_REGION(name) ::quasar::HotRegion quasar_hot_region_guard_(name)
+#else
+#define QUASAR_HOT_REGION(name) ((void)0)
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace quasar {
+
+// Platform jitter ("hiccup") monitor. A background thread, optionally pinned
+// to one CPU, reads the clock in a tight loop and records the gap between
+// successive reads. On an idle, well-isolated core every gap is tens of
+// nanoseconds; anything longer is time the thread lost to the platform
+// (interrupts, page faults, THP compaction, preemption). Running it next to a
+// latency measurement separates environmental outliers from code regressions.
+class HiccupMonitor {
+public:
+    struct Config {
+        // CPU to pin the spinning thread to; -1 leaves it unpinned
+        int cpu{-1};
+        // Gaps at or above this are counted as hiccups
+        uint64_t threshold_ns{1000};
+    };
+
+    struct Report {
+        double elapsed_seconds{0.0};
+        uint64_t samples{0};
+        uint64_t hiccups{0};
+        uint64_t hiccup_time_ns{0};
+        uint64_t p50_ns{0};
+        uint64_t p99_ns{0};
+        uint64_t p999_ns{0};
+        uint64_t p9999_ns{0};
+        uint64_t max_ns{0};
+    };
+
+    HiccupMonitor();
+    explicit HiccupMonitor(const Config& config);
+    ~HiccupMonitor();
+
+    HiccupMonitor(const HiccupMonitor&) = delete;
+    HiccupMonitor& operator=(const HiccupMonitor&) = delete;
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // True if the thread was requested on a CPU and the affinity call succeeded
+    bool is_pinned() const { return pinned_.load(); }
+    const Config& get_config() const { return config_; }
+
+    // Statistics since start() or the last reset()
+    Report report() const;
+    void reset();
+
+    // Add one observed gap (the monitor thread calls this; exposed for tests)
+    void record(uint64_t gap_ns);
+
+    // Percentiles are reported as the upper bound of their histogram bucket
+    static void print_report(const Report& report, std::ostream& out);
+    static void print_csv_header(std::ostream& out);
+    static void print_csv_row(const std::string& label, const Report& report, std::ostream& out);
+
+private:
+    // Log-linear buckets: exact below 8ns, then 4 sub-buckets per power of two
+    static constexpr size_t kSubBuckets = 4;
+    static constexpr size_t kBucketCount = 8 + (64 - 3) * kSubBuckets;
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(size_t index);
+
+    void run();
+
+    Config config_;
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> samples_{0};
+    std::atomic<uint64_t> hiccups_{0};
+    std::atomic<uint64_t> hiccup_time_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+    std::atomic<int64_t> window_start_ns_{0};
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> pinned_{false};
+    std::thread thread_;
+};
+
+} // namespace quasar
@@ -0,0 +1,126 @@
+#include "common/AllocationTracker.h"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+
+// glibc's underlying allocator entry points
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace quasar {
+
+namespace {
+
+// Constant-initialized so that touching it from inside malloc never allocates
+thread_local AllocationCounters t_counters;
+
+std::atomic<bool> g_armed{false};
+std::atomic<uint64_t> g_violations{0};
+std::atomic<const char*> g_last_violation{nullptr};
+
+inline void count_allocation(size_t size) {
+    t_counters.allocations++;
+    t_counters.bytes += size;
+}
+
+} // namespace
+
+AllocationCounters AllocationTracker::thread_counters() {
+    return t_counters;
+}
+
+void AllocationTracker::arm() {
+    g_armed.store(true);
+}
+
+void AllocationTracker::disarm() {
+    g_armed.store(false);
+}
+
+bool AllocationTracker::is_armed() {
+    return g_armed.load();
+}
+
+uint64_t AllocationTracker::violation_count() {
+    return g_violations.load();
+}
+
+const char* AllocationTracker::last_violation() {
+    return g_last_violation.load();
+}
+
+void AllocationTracker::reset_violations() {
+    g_violations.store(0);
+    g_last_violation.store(nullptr);
+}
+
+HotRegion::HotRegion(const char* name) : name_(name), start_(t_counters) {}
+
+HotRegion::~HotRegion() {
+    if (g_armed.load(std::memory_order_relaxed) && allocations() > 0) {
+        g_violations.fetch_add(1);
+        g_last_violation.store(name_);
+    }
+}
+
+uint64_t HotRegion::allocations() const {
+    return t_counters.allocations - start_.allocations;
+}
+
+uint64_t HotRegion::bytes() const {
+    return t_counters.bytes - start_.bytes;
+}
+
+} // namespace quasar
+
+// --- Interposed allocator ---
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+    quasar::count_allocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    quasar::count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    quasar::count_allocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    quasar::count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    quasar::count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+    quasar::count_allocation(size);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *result = ptr;
+    return 0;
+}
+
+void free(void* ptr) noexcept {
+    if (ptr) {
+        quasar::t_counters.deallocations++;
+    }
+    __libc_free(ptr);
+}
+
+} // extern "C"
@@ -0,0 +1,173 @@
+#include "common/HiccupMonitor.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <pthread.h>
+#include <sched.h>
+
+namespace quasar {
+
+namespace {
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+HiccupMonitor::HiccupMonitor() : HiccupMonitor(Config()) {}
+
+HiccupMonitor::HiccupMonitor(const Config& config) : config_(config) {}
+
+HiccupMonitor::~HiccupMonitor() {
+    stop();
+}
+
+void HiccupMonitor::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    reset();
+    thread_ = std::thread(&HiccupMonitor::run, this);
+
+    if (config_.cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(config_.cpu, &cpuset);
+        pinned_.store(pthread_setaffinity_np(thread_.native_handle(), sizeof(cpuset), &cpuset) == 0);
+    }
+}
+
+void HiccupMonitor::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void HiccupMonitor::run() {
+    int64_t previous = steady_now_ns();
+    while (running_.load(std::memory_order_relaxed)) {
+        int64_t now = steady_now_ns();
+        record(static_cast<uint64_t>(now - previous));
+        previous = now;
+    }
+}
+
+void HiccupMonitor::record(uint64_t gap_ns) {
+    buckets_[bucket_index(gap_ns)].fetch_add(1, std::memory_order_relaxed);
+    samples_.fetch_add(1, std::memory_order_relaxed);
+
+    if (gap_ns >= config_.threshold_ns) {
+        hiccups_.fetch_add(1, std::memory_order_relaxed);
+        hiccup_time_ns_.fetch_add(gap_ns, std::memory_order_relaxed);
+    }
+
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (gap_ns > max && !max_ns_.compare_exchange_weak(max, gap_ns, std::memory_order_relaxed)) {
+    }
+}
+
+void HiccupMonitor::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    samples_.store(0);
+    hiccups_.store(0);
+    hiccup_time_ns_.store(0);
+    max_ns_.store(0);
+    window_start_ns_.store(steady_now_ns());
+}
+
+HiccupMonitor::Report HiccupMonitor::report() const {
+    Report report;
+    report.elapsed_seconds = (steady_now_ns() - window_start_ns_.load()) / 1e9;
+    report.hiccups = hiccups_.load();
+    report.hiccup_time_ns = hiccup_time_ns_.load();
+    report.max_ns = max_ns_.load();
+
+    std::array<uint64_t, kBucketCount> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    report.samples = total;
+    if (total == 0) {
+        return report;
+    }
+
+    auto percentile = [&](double pct) {
+        uint64_t rank = static_cast<uint64_t>(pct / 100.0 * (total - 1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += counts[i];
+            if (seen > rank) {
+                return std::min(bucket_upper_bound(i), report.max_ns);
+            }
+        }
+        return report.max_ns;
+    };
+
+    report.p50_ns = percentile(50.0);
+    report.p99_ns = percentile(99.0);
+    report.p999_ns = percentile(99.9);
+    report.p9999_ns = percentile(99.99);
+    return report;
+}
+
+size_t HiccupMonitor::bucket_index(uint64_t value) {
+    if (value < 8) {
+        return static_cast<size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    size_t sub = static_cast<size_t>(value >> (msb - 2)) & (kSubBuckets - 1);
+    return 8 + static_cast<size_t>(msb - 3) * kSubBuckets + sub;
+}
+
+uint64_t HiccupMonitor::bucket_upper_bound(size_t index) {
+    if (index < 8) {
+        return index;
+    }
+    size_t msb = 3 + (index - 8) / kSubBuckets;
+    uint64_t sub = (index - 8) % kSubBuckets;
+    uint64_t width = 1ULL << (msb - 2);
+    return (kSubBuckets + sub + 1) * width - 1;
+}
+
+void HiccupMonitor::print_report(const Report& report, std::ostream& out) {
+    double lost_pct = report.elapsed_seconds > 0
+        ? report.hiccup_time_ns / (report.elapsed_seconds * 1e9) * 100.0 : 0.0;
+
+    out << "Platform Hiccups:" << std::endl;
+    out << "  Observed:        " << std::fixed << std::setprecision(2)
+        << report.elapsed_seconds << " s, " << report.samples << " clock reads" << std::endl;
+    out << "  Hiccups:         " << report.hiccups << " ("
+        << std::setprecision(3) << lost_pct << "% of time lost)" << std::endl;
+    out << "  Gap P50/P99:     " << report.p50_ns << " / " << report.p99_ns << " ns" << std::endl;
+    out << "  Gap P99.9/99.99: " << report.p999_ns << " / " << report.p9999_ns << " ns" << std::endl;
+    out << "  Gap Max:         " << std::setprecision(2) << report.max_ns / 1000.0 << " us" << std::endl;
+}
+
+void HiccupMonitor::print_csv_header(std::ostream& out) {
+    out << "label,elapsed_seconds,samples,hiccups,hiccup_time_ns,"
+        << "p50_ns,p99_ns,p999_ns,p9999_ns,max_ns" << std::endl;
+}
+
+void HiccupMonitor::print_csv_row(const std::string& label, const Report& report, std::ostream& out) {
+    out << label << ","
+        << std::fixed << std::setprecision(3) << report.elapsed_seconds << ","
+        << report.samples << ","
+        << report.hiccups << ","
+        << report.hiccup_time_ns << ","
+        << report.p50_ns << ","
+        << report.p99_ns << ","
+        << report.p999_ns << ","
+        << report.p9999_ns << ","
+        << report.max_ns << std::endl;
+}
+
+} // namespace quasar
@@ -3,11 +3,13 @@
 #include <memory>
 #include <atomic>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_set>
 #include <boost/asio.hpp>
 #include <spdlog/spdlog.h>
 #include "kafka/KafkaClient.h"
+#include "common/HiccupMonitor.h"
 
 namespace quasar {
 namespace gateway {
@@ -27,6 +29,10 @@ struct GatewayConfig {
     int32_t socket_buffer_size{65536};
     size_t max_message_size{4096};
 
+    // Platform jitter monitoring (reported with the periodic statistics)
+    bool hiccup_monitor{false};
+    int32_t hiccup_cpu{-1};
+
     // Load from environment variables
     static GatewayConfig from_environment();
     static GatewayConfig from_file(const std::string& config_file);
@@ -85,7 +91,7 @@ public:
      * Publish order to Kafka (called by ClientSession)
      */
     bool publish_order(const std::vector<uint8_t>& serialized_order,
-                      const std::string& trading_pair);
+                      std::string_view trading_pair);
 
     /**
      * Register/unregister client sessions
@@ -111,6 +117,9 @@ private:
     std::unique_ptr<kafka::KafkaClient> kafka_client_;
     kafka::KafkaConfig kafka_config_;
 
+    // Optional platform jitter monitor
+    std::unique_ptr<HiccupMonitor> hiccup_monitor_;
+
     // Session management
     std::unordered_set<std::shared_ptr<ClientSession>> active_sessions_;
     std::mutex sessions_mutex_;
@@ -1,4 +1,5 @@
 #include "HFTGateway.h"
+#include "common/AllocationTracker.h"
 #include "messages_generated.h"
 
 #include <iostream>
@@ -32,6 +33,13 @@ GatewayConfig GatewayConfig::from_environment() {
     if (const char* client_id = std::getenv("KAFKA_CLIENT_ID")) {
         config.client_id = client_id;
     }
+    if (const char* hiccup = std::getenv("HICCUP_MONITOR")) {
+        config.hiccup_monitor = std::string(hiccup) == "1" || std::string(hiccup) == "true";
+    }
+    if (const char* hiccup_cpu = std::getenv("HICCUP_CPU")) {
+        config.hiccup_monitor = true;
+        config.hiccup_cpu = std::stoi(hiccup_cpu);
+    }
 
     return config;
 }
@@ -71,6 +79,8 @@ GatewayConfig GatewayConfig::from_file(const std::string& config_file) {
         else if (key == "kafka_brokers") config.kafka_brokers = value;
         else if (key == "orders_topic") config.orders_topic = value;
         else if (key == "client_id") config.client_id = value;
+        else if (key == "hiccup_monitor") config.hiccup_monitor = (value == "1" || value == "true");
+        else if (key == "hiccup_cpu") config.hiccup_cpu = std::stoi(value);
     }
 
     return config;
@@ -186,6 +196,17 @@ void HFTGateway::run() {
     // Start accepting connections
     start_accept();
 
+    // Start platform jitter monitor before taking traffic
+    if (config_.hiccup_monitor) {
+        HiccupMonitor::Config hiccup_config;
+        hiccup_config.cpu = config_.hiccup_cpu;
+        hiccup_monitor_ = std::make_unique<HiccupMonitor>(hiccup_config);
+        hiccup_monitor_->start();
+        if (config_.hiccup_cpu >= 0 && !hiccup_monitor_->is_pinned()) {
+            logger_->warn("Could not pin hiccup monitor to CPU {}", config_.hiccup_cpu);
+        }
+    }
+
     // Start statistics timer
     log_statistics();
 
@@ -216,6 +237,10 @@ void HFTGateway::shutdown() {
         active_sessions_.clear();
     }
 
+    if (hiccup_monitor_) {
+        hiccup_monitor_->stop();
+    }
+
     // Shutdown Kafka client
     if (kafka_client_) {
         kafka_client_->shutdown();
@@ -228,21 +253,23 @@ void HFTGateway::shutdown() {
 }
 
 bool HFTGateway::publish_order(const std::vector<uint8_t>& serialized_order,
-                              const std::string& trading_pair) {
+                              std::string_view trading_pair) {
+    QUASAR_HOT_REGION("HFTGateway::publish_order");
+
     if (!kafka_client_) {
         logger_->error("Kafka client not available");
         return false;
     }
 
-    // Use trading pair as message key for proper partitioning
-    std::string key = trading_pair.empty() ? "DEFAULT" : trading_pair;
+    // Use trading pair as message key for proper partitioning (short keys stay in SSO storage)
+    std::string key(trading_pair.empty() ? std::string_view("DEFAULT") : trading_pair);
 
     bool success = kafka_client_->produce_async(
         config_.orders_topic, key, serialized_order);
-    
+
+    // No per-message logging here: formatting allocates on every order
     if (success) {
         stats_.bytes_published.fetch_add(serialized_order.size());
-        logger_->debug("Order published to topic {} with key {}", config_.orders_topic, key);
     } else {
         stats_.kafka_errors.fetch_add(1);
         logger_->error("Failed to publish order to Kafka");
@@ -317,6 +344,12 @@ void HFTGateway::log_statistics() {
                          stats_.protocol_errors.load(),
                          stats_.kafka_errors.load(),
                          stats_.validation_errors.load());
+            if (hiccup_monitor_) {
+                auto hiccups = hiccup_monitor_->report();
+                logger_->info("Hiccups: count={}, p99={}ns, p99.99={}ns, max={}ns",
+                             hiccups.hiccups, hiccups.p99_ns, hiccups.p9999_ns, hiccups.max_ns);
+                hiccup_monitor_->reset();
+            }
             logger_->info("==============================");
 
             // Schedule next log
@@ -332,6 +365,9 @@ ClientSession::ClientSession(boost::asio::ip::tcp::socket socket, HFTGateway* ga
     , gateway_(gateway)
     , logger_(spdlog::get("gateway")) {
 
+    // Size the body buffer once so resizing per message never reallocates
+    message_buffer_.reserve(4096);
+
     try {
         remote_endpoint_ = socket_.remote_endpoint().address().to_string() + ":" + 
                          std::to_string(socket_.remote_endpoint().port());
@@ -429,7 +465,7 @@ void ClientSession::read_message_body(uint32_t length) {
 }
 
 void ClientSession::handle_message(const std::vector<uint8_t>& message) {
-    logger_->debug("Received message of {} bytes from {}", message.size(), remote_endpoint_);
+    QUASAR_HOT_REGION("ClientSession::handle_message");
 
     // Validate the FlatBuffer message
     if (!validate_order_message(message)) {
@@ -438,8 +474,8 @@ void ClientSession::handle_message(const std::vector<uint8_t>& message) {
         return;
     }
 
-    // Extract trading pair from the message for partitioning
-    std::string trading_pair = "DEFAULT";
+    // Extract trading pair from the message for partitioning (a view into the message)
+    std::string_view trading_pair = "DEFAULT";
 
     try {
         // Parse FlatBuffer to extract symbol
@@ -449,7 +485,8 @@ void ClientSession::handle_message(const std::vector<uint8_t>& message) {
             if (fb_message->message_type_type() == quasar::schema::MessageType_NewOrderRequest) {
                 auto order_request = static_cast<const quasar::schema::NewOrderRequest*>(fb_message->message_type_as_NewOrderRequest());
                 if (order_request && order_request->symbol()) {
-                    trading_pair = order_request->symbol()->str();
+                    trading_pair = std::string_view(order_request->symbol()->c_str(),
+                                                    order_request->symbol()->size());
                 }
             }
         }
@@ -14,6 +14,8 @@ protected:
         unsetenv("KAFKA_BROKERS");
         unsetenv("ORDERS_TOPIC");
         unsetenv("KAFKA_CLIENT_ID");
+        unsetenv("HICCUP_MONITOR");
+        unsetenv("HICCUP_CPU");
     }
 };
 
@@ -113,6 +115,26 @@ TEST_F(GatewayConfigTest, FromFileWithComments) {
     std::remove("/tmp/test_gateway_config2.txt");
 }
 
+TEST_F(GatewayConfigTest, HiccupMonitorSettings) {
+    EXPECT_FALSE(GatewayConfig().hiccup_monitor);
+    EXPECT_EQ(GatewayConfig().hiccup_cpu, -1);
+
+    setenv("HICCUP_CPU", "3", 1);
+    GatewayConfig env_config = GatewayConfig::from_environment();
+    EXPECT_TRUE(env_config.hiccup_monitor);
+    EXPECT_EQ(env_config.hiccup_cpu, 3);
+
+    std::ofstream config_file("/tmp/test_gateway_config_hiccup.txt");
+    config_file << "hiccup_monitor = true\nhiccup_cpu = 2\n";
+    config_file.close();
+
+    GatewayConfig file_config = GatewayConfig::from_file("/tmp/test_gateway_config_hiccup.txt");
+    EXPECT_TRUE(file_config.hiccup_monitor);
+    EXPECT_EQ(file_config.hiccup_cpu, 2);
+
+    std::remove("/tmp/test_gateway_config_hiccup.txt");
+}
+
 TEST_F(GatewayConfigTest, FromFileNotFound) {
     EXPECT_THROW(
         GatewayConfig::from_file("/nonexistent/file.txt"),
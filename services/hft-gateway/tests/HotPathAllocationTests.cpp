@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "HFTGateway.h"
+#include "common/AllocationTracker.h"
+#include <vector>
+
+using namespace quasar;
+using namespace quasar::gateway;
+
+// Built into hft_gateway_allocation_tests: malloc is interposed and the
+// gateway's hot regions are instrumented.
+
+class HotPathAllocationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        config_.listen_address = "127.0.0.1";
+        config_.listen_port = 0;
+        config_.orders_topic = "test.orders";
+    }
+
+    void TearDown() override {
+        AllocationTracker::disarm();
+        AllocationTracker::reset_violations();
+    }
+
+    GatewayConfig config_;
+};
+
+TEST_F(HotPathAllocationTest, TrackerDetectsAllocation) {
+    AllocationTracker::arm();
+    {
+        HotRegion region("allocating_region");
+        std::vector<uint8_t> buffer(64);
+        EXPECT_GE(region.allocations(), 1u);
+    }
+    AllocationTracker::disarm();
+    EXPECT_EQ(AllocationTracker::violation_count(), 1u);
+}
+
+TEST_F(HotPathAllocationTest, SteadyStatePublishDoesNotAllocate) {
+    HFTGateway gateway(config_);
+    ASSERT_TRUE(gateway.initialize());
+
+    std::vector<uint8_t> order(128, 0xAB);
+    for (int i = 0; i < 100; ++i) {
+        gateway.publish_order(order, "BTC-USD");
+    }
+
+    AllocationTracker::arm();
+    uint64_t allocations = 0;
+    {
+        HotRegion region("steady_state_publish");
+        for (int i = 0; i < 10000; ++i) {
+            gateway.publish_order(order, i % 2 ? "BTC-USD" : "ETH-USD");
+        }
+        allocations = region.allocations();
+    }
+    AllocationTracker::disarm();
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(AllocationTracker::violation_count(), 0u);
+    EXPECT_EQ(gateway.get_statistics().bytes_published.load(), 10100u * order.size());
+
+    gateway.shutdown();
+}
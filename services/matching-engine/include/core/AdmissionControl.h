@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace quasar {
+
+// Engine-wide admission limits; 0 leaves a check off
+struct AdmissionLimits {
+    uint64_t max_queue_depth{0};  // commands waiting at the engine input (reported by the input stage)
+    uint64_t max_latency_ns{0};   // recent matching latency: moving average of order entry calls
+    // Overload clears once every signal is back under this share of its limit
+    double resume_ratio{0.5};
+};
+
+// Overload detector in front of order entry. The input stage reports its
+// queue depth and the engine feeds in how long each order took to match.
+// Past either limit the engine is overloaded until both fall back under
+// resume_ratio of their limits; the gap keeps the signal from flapping at
+// the threshold. All state is atomic, the limits included (set_limits may
+// race the order path's update): checking it on the order path is one
+// relaxed load.
+class AdmissionControl {
+public:
+    void set_limits(const AdmissionLimits& limits) {
+        max_queue_depth_.store(limits.max_queue_depth, std::memory_order_relaxed);
+        max_latency_ns_.store(limits.max_latency_ns, std::memory_order_relaxed);
+        resume_ratio_.store(limits.resume_ratio, std::memory_order_relaxed);
+        enabled_.store(limits.max_queue_depth != 0 || limits.max_latency_ns != 0, std::memory_order_relaxed);
+        timed_.store(limits.max_latency_ns != 0, std::memory_order_relaxed);
+        if (!enabled_.load(std::memory_order_relaxed)) {
+            overloaded_.store(false, std::memory_order_relaxed);
+        }
+    }
+    AdmissionLimits limits() const {
+        AdmissionLimits limits;
+        limits.max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+        limits.max_latency_ns = max_latency_ns_.load(std::memory_order_relaxed);
+        limits.resume_ratio = resume_ratio_.load(std::memory_order_relaxed);
+        return limits;
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    // Whether order entry should be timed
+    bool timed() const { return timed_.load(std::memory_order_relaxed); }
+    bool overloaded() const { return overloaded_.load(std::memory_order_relaxed); }
+
+    void set_queue_depth(uint64_t depth) { queue_depth_.store(depth, std::memory_order_relaxed); }
+
+    // Moving average over about the last 16 orders. Orders entered on
+    // several threads all count: a lost update would drop a sample.
+    void record_latency(uint64_t nanos) {
+        uint64_t average = latency_ns_.load(std::memory_order_relaxed);
+        while (!latency_ns_.compare_exchange_weak(average, average - average / 16 + nanos / 16,
+                                                  std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t queue_depth() const { return queue_depth_.load(std::memory_order_relaxed); }
+    uint64_t latency_ns() const { return latency_ns_.load(std::memory_order_relaxed); }
+    uint64_t episodes() const { return episodes_.load(std::memory_order_relaxed); }
+
+    // Re-evaluate the signals; true when the state changed (the caller
+    // publishes the transition)
+    bool update() {
+        if (!enabled()) {
+            return false;
+        }
+        bool was = overloaded();
+        bool now = was ? !below(resume_ratio_.load(std::memory_order_relaxed)) : !below(1.0);
+        if (now == was || !overloaded_.compare_exchange_strong(was, now, std::memory_order_relaxed)) {
+            return false;
+        }
+        if (now) {
+            episodes_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+private:
+    // Every signal in use under ratio of its limit
+    bool below(double ratio) const {
+        uint64_t max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+        if (max_queue_depth != 0 &&
+            static_cast<double>(queue_depth()) >= static_cast<double>(max_queue_depth) * ratio) {
+            return false;
+        }
+        uint64_t max_latency_ns = max_latency_ns_.load(std::memory_order_relaxed);
+        if (max_latency_ns != 0 &&
+            static_cast<double>(latency_ns()) >= static_cast<double>(max_latency_ns) * ratio) {
+            return false;
+        }
+        return true;
+    }
+
+    // The limits, field by field (see AdmissionLimits)
+    std::atomic<uint64_t> max_queue_depth_{0};
+    std::atomic<uint64_t> max_latency_ns_{0};
+    std::atomic<double> resume_ratio_{0.5};
+    std::atomic<bool> enabled_{false};
+    std::atomic<bool> timed_{false};
+    std::atomic<bool> overloaded_{false};
+    std::atomic<uint64_t> queue_depth_{0};
+    std::atomic<uint64_t> latency_ns_{0};
+    std::atomic<uint64_t> episodes_{0};
+};
+
+} // namespace quasar
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "Order.h"
+#include "BookPolicies.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace quasar {
+
+// Outcome of a call auction at its equilibrium price
+struct AuctionResult {
+    double price{0.0};         // 0 when the book does not cross
+    uint64_t volume{0};        // quantity executable at price
+    uint64_t imbalance{0};     // quantity left unmatched at price on the heavier side
+    Side imbalance_side{Side::BUY};
+};
+
+// Equilibrium price of a crossed book: the price with the largest executable
+// volume, then the smallest imbalance, then the one closest to the reference
+// price (the lowest one without a reference). Only level prices are
+// candidates. Demand at p is the bid quantity at or above p and supply the ask
+// quantity at or below p, computed as a prefix and a suffix sum. When the
+// crossed range is dense on the tick grid, levels are dropped into per-tick
+// arrays directly; otherwise the two sides are merged into one sorted list.
+// Either way the selection runs as branch-free passes over flat arrays, which
+// the compiler vectorizes on targets with 64-bit integer compares (SSE4.2 and
+// up, see QUASAR_NATIVE_ARCH). Buffers keep their capacity between auctions.
+class AuctionCalculator {
+public:
+    // Bids best (highest) first, asks best (lowest) first, both limited to
+    // the crossed range [best ask, best bid]. tick_size 0 forces the merge.
+    AuctionResult compute(const std::vector<BookLevel>& bids, const std::vector<BookLevel>& asks,
+                          double tick_size, double reference_price) {
+        if (bids.empty() || asks.empty() || bids.front().price < asks.front().price) {
+            return AuctionResult{};
+        }
+        if (!fill_dense(bids, asks, tick_size)) {
+            fill_sparse(bids, asks);
+        }
+        return select(reference_price);
+    }
+
+    // Whether the last compute() used the per-tick arrays
+    bool last_was_dense() const { return dense_; }
+
+private:
+    // Ranges wider than this many ticks per level are treated as sparse
+    static constexpr size_t kDenseTicksPerLevel = 4;
+    static constexpr size_t kDenseMinTicks = 64;
+
+    bool fill_dense(const std::vector<BookLevel>& bids, const std::vector<BookLevel>& asks, double tick_size) {
+        dense_ = false;
+        if (tick_size <= 0.0) {
+            return false;
+        }
+        int64_t low = std::llround(asks.front().price / tick_size);
+        int64_t high = std::llround(bids.front().price / tick_size);
+        size_t span = static_cast<size_t>(high - low + 1);
+        if (span > kDenseMinTicks + kDenseTicksPerLevel * (bids.size() + asks.size())) {
+            return false;
+        }
+
+        // Empty ticks keep price 0; they are never selected
+        prices_.assign(span, 0.0);
+        bid_qty_.assign(span, 0);
+        ask_qty_.assign(span, 0);
+        for (const BookLevel& level : bids) {
+            if (!place(level, tick_size, low, span, bid_qty_)) {
+                return false;
+            }
+        }
+        for (const BookLevel& level : asks) {
+            if (!place(level, tick_size, low, span, ask_qty_)) {
+                return false;
+            }
+        }
+        dense_ = true;
+        return true;
+    }
+
+    // Off-grid prices send the book down the sparse path. The level's own
+    // price is kept so the result compares equal to resting order prices.
+    bool place(const BookLevel& level, double tick_size, int64_t low, size_t span, std::vector<uint64_t>& qty) {
+        double ticks = level.price / tick_size;
+        int64_t tick = std::llround(ticks);
+        if (std::fabs(ticks - static_cast<double>(tick)) > 1e-6) {
+            return false;
+        }
+        int64_t index = tick - low;
+        if (index < 0 || index >= static_cast<int64_t>(span)) {
+            return false;
+        }
+        qty[static_cast<size_t>(index)] += level.quantity;
+        prices_[static_cast<size_t>(index)] = level.price;
+        return true;
+    }
+
+    // Merge bids (descending) and asks (ascending) into ascending prices
+    void fill_sparse(const std::vector<BookLevel>& bids, const std::vector<BookLevel>& asks) {
+        prices_.clear();
+        bid_qty_.clear();
+        ask_qty_.clear();
+        size_t b = bids.size();
+        size_t a = 0;
+        while (b > 0 || a < asks.size()) {
+            double bid_price = b > 0 ? bids[b - 1].price : 0.0;
+            double ask_price = a < asks.size() ? asks[a].price : 0.0;
+            bool take_bid = b > 0 && (a == asks.size() || bid_price <= ask_price);
+            bool take_ask = a < asks.size() && (b == 0 || ask_price <= bid_price);
+            prices_.push_back(take_bid ? bid_price : ask_price);
+            bid_qty_.push_back(take_bid ? bids[--b].quantity : 0);
+            ask_qty_.push_back(take_ask ? asks[a++].quantity : 0);
+        }
+    }
+
+    AuctionResult select(double reference_price) {
+        size_t n = prices_.size();
+        supply_.resize(n);
+        demand_.resize(n);
+        executable_.resize(n);
+        imbalance_.resize(n);
+
+        uint64_t running = 0;
+        for (size_t i = 0; i < n; ++i) {
+            running += ask_qty_[i];
+            supply_[i] = running;
+        }
+        running = 0;
+        for (size_t i = n; i-- > 0;) {
+            running += bid_qty_[i];
+            demand_[i] = running;
+        }
+
+        // Selects only (no branches) so both passes vectorize; empty ticks of
+        // the dense grid are not candidates
+        const uint64_t* demand = demand_.data();
+        const uint64_t* supply = supply_.data();
+        const uint64_t* bid_qty = bid_qty_.data();
+        const uint64_t* ask_qty = ask_qty_.data();
+        uint64_t* executable = executable_.data();
+        uint64_t* imbalance = imbalance_.data();
+        uint64_t best_volume = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t low = demand[i] < supply[i] ? demand[i] : supply[i];
+            uint64_t high = demand[i] < supply[i] ? supply[i] : demand[i];
+            uint64_t volume = (bid_qty[i] | ask_qty[i]) != 0 ? low : 0;
+            executable[i] = volume;
+            imbalance[i] = high - low;
+            best_volume = best_volume < volume ? volume : best_volume;
+        }
+        if (best_volume == 0) {
+            return AuctionResult{};
+        }
+
+        uint64_t best_imbalance = UINT64_MAX;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t candidate = executable[i] == best_volume ? imbalance[i] : UINT64_MAX;
+            best_imbalance = candidate < best_imbalance ? candidate : best_imbalance;
+        }
+
+        // Ascending prices: the first of equally distant candidates is the lowest
+        size_t best = n;
+        double best_distance = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            if (executable[i] != best_volume || imbalance[i] != best_imbalance) {
+                continue;
+            }
+            double distance = reference_price > 0.0 ? std::fabs(prices_[i] - reference_price) : 0.0;
+            if (best == n || distance < best_distance) {
+                best = i;
+                best_distance = distance;
+            }
+        }
+
+        AuctionResult result;
+        result.price = prices_[best];
+        result.volume = best_volume;
+        result.imbalance = best_imbalance;
+        result.imbalance_side = demand_[best] >= supply_[best] ? Side::BUY : Side::SELL;
+        return result;
+    }
+
+    bool dense_{false};
+    std::vector<double> prices_;
+    std::vector<uint64_t> bid_qty_;
+    std::vector<uint64_t> ask_qty_;
+    std::vector<uint64_t> demand_;
+    std::vector<uint64_t> supply_;
+    std::vector<uint64_t> executable_;
+    std::vector<uint64_t> imbalance_;
+};
+
+} // namespace quasar
@@ -0,0 +1,812 @@
+#pragma once
+
+#include "Order.h"
+#include "NodePool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace quasar {
+
+// Aggregated view of one price level (for market data)
+struct BookLevel {
+    double price;
+    uint64_t quantity;
+    uint32_t order_count;
+};
+
+// Runtime tag for the compile-time book policies, used to pick one per symbol
+enum class BookType {
+    HEAP,
+    MAP,
+    INTRUSIVE,
+    LADDER
+};
+
+// How an incoming order is shared among the orders resting at a price
+enum class MatchingAlgorithm {
+    FIFO,          // price-time priority
+    PRO_RATA,      // in proportion to resting size, rounding left-overs FIFO
+    TOP_PRO_RATA   // the level's first order fills first, then pro-rata
+};
+
+// Construction-time settings shared by all book policies
+struct BookConfig {
+    // Price increment used by the ladder policy to index levels
+    double tick_size{0.01};
+
+    // Widest band of ticks a ladder side or queue index spans, lowest live
+    // level to highest. Books with either only rest limit prices on the tick
+    // grid and inside the band: other orders are rejected on entry
+    // (BookReject::INVALID_PRICE) and so are replacements to such prices.
+    uint32_t max_band_ticks{100000};
+
+    // Allocation among resting orders at a price. Pro-rata needs a side that
+    // can walk a level (not the heap policy).
+    MatchingAlgorithm matching{MatchingAlgorithm::FIFO};
+
+    // Pro-rata shares below this are not allocated (they join the FIFO
+    // left-over pass instead)
+    uint64_t pro_rata_min_allocation{1};
+
+    // Keep a queue index (QueueIndex.h) beside the sides, for O(log n) queue
+    // position, depth and sweep cost queries at O(log n) extra per book change
+    bool queue_index{false};
+};
+
+// FIFO queue of resting orders at a single price, linked through the orders
+// themselves so that insertion and removal never allocate
+struct PriceLevel {
+    double price{0.0};
+    uint64_t total_quantity{0};
+    uint32_t order_count{0};
+    Order* head{nullptr};
+    Order* tail{nullptr};
+
+    bool empty() const { return head == nullptr; }
+
+    void push_back(Order* order) {
+        order->level = this;
+        order->prev_in_level = tail;
+        order->next_in_level = nullptr;
+        if (tail) {
+            tail->next_in_level = order;
+        } else {
+            head = order;
+        }
+        tail = order;
+        total_quantity += order->displayed_quantity();
+        order_count++;
+    }
+
+    // Move an order to the back of the queue in place, adding shown_quantity
+    // (a new iceberg slice) to the level total
+    void requeue(Order* order, uint64_t shown_quantity) {
+        total_quantity += shown_quantity;
+        if (order == tail) {
+            return;
+        }
+        if (order->prev_in_level) {
+            order->prev_in_level->next_in_level = order->next_in_level;
+        } else {
+            head = order->next_in_level;
+        }
+        order->next_in_level->prev_in_level = order->prev_in_level;
+        order->prev_in_level = tail;
+        order->next_in_level = nullptr;
+        tail->next_in_level = order;
+        tail = order;
+    }
+
+    void erase(Order* order) {
+        if (order->prev_in_level) {
+            order->prev_in_level->next_in_level = order->next_in_level;
+        } else {
+            head = order->next_in_level;
+        }
+        if (order->next_in_level) {
+            order->next_in_level->prev_in_level = order->prev_in_level;
+        } else {
+            tail = order->prev_in_level;
+        }
+        total_quantity -= order->displayed_quantity();
+        order_count--;
+        order->prev_in_level = nullptr;
+        order->next_in_level = nullptr;
+        order->level = nullptr;
+    }
+};
+
+/*
+ * Book policies
+ *
+ * A policy bundles one container type per side of the book. Every side
+ * container exposes the same shape so BasicOrderBook can be written once:
+ *
+ *   Side(const BookConfig&, NodePool&)  node containers draw from the book's pool
+ *   static constexpr bool lazy_cancel   erase() leaves the order in place; front()
+ *                                       drops it later and lists it in released()
+ *   static constexpr bool level_access  the side also has, for pro-rata matching:
+ *     uint64_t front_level_quantity() const   displayed quantity at the best price
+ *     void for_each_at_front(Fn fn) const     fn(Order*) for each order at the best
+ *                                             price, in time priority
+ *     void requeue(Order*)                    requeue_front() for any order
+ *   void insert(Order*)                 rest a live order at the back of its price
+ *   void erase(Order*)                  remove a live order (cancel)
+ *   void on_fill(Order*, uint64_t qty)  a resting order's open quantity dropped by qty
+ *                                       (a fill or a size reduction)
+ *   Order* front()                      highest priority live order, or nullptr
+ *   void pop_front()                    remove front() once it is filled
+ *   void requeue_front()                front() showed a new iceberg slice: move it
+ *                                       behind the other orders at its price
+ *   void for_each_level(Fn fn) const    fn(const BookLevel&) on each level, best
+ *                                       first, until it returns false
+ *   void for_each_order(Fn fn) const    fn(Order*) on each live order, best price
+ *                                       first and in time priority within a price
+ *   std::vector<BookLevel> levels(size_t max_levels) const   best level first
+ *   BookLevel level_at(double price) const   one level (quantity 0 if empty)
+ *   uint64_t volume() const             total displayed quantity (iceberg reserve
+ *                                       is left out)
+ *   size_t entries() const              container slots held (heap entries including
+ *                                       tombstones, or price levels)
+ *   bool can_hold(double price) const   whether an order may rest at price
+ */
+
+// Orders of a linked level in time priority
+template<typename Fn>
+void for_each_in_level(const PriceLevel& level, Fn&& fn) {
+    for (Order* order = level.head; order; order = order->next_in_level) {
+        fn(order);
+    }
+}
+
+// The first max_levels levels of a side, best first
+template<typename SideT>
+std::vector<BookLevel> collect_levels(const SideT& side, size_t max_levels) {
+    std::vector<BookLevel> result;
+    if (max_levels == 0) {
+        return result;
+    }
+    side.for_each_level([&](const BookLevel& level) {
+        result.push_back(level);
+        return result.size() < max_levels;
+    });
+    return result;
+}
+
+// Binary heaps ordered by price, then by the sequence in which orders were
+// inserted into the side. Cancels are lazy: the order is only marked cancelled
+// and skipped once it surfaces at the top. Tombstones buried below live orders
+// are swept out once they outnumber the live ones.
+template<typename Comparator>
+class HeapSide {
+    struct Entry {
+        Order* order;
+        uint64_t sequence;
+    };
+
+    // Comparator decides on price; equal prices go to the earlier insertion
+    struct EntryCompare {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.order->price != b.order->price) {
+                return Comparator()(a.order, b.order);
+            }
+            return a.sequence > b.sequence;
+        }
+    };
+
+public:
+    static constexpr bool lazy_cancel = true;
+    static constexpr bool level_access = false;
+
+    HeapSide(const BookConfig&, NodePool&) {}
+
+    void insert(Order* order) {
+        heap_.push_back(Entry{order, next_sequence_++});
+        std::push_heap(heap_.begin(), heap_.end(), EntryCompare());
+    }
+
+    // Called after the order has been marked cancelled
+    void erase(Order*) {
+        cancelled_++;
+        if (cancelled_ > kMinCompaction && cancelled_ * 2 > heap_.size()) {
+            compact();
+        }
+    }
+
+    void on_fill(Order*, uint64_t) {}
+
+    Order* front() {
+        while (!heap_.empty() && !heap_.front().order->is_active()) {
+            released_.push_back(heap_.front().order);
+            pop_front();
+            cancelled_--;
+        }
+        return heap_.empty() ? nullptr : heap_.front().order;
+    }
+
+    void pop_front() {
+        std::pop_heap(heap_.begin(), heap_.end(), EntryCompare());
+        heap_.pop_back();
+    }
+
+    // Re-enter the front with a fresh sequence: O(log n), no allocation
+    void requeue_front() {
+        std::pop_heap(heap_.begin(), heap_.end(), EntryCompare());
+        heap_.back().sequence = next_sequence_++;
+        std::push_heap(heap_.begin(), heap_.end(), EntryCompare());
+    }
+
+    // Cancelled orders dropped from the heap; the book frees them and clears this
+    std::vector<Order*>& released() { return released_; }
+
+    // Drop every tombstone now rather than as it surfaces
+    void purge() { compact(); }
+
+    // Sorts the live orders first: O(n log n)
+    template<typename Fn>
+    void for_each_level(Fn&& fn) const {
+        std::vector<Order*> live;
+        for (const Entry& entry : heap_) {
+            if (entry.order->is_active()) {
+                live.push_back(entry.order);
+            }
+        }
+        // Best first: sort by the inverse of the heap ordering
+        std::sort(live.begin(), live.end(), [](const Order* a, const Order* b) { return Comparator()(b, a); });
+        BookLevel level{0.0, 0, 0};
+        for (const Order* order : live) {
+            if (level.order_count > 0 && level.price != order->price) {
+                if (!fn(static_cast<const BookLevel&>(level))) {
+                    return;
+                }
+                level = BookLevel{0.0, 0, 0};
+            }
+            level.price = order->price;
+            level.quantity += order->displayed_quantity();
+            level.order_count++;
+        }
+        if (level.order_count > 0) {
+            fn(static_cast<const BookLevel&>(level));
+        }
+    }
+
+    std::vector<BookLevel> levels(size_t max_levels) const {
+        return collect_levels(*this, max_levels);
+    }
+
+    // Sorts the live entries by the heap ordering: O(n log n)
+    template<typename Fn>
+    void for_each_order(Fn&& fn) const {
+        std::vector<Entry> live;
+        for (const Entry& entry : heap_) {
+            if (entry.order->is_active()) {
+                live.push_back(entry);
+            }
+        }
+        std::sort(live.begin(), live.end(), [](const Entry& a, const Entry& b) { return EntryCompare()(b, a); });
+        for (const Entry& entry : live) {
+            fn(entry.order);
+        }
+    }
+
+    // Linear scan: the heap keeps no per-price index
+    BookLevel level_at(double price) const {
+        BookLevel level{price, 0, 0};
+        for (const Entry& entry : heap_) {
+            if (entry.order->price == price && entry.order->is_active()) {
+                level.quantity += entry.order->displayed_quantity();
+                level.order_count++;
+            }
+        }
+        return level;
+    }
+
+    uint64_t volume() const {
+        uint64_t total_volume = 0;
+        for (const Entry& entry : heap_) {
+            if (entry.order->is_active()) {
+                total_volume += entry.order->displayed_quantity();
+            }
+        }
+        return total_volume;
+    }
+
+    size_t entries() const { return heap_.size(); }
+
+    bool can_hold(double) const { return true; }
+
+private:
+    static constexpr size_t kMinCompaction = 64;
+
+    void compact() {
+        auto live_end = std::partition(heap_.begin(), heap_.end(),
+                                       [](const Entry& entry) { return entry.order->is_active(); });
+        for (auto it = live_end; it != heap_.end(); ++it) {
+            released_.push_back(it->order);
+        }
+        heap_.erase(live_end, heap_.end());
+        std::make_heap(heap_.begin(), heap_.end(), EntryCompare());
+        cancelled_ = 0;
+    }
+
+    std::vector<Entry> heap_;
+    std::vector<Order*> released_;
+    size_t cancelled_{0};
+    uint64_t next_sequence_{0};
+};
+
+// Ordered map of price -> std::list of orders, with an id -> iterator index
+// for O(1) removal inside a level
+template<typename PriceCompare>
+class MapSide {
+    using OrderList = std::list<Order*, PoolAllocator<Order*>>;
+
+public:
+    static constexpr bool lazy_cancel = false;
+    static constexpr bool level_access = true;
+
+    MapSide(const BookConfig&, NodePool& pool)
+        : pool_(pool),
+          levels_(PriceCompare(), PoolAllocator<std::pair<const double, OrderList>>(pool)),
+          iterators_(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+                     PoolAllocator<std::pair<const uint64_t, typename OrderList::iterator>>(pool)) {}
+
+    void insert(Order* order) {
+        auto& queue = levels_.try_emplace(order->price, PoolAllocator<Order*>(pool_)).first->second;
+        queue.push_back(order);
+        iterators_[order->order_id] = std::prev(queue.end());
+    }
+
+    void erase(Order* order) {
+        auto it = iterators_.find(order->order_id);
+        if (it == iterators_.end()) {
+            return;
+        }
+        auto level = levels_.find(order->price);
+        level->second.erase(it->second);
+        if (level->second.empty()) {
+            levels_.erase(level);
+        }
+        iterators_.erase(it);
+    }
+
+    void on_fill(Order*, uint64_t) {}
+
+    Order* front() {
+        return levels_.empty() ? nullptr : levels_.begin()->second.front();
+    }
+
+    // Splice the order to the back of its level: O(1), iterators stay valid
+    void requeue(Order* order) {
+        auto& queue = levels_.find(order->price)->second;
+        queue.splice(queue.end(), queue, iterators_.find(order->order_id)->second);
+    }
+
+    void requeue_front() {
+        auto& queue = levels_.begin()->second;
+        queue.splice(queue.end(), queue, queue.begin());
+    }
+
+    // No level totals are kept: O(orders at the level)
+    uint64_t front_level_quantity() const {
+        uint64_t quantity = 0;
+        if (!levels_.empty()) {
+            for (const Order* order : levels_.begin()->second) {
+                quantity += order->displayed_quantity();
+            }
+        }
+        return quantity;
+    }
+
+    template<typename Fn>
+    void for_each_at_front(Fn&& fn) const {
+        if (!levels_.empty()) {
+            for (Order* order : levels_.begin()->second) {
+                fn(order);
+            }
+        }
+    }
+
+    void pop_front() {
+        auto level = levels_.begin();
+        iterators_.erase(level->second.front()->order_id);
+        level->second.pop_front();
+        if (level->second.empty()) {
+            levels_.erase(level);
+        }
+    }
+
+    template<typename Fn>
+    void for_each_level(Fn&& fn) const {
+        for (const auto& [price, queue] : levels_) {
+            BookLevel level{price, 0, 0};
+            for (const Order* order : queue) {
+                level.quantity += order->displayed_quantity();
+                level.order_count++;
+            }
+            if (!fn(static_cast<const BookLevel&>(level))) {
+                return;
+            }
+        }
+    }
+
+    std::vector<BookLevel> levels(size_t max_levels) const {
+        return collect_levels(*this, max_levels);
+    }
+
+    template<typename Fn>
+    void for_each_order(Fn&& fn) const {
+        for (const auto& [price, queue] : levels_) {
+            for (Order* order : queue) {
+                fn(order);
+            }
+        }
+    }
+
+    BookLevel level_at(double price) const {
+        BookLevel level{price, 0, 0};
+        auto it = levels_.find(price);
+        if (it != levels_.end()) {
+            for (const Order* order : it->second) {
+                level.quantity += order->displayed_quantity();
+                level.order_count++;
+            }
+        }
+        return level;
+    }
+
+    uint64_t volume() const {
+        uint64_t total_volume = 0;
+        for (const auto& [price, queue] : levels_) {
+            for (const Order* order : queue) {
+                total_volume += order->displayed_quantity();
+            }
+        }
+        return total_volume;
+    }
+
+    size_t entries() const { return levels_.size(); }
+
+    bool can_hold(double) const { return true; }
+
+private:
+    NodePool& pool_;
+    std::map<double, OrderList, PriceCompare,
+             PoolAllocator<std::pair<const double, OrderList>>> levels_;
+    std::unordered_map<uint64_t, typename OrderList::iterator, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       PoolAllocator<std::pair<const uint64_t, typename OrderList::iterator>>> iterators_;
+};
+
+// Ordered map of price -> PriceLevel. Orders are chained intrusively inside
+// their level, so cancels and fills are O(1) and level totals are always
+// available without walking the queue.
+template<typename PriceCompare>
+class IntrusiveSide {
+public:
+    static constexpr bool lazy_cancel = false;
+    static constexpr bool level_access = true;
+
+    IntrusiveSide(const BookConfig&, NodePool& pool)
+        : levels_(PriceCompare(), PoolAllocator<std::pair<const double, PriceLevel>>(pool)) {}
+
+    void insert(Order* order) {
+        auto [it, inserted] = levels_.try_emplace(order->price);
+        if (inserted) {
+            it->second.price = order->price;
+        }
+        it->second.push_back(order);
+        volume_ += order->displayed_quantity();
+    }
+
+    void erase(Order* order) {
+        PriceLevel* level = order->level;
+        if (!level) {
+            return;
+        }
+        volume_ -= order->displayed_quantity();
+        level->erase(order);
+        if (level->empty()) {
+            levels_.erase(level->price);
+        }
+    }
+
+    void on_fill(Order* order, uint64_t quantity) {
+        order->level->total_quantity -= quantity;
+        volume_ -= quantity;
+    }
+
+    Order* front() {
+        return levels_.empty() ? nullptr : levels_.begin()->second.head;
+    }
+
+    void pop_front() { erase(front()); }
+
+    void requeue(Order* order) {
+        order->level->requeue(order, order->shown_quantity);
+        volume_ += order->shown_quantity;
+    }
+
+    void requeue_front() { requeue(front()); }
+
+    uint64_t front_level_quantity() const {
+        return levels_.empty() ? 0 : levels_.begin()->second.total_quantity;
+    }
+
+    template<typename Fn>
+    void for_each_at_front(Fn&& fn) const {
+        if (!levels_.empty()) {
+            for_each_in_level(levels_.begin()->second, fn);
+        }
+    }
+
+    template<typename Fn>
+    void for_each_level(Fn&& fn) const {
+        for (const auto& [price, level] : levels_) {
+            if (!fn(BookLevel{price, level.total_quantity, level.order_count})) {
+                return;
+            }
+        }
+    }
+
+    std::vector<BookLevel> levels(size_t max_levels) const {
+        return collect_levels(*this, max_levels);
+    }
+
+    template<typename Fn>
+    void for_each_order(Fn&& fn) const {
+        for (const auto& [price, level] : levels_) {
+            for_each_in_level(level, fn);
+        }
+    }
+
+    BookLevel level_at(double price) const {
+        auto it = levels_.find(price);
+        return it == levels_.end() ? BookLevel{price, 0, 0}
+                                   : BookLevel{price, it->second.total_quantity, it->second.order_count};
+    }
+
+    uint64_t volume() const { return volume_; }
+
+    size_t entries() const { return levels_.size(); }
+
+    bool can_hold(double) const { return true; }
+
+private:
+    std::map<double, PriceLevel, PriceCompare, PoolAllocator<std::pair<const double, PriceLevel>>> levels_;
+    uint64_t volume_{0};
+};
+
+// Contiguous price ladder indexed by tick. Levels live in a deque so that
+// growing the ladder at either end never moves existing levels. Best price is
+// tracked as an index and only rescanned when the best level empties. Only
+// prices on the tick grid and within BookConfig::max_band_ticks of the live
+// levels are held: growing toward a new price first drops empty slots off the
+// far end, and an empty ladder moves to the next price it is given.
+template<bool IsBid>
+class LadderSide {
+public:
+    static constexpr bool lazy_cancel = false;
+    static constexpr bool level_access = true;
+
+    // Levels only grow when the band widens, so the ladder needs no node pool
+    LadderSide(const BookConfig& config, NodePool&)
+        : tick_size_(config.tick_size), max_ticks_(std::max<int64_t>(config.max_band_ticks, 1)) {}
+
+    void insert(Order* order) {
+        int64_t index = ensure_index(to_tick(order->price));
+        PriceLevel& level = levels_[static_cast<size_t>(index)];
+        if (level.empty()) {
+            level.price = order->price;
+            live_levels_++;
+            if (best_ < 0 || better(index, best_)) {
+                best_ = index;
+            }
+        }
+        level.push_back(order);
+        volume_ += order->displayed_quantity();
+    }
+
+    void erase(Order* order) {
+        PriceLevel* level = order->level;
+        if (!level) {
+            return;
+        }
+        volume_ -= order->displayed_quantity();
+        level->erase(order);
+        if (level->empty()) {
+            live_levels_--;
+            if (to_tick(level->price) - base_tick_ == best_) {
+                rescan_best();
+            }
+        }
+    }
+
+    void on_fill(Order* order, uint64_t quantity) {
+        order->level->total_quantity -= quantity;
+        volume_ -= quantity;
+    }
+
+    Order* front() {
+        return best_ < 0 ? nullptr : levels_[static_cast<size_t>(best_)].head;
+    }
+
+    void pop_front() { erase(front()); }
+
+    void requeue(Order* order) {
+        order->level->requeue(order, order->shown_quantity);
+        volume_ += order->shown_quantity;
+    }
+
+    void requeue_front() { requeue(front()); }
+
+    uint64_t front_level_quantity() const {
+        return best_ < 0 ? 0 : levels_[static_cast<size_t>(best_)].total_quantity;
+    }
+
+    template<typename Fn>
+    void for_each_at_front(Fn&& fn) const {
+        if (best_ >= 0) {
+            for_each_in_level(levels_[static_cast<size_t>(best_)], fn);
+        }
+    }
+
+    template<typename Fn>
+    void for_each_level(Fn&& fn) const {
+        for (int64_t i = best_; i >= 0 && i < static_cast<int64_t>(levels_.size()); i += step()) {
+            const PriceLevel& level = levels_[static_cast<size_t>(i)];
+            if (!level.empty() && !fn(BookLevel{level.price, level.total_quantity, level.order_count})) {
+                return;
+            }
+        }
+    }
+
+    std::vector<BookLevel> levels(size_t max_levels) const {
+        return collect_levels(*this, max_levels);
+    }
+
+    template<typename Fn>
+    void for_each_order(Fn&& fn) const {
+        for (int64_t i = best_; i >= 0 && i < static_cast<int64_t>(levels_.size()); i += step()) {
+            for_each_in_level(levels_[static_cast<size_t>(i)], fn);
+        }
+    }
+
+    BookLevel level_at(double price) const {
+        int64_t index = to_tick(price) - base_tick_;
+        if (index < 0 || index >= static_cast<int64_t>(levels_.size())) {
+            return {price, 0, 0};
+        }
+        const PriceLevel& level = levels_[static_cast<size_t>(index)];
+        return {price, level.total_quantity, level.order_count};
+    }
+
+    uint64_t volume() const { return volume_; }
+
+    // Every tick slot in the ladder, empty or not
+    size_t entries() const { return levels_.size(); }
+
+    // On the grid, and inside the band with the live levels. The ladder never
+    // spans more than the band, so the live levels are only looked for when
+    // the whole ladder and the price do not fit in it.
+    bool can_hold(double price) const {
+        double ticks = price / tick_size_;
+        int64_t tick = std::llround(ticks);
+        if (std::fabs(ticks - static_cast<double>(tick)) > 1e-6) {
+            return false;
+        }
+        int64_t size = static_cast<int64_t>(levels_.size());
+        if (live_levels_ == 0 || std::max(base_tick_ + size - 1, tick) - std::min(base_tick_, tick) < max_ticks_) {
+            return true;
+        }
+        int64_t worst = IsBid ? 0 : size - 1;
+        while (levels_[static_cast<size_t>(worst)].empty()) {
+            worst -= step();
+        }
+        int64_t low = base_tick_ + std::min(best_, worst);
+        int64_t high = base_tick_ + std::max(best_, worst);
+        return std::max(high, tick) - std::min(low, tick) < max_ticks_;
+    }
+
+private:
+    static constexpr int64_t step() { return IsBid ? -1 : 1; }
+
+    static bool better(int64_t a, int64_t b) { return IsBid ? a > b : a < b; }
+
+    int64_t to_tick(double price) const {
+        return static_cast<int64_t>(std::llround(price / tick_size_));
+    }
+
+    // Grow the ladder to cover tick (which can_hold accepted) and return its index
+    int64_t ensure_index(int64_t tick) {
+        if (levels_.empty()) {
+            base_tick_ = tick;
+            levels_.emplace_back();
+            return 0;
+        }
+        int64_t size = static_cast<int64_t>(levels_.size());
+        if (tick >= base_tick_ && tick < base_tick_ + size) {
+            return tick - base_tick_;
+        }
+        if (live_levels_ == 0) {
+            base_tick_ = tick - size / 2;
+            return tick - base_tick_;
+        }
+        if (tick < base_tick_) {
+            while (static_cast<int64_t>(levels_.size()) + (base_tick_ - tick) > max_ticks_ && levels_.back().empty()) {
+                levels_.pop_back();
+            }
+            while (tick < base_tick_) {
+                levels_.emplace_front();
+                base_tick_--;
+                best_++;
+            }
+        } else {
+            while (tick - base_tick_ + 1 > max_ticks_ && levels_.front().empty()) {
+                levels_.pop_front();
+                base_tick_++;
+                best_--;
+            }
+            while (tick - base_tick_ >= static_cast<int64_t>(levels_.size())) {
+                levels_.emplace_back();
+            }
+        }
+        return tick - base_tick_;
+    }
+
+    void rescan_best() {
+        if (live_levels_ == 0) {
+            best_ = -1;
+            return;
+        }
+        int64_t i = best_;
+        while (levels_[static_cast<size_t>(i)].empty()) {
+            i += step();
+        }
+        best_ = i;
+    }
+
+    double tick_size_;
+    int64_t max_ticks_;
+    std::deque<PriceLevel> levels_;
+    int64_t base_tick_{0};
+    int64_t best_{-1};
+    size_t live_levels_{0};
+    uint64_t volume_{0};
+};
+
+struct HeapBookPolicy {
+    static constexpr BookType type = BookType::HEAP;
+    static constexpr const char* name = "heap";
+    using BidSide = HeapSide<BuyOrderComparator>;
+    using AskSide = HeapSide<SellOrderComparator>;
+};
+
+struct MapBookPolicy {
+    static constexpr BookType type = BookType::MAP;
+    static constexpr const char* name = "map";
+    using BidSide = MapSide<std::greater<double>>;
+    using AskSide = MapSide<std::less<double>>;
+};
+
+struct IntrusiveBookPolicy {
+    static constexpr BookType type = BookType::INTRUSIVE;
+    static constexpr const char* name = "intrusive";
+    using BidSide = IntrusiveSide<std::greater<double>>;
+    using AskSide = IntrusiveSide<std::less<double>>;
+};
+
+struct LadderBookPolicy {
+    static constexpr BookType type = BookType::LADDER;
+    static constexpr const char* name = "ladder";
+    using BidSide = LadderSide<true>;
+    using AskSide = LadderSide<false>;
+};
+
+} // namespace quasar
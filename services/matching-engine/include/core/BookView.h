@@ -0,0 +1,197 @@
+#pragma once
+
+#include "BookPolicies.h"
+#include "Epoch.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace quasar {
+
+class OrderBookBase;
+
+// What market data queries see of a book: the top levels of each side, best
+// first, with the side volumes and the last trade price as of one publish
+struct BookView {
+    std::vector<BookLevel> bids;
+    std::vector<BookLevel> asks;
+    uint64_t bid_volume{0};
+    uint64_t ask_volume{0};
+    double last_trade_price{0.0};
+    uint64_t version{0};  // publishes before this one
+
+    double best_bid() const { return bids.empty() ? 0.0 : bids.front().price; }
+    double best_ask() const { return asks.empty() ? 0.0 : asks.front().price; }
+    double spread() const {
+        return bids.empty() || asks.empty() ? 0.0 : asks.front().price - bids.front().price;
+    }
+};
+
+// Double-buffered read replica of one book (see MatchingEngine::set_book_views).
+// The thread changing the book notes each displayed level it touches and,
+// at the end of the book call, rebuilds the back buffer and swaps it in with
+// one atomic store. Readers pin the replica domain's epoch, load the front
+// buffer and copy out of it, never touching the book or its lock.
+//
+// The rebuild is incremental: an untouched side is copied from the front
+// buffer, and a touched side is only walked again when a change reached its
+// published depth (else only its volume is refreshed). The back buffer was
+// the front one publish ago, so a reader that loaded it then may still be
+// copying; until every reader pinned at that swap has left, publish()
+// keeps its notes and returns false, and the next call on the book (or
+// refresh) publishes instead. A view thus lags its book by at most the
+// changes made while one reader copied one view.
+class BookReplica {
+public:
+    explicit BookReplica(size_t depth);
+
+    BookReplica(const BookReplica&) = delete;
+    BookReplica& operator=(const BookReplica&) = delete;
+
+    // Readers of every replica pin this domain, apart from the one retiring
+    // book orders, so that queries never hold back order reclamation
+    static EpochDomain& domain();
+
+    size_t depth() const { return depth_; }
+
+    // Writer side: the thread holding the book's lock
+
+    // A displayed level of side changed at price
+    void note(Side side, double price) {
+        Change& change = changes_[side == Side::BUY ? 0 : 1];
+        if (!change.dirty) {
+            change = Change{true, price};
+        } else if (side == Side::BUY ? price > change.edge : price < change.edge) {
+            change.edge = price;
+        }
+    }
+
+    // Everything may have changed (a restored or newly viewed book)
+    void note_all() {
+        changes_[0] = Change{true, std::numeric_limits<double>::infinity()};
+        changes_[1] = Change{true, -std::numeric_limits<double>::infinity()};
+    }
+
+    bool dirty() const { return changes_[0].dirty || changes_[1].dirty; }
+
+    template<typename BidSide, typename AskSide>
+    bool publish(const BidSide& bids, const AskSide& asks, double last_trade_price) {
+        const BookView* front = front_.load(std::memory_order_relaxed);
+        BookView* back = front == &buffers_[0] ? &buffers_[1] : &buffers_[0];
+        if (swapped_at_ != 0 && !domain().quiesced(swapped_at_)) {
+            deferred_.fetch_add(1, std::memory_order_relaxed);
+            behind_.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        rebuild(bids, changes_[0], front->bids, front->bid_volume, back->bids, back->bid_volume, true);
+        rebuild(asks, changes_[1], front->asks, front->ask_volume, back->asks, back->ask_volume, false);
+        back->last_trade_price = last_trade_price;
+        back->version = front->version + 1;
+        front_.store(back);
+        swapped_at_ = domain().epoch();
+        changes_[0].dirty = false;
+        changes_[1].dirty = false;
+        behind_.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Reader side: any thread, lock-free. fn(const BookView&) runs inside
+    // the guard and must copy out what it needs.
+    template<typename Fn>
+    auto read(Fn&& fn) const {
+        EpochGuard guard(domain());
+        return fn(*front_.load());
+    }
+
+    // Publishes so far, and publishes put off for a reader
+    uint64_t version() const {
+        return read([](const BookView& view) { return view.version; });
+    }
+    uint64_t deferred() const { return deferred_.load(std::memory_order_relaxed); }
+    // The last publish was put off: the view is behind until the next one.
+    // Readable without the book's lock.
+    bool behind() const { return behind_.load(std::memory_order_relaxed); }
+
+    // Whether the book is on its ViewBacklog: claim_backlog is true for the
+    // first put-off publish since release_backlog, so a book is queued once
+    bool claim_backlog() { return !queued_.exchange(true, std::memory_order_relaxed); }
+    void release_backlog() { queued_.store(false, std::memory_order_relaxed); }
+
+private:
+    // Levels of a side changed since the last publish, and the best price
+    // among them
+    struct Change {
+        bool dirty{false};
+        double edge{0.0};
+    };
+
+    template<typename SideT>
+    void rebuild(const SideT& side, const Change& change, const std::vector<BookLevel>& levels,
+                 uint64_t volume, std::vector<BookLevel>& out, uint64_t& out_volume, bool bid) const {
+        if (!change.dirty) {
+            out = levels;
+            out_volume = volume;
+            return;
+        }
+        bool reached = levels.size() < depth_ ||
+                       (bid ? change.edge >= levels.back().price : change.edge <= levels.back().price);
+        if (reached) {
+            out.clear();
+            side.for_each_level([this, &out](const BookLevel& level) {
+                out.push_back(level);
+                return out.size() < depth_;
+            });
+        } else {
+            out = levels;
+        }
+        out_volume = side.volume();
+    }
+
+    size_t depth_;
+    BookView buffers_[2];
+    std::atomic<const BookView*> front_;
+    uint64_t swapped_at_{0};  // replica domain epoch at the last swap (0: none yet)
+    Change changes_[2];       // bids, asks
+    std::atomic<uint64_t> deferred_{0};
+    std::atomic<bool> behind_{false};
+    std::atomic<bool> queued_{false};
+};
+
+// Books whose view a reader held back. A book queues itself (under its own
+// lock) when a publish is put off, and whoever refreshes views drains the
+// queue instead of walking every book. The two buffers trade places on each
+// drain, so once they have grown to the most books ever behind at once,
+// neither allocates.
+class ViewBacklog {
+public:
+    void add(OrderBookBase* book) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        books_.push_back(book);
+    }
+
+    // fn(book) for every book queued so far, one drain at a time. Books
+    // queued meanwhile (fn's own refreshes included) wait for the next one.
+    template<typename Fn>
+    void drain(Fn&& fn) {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            draining_.swap(books_);
+        }
+        for (OrderBookBase* book : draining_) {
+            fn(book);
+        }
+        draining_.clear();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<OrderBookBase*> books_;
+    std::mutex drain_mutex_;
+    std::vector<OrderBookBase*> draining_;
+};
+
+} // namespace quasar
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Order.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace quasar {
+
+enum class CommandType : uint8_t {
+    NEW_ORDER,  // limit order
+    CANCEL,
+    HANDOFF     // move the symbol to another partition (see PartitionedEngine)
+};
+
+// One fixed-size record of the engine input log
+struct Command {
+    static constexpr size_t kMaxSymbolLength = 25;
+
+    uint64_t order_id{0};   // CANCEL
+    uint64_t client_id{0};
+    double price{0.0};
+    uint64_t quantity{0};
+    uint32_t partition{0};  // HANDOFF: the new owner
+    CommandType type{CommandType::NEW_ORDER};
+    uint8_t side{0};        // 0 buy, 1 sell
+    char symbol[kMaxSymbolLength + 1]{};
+
+    // A symbol longer than kMaxSymbolLength leaves the command without one,
+    // and CommandLog::append refuses it
+    static Command new_order(uint64_t client_id, const std::string& symbol, Side side, double price,
+                             uint64_t quantity);
+    static Command cancel(const std::string& symbol, uint64_t order_id);
+    static Command handoff(const std::string& symbol, uint32_t partition);
+
+    bool set_symbol(const std::string& name);
+    std::string get_symbol() const { return std::string(symbol); }
+    Side get_side() const { return side == 0 ? Side::BUY : Side::SELL; }
+};
+
+static_assert(sizeof(Command) == 64, "Command is a fixed 64-byte record");
+
+// File-backed, append-only command log: the local stand-in for a partitioned
+// topic. Records are appended whole with O_APPEND, so producers in several
+// processes can share one file, and each reader keeps its own offset (a
+// record index). A record still being written is not returned.
+class CommandLog {
+public:
+    explicit CommandLog(const std::string& path);
+    ~CommandLog();
+
+    CommandLog(const CommandLog&) = delete;
+    CommandLog& operator=(const CommandLog&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+
+    // False for a command without a symbol or a failed write; offset is the
+    // record's index
+    bool append(const Command& command, uint64_t* offset = nullptr);
+
+    // Copy up to max records from offset into out; returns how many
+    size_t read(uint64_t offset, Command* out, size_t max) const;
+
+    // Whole records in the file
+    uint64_t size() const;
+
+private:
+    std::string path_;
+    int fd_{-1};
+    std::mutex append_mutex_;
+};
+
+} // namespace quasar
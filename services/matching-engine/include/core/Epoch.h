@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace quasar {
+
+class EpochThreadRecords;
+
+// Epoch-based reclamation. Readers pin the current epoch for the length of
+// an EpochGuard and may then follow pointers into shared structures without
+// a lock. A writer that unlinks an object retires it instead of deleting it;
+// the object is freed once the global epoch is two past the epoch it was
+// retired in, which can only happen after every reader that might have seen
+// it has left. The epoch advances when every pinned reader has caught up
+// with it, so one reader parked in a guard holds back all reclamation.
+//
+// Each thread gets a record on first use (a lock-free list, records are
+// reused after their thread exits) holding its pin and what it has retired.
+// Entering and leaving a guard touch only the thread's own record. Retiring
+// while no reader is pinned frees the object at once; otherwise it is
+// appended to the record, and every kCollectEvery retires try to advance the
+// epoch and free what has become safe. What a thread leaves behind when it
+// exits is handed to the domain and freed by later collections.
+class EpochDomain {
+public:
+    static constexpr uint32_t kCollectEvery = 64;
+
+    EpochDomain();
+    // Frees everything still retired; no thread may be inside a guard
+    ~EpochDomain();
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // Shared by the order books (see BasicOrderBook::erase_order). Never
+    // destroyed, so books may retire into it during static destruction.
+    static EpochDomain& global();
+
+    // Guards nest; only the outermost pins the epoch
+    void enter();
+    void exit();
+
+    using Deleter = void (*)(void*);
+    void retire(void* object, Deleter deleter);
+    template<typename T>
+    void retire(T* object) {
+        retire(object, [](void* retired) { delete static_cast<T*>(retired); });
+    }
+
+    // Try to advance the epoch, then free what this thread retired (and what
+    // exited threads left) that is now safe; returns the objects freed
+    size_t collect();
+
+    // Wait until every reader inside a guard now has left, then free
+    // everything this thread has retired. False (and nothing waited for) if
+    // this thread is inside a guard itself.
+    bool synchronize();
+
+    // Whether every reader that was inside a guard at epoch since (a value
+    // of epoch()) has left, trying to advance the epoch to find out. For a
+    // writer reusing memory it unlinked at since, without waiting.
+    bool quiesced(uint64_t since);
+
+    uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+    // Retired while readers were pinned and not yet freed, over all threads
+    uint64_t pending() const {
+        return retired_.load(std::memory_order_relaxed) - freed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class EpochThreadRecords;
+
+    struct Retired {
+        void* object;
+        Deleter deleter;
+        uint64_t epoch;
+    };
+
+    struct alignas(64) Record {
+        std::atomic<uint64_t> pinned{0};  // epoch pinned by the thread; 0 outside guards
+        std::atomic<bool> claimed{false};
+        uint32_t depth{0};                // owner only from here on
+        uint32_t since_collect{0};
+        std::vector<Retired> retired;     // in retire order, so epochs never decrease
+        Record* next{nullptr};
+    };
+
+    Record* local();
+    Record* claim();
+    bool any_pinned() const;
+    bool try_advance();
+    size_t free_safe(std::vector<Retired>& list);
+    void release(Record* record);
+
+    std::atomic<uint64_t> epoch_{1};
+    std::atomic<Record*> records_{nullptr};
+    uint64_t serial_;
+
+    // Left behind by exited threads
+    std::mutex orphans_mutex_;
+    std::vector<Retired> orphans_;
+
+    std::atomic<uint64_t> retired_{0};
+    std::atomic<uint64_t> freed_{0};
+};
+
+// Pins the domain's epoch for its lifetime
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochDomain& domain = EpochDomain::global()) : domain_(domain) { domain_.enter(); }
+    ~EpochGuard() { domain_.exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+private:
+    EpochDomain& domain_;
+};
+
+} // namespace quasar
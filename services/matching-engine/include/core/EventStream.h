@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Order.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace quasar {
+
+enum class EngineEventType : uint8_t {
+    ACCEPTED,   // passed every check and went to its book
+    REJECTED,   // refused before reaching a book; detail is a RejectReason
+    RESTED,     // left open after its engine call: price and open quantity
+    FILL,       // one trade; order/client are the taker's, contra the maker's
+    CANCELLED,  // cancelled, or left without resting (market remainder, unpriceable peg)
+    EXPIRED,    // time in force ran out
+    BOOK_DELTA, // new displayed state of one price level (quantity 0: level gone)
+    OVERLOAD    // admission state changed; detail 1: shedding new orders, 0: accepting again
+};
+
+enum class RejectReason : uint8_t {
+    NONE,
+    EXPIRE_TIME,     // GTD/DAY expiry not after the engine clock
+    ORDER_QUANTITY,  // the RiskReject values, in order
+    ORDER_NOTIONAL,
+    PRICE_COLLAR,
+    OPEN_ORDERS,
+    INVALID_QUOTE,   // a mass quote entry (order_id 0)
+    SYSTEM_BUSY,     // the engine is overloaded (see MatchingEngine::set_admission_limits)
+    UNPRICED_PEG,    // the BookReject values, in order
+    INVALID_PRICE
+};
+
+// FILL detail bits
+constexpr uint8_t kTakerFilled = 1;
+constexpr uint8_t kMakerFilled = 2;
+
+// One record of the engine's event stream. Records are fixed size and carry
+// the symbol as the engine's symbol id (MatchingEngine::get_symbol_name).
+// A quote side moved in place (MatchingEngine::mass_quote) is ACCEPTED again
+// with its new price and open size. CANCELLED and EXPIRED carry no quantity:
+// what was open is the last ACCEPTED or RESTED quantity minus the FILLs since.
+struct EngineEvent {
+    uint64_t sequence{0};         // 1, 2, 3, ... across the whole engine
+    uint64_t order_id{0};
+    uint64_t client_id{0};
+    uint64_t contra_order_id{0};  // FILL: maker order
+    uint64_t contra_client_id{0}; // FILL: maker client
+    uint64_t trade_id{0};         // FILL: trade id; BOOK_DELTA: orders at the level
+    double price{0.0};            // OVERLOAD: recent matching latency in microseconds
+    uint64_t quantity{0};         // OVERLOAD: reported queue depth
+    uint32_t symbol_id{0};
+    Side side{Side::BUY};         // FILL: the taker's side; BOOK_DELTA: the book side
+    OrderType order_type{OrderType::LIMIT};
+    EngineEventType type{EngineEventType::ACCEPTED};
+    uint8_t detail{0};            // REJECTED: RejectReason; FILL: kTakerFilled | kMakerFilled; OVERLOAD: 1 or 0
+};
+
+static_assert(sizeof(EngineEvent) == 80, "EngineEvent is a fixed 80-byte record");
+
+// Fan-out of the engine's events. Each engine call publishes its events as
+// one span: they get the next sequence numbers and reach every subscriber
+// before the next span, under one lock. Subscribers are dispatched through a
+// function pointer made for their type (no std::function), so a span costs
+// one indirect call per subscriber. A subscriber runs on the publishing
+// thread with that lock held and must not call back into the engine; a
+// consumer on its own thread reads through an EventRing instead.
+class EventStream {
+public:
+    // Sink needs on_events(const EngineEvent* events, size_t count)
+    template<typename Sink>
+    void subscribe(Sink& sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.push_back(Subscriber{&sink, [](void* self, const EngineEvent* events, size_t count) {
+            static_cast<Sink*>(self)->on_events(events, count);
+        }});
+        active_.store(true, std::memory_order_release);
+    }
+
+    void unsubscribe(const void* sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                          [sink](const Subscriber& s) { return s.self == sink; }),
+                           subscribers_.end());
+        active_.store(!subscribers_.empty(), std::memory_order_release);
+    }
+
+    // Whether anyone listens; publishers skip building events otherwise
+    bool active() const { return active_.load(std::memory_order_acquire); }
+
+    // Stamp sequence numbers on the span and deliver it
+    void publish(EngineEvent* events, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            events[i].sequence = ++last_sequence_;
+        }
+        for (const Subscriber& subscriber : subscribers_) {
+            subscriber.deliver(subscriber.self, events, count);
+        }
+    }
+
+    uint64_t last_sequence() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_sequence_;
+    }
+
+private:
+    struct Subscriber {
+        void* self;
+        void (*deliver)(void*, const EngineEvent*, size_t);
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Subscriber> subscribers_;
+    uint64_t last_sequence_{0};
+    std::atomic<bool> active_{false};
+};
+
+// Single-producer single-consumer ring of events, itself a sink: the stream
+// (one publisher at a time) writes, one consumer thread polls. A full ring
+// drops what does not fit rather than stall the engine; the consumer sees
+// the loss as a jump in sequence numbers.
+class EventRing {
+public:
+    // capacity is rounded up to a power of two
+    explicit EventRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    void on_events(const EngineEvent* events, size_t count) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t free = slots_.size() - (head - tail_.load(std::memory_order_acquire));
+        size_t accepted = static_cast<size_t>(std::min<uint64_t>(count, free));
+        for (size_t i = 0; i < accepted; ++i) {
+            slots_[(head + i) & mask_] = events[i];
+        }
+        head_.store(head + accepted, std::memory_order_release);
+        if (accepted < count) {
+            dropped_.fetch_add(count - accepted, std::memory_order_relaxed);
+        }
+    }
+
+    // Copy up to max events into out; returns how many
+    size_t poll(EngineEvent* out, size_t max) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t available = head_.load(std::memory_order_acquire) - tail;
+        size_t count = static_cast<size_t>(std::min<uint64_t>(available, max));
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = slots_[(tail + i) & mask_];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t capacity() const { return slots_.size(); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<EngineEvent> slots_;
+    uint64_t mask_{0};
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Consumer-side check of sequence continuity
+class SequenceGapDetector {
+public:
+    // Returns false when events were missed before this one
+    bool check(const EngineEvent& event) {
+        bool in_order = event.sequence == expected_;
+        if (!in_order && event.sequence > expected_) {
+            gaps_++;
+            missed_ += event.sequence - expected_;
+        }
+        expected_ = event.sequence + 1;
+        return in_order;
+    }
+
+    uint64_t expected() const { return expected_; }
+    uint64_t gaps() const { return gaps_; }
+    uint64_t missed() const { return missed_; }
+
+private:
+    uint64_t expected_{1};
+    uint64_t gaps_{0};
+    uint64_t missed_{0};
+};
+
+} // namespace quasar
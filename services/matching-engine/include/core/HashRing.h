@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace quasar {
+
+// Consistent hashing of symbols onto engine partitions. Each partition puts
+// virtual_nodes points on a 64-bit ring and a symbol belongs to the first
+// point at or after its hash, so adding or removing one of K partitions only
+// moves about 1/K of the symbols, all of them to or from that partition.
+// Explicit assignments (symbols a controller has migrated) take precedence
+// over the ring.
+class HashRing {
+public:
+    explicit HashRing(uint32_t partitions = 1, uint32_t virtual_nodes = 64)
+        : virtual_nodes_(virtual_nodes == 0 ? 1 : virtual_nodes) {
+        for (uint32_t partition = 0; partition < partitions; ++partition) {
+            add_partition(partition);
+        }
+    }
+
+    void add_partition(uint32_t partition) {
+        if (has_partition(partition)) {
+            return;
+        }
+        for (uint32_t node = 0; node < virtual_nodes_; ++node) {
+            points_.emplace_back(mix((uint64_t{partition} << 32) | node), partition);
+        }
+        std::sort(points_.begin(), points_.end());
+    }
+
+    void remove_partition(uint32_t partition) {
+        points_.erase(std::remove_if(points_.begin(), points_.end(),
+                                     [partition](const auto& point) { return point.second == partition; }),
+                      points_.end());
+    }
+
+    bool has_partition(uint32_t partition) const {
+        return std::any_of(points_.begin(), points_.end(),
+                           [partition](const auto& point) { return point.second == partition; });
+    }
+
+    size_t partition_count() const { return points_.size() / virtual_nodes_; }
+
+    // Owner by the ring alone: O(log(K * virtual_nodes)); 0 on an empty ring
+    uint32_t ring_partition(const std::string& symbol) const {
+        if (points_.empty()) {
+            return 0;
+        }
+        auto it = std::lower_bound(points_.begin(), points_.end(), std::make_pair(hash(symbol), uint32_t{0}));
+        return it == points_.end() ? points_.front().second : it->second;
+    }
+
+    uint32_t partition_of(const std::string& symbol) const {
+        auto it = assignments_.find(symbol);
+        return it != assignments_.end() ? it->second : ring_partition(symbol);
+    }
+
+    void assign(const std::string& symbol, uint32_t partition) { assignments_[symbol] = partition; }
+    size_t assignments() const { return assignments_.size(); }
+
+    // FNV-1a, finished with a 64-bit mixer so that similar symbols spread
+    static uint64_t hash(const std::string& symbol) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : symbol) {
+            h = (h ^ c) * 0x100000001b3ULL;
+        }
+        return mix(h);
+    }
+
+private:
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint32_t virtual_nodes_;
+    std::vector<std::pair<uint64_t, uint32_t>> points_;  // (point, partition), sorted
+    std::unordered_map<std::string, uint32_t> assignments_;
+};
+
+} // namespace quasar
@@ -3,6 +3,12 @@
 #include "OrderBook.h"
 #include "Order.h"
 #include "Trade.h"
+#include "NodePool.h"
+#include "TimingWheel.h"
+#include "RiskCheck.h"
+#include "EventStream.h"
+#include "OrderId.h"
+#include "AdmissionControl.h"
 #include <unordered_map>
 #include <memory>
 #include <mutex>
@@ -13,25 +19,171 @@ namespace quasar {
 
 class MatchingEngine {
 public:
-    MatchingEngine();
+    // shard (below kMaxShards) goes into every order id this engine hands
+    // out, so engines running side by side never issue the same id
+    explicit MatchingEngine(BookType default_book_type = BookType::INTRUSIVE, uint32_t shard = 0);
     ~MatchingEngine() = default;
 
-    // Order management
+    uint32_t get_shard() const { return shard_; }
+
+    // Book implementation and matching algorithm selection. A symbol's type
+    // must be chosen before its book is created (i.e. before its first
+    // order); returns false otherwise, or for pro-rata on a heap book.
+    bool set_book_type(const std::string& symbol, BookType type,
+                       const BookConfig& config = BookConfig());
+    BookType get_book_type(const std::string& symbol) const;
+
+    // Order management. Every submit returns the new order's id, or 0 if the
+    // order is rejected (an expiry not in the future, a risk limit, a new
+    // symbol past kMaxSymbolId, or a BookReject from its book). Ids encode shard, symbol and a per-book
+    // sequence (see OrderId.h).
     uint64_t submit_order(uint64_t client_id, const std::string& symbol,
                          Side side, double price, uint64_t quantity);
 
+    // Limit order with a time in force. GTD orders expire at expire_time and
+    // DAY orders at the session close, both on the engine clock (see
+    // advance_time). Rejected if that time is not in the future.
+    uint64_t submit_order(uint64_t client_id, const std::string& symbol, Side side, double price,
+                          uint64_t quantity, TimeInForce time_in_force, uint64_t expire_time = 0);
+
+    // Stop (type STOP, released as a market order) or stop-limit (STOP_LIMIT,
+    // released as a limit order at limit_price) order. It is held off the
+    // book until a trade in the symbol prints at or through stop_price.
+    uint64_t submit_stop_order(uint64_t client_id, const std::string& symbol, Side side,
+                               OrderType type, double stop_price, double limit_price, uint64_t quantity);
+
+    // Iceberg limit order: only display_quantity is shown at a time. When the
+    // shown slice fills, the next one is taken from the hidden reserve and the
+    // same order re-queues behind its price level.
+    uint64_t submit_iceberg_order(uint64_t client_id, const std::string& symbol, Side side,
+                                  double price, uint64_t quantity, uint64_t display_quantity);
+
+    // Pegged order (type PEG_PRIMARY or PEG_MIDPOINT). It is not displayed and
+    // its price follows the symbol's displayed BBO, offset passively by
+    // peg_offset. Rejected with UNPRICED_PEG if its reference is missing, in
+    // an auction, or on a pro-rata book.
+    uint64_t submit_peg_order(uint64_t client_id, const std::string& symbol, Side side,
+                              OrderType type, double peg_offset, uint64_t quantity);
+
+    // Routed by the book encoded in the id; no symbol lookup
     bool cancel_order(uint64_t order_id);
 
+    // Pre-trade risk, checked on every order before it reaches its book:
+    // order size, notional, a price collar around the book's reference price
+    // (see OrderBookBase::get_reference_price) and the client's open order
+    // count. Client limits override the defaults; zero limits are off (the
+    // default). Rejects count in EngineStats::rejected_orders.
+    void set_risk_limits(const RiskLimits& limits);
+    void set_client_risk_limits(uint64_t client_id, const RiskLimits& limits);
+
+    // Load shedding. Past either limit the engine is overloaded: new orders
+    // are rejected with SYSTEM_BUSY before they reach a book or take an
+    // order id (counted in rejected_orders and busy_rejects) until the signals fall back under resume_ratio of their
+    // limits. Cancels and mass quotes are always taken, so participants can
+    // still pull or reprice what they have resting. Each change of state is
+    // published as an OVERLOAD event. Zero limits (the default) are off.
+    void set_admission_limits(const AdmissionLimits& limits);
+    // Depth of the queue in front of the engine, from the stage that feeds
+    // it; a no-op without admission limits
+    void report_queue_depth(uint64_t depth);
+    bool is_overloaded() const { return admission_.overloaded(); }
+
+    // Orders of the client entered and not yet filled, cancelled or expired
+    uint32_t get_open_order_count(uint64_t client_id) const;
+
+    // Two-sided quote of a market maker in one symbol. A side with quantity 0
+    // is pulled; a quoted side needs a positive price and the bid must be
+    // below the ask.
+    struct QuoteEntry {
+        std::string symbol;
+        double bid_price{0.0};
+        uint64_t bid_quantity{0};
+        double ask_price{0.0};
+        uint64_t ask_quantity{0};
+    };
+
+    // The one acknowledgement of a mass quote
+    struct MassQuoteAck {
+        uint64_t quote_id{0};
+        uint32_t entries{0};
+        uint32_t rejected_entries{0};
+        uint32_t sides_resized{0};    // same price, smaller size: priority kept
+        uint32_t sides_reentered{0};  // new price or larger size: re-queued in place
+        uint32_t sides_entered{0};    // no live quote order to reuse: new order
+        uint32_t sides_pulled{0};
+        uint32_t trades{0};
+    };
+
+    // Replace the client's bid and ask in every listed symbol. Each client
+    // has one bid and one ask order slot per symbol, and a new quote updates
+    // those orders in place (see OrderBookBase::replace_order) instead of
+    // cancelling them and entering new ones, so ids survive re-quotes and a
+    // size cut at the same price keeps its queue position. A slot whose order
+    // has filled, or that the book cannot move in place, gets a new order.
+    // Entries are applied in order; a rejected entry leaves its symbol as is.
+    // Each quoted side is held to the client's size, notional and collar
+    // limits (one failing side rejects the entry), and a new quote order to
+    // the open order limit; a side refused that way is left without an order.
+    MassQuoteAck mass_quote(uint64_t client_id, uint64_t quote_id, const std::vector<QuoteEntry>& quotes);
+
+    // Call auction for a symbol (opening/closing auctions, or frequent batch
+    // auctions by uncrossing with continue_auction at each interval). While
+    // in auction, orders accumulate without matching; see OrderBookBase.
+    void start_auction(const std::string& symbol);
+    AuctionResult get_indicative_auction(const std::string& symbol) const;
+    AuctionResult uncross(const std::string& symbol, bool continue_auction = false);
+
+    // Engine clock, in microseconds. It only moves through advance_time,
+    // which expires every GTD/DAY order due by now_us and returns how many.
+    // Orders are expired tick by tick (kExpiryTickMicros): all orders due on
+    // one tick leave each book in one batch, and every price level they
+    // leave gets a single level update.
+    static constexpr uint64_t kExpiryTickMicros = 1000;
+    size_t advance_time(uint64_t now_us);
+    uint64_t get_time() const;
+
+    // Session close time on the engine clock, applied to DAY orders
+    void set_session_close(uint64_t close_time_us);
+
+    // Read replicas for market data. With views on, every book (existing and
+    // new) publishes its top depth levels per side, BBO, volumes and last
+    // trade at the end of each call that changes it (BookView.h), and the
+    // queries below read that view without the book's lock: a query may be
+    // a few changes behind a book being matched, never torn. Level queries
+    // deeper than depth still go to the book. Heap books get no view (their
+    // level walk sorts every order) and are always queried under their lock.
+    // Views stay on once set; set_book_views fails for depth 0 or when they
+    // are already on.
+    // refresh_book_views publishes what readers held back and returns the
+    // books whose view is still behind; it only visits the books a reader
+    // held back (queued as it happened), and a matching thread calls it
+    // between batches.
+    bool set_book_views(size_t depth);
+    size_t get_book_view_depth() const { return view_depth_.load(std::memory_order_acquire); }
+    size_t refresh_book_views();
+
     double get_best_bid(const std::string& symbol) const;
     double get_best_ask(const std::string& symbol) const;
     double get_spread(const std::string& symbol) const;
 
-    std::vector<OrderBook::BookLevel> get_bid_levels(const std::string& symbol,
+    std::vector<BookLevel> get_bid_levels(const std::string& symbol,
                                                     size_t max_levels = 10) const;
 
-    std::vector<OrderBook::BookLevel> get_ask_levels(const std::string& symbol,
+    std::vector<BookLevel> get_ask_levels(const std::string& symbol,
                                                     size_t max_levels = 10) const;
 
+    uint64_t get_bid_volume(const std::string& symbol) const;
+    uint64_t get_ask_volume(const std::string& symbol) const;
+    double get_last_trade_price(const std::string& symbol) const;
+
+    // Queue position of a resting order, and depth and sweep cost of one side
+    // of a symbol's book, in O(log n) from the book's queue index (enabled by
+    // BookConfig::queue_index in set_book_type). False without an index or
+    // for an order that is not resting displayed; see OrderBookBase.
+    bool queue_position(uint64_t order_id, QueuePosition& position) const;
+    bool depth_to_price(const std::string& symbol, Side side, double price, uint64_t& quantity) const;
+    bool cost_to_fill(const std::string& symbol, Side side, uint64_t quantity, FillEstimate& estimate) const;
+
     std::vector<Trade> get_trades(const std::string& symbol, size_t num_trades) const;
 
     std::vector<Order> get_open_orders(const std::string& symbol) const;
@@ -43,41 +195,182 @@ public:
         uint64_t total_trades{0};
         uint64_t cancelled_orders{0};
         uint64_t rejected_orders{0};
+        uint64_t expired_orders{0};
+        uint64_t busy_rejects{0};         // new orders shed while overloaded
+        uint64_t overload_episodes{0};
+        // Admission signals as of the call
+        bool overloaded{false};
+        uint64_t queue_depth{0};
+        uint64_t matching_latency_ns{0};  // moving average; 0 without a latency limit
     };
 
     EngineStats get_stats() const;
 
+    // Container sizes, summed over all books. A steady workload should hold
+    // these flat; growth points at a leak or at tombstones piling up.
+    struct StorageStats {
+        size_t books{0};
+        size_t order_map_entries{0};
+        size_t order_map_buckets{0};
+        size_t order_map_pool_chunks{0};
+        BookStorageStats book_totals;
+    };
+
+    StorageStats get_storage_stats() const;
+
+    // Engine event stream: acceptances and rejections, fills, orders left
+    // resting, cancels, expiries and displayed level changes, as globally
+    // sequenced fixed-size records (see EventStream). Each engine call
+    // publishes its events as one span, and a book's spans are published in
+    // the order its calls ran, even from several threads: a FILL comes after
+    // the ACCEPTED of both its orders. Trade callbacks run after the span is
+    // published. A Sink has on_events(const
+    // EngineEvent*, size_t); it runs on the calling thread and must not call
+    // back into the engine. Events are only built while someone subscribes.
+    template<typename Sink>
+    void subscribe_events(Sink& sink) {
+        events_.subscribe(sink);
+        set_level_tracking(true);
+    }
+    void unsubscribe_events(const void* sink);
+    uint64_t get_last_event_sequence() const;
+
+    // Symbol of an event's symbol_id ("" for 0, a symbol without a book)
+    std::string get_symbol_name(uint32_t symbol_id) const;
+
     // Callbacks for trade notifications
     using TradeCallback = std::function<void(const Trade&)>;
     void set_trade_callback(TradeCallback callback);
 
+    // Level updates for batch changes (currently expiry), one per level per batch
+    using LevelUpdateCallback = std::function<void(const std::string& symbol, const LevelUpdate&)>;
+    void set_level_update_callback(LevelUpdateCallback callback);
+
     // Get all symbols
     std::vector<std::string> get_all_symbols() const;
 
+    // One cache warming pass for an idle matching thread, with no effect a
+    // client can see. It reads the BBO, top levels and a dry-run sweep of
+    // each side in up to max_books books (round robin across calls), matches
+    // synthetic orders in a private shadow book of the default type, and
+    // encodes their events into scratch buffers that are then dropped. No
+    // order ids, stats, events or callbacks come out of it.
+    void warm(size_t max_books = 8);
+    uint64_t get_warm_passes() const { return warm_passes_.load(std::memory_order_relaxed); }
+
+    // Symbol handover between engines (see PartitionedEngine). snapshot_symbol
+    // copies the symbol's book and leaves it as it is. hand_off_symbol
+    // snapshots the symbol's book and takes its orders out of this engine:
+    // they are neither cancelled nor counted, the book stays (empty) and
+    // subscribers only see its levels go. adopt_symbol rebuilds the snapshot
+    // here with its order ids, so cancels for orders entered on the old
+    // engine route to this one, and new orders continue its id sequence.
+    // adopt_symbol fails if the symbol's book here holds orders or has
+    // another type.
+    bool snapshot_symbol(const std::string& symbol, BookSnapshot& snapshot);
+    bool hand_off_symbol(const std::string& symbol, BookSnapshot& snapshot);
+    bool adopt_symbol(const BookSnapshot& snapshot);
+
 private:
     // Order books by symbol
     mutable std::mutex order_books_mutex_;
-    std::unordered_map<std::string, std::unique_ptr<OrderBook>> order_books_;
+    std::unordered_map<std::string, std::unique_ptr<OrderBookBase>> order_books_;
+
+    // Symbols by symbol id - 1, in order of book creation, and books by
+    // symbol id for routing an order id without a lock
+    std::vector<std::string> symbol_names_;
+    SymbolDirectory<OrderBookBase> books_by_id_;
+    uint32_t shard_;
+
+    // Adopted books issuing ids of another shard, by the id's shard and
+    // symbol bits (under order_books_mutex_)
+    std::unordered_map<uint64_t, OrderBookBase*> adopted_routes_;
 
-    // Order ID to symbol mapping for cancellations
+    // Depth of the books' read replicas (0: off), and the books whose view
+    // a reader held back
+    std::atomic<size_t> view_depth_{0};
+    ViewBacklog view_backlog_;
+
+    // Book type selection for books not yet created
+    BookType default_book_type_;
+    std::unordered_map<std::string, std::pair<BookType, BookConfig>> book_types_;
+
+    // Owning client of every resting order, for the client's open order
+    // count. Routing needs no map: the book is in the order id.
+    using OpenOrderMap = std::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                            PoolAllocator<std::pair<const uint64_t, uint64_t>>>;
     mutable std::mutex order_map_mutex_;
-    std::unordered_map<uint64_t, std::string> order_to_symbol_;
+    NodePool order_map_pool_;
+    OpenOrderMap open_orders_;
 
-    // Order ID generator
-    std::atomic<uint64_t> next_order_id_{1};
+    // Per-client risk state. Open orders come and go with open_orders_, so
+    // it shares the order map lock.
+    RiskTable risk_;
+    std::atomic<bool> risk_uses_reference_{false};
 
     // Statistics
     mutable std::mutex stats_mutex_;
     EngineStats stats_;
 
+    // Overload detection for set_admission_limits
+    AdmissionControl admission_;
+
+    // Idle warming (see warm()): the shadow book and where the next pass
+    // starts among the real books
+    std::mutex warm_mutex_;
+    std::unique_ptr<OrderBookBase> warm_book_;
+    size_t warm_cursor_{0};
+    std::atomic<uint64_t> warm_passes_{0};
+
+    // Event stream subscribers and sequencing
+    EventStream events_;
+
     // Trade callback
     std::mutex callback_mutex_;
     TradeCallback trade_callback_;
+    LevelUpdateCallback level_update_callback_;
+
+    // Engine clock and GTD/DAY expiry schedule by deadline tick. Books are
+    // never destroyed while the engine lives, so entries hold the book directly.
+    struct ScheduledExpiry {
+        OrderBookBase* book;
+        uint64_t order_id;
+    };
+    mutable std::mutex expiry_mutex_;
+    uint64_t now_us_{0};
+    uint64_t session_close_us_{0};
+    TimingWheel<ScheduledExpiry> expiry_wheel_;
+
+    // Quote order ids by client and symbol (0: none). An id may name an
+    // order that has since filled; the book then rejects the replacement.
+    struct QuoteSlot {
+        uint64_t bid_order_id{0};
+        uint64_t ask_order_id{0};
+    };
+    std::mutex quotes_mutex_;
+    std::unordered_map<uint64_t, std::unordered_map<std::string, QuoteSlot>> quote_slots_;
 
     // Helper methods
-    OrderBook* get_or_create_book(const std::string& symbol);
+    OrderBookBase* get_or_create_book(const std::string& symbol);
+    OrderBookBase* book_of(uint64_t order_id) const;
+    OrderBookBase* find_book(const std::string& symbol) const;
+    uint64_t submit(std::unique_ptr<Order> order);
+    uint64_t enter_order(std::unique_ptr<Order> order, bool admit, size_t* trade_count = nullptr);
+    void publish_overload();
+    void settle(OrderBookBase* book, const std::vector<Trade>& trades, const std::vector<uint64_t>& expired_ids,
+                std::vector<EngineEvent>* events = nullptr);
+    void report_trades(const std::vector<Trade>& trades);
+    bool forget_order(uint64_t order_id, uint64_t* client_id = nullptr);
+    RiskReject quote_within_limits(uint64_t client_id, const OrderBookBase* book, const QuoteEntry& quote);
+    void set_level_tracking(bool on);
+    void append_rested(OrderBookBase* book, uint64_t order_id, std::vector<EngineEvent>& events);
+    void append_level_changes(OrderBookBase* book, std::vector<EngineEvent>& events);
+    void publish_reject(uint64_t order_id, uint64_t client_id, uint32_t symbol_id, RejectReason reason);
+    uint64_t requote_side(uint64_t client_id, OrderBookBase* book, Side side, uint64_t order_id,
+                          double price, uint64_t quantity, MassQuoteAck& ack);
     void notify_trade(const Trade& trade);
-    void update_stats_for_trade(const Trade& trade, OrderBook* book);
+    void update_stats_for_trade(const Trade& trade);
+    void expire_batch(const ScheduledExpiry* due, size_t count);
 };
 
 } // namespace quasar
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace quasar {
+
+// Free-list arena for fixed-size blocks. Blocks are carved from large chunks
+// and recycled on release, so once a container has reached its high-water
+// mark, inserting and erasing nodes never reaches malloc. Not thread safe:
+// each pool is guarded by the lock of the structure that owns it.
+class NodePool {
+public:
+    explicit NodePool(size_t blocks_per_chunk = 1024);
+    ~NodePool();
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr, size_t size);
+
+    // Number of chunks obtained from the system allocator so far
+    size_t chunk_count() const { return chunks_.size(); }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SizeClass {
+        size_t block_size;
+        FreeBlock* free_list;
+    };
+
+    static size_t round_up(size_t size);
+    SizeClass& size_class(size_t block_size);
+    void grow(SizeClass& size_class);
+
+    size_t blocks_per_chunk_;
+    std::vector<SizeClass> size_classes_;
+    std::vector<void*> chunks_;
+};
+
+// Standard allocator adapter over a NodePool. Single-object requests (tree,
+// list and hash nodes) come from the pool; arrays such as hash bucket tables
+// fall through to the system allocator.
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(NodePool& pool) noexcept : pool_(&pool) {}
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool()) {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(pool_->allocate(sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n == 1) {
+            pool_->deallocate(ptr, sizeof(T));
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+
+    NodePool* pool() const noexcept { return pool_; }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return pool_ == other.pool(); }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept { return pool_ != other.pool(); }
+
+private:
+    NodePool* pool_;
+};
+
+} // namespace quasar
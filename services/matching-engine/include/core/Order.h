@@ -7,6 +7,8 @@
 
 namespace quasar {
 
+struct PriceLevel;
+
 enum class Side {
     BUY,
     SELL
@@ -14,7 +16,17 @@ enum class Side {
 
 enum class OrderType {
     LIMIT,
-    MARKET
+    MARKET,
+    STOP,       // Becomes MARKET when triggered
+    STOP_LIMIT, // Becomes LIMIT at price when triggered
+    PEG_PRIMARY,  // Non-displayed, priced at the same-side best bid/ask
+    PEG_MIDPOINT  // Non-displayed, priced at the bid/ask midpoint
+};
+
+enum class TimeInForce {
+    GTC, // Good till cancelled
+    DAY, // Expires at the engine's session close
+    GTD  // Expires at expire_time
 };
 
 enum class OrderStatus {
@@ -35,15 +47,34 @@ struct Order {
     Side side{Side::BUY};
     OrderType type{OrderType::LIMIT};
     double price{0.0};
+    double stop_price{0.0}; // Trigger price for STOP / STOP_LIMIT
+    double peg_offset{0.0}; // Passive distance from the peg reference (>= 0)
     uint64_t quantity{0};
     uint64_t filled_quantity{0};
 
+    // Iceberg: peak size shown at a time (0 = fully displayed) and what is
+    // left of the slice currently shown; the rest is hidden reserve
+    uint64_t display_quantity{0};
+    uint64_t shown_quantity{0};
+
+    // Time in force; expire_time is on the engine clock (microseconds)
+    TimeInForce time_in_force{TimeInForce::GTC};
+    uint64_t expire_time{0};
+
     // Status and timestamps
     OrderStatus status{OrderStatus::NEW};
     std::chrono::system_clock::time_point created_time;
     std::chrono::system_clock::time_point updated_time;
     uint64_t timestamp{0}; // Microseconds since epoch for performance
 
+    // Intrusive level links, owned by level-based book policies
+    Order* prev_in_level{nullptr};
+    Order* next_in_level{nullptr};
+    PriceLevel* level{nullptr};
+
+    // Slot in its level's queue index (see QueueIndex.h), when the book keeps one
+    uint32_t queue_slot{0};
+
     // Constructor
     Order() = default;
 
@@ -58,11 +89,30 @@ struct Order {
             created_time.time_since_epoch()).count();    
     }
 
+    // Orders are recycled through per-thread pools instead of malloc; one
+    // released on another thread goes back to the pool it came from
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size) noexcept;
+
     // Helper methods
     uint64_t remaining_quantity() const {
         return quantity - filled_quantity;
     }
 
+    bool is_iceberg() const {
+        return display_quantity != 0;
+    }
+
+    // Quantity visible in the book (and available to the next match)
+    uint64_t displayed_quantity() const {
+        return is_iceberg() ? shown_quantity : remaining_quantity();
+    }
+
+    // Show the next iceberg slice from the reserve
+    void show_next_slice() {
+        shown_quantity = remaining_quantity() < display_quantity ? remaining_quantity() : display_quantity;
+    }
+
     bool is_filled() const {
         return filled_quantity >= quantity;
     }
@@ -75,6 +125,29 @@ struct Order {
         return side == Side::SELL;
     }
 
+    bool is_active() const {
+        return status == OrderStatus::NEW || status == OrderStatus::PARTIALLY_FILLED;
+    }
+
+    // A stop that has not been triggered yet (held off the book)
+    bool is_pending_stop() const {
+        return type == OrderType::STOP || type == OrderType::STOP_LIMIT;
+    }
+
+    // Pegged orders rest in peg groups; their price follows the BBO
+    bool is_pegged() const {
+        return type == OrderType::PEG_PRIMARY || type == OrderType::PEG_MIDPOINT;
+    }
+
+    // A buy stop triggers when the last trade is at or above its stop price,
+    // a sell stop when it is at or below
+    bool stop_triggered_by(double last_trade_price) const {
+        return is_buy() ? last_trade_price >= stop_price : last_trade_price <= stop_price;
+    }
+
+    // Release a triggered stop as the order it carries (STOP -> MARKET, STOP_LIMIT -> LIMIT)
+    void trigger();
+
     void fill(uint64_t fill_quantity);
 
     void cancel();
@@ -120,6 +193,7 @@ struct SellOrderComparator {
 std::string to_string(Side side);
 std::string to_string(OrderType type);
 std::string to_string(OrderStatus status);
+std::string to_string(TimeInForce time_in_force);
 
 // Stream output operators
 std::ostream& operator<<(std::ostream& os, const Order& order);
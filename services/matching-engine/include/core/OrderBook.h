@@ -2,73 +2,416 @@
 
 #include "Order.h"
 #include "Trade.h"
-#include <queue>
+#include "BookPolicies.h"
+#include "StopBook.h"
+#include "PegBook.h"
+#include "Auction.h"
+#include "QueueIndex.h"
+#include "BookView.h"
+#include <atomic>
 #include <unordered_map>
 #include <memory>
 #include <vector>
 #include <mutex>
-#include <map>
-#include <list>
+#include <string>
 
 namespace quasar {
 
-class OrderBook {
+std::string to_string(BookType type);
+bool parse_book_type(const std::string& name, BookType& type);
+std::string to_string(MatchingAlgorithm algorithm);
+bool parse_matching_algorithm(const std::string& name, MatchingAlgorithm& algorithm);
+
+// Sizes of a book's internal containers, for watching growth over long runs
+struct BookStorageStats {
+    size_t indexed_orders{0};   // entries in the order index (resting + not yet released)
+    size_t index_buckets{0};    // bucket count of the order index
+    size_t side_entries{0};     // entries() summed over both sides
+    size_t pool_chunks{0};      // node pool chunks obtained from the system allocator
+    size_t pending_stops{0};    // untriggered stop orders
+    size_t pegged_orders{0};    // resting pegged orders (not on the sides)
+};
+
+// New state of one price level after a batch change (quantity 0: level gone)
+struct LevelUpdate {
+    Side side;
+    double price;
+    uint64_t quantity;
+    uint32_t order_count;
+};
+
+// Distinct (side, price) keys touched by a batch. Open addressing over a
+// table that only grows; clear() resets just the slots in use, so a batch
+// costs O(its size) however large an earlier one was.
+class TouchedLevels {
+public:
+    void insert(Side side, double price) {
+        if ((keys_.size() + 1) * 2 > table_.size()) {
+            grow();
+        }
+        size_t mask = table_.size() - 1;
+        for (size_t slot = hash(side, price) & mask;; slot = (slot + 1) & mask) {
+            uint32_t index = table_[slot];
+            if (index == 0) {
+                keys_.emplace_back(side, price);
+                table_[slot] = static_cast<uint32_t>(keys_.size());
+                return;
+            }
+            const auto& key = keys_[index - 1];
+            if (key.first == side && key.second == price) {
+                return;
+            }
+        }
+    }
+
+    const std::vector<std::pair<Side, double>>& keys() const { return keys_; }
+
+    void clear() {
+        size_t mask = table_.size() - 1;
+        for (const auto& [side, price] : keys_) {
+            size_t slot = hash(side, price) & mask;
+            while (table_[slot] == 0 || keys_[table_[slot] - 1] != std::make_pair(side, price)) {
+                slot = (slot + 1) & mask;
+            }
+            table_[slot] = 0;
+        }
+        keys_.clear();
+    }
+
+private:
+    static size_t hash(Side side, double price) {
+        uint64_t bits = std::hash<double>()(price) ^ (side == Side::BUY ? 0 : 0x9e3779b97f4a7c15ULL);
+        return static_cast<size_t>((bits * 0xff51afd7ed558ccdULL) >> 17);
+    }
+
+    void grow() {
+        table_.assign(table_.empty() ? 64 : table_.size() * 2, 0);
+        size_t mask = table_.size() - 1;
+        for (size_t i = 0; i < keys_.size(); ++i) {
+            size_t slot = hash(keys_[i].first, keys_[i].second) & mask;
+            while (table_[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            table_[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    std::vector<uint32_t> table_; // index + 1 into keys_, 0 = empty
+    std::vector<std::pair<Side, double>> keys_;
+};
+
+// Why a book turned an incoming order away (process_order). A rejected order
+// never entered the book: nothing rested, traded or was reported as expired.
+enum class BookReject {
+    NONE,
+    UNPRICED_PEG,  // a peg without a reference price, in an auction or on a pro-rata book
+    INVALID_PRICE  // a limit price off the tick grid or outside the band (BookConfig::max_band_ticks)
+};
+
+// Outcome of replacing a resting order in place
+enum class ReplaceResult {
+    REJECTED,   // not resting, or not movable in place: cancel and enter a new order
+    RESIZED,    // same price, size reduced: priority kept
+    REENTERED   // new price or larger size: matched and re-queued as if new
+};
+
+// Everything a book holds, for handing its symbol over to another engine
+// (MatchingEngine::hand_off_symbol / adopt_symbol)
+struct BookSnapshot {
+    std::string symbol;
+    BookType type{BookType::INTRUSIVE};
+    BookConfig config;
+    uint64_t order_id_base{0};       // the book issues base | sequence (OrderId.h)
+    uint64_t next_order_sequence{1};
+    uint64_t next_trade_id{1};
+    double last_trade_price{0.0};
+    bool in_auction{false};
+    // Bids then asks, each best price first and in time priority within a
+    // price; then pegs by group in arrival order; then pending stops. Level
+    // links are cleared; icebergs keep the slice they show.
+    std::vector<Order> orders;
+};
+
+// Common interface shared by every book implementation
+class OrderBookBase {
 public:
-    OrderBook(const std::string& symbol, bool use_map__implementation = false);
-    ~OrderBook() = default;
+    using BookLevel = quasar::BookLevel;
+
+    explicit OrderBookBase(const std::string& symbol) : symbol_(symbol) {}
+    virtual ~OrderBookBase() = default;
 
     // Add a new order to the book
-    void add_order(std::unique_ptr<Order> order);
+    virtual void add_order(std::unique_ptr<Order> order) = 0;
 
     // Cancel an existing order
-    bool cancel_order(uint64_t order_id);
+    virtual bool cancel_order(uint64_t order_id) = 0;
+
+    // Process incoming order, appending generated trades to `trades`. Callers
+    // that reuse the vector avoid allocating on every order. STOP and
+    // STOP_LIMIT orders are held until a trade prints at or through their stop
+    // price; the trades of stops triggered by this order follow its own.
+    // Pegged orders take their price from the displayed BBO on arrival and
+    // rest in peg groups. A peg without a reference price, or a limit price
+    // the book cannot hold, is rejected (see BookReject). Orders that leave
+    // without filling or resting (the unfilled remainder of a market order)
+    // are appended to expired_ids when it is given.
+    virtual BookReject process_order(std::unique_ptr<Order> order, std::vector<Trade>& trades,
+                                     std::vector<uint64_t>* expired_ids) = 0;
+
+    BookReject process_order(std::unique_ptr<Order> order, std::vector<Trade>& trades) {
+        return process_order(std::move(order), trades, nullptr);
+    }
 
     // Process incoming order and return generated trades
     std::vector<Trade> process_order(std::unique_ptr<Order> order);
 
-    // Get order book state (for market data)
-    struct BookLevel {
-        double price;
-        uint64_t quantity;
-        uint32_t order_count;
-    };
+    // Replace a resting limit order's price and open size, keeping the Order
+    // and its id (market maker quotes). At the same price with no more than
+    // the size left, the size shrinks and priority is kept. Otherwise the
+    // order leaves its level and re-enters as if new, matching first (trades
+    // appended) and queueing last. Stops, pegs and icebergs are rejected, and
+    // so are prices the book cannot hold and re-entries on lazy-cancel sides,
+    // whose tombstones still point at the order. quantity must be non-zero (cancel_order pulls an order).
+    virtual ReplaceResult replace_order(uint64_t order_id, double price, uint64_t quantity,
+                                        std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids) = 0;
+
+    // Call auction. In auction mode limit orders rest without matching, so
+    // the book may be crossed; market orders are cancelled (reported through
+    // expired_ids) and new pegs rejected, stops wait and pegs already resting
+    // sit the auction out.
+    virtual void start_auction() = 0;
+    virtual bool in_auction() const = 0;
+
+    // Equilibrium the book would uncross at now, without trading
+    virtual AuctionResult indicative_auction() const = 0;
+
+    // Trade the auction volume at the equilibrium price, bids and asks each
+    // in price-time priority (the later of each pair is the taker). The book
+    // then returns to continuous matching, or stays in auction when
+    // continue_auction is set (frequent batch auctions). Stops wait out an
+    // auction even when triggered, and are released (against the last trade
+    // price) once continuous matching resumes.
+    virtual AuctionResult uncross(std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids,
+                                  bool continue_auction) = 0;
 
-    std::vector<BookLevel> get_bid_levels(size_t max_levels = 10) const;
-    std::vector<BookLevel> get_ask_levels(size_t max_levels = 10) const;
+    // Queue and depth queries, answered from the book's queue index in
+    // O(log n) (see BookConfig::queue_index); false when the book keeps no
+    // index or the order is not resting displayed. side is the side of the
+    // book being asked about: depth_to_price(SELL, p) is the displayed ask
+    // quantity at p or lower, cost_to_fill(SELL, q) the cost of buying q.
+    virtual bool queue_position(uint64_t order_id, QueuePosition& position) const = 0;
+    virtual bool depth_to_price(Side side, double price, uint64_t& quantity) const = 0;
+    virtual bool cost_to_fill(Side side, uint64_t quantity, FillEstimate& estimate) const = 0;
+
+    // Remove a batch of orders whose time in force ran out, under one lock.
+    // Ids no longer in the book are skipped. Removed ids are appended to
+    // expired_ids and each price level they left gets one entry in updates.
+    virtual void expire_orders(const std::vector<uint64_t>& order_ids, std::vector<uint64_t>& expired_ids,
+                               std::vector<LevelUpdate>& updates) = 0;
+
+    // Displayed level changes, for event streams. While tracking is on, each
+    // price level any call changes is remembered; take_level_changes appends
+    // the new state of each once and starts over.
+    virtual void track_level_changes(bool on) = 0;
+    virtual void take_level_changes(std::vector<LevelUpdate>& updates) = 0;
+
+    // Copy the book into snapshot under one lock. With release, every order
+    // then leaves the book without trading (levels changed are noted for
+    // take_level_changes). restore rebuilds a snapshot onto an empty book of
+    // the same type: the same queues, iceberg slices and id base, no matching.
+    virtual void snapshot(BookSnapshot& snapshot, bool release) = 0;
+    virtual void restore(const BookSnapshot& snapshot) = 0;
+
+    // Read replica for lock-free market data queries (BookView.h). Once
+    // enabled, every call that changes the book publishes the replica before
+    // it returns; the depth is fixed and the replica lives as long as the
+    // book. enable_view fails for depth 0, once a replica exists, or on a
+    // heap book, whose level walk sorts every order. With a
+    // backlog, the book queues itself there when a reader holds back a
+    // publish; refresh_view, called by whoever drained the backlog,
+    // publishes those changes (true: the view is current, else the book is
+    // queued again). view() is nullptr until enabled.
+    virtual bool enable_view(size_t depth, ViewBacklog* backlog = nullptr) = 0;
+    virtual bool refresh_view() = 0;
+    const BookReplica* view() const { return view_.load(std::memory_order_acquire); }
+
+    // Get order book state (for market data), best level first. Pegged
+    // orders are not displayed and are left out of levels, best prices and
+    // volumes.
+    virtual std::vector<BookLevel> get_bid_levels(size_t max_levels = 10) const = 0;
+    virtual std::vector<BookLevel> get_ask_levels(size_t max_levels = 10) const = 0;
 
     // Get best bid/ask
-    double get_best_bid() const;
-    double get_best_ask() const;
+    virtual double get_best_bid() const = 0;
+    virtual double get_best_ask() const = 0;
 
     // Get spread
     double get_spread() const;
 
     // Get total volume at each side
-    uint64_t get_bid_volume() const;
-    uint64_t get_ask_volume() const;
+    virtual uint64_t get_bid_volume() const = 0;
+    virtual uint64_t get_ask_volume() const = 0;
+
+    // Price of the most recent trade (the stop trigger reference), 0 before the first
+    virtual double get_last_trade_price() const = 0;
+
+    // Pre-trade risk reference: the last trade price, else the displayed BBO
+    // midpoint, else the one best price shown, else 0
+    virtual double get_reference_price() const = 0;
+
+    // Get a resting order by ID. Filled and cancelled orders are released
+    // (a lazy-cancel book may keep a cancelled order until it surfaces).
+    // Released orders are retired to EpochDomain::global(), so the pointer
+    // stays valid while the caller is inside an EpochGuard; fields the book
+    // updates in place (fills, status) may change under it.
+    virtual const Order* get_order(uint64_t order_id) const = 0;
+
+    virtual BookType get_book_type() const = 0;
+
+    virtual BookStorageStats get_storage_stats() const = 0;
 
     // Get symbol
     const std::string& get_symbol() const { return symbol_; }
 
-    // Get a specific order by ID
-    const Order* get_order(uint64_t order_id) const;
+    // Id the engine gave the symbol, for fixed-size event records and order ids
+    uint32_t get_symbol_id() const { return symbol_id_; }
+    void set_symbol_id(uint32_t symbol_id) { symbol_id_ = symbol_id; }
 
-private:
+    // Ids of this book's orders: the engine's base (shard and symbol id, see
+    // OrderId.h) and a sequence from 1. The counter belongs to the book, so
+    // symbols never contend on it. A book adopted from another engine keeps
+    // the base it had there.
+    void set_order_id_base(uint64_t base) { order_id_base_ = base; }
+    uint64_t get_order_id_base() const { return order_id_base_; }
+    uint64_t next_order_id() {
+        return order_id_base_ | next_order_sequence_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Held by the engine from a book call until the call's events are
+    // published, so that the event stream carries each book's events in the
+    // order the book made them. The book itself never takes it; its own
+    // lock only covers each call.
+    std::mutex& event_mutex() { return event_mutex_; }
+
+protected:
     std::string symbol_;
+    uint32_t symbol_id_{0};
+    uint64_t order_id_base_{0};
+    std::atomic<uint64_t> next_order_sequence_{1};
+    std::atomic<const BookReplica*> view_{nullptr};
+    std::mutex event_mutex_;
+};
+
+// Order book whose price-level storage is chosen at compile time by Policy
+// (see BookPolicies.h). Matching is price-time priority unless the config
+// selects pro-rata, which policies with level access support (the heap book
+// always matches FIFO). A peg at the same price as a resting order goes by
+// order id (arrival); pro-rata books take no pegs.
+template<typename Policy>
+class BasicOrderBook : public OrderBookBase {
+public:
+    explicit BasicOrderBook(const std::string& symbol, const BookConfig& config = BookConfig());
+    ~BasicOrderBook() override = default;
+
+    using OrderBookBase::process_order;
 
-    // Order storage - owns all orders
-    std::unordered_map<uint64_t, std::unique_ptr<Order>> orders_;
+    void add_order(std::unique_ptr<Order> order) override;
+    bool cancel_order(uint64_t order_id) override;
+    BookReject process_order(std::unique_ptr<Order> order, std::vector<Trade>& trades,
+                             std::vector<uint64_t>* expired_ids) override;
+    ReplaceResult replace_order(uint64_t order_id, double price, uint64_t quantity,
+                                std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids) override;
+    void expire_orders(const std::vector<uint64_t>& order_ids, std::vector<uint64_t>& expired_ids,
+                       std::vector<LevelUpdate>& updates) override;
+    void track_level_changes(bool on) override;
+    void take_level_changes(std::vector<LevelUpdate>& updates) override;
+    void snapshot(BookSnapshot& snapshot, bool release) override;
+    void restore(const BookSnapshot& snapshot) override;
+    bool enable_view(size_t depth, ViewBacklog* backlog = nullptr) override;
+    bool refresh_view() override;
 
-    // Priority queues for bid and ask sides (current high-performance implementation)
-    mutable std::priority_queue<Order*, std::vector<Order*>, BuyOrderComparator> bids_;
-    mutable std::priority_queue<Order*, std::vector<Order*>, SellOrderComparator> asks_;
+    void start_auction() override;
+    bool in_auction() const override;
+    AuctionResult indicative_auction() const override;
+    AuctionResult uncross(std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids,
+                          bool continue_auction) override;
 
-    // Alternative map-based implementation
-    std::map<double, std::list<Order*>, std::greater<double>> bid_levels_;
-    std::map<double, std::list<Order*>, std::less<double>> ask_levels_;
+    bool queue_position(uint64_t order_id, QueuePosition& position) const override;
+    bool depth_to_price(Side side, double price, uint64_t& quantity) const override;
+    bool cost_to_fill(Side side, uint64_t quantity, FillEstimate& estimate) const override;
 
-    // Order ID to iterator mapping for O(1) cancellation
-    std::unordered_map<uint64_t, std::list<Order*>::iterator> order_iterators_;
+    std::vector<BookLevel> get_bid_levels(size_t max_levels = 10) const override;
+    std::vector<BookLevel> get_ask_levels(size_t max_levels = 10) const override;
+
+    double get_best_bid() const override;
+    double get_best_ask() const override;
+
+    uint64_t get_bid_volume() const override;
+    uint64_t get_ask_volume() const override;
+
+    double get_last_trade_price() const override;
+    double get_reference_price() const override;
+
+    const Order* get_order(uint64_t order_id) const override;
+
+    BookType get_book_type() const override;
+
+    BookStorageStats get_storage_stats() const override;
+
+private:
+    using OrderIndex = std::unordered_map<uint64_t, std::unique_ptr<Order>, std::hash<uint64_t>,
+                                          std::equal_to<uint64_t>,
+                                          PoolAllocator<std::pair<const uint64_t, std::unique_ptr<Order>>>>;
+
+    // Node storage for the order index and side containers (declared first, destroyed last)
+    NodePool node_pool_;
+
+    // Order storage - owns all resting orders
+    OrderIndex orders_;
+
+    // Price-level storage for each side (mutable: heap sides clean lazily on read)
+    mutable typename Policy::BidSide bids_;
+    mutable typename Policy::AskSide asks_;
+
+    // Untriggered stops (also owned by orders_) and the trigger reference
+    StopBook stops_;
+    double last_trade_price_{0.0};
+    std::vector<Order*> triggered_;
+
+    // Levels touched by the current expiry batch, and levels changed since
+    // the last take_level_changes while tracking is on
+    TouchedLevels touched_levels_;
+    TouchedLevels changed_levels_;
+    bool track_levels_{false};
+
+    // Read replica, once enabled (published through view_), and where the
+    // book queues itself when a publish is put off
+    std::unique_ptr<BookReplica> replica_;
+    ViewBacklog* view_backlog_{nullptr};
+
+    // Non-displayed pegged orders (also owned by orders_)
+    PegSide bid_pegs_{true};
+    PegSide ask_pegs_{false};
+
+    // As constructed, for snapshots
+    BookConfig config_;
+
+    // Allocation among orders at a price, and the pro-rata scratch list
+    // (order, quantity) in time priority
+    MatchingAlgorithm matching_;
+    uint64_t min_allocation_;
+    std::vector<std::pair<Order*, uint64_t>> allocations_;
+
+    // Call auction state and the crossed levels handed to the calculator
+    bool in_auction_{false};
+    double tick_size_;
+    mutable AuctionCalculator auction_;
+    mutable std::vector<BookLevel> auction_bids_;
+    mutable std::vector<BookLevel> auction_asks_;
+
+    // Optional queue index per side, kept in step with bids_ and asks_
+    std::unique_ptr<QueueIndex> bid_index_;
+    std::unique_ptr<QueueIndex> ask_index_;
 
     // Trade ID generator
     uint64_t next_trade_id_{1};
@@ -76,22 +419,60 @@ private:
     // Thread safety
     mutable std::mutex mutex_;
 
-    // Configuration flag for choosing implementation
-    bool use_map_implementation_{false};
-
     // Helper methods
-    std::vector<Trade> match_order(Order* order);
-    void clean_filled_orders();
+    template<typename OppositeSide>
+    void match_order(Order* order, OppositeSide& opposite, PegSide& opposite_pegs,
+                     std::vector<Trade>& trades);
+    template<typename OppositeSide>
+    void match_pro_rata(Order* order, OppositeSide& opposite, std::vector<Trade>& trades);
+    template<typename SideT>
+    void release_front(SideT& side, Order* order);
+    QueueIndex* index_for(const Order* order) const {
+        return order->is_buy() ? bid_index_.get() : ask_index_.get();
+    }
+    // A ladder side or queue index only holds prices on the grid and in its
+    // band (BookConfig::max_band_ticks)
+    bool can_rest(Side side, double price) const {
+        bool buy = side == Side::BUY;
+        const QueueIndex* index = buy ? bid_index_.get() : ask_index_.get();
+        return (buy ? bids_.can_hold(price) : asks_.can_hold(price)) && (!index || index->can_hold(price));
+    }
+    void note_level(const Order* order) {
+        if (track_levels_) {
+            changed_levels_.insert(order->side, order->price);
+        }
+        if (replica_) {
+            replica_->note(order->side, order->price);
+        }
+    }
+    // End of a call that may have changed the book
+    void publish_view() {
+        if (replica_ && replica_->dirty() && !replica_->publish(bids_, asks_, last_trade_price_) &&
+            view_backlog_ && replica_->claim_backlog()) {
+            view_backlog_->add(this);
+        }
+    }
+    double current_peg_price(const Order* order) const;
+    AuctionResult compute_auction() const;
     void add_order_unlocked(std::unique_ptr<Order> order);
-
-    // Helper to aggreagate orders at same price level
-    std::vector<BookLevel> aggregate_levels(
-        const std::priority_queue<Order*, std::vector<Order*>, BuyOrderComparator>& orders,
-        size_t max_levels) const;
-    
-    std::vector<BookLevel> aggregate_levels(
-        const std::priority_queue<Order*, std::vector<Order*>, SellOrderComparator>& orders,
-        size_t max_levels) const;
+    void erase_order(uint64_t order_id);
+    void insert_into_side(Order* order, bool show_slice = true);
+    bool execute(Order* order, std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids);
+    void trigger_stops(std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids);
+    void release_cancelled();
+    void remove_resting(Order* order);
 };
 
-} // namespace quasar
\ No newline at end of file
+using HeapOrderBook = BasicOrderBook<HeapBookPolicy>;
+using MapOrderBook = BasicOrderBook<MapBookPolicy>;
+using IntrusiveOrderBook = BasicOrderBook<IntrusiveBookPolicy>;
+using LadderOrderBook = BasicOrderBook<LadderBookPolicy>;
+
+// Default book implementation
+using OrderBook = IntrusiveOrderBook;
+
+// Create a book of the requested type
+std::unique_ptr<OrderBookBase> make_order_book(const std::string& symbol, BookType type,
+                                               const BookConfig& config = BookConfig());
+
+} // namespace quasar
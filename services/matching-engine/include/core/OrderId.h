@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace quasar {
+
+// Engine order ids name the book that holds the order:
+//
+//   bits 63..56  shard      the engine instance (MatchingEngine constructor)
+//   bits 55..36  symbol id  1-based, in order of book creation
+//   bits 35..0   sequence   per book, from 1
+//
+// A cancel decodes the book straight from the id, and each book numbers its
+// own orders, so threads entering orders in different symbols share no
+// counter. Within one book ids still rise with arrival. An id is never 0.
+constexpr unsigned kOrderIdShardBits = 8;
+constexpr unsigned kOrderIdSymbolBits = 20;
+constexpr unsigned kOrderIdSequenceBits = 64 - kOrderIdShardBits - kOrderIdSymbolBits;
+
+constexpr uint32_t kMaxShards = 1u << kOrderIdShardBits;
+constexpr uint32_t kMaxSymbolId = (1u << kOrderIdSymbolBits) - 1;
+constexpr uint64_t kMaxOrderSequence = (uint64_t{1} << kOrderIdSequenceBits) - 1;
+
+constexpr uint64_t make_order_id(uint32_t shard, uint32_t symbol_id, uint64_t sequence) {
+    return (uint64_t{shard} << (kOrderIdSymbolBits + kOrderIdSequenceBits)) |
+           (uint64_t{symbol_id} << kOrderIdSequenceBits) | (sequence & kMaxOrderSequence);
+}
+
+constexpr uint32_t order_id_shard(uint64_t order_id) {
+    return static_cast<uint32_t>(order_id >> (kOrderIdSymbolBits + kOrderIdSequenceBits));
+}
+
+constexpr uint32_t order_id_symbol(uint64_t order_id) {
+    return static_cast<uint32_t>(order_id >> kOrderIdSequenceBits) & kMaxSymbolId;
+}
+
+constexpr uint64_t order_id_sequence(uint64_t order_id) {
+    return order_id & kMaxOrderSequence;
+}
+
+// Symbol id -> T* without a lock. Slots live in fixed pages that never move
+// once allocated, so a reader may look up while a writer adds symbols.
+// Writers must be serialized by the caller.
+template<typename T>
+class SymbolDirectory {
+public:
+    SymbolDirectory() = default;
+    ~SymbolDirectory() {
+        for (auto& page : pages_) {
+            delete page.load(std::memory_order_relaxed);
+        }
+    }
+
+    SymbolDirectory(const SymbolDirectory&) = delete;
+    SymbolDirectory& operator=(const SymbolDirectory&) = delete;
+
+    // symbol_id in [1, kMaxSymbolId]
+    void publish(uint32_t symbol_id, T* value) {
+        std::atomic<Page*>& slot = pages_[symbol_id >> kPageBits];
+        Page* page = slot.load(std::memory_order_relaxed);
+        if (!page) {
+            page = new Page();  // value-initialized: every slot null
+            slot.store(page, std::memory_order_release);
+        }
+        page->slots[symbol_id & (kPageSize - 1)].store(value, std::memory_order_release);
+    }
+
+    // nullptr for an id never published (or out of range)
+    T* find(uint32_t symbol_id) const {
+        if (symbol_id > kMaxSymbolId) {
+            return nullptr;
+        }
+        const Page* page = pages_[symbol_id >> kPageBits].load(std::memory_order_acquire);
+        return page ? page->slots[symbol_id & (kPageSize - 1)].load(std::memory_order_acquire) : nullptr;
+    }
+
+private:
+    static constexpr unsigned kPageBits = 10;
+    static constexpr size_t kPageSize = size_t{1} << kPageBits;
+    static constexpr size_t kPages = (size_t{kMaxSymbolId} >> kPageBits) + 1;
+
+    struct Page {
+        std::atomic<T*> slots[kPageSize];
+    };
+
+    std::array<std::atomic<Page*>, kPages> pages_{};
+};
+
+} // namespace quasar
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CommandLog.h"
+#include "HashRing.h"
+#include "MatchingEngine.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace quasar {
+
+struct PartitionConfig {
+    uint32_t partition{0};       // this process; also the engine's order id shard
+    uint32_t partitions{1};      // K, the size of the ring
+    uint32_t virtual_nodes{64};
+    std::string snapshot_dir;    // shared by every partition, for book handoff
+    BookType book_type{BookType::INTRUSIVE};
+};
+
+// One of K engine processes reading the same command log. Every partition
+// reads every command and applies those for the symbols it owns by the hash
+// ring, so each symbol is matched by exactly one engine and the partitions
+// need no coordination beyond the log itself.
+//
+// A HANDOFF command moves a symbol without stopping the others: at its
+// offset the owner snapshots the book, writes the snapshot to snapshot_dir
+// and only then takes its orders out; the new owner waits at the same offset
+// for the file, adopts the book with its order ids and queue priority, and
+// goes on. A hand-off that fails (the file cannot be written, or the book
+// cannot be adopted) leaves everything as it was and holds the partition at
+// that offset, reporting the error (failed(), error()); each poll retries.
+// Everyone else just records the new owner. Because the move happens at a
+// fixed log offset, each command for the symbol is applied once, by the
+// owner at its offset. Snapshot files are kept so that a partition replaying
+// the log from the start ends in the same state.
+//
+// Commands are limit orders and cancels; a cancel carries the symbol so that
+// it reaches the symbol's current owner.
+class PartitionedEngine {
+public:
+    PartitionedEngine(CommandLog& log, const PartitionConfig& config);
+
+    // Apply up to max commands from the current offset; returns how many.
+    // Stops early at a handoff to this partition whose snapshot is not
+    // written yet (waiting() is then true), or at a handoff that failed
+    // (failed() is then true as well).
+    size_t poll(size_t max = 256);
+
+    bool owns(const std::string& symbol) const { return ring_.partition_of(symbol) == config_.partition; }
+    uint32_t owner_of(const std::string& symbol) const { return ring_.partition_of(symbol); }
+    uint64_t offset() const { return offset_; }
+    bool waiting() const { return waiting_; }
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    struct PartitionStats {
+        uint64_t applied{0};      // commands for symbols this partition owned
+        uint64_t skipped{0};      // commands for other partitions' symbols
+        uint64_t handed_off{0};
+        uint64_t adopted{0};
+        uint64_t failed_handoffs{0};  // attempts, retries included
+    };
+    PartitionStats get_stats() const { return stats_; }
+
+    MatchingEngine& engine() { return engine_; }
+    const MatchingEngine& engine() const { return engine_; }
+    const PartitionConfig& get_config() const { return config_; }
+
+    // Called for each new order this partition applied: the command's log
+    // offset and the engine's order id (0 if rejected)
+    using AckCallback = std::function<void(uint64_t offset, uint64_t order_id)>;
+    void set_ack_callback(AckCallback callback) { ack_callback_ = std::move(callback); }
+
+    // The file a handoff at offset writes, and its format. has_book is false
+    // for a symbol its owner never saw an order for.
+    static std::string snapshot_path(const std::string& dir, const std::string& symbol, uint64_t offset);
+    static bool write_snapshot(const std::string& path, const BookSnapshot& snapshot, bool has_book);
+    static bool read_snapshot(const std::string& path, BookSnapshot& snapshot, bool& has_book);
+
+private:
+    // False when the command must be retried (a handoff still waiting, or failed)
+    bool apply(const Command& command);
+    bool apply_handoff(const Command& command);
+    bool fail_handoff(const std::string& error);
+
+    CommandLog& log_;
+    PartitionConfig config_;
+    MatchingEngine engine_;
+    HashRing ring_;
+    uint64_t offset_{0};
+    bool waiting_{false};
+    std::string error_;  // why the handoff at offset_ failed ("" when none did)
+    PartitionStats stats_;
+    AckCallback ack_callback_;
+    std::vector<Command> buffer_;
+};
+
+} // namespace quasar
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Order.h"
+#include <vector>
+
+namespace quasar {
+
+// Pegged orders of one side of a book. Pegs are not displayed and are kept
+// off the price-level side in FIFO groups, one per (peg type, offset). A
+// group's price is derived from the displayed best bid/ask whenever it is
+// needed, so a BBO move re-pegs every order in the group at once: nothing is
+// touched when the BBO changes, and finding the best peg costs O(groups).
+// Orders in a group keep their arrival order across re-pegs.
+class PegSide {
+public:
+    explicit PegSide(bool is_buy) : is_buy_(is_buy) {}
+
+    // Effective price of a peg with the given type and offset, or 0.0 when
+    // its reference is missing (no bid for a buy primary peg, no ask for a
+    // sell primary peg, either side missing for a midpoint peg). Offsets are
+    // passive: a buy pegs below its reference and a sell above.
+    static double peg_price(bool is_buy, OrderType type, double offset, double best_bid, double best_ask) {
+        double reference = 0.0;
+        if (type == OrderType::PEG_MIDPOINT) {
+            if (best_bid > 0.0 && best_ask > 0.0) {
+                reference = (best_bid + best_ask) / 2.0;
+            }
+        } else {
+            reference = is_buy ? best_bid : best_ask;
+        }
+        if (reference <= 0.0) {
+            return 0.0;
+        }
+        double price = is_buy ? reference - offset : reference + offset;
+        return price > 0.0 ? price : 0.0;
+    }
+
+    void insert(Order* order) {
+        Group& group = find_or_add(order->type, order->peg_offset);
+        order->prev_in_level = group.tail;
+        order->next_in_level = nullptr;
+        if (group.tail) {
+            group.tail->next_in_level = order;
+        } else {
+            group.head = order;
+        }
+        group.tail = order;
+        size_++;
+    }
+
+    void erase(Order* order) {
+        for (size_t i = 0; i < groups_.size(); ++i) {
+            Group& group = groups_[i];
+            if (group.type != order->type || group.offset != order->peg_offset) {
+                continue;
+            }
+            if (order->prev_in_level) {
+                order->prev_in_level->next_in_level = order->next_in_level;
+            } else {
+                group.head = order->next_in_level;
+            }
+            if (order->next_in_level) {
+                order->next_in_level->prev_in_level = order->prev_in_level;
+            } else {
+                group.tail = order->prev_in_level;
+            }
+            order->prev_in_level = nullptr;
+            order->next_in_level = nullptr;
+            size_--;
+
+            // Keep the scan short: empty groups are dropped (capacity is kept)
+            if (!group.head) {
+                groups_[i] = groups_.back();
+                groups_.pop_back();
+            }
+            return;
+        }
+    }
+
+    // Head of the best priced group at the given BBO, nullptr if no group has
+    // a reference. Equal prices go to the group whose head arrived first.
+    Order* front(double best_bid, double best_ask, double& price) const {
+        Order* best = nullptr;
+        price = 0.0;
+        for (const Group& group : groups_) {
+            double candidate = peg_price(is_buy_, group.type, group.offset, best_bid, best_ask);
+            if (candidate <= 0.0) {
+                continue;
+            }
+            if (!best || (is_buy_ ? candidate > price : candidate < price) ||
+                (candidate == price && group.head->order_id < best->order_id)) {
+                best = group.head;
+                price = candidate;
+            }
+        }
+        return best;
+    }
+
+    // Every peg, group by group in arrival order
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const Group& group : groups_) {
+            for (Order* order = group.head; order; order = order->next_in_level) {
+                fn(order);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t groups() const { return groups_.size(); }
+
+private:
+    struct Group {
+        OrderType type;
+        double offset;
+        Order* head;
+        Order* tail;
+    };
+
+    Group& find_or_add(OrderType type, double offset) {
+        for (Group& group : groups_) {
+            if (group.type == type && group.offset == offset) {
+                return group;
+            }
+        }
+        groups_.push_back(Group{type, offset, nullptr, nullptr});
+        return groups_.back();
+    }
+
+    bool is_buy_;
+    std::vector<Group> groups_;
+    size_t size_{0};
+};
+
+} // namespace quasar
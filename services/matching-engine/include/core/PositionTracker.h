@@ -0,0 +1,184 @@
+#pragma once
+
+#include "EventStream.h"
+#include "Order.h"
+#include "Trade.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace quasar {
+
+class MatchingEngine;
+
+// Per-client positions and PnL, kept off the matching thread. Following an
+// engine (follow()), the tracker is a sink of its event stream: FILL events
+// are the fills, and BOOK_DELTA events keep each symbol's best bid and ask,
+// which mark the open positions. Standalone, on_trade() and update_mark()
+// feed the same. Either way the producer only copies its events into an
+// inbox; the tracker thread swaps the inbox out and applies it in arrival
+// order. Each fill is O(1): clients and symbols get dense indices on first
+// sight, and the positions held are found by (client, symbol) in one
+// open-addressed table, so memory follows the positions, not clients x
+// symbols.
+class PositionTracker {
+public:
+    struct Position {
+        uint64_t client_id{0};
+        std::string symbol;
+        int64_t net_quantity{0};   // long > 0, short < 0
+        double average_price{0.0}; // of the open quantity; 0 when flat
+        double realized_pnl{0.0};
+        double unrealized_pnl{0.0}; // open quantity at the mark
+        double mark_price{0.0};     // bid for a long, ask for a short, else the last fill
+        uint64_t bought{0};
+        uint64_t sold{0};
+    };
+
+    PositionTracker() = default;
+    ~PositionTracker();
+
+    PositionTracker(const PositionTracker&) = delete;
+    PositionTracker& operator=(const PositionTracker&) = delete;
+
+    void start();
+    // Applies whatever is still queued before returning
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // Take fills and marks from the engine's event stream. Call before the
+    // engine trades (levels resting before then are only seen once they
+    // change), and not together with on_trade, which would count each fill
+    // twice. The engine must outlive the tracker, which unsubscribes when
+    // destroyed.
+    void follow(MatchingEngine& engine);
+
+    // Event stream sink (see follow); runs on the publishing thread
+    void on_events(const EngineEvent* events, size_t count);
+
+    // Feeding the tracker by hand instead; safe from any thread
+    void on_trade(const Trade& trade);
+    void update_mark(const std::string& symbol, double best_bid, double best_ask);
+
+    // Wait until every event queued before the call has been applied. Without
+    // a running thread the caller applies them itself.
+    void flush();
+
+    // Apply queued events on the calling thread; returns how many there were.
+    // For use while the thread is stopped (tests, benchmarks).
+    size_t drain();
+
+    bool get_position(uint64_t client_id, const std::string& symbol, Position& position) const;
+    std::vector<Position> get_positions(uint64_t client_id) const;
+    // Every client and symbol that has traded
+    std::vector<Position> snapshot() const;
+
+    double get_realized_pnl(uint64_t client_id) const;
+    double get_unrealized_pnl(uint64_t client_id) const;
+
+    uint64_t fills_processed() const { return fills_processed_.load(std::memory_order_relaxed); }
+    size_t client_count() const;
+    size_t symbol_count() const;
+
+private:
+    enum class EventKind : uint8_t {
+        FILL,
+        MARK,  // update_mark
+        LEVEL  // a BOOK_DELTA: taker_side is the book side, quantity the level's new size
+    };
+
+    struct Event {
+        EventKind kind{EventKind::FILL};
+        Side taker_side{Side::BUY};
+        uint64_t taker_client_id{0};
+        uint64_t maker_client_id{0};
+        uint64_t quantity{0};
+        double price{0.0}; // trade price, level price, or the bid of a mark
+        double ask{0.0};
+        std::string symbol; // empty for stream events, which carry symbol_id
+        uint32_t symbol_id{0};
+    };
+
+    // One client's book in one symbol
+    struct Cell {
+        uint32_t client{0};
+        uint32_t symbol{0};
+        int64_t net_quantity{0};
+        double average_price{0.0};
+        double realized_pnl{0.0};
+        uint64_t bought{0};
+        uint64_t sold{0};
+    };
+
+    struct Mark {
+        double bid{0.0};
+        double ask{0.0};
+        double last{0.0};
+    };
+
+    // Displayed levels of a followed symbol, best first, for its bid and ask
+    struct Ladder {
+        std::map<double, uint64_t, std::greater<double>> bids;
+        std::map<double, uint64_t> asks;
+    };
+
+    static constexpr int kIdleYields = 256;
+
+    void run();
+    void enqueue(Event&& event);
+    void apply(const std::vector<Event>& events);
+    void apply_fill(uint32_t client, uint32_t symbol, Side side, uint64_t quantity, double price);
+    uint32_t client_index(uint64_t client_id);
+    uint32_t symbol_index(const std::string& symbol);
+    uint32_t symbol_index(const Event& event);
+    void apply_level(uint32_t symbol, Side side, double price, uint64_t quantity);
+    Cell& cell(uint32_t client, uint32_t symbol);
+    const Cell* find_cell(uint32_t client, uint32_t symbol) const;
+    size_t home_slot(uint32_t client, uint32_t symbol) const;
+    void grow_slots();
+    Position make_position(const Cell& cell) const;
+
+    // Producer side
+    mutable std::mutex inbox_mutex_;
+    std::condition_variable inbox_cv_;
+    std::condition_variable applied_cv_;
+    std::vector<Event> inbox_;
+    std::atomic<uint64_t> enqueued_{0}; // events queued; written under inbox_mutex_
+    uint64_t applied_{0};               // events applied, under inbox_mutex_
+    bool sleeping_{false};              // the thread waits on inbox_cv_, under inbox_mutex_
+
+    // Tracker side; state_mutex_ lets queries read while the thread applies
+    std::mutex drain_mutex_;
+    std::vector<Event> batch_; // the swapped-out inbox, under drain_mutex_
+    mutable std::mutex state_mutex_;
+    std::unordered_map<uint64_t, uint32_t> client_indices_;
+    std::unordered_map<std::string, uint32_t> symbol_indices_;
+    std::vector<uint64_t> client_ids_;
+    std::vector<std::string> symbols_;
+    std::vector<Mark> marks_;
+    std::vector<Ladder> ladders_;
+    // Followed engine, and its symbol ids resolved so far (symbol index + 1)
+    MatchingEngine* engine_{nullptr};
+    std::vector<uint32_t> symbols_by_id_;
+    // Every position held, in order of its first fill, and the cells of
+    // each client
+    std::vector<Cell> cells_;
+    std::vector<std::vector<uint32_t>> client_cells_;
+    // Open addressing (linear probing) on (client, symbol): cell index + 1,
+    // 0 for an empty slot; kept at most half full
+    std::vector<uint32_t> slots_;
+    size_t slot_mask_{0};
+    std::atomic<uint64_t> fills_processed_{0};
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+} // namespace quasar
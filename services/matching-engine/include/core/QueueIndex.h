@@ -0,0 +1,415 @@
+#pragma once
+
+#include "Order.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace quasar {
+
+// Where a resting order stands in its price level
+struct QueuePosition {
+    double price{0.0};
+    uint64_t quantity_ahead{0};   // displayed quantity queued before it at its price
+    uint32_t orders_ahead{0};
+    uint64_t level_quantity{0};   // displayed quantity at its price, itself included
+    uint64_t better_quantity{0};  // displayed quantity at better prices on its side
+};
+
+// What sweeping a quantity off one side of the book would cost
+struct FillEstimate {
+    uint64_t filled_quantity{0};  // less than asked when the side is too thin
+    double notional{0.0};
+    double average_price{0.0};
+    double worst_price{0.0};      // last level reached
+};
+
+// Binary indexed tree of T (anything with += and -=) over a growing array.
+// Point updates, prefix sums and appends are O(log n); the tree is 1-based.
+template<typename T>
+class FenwickTree {
+public:
+    FenwickTree() : tree_(1) {}
+
+    size_t size() const { return tree_.size() - 1; }
+
+    void clear() { tree_.resize(1); }
+
+    // Rebuild from values in O(n)
+    void assign(const std::vector<T>& values) {
+        tree_.assign(1, T{});
+        tree_.insert(tree_.end(), values.begin(), values.end());
+        for (size_t i = 1; i < tree_.size(); ++i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent < tree_.size()) {
+                tree_[parent] += tree_[i];
+            }
+        }
+    }
+
+    // Node i covers (i - lowbit(i), i]: the new value plus the nodes below it
+    void push_back(const T& value) {
+        size_t i = tree_.size();
+        T node = value;
+        for (size_t step = 1; step < (i & (~i + 1)); step <<= 1) {
+            node += tree_[i - step];
+        }
+        tree_.push_back(node);
+    }
+
+    void add(size_t index, const T& delta) {
+        for (size_t i = index + 1; i < tree_.size(); i += i & (~i + 1)) {
+            tree_[i] += delta;
+        }
+    }
+
+    void subtract(size_t index, const T& delta) {
+        for (size_t i = index + 1; i < tree_.size(); i += i & (~i + 1)) {
+            tree_[i] -= delta;
+        }
+    }
+
+    // Sum of the first count values
+    T prefix(size_t count) const {
+        T sum{};
+        for (size_t i = count; i > 0; i -= i & (~i + 1)) {
+            sum += tree_[i];
+        }
+        return sum;
+    }
+
+    // Largest count whose prefix sum satisfies keep (which must hold for a
+    // prefix of the counts), with that sum in sum
+    template<typename Keep>
+    size_t count_while(Keep&& keep, T& sum) const {
+        size_t n = size();
+        size_t step = 1;
+        while (step * 2 <= n) {
+            step *= 2;
+        }
+        size_t count = 0;
+        sum = T{};
+        for (; n > 0 && step > 0; step >>= 1) {
+            if (count + step <= n) {
+                T next = sum;
+                next += tree_[count + step];
+                if (keep(next)) {
+                    count += step;
+                    sum = next;
+                }
+            }
+        }
+        return count;
+    }
+
+private:
+    std::vector<T> tree_;
+};
+
+// Order-statistic index over one side of a book, maintained by the book next
+// to its price-level storage (whatever the policy), so queue and depth
+// questions never walk a level or the ladder:
+//
+//  - Each price level numbers its orders by queue slot in arrival order and
+//    keeps a Fenwick tree of (displayed quantity, orders) by slot, so the
+//    quantity ahead of an order is one prefix sum. Departures leave empty
+//    slots; a level renumbers its slots when they outnumber its orders two
+//    to one, and starts over whenever it empties.
+//  - Levels sit on a tick-indexed ladder with a Fenwick tree of (displayed
+//    quantity, notional in ticks) ordered best price first, so depth to a
+//    price is a prefix sum and the cost of a sweep is a binary-lifting search.
+//
+// Prices sit on the tick grid like the ladder policy, within a band of
+// max_ticks (BookConfig::max_band_ticks) around the live levels; the book
+// checks can_hold before resting an order. The ladder doubles (one O(n)
+// rebuild) when an order lands outside it, up to the band, past which it is
+// laid out again around the live levels and the new price.
+class QueueIndex {
+public:
+    QueueIndex(bool is_buy, double tick_size, uint32_t max_ticks)
+        : is_buy_(is_buy), tick_size_(tick_size), max_ticks_(std::max<int64_t>(max_ticks, 1)) {}
+
+    // On the grid, and inside the band with the live levels
+    bool can_hold(double price) const {
+        double ticks = price / tick_size_;
+        int64_t tick = std::llround(ticks);
+        if (std::fabs(ticks - static_cast<double>(tick)) > 1e-6) {
+            return false;
+        }
+        int64_t size = static_cast<int64_t>(levels_.size());
+        if (live_levels_ == 0 || (size <= max_ticks_ && std::max(base_tick_ + size - 1, tick) -
+                                                                std::min(base_tick_, tick) < max_ticks_)) {
+            return true;
+        }
+        int64_t low = 0;
+        int64_t high = 0;
+        live_range(low, high);
+        return std::max(high, tick) - std::min(low, tick) < max_ticks_;
+    }
+
+    void insert(Order* order) {
+        size_t index = ensure_index(to_tick(order->price));
+        Level& level = levels_[index];
+        if (level.live == 0) {
+            level.price = order->price;
+            live_levels_++;
+        } else if (level.slots.size() >= kMinCompaction && level.live * 2 < level.slots.size()) {
+            compact(level);
+        }
+        uint64_t quantity = order->displayed_quantity();
+        order->queue_slot = static_cast<uint32_t>(level.slots.size());
+        level.slots.push_back(Slot{order, quantity});
+        level.queue.push_back(QueueSum{quantity, 1});
+        level.live++;
+        add_depth(index, quantity);
+    }
+
+    void erase(Order* order) {
+        size_t index = index_of(order);
+        Level& level = levels_[index];
+        Slot& slot = level.slots[order->queue_slot];
+        uint64_t quantity = slot.quantity;
+        level.queue.subtract(order->queue_slot, QueueSum{quantity, 1});
+        slot = Slot{nullptr, 0};
+        subtract_depth(index, quantity);
+        if (--level.live == 0) {
+            level.slots.clear();
+            level.queue.clear();
+            live_levels_--;
+        }
+    }
+
+    // A resting order's displayed quantity dropped by quantity
+    void on_fill(Order* order, uint64_t quantity) {
+        size_t index = index_of(order);
+        Level& level = levels_[index];
+        level.slots[order->queue_slot].quantity -= quantity;
+        level.queue.subtract(order->queue_slot, QueueSum{quantity, 0});
+        subtract_depth(index, quantity);
+    }
+
+    // The order showed a new slice and went to the back of its level
+    void requeue(Order* order) {
+        erase(order);
+        insert(order);
+    }
+
+    bool position(const Order* order, QueuePosition& position) const {
+        int64_t index = to_tick(order->price) - base_tick_;
+        if (index < 0 || index >= static_cast<int64_t>(levels_.size())) {
+            return false;
+        }
+        const Level& level = levels_[static_cast<size_t>(index)];
+        if (order->queue_slot >= level.slots.size() || level.slots[order->queue_slot].order != order) {
+            return false;
+        }
+        QueueSum ahead = level.queue.prefix(order->queue_slot);
+        position.price = level.price;
+        position.quantity_ahead = ahead.quantity;
+        position.orders_ahead = static_cast<uint32_t>(ahead.orders);
+        position.level_quantity = level.quantity;
+        position.better_quantity = depth_.prefix(rank(static_cast<size_t>(index))).quantity;
+        return true;
+    }
+
+    // Displayed quantity at price or better
+    uint64_t depth_to_price(double price) const {
+        int64_t index = to_tick(price) - base_tick_;
+        int64_t size = static_cast<int64_t>(levels_.size());
+        int64_t count = (is_buy_ ? size - 1 - index : index) + 1;
+        count = count < 0 ? 0 : (count > size ? size : count);
+        return depth_.prefix(static_cast<size_t>(count)).quantity;
+    }
+
+    // Take quantity best price first: whole levels while the running total
+    // stays below it, then part of the next one
+    FillEstimate cost_to_fill(uint64_t quantity) const {
+        FillEstimate estimate;
+        if (quantity == 0) {
+            return estimate;
+        }
+        DepthSum taken;
+        size_t count = depth_.count_while([quantity](const DepthSum& sum) { return sum.quantity < quantity; }, taken);
+        unsigned __int128 notional_ticks = taken.notional_ticks;
+        estimate.filled_quantity = taken.quantity;
+        if (count < levels_.size()) {
+            size_t index = is_buy_ ? levels_.size() - 1 - count : count;
+            uint64_t rest = quantity - taken.quantity;
+            notional_ticks += static_cast<unsigned __int128>(rest) *
+                              static_cast<uint64_t>(base_tick_ + static_cast<int64_t>(index));
+            estimate.filled_quantity = quantity;
+            estimate.worst_price = levels_[index].price;
+        } else if (taken.quantity > 0) {
+            // The side is too thin: the last live level is the one before the total
+            DepthSum before;
+            uint64_t total = taken.quantity;
+            size_t last = depth_.count_while([total](const DepthSum& sum) { return sum.quantity < total; }, before);
+            estimate.worst_price = levels_[is_buy_ ? levels_.size() - 1 - last : last].price;
+        }
+        estimate.notional = static_cast<double>(notional_ticks) * tick_size_;
+        if (estimate.filled_quantity > 0) {
+            estimate.average_price = estimate.notional / static_cast<double>(estimate.filled_quantity);
+        }
+        return estimate;
+    }
+
+private:
+    // Fewer slots than this are never renumbered
+    static constexpr size_t kMinCompaction = 32;
+    static constexpr size_t kMinLadder = 64;
+
+    struct QueueSum {
+        uint64_t quantity{0};
+        uint64_t orders{0};
+        QueueSum& operator+=(const QueueSum& other) {
+            quantity += other.quantity;
+            orders += other.orders;
+            return *this;
+        }
+        QueueSum& operator-=(const QueueSum& other) {
+            quantity -= other.quantity;
+            orders -= other.orders;
+            return *this;
+        }
+    };
+
+    struct DepthSum {
+        uint64_t quantity{0};
+        unsigned __int128 notional_ticks{0};
+        DepthSum& operator+=(const DepthSum& other) {
+            quantity += other.quantity;
+            notional_ticks += other.notional_ticks;
+            return *this;
+        }
+        DepthSum& operator-=(const DepthSum& other) {
+            quantity -= other.quantity;
+            notional_ticks -= other.notional_ticks;
+            return *this;
+        }
+    };
+
+    struct Slot {
+        Order* order;
+        uint64_t quantity;
+    };
+
+    struct Level {
+        double price{0.0};
+        uint64_t quantity{0};
+        size_t live{0};
+        std::vector<Slot> slots;
+        FenwickTree<QueueSum> queue;
+    };
+
+    int64_t to_tick(double price) const {
+        return static_cast<int64_t>(std::llround(price / tick_size_));
+    }
+
+    size_t index_of(const Order* order) const {
+        return static_cast<size_t>(to_tick(order->price) - base_tick_);
+    }
+
+    // Position of a ladder index in best-first order
+    size_t rank(size_t index) const {
+        return is_buy_ ? levels_.size() - 1 - index : index;
+    }
+
+    DepthSum depth_of(size_t index, uint64_t quantity) const {
+        uint64_t tick = static_cast<uint64_t>(base_tick_ + static_cast<int64_t>(index));
+        return DepthSum{quantity, static_cast<unsigned __int128>(quantity) * tick};
+    }
+
+    void add_depth(size_t index, uint64_t quantity) {
+        levels_[index].quantity += quantity;
+        depth_.add(rank(index), depth_of(index, quantity));
+    }
+
+    void subtract_depth(size_t index, uint64_t quantity) {
+        levels_[index].quantity -= quantity;
+        depth_.subtract(rank(index), depth_of(index, quantity));
+    }
+
+    // Renumber the live orders of a level from slot 0, keeping their order
+    void compact(Level& level) {
+        size_t live = 0;
+        queue_scratch_.clear();
+        for (const Slot& slot : level.slots) {
+            if (slot.order) {
+                slot.order->queue_slot = static_cast<uint32_t>(live);
+                level.slots[live++] = slot;
+                queue_scratch_.push_back(QueueSum{slot.quantity, 1});
+            }
+        }
+        level.slots.resize(live);
+        level.queue.assign(queue_scratch_);
+    }
+
+    // Ticks of the lowest and highest live levels (some must be live)
+    void live_range(int64_t& low, int64_t& high) const {
+        size_t first = 0;
+        while (levels_[first].live == 0) {
+            first++;
+        }
+        size_t last = levels_.size() - 1;
+        while (levels_[last].live == 0) {
+            last--;
+        }
+        low = base_tick_ + static_cast<int64_t>(first);
+        high = base_tick_ + static_cast<int64_t>(last);
+    }
+
+    // Lay the ladder out to cover tick (which can_hold accepted) and return
+    // its index
+    size_t ensure_index(int64_t tick) {
+        int64_t size = static_cast<int64_t>(levels_.size());
+        if (size > 0 && tick >= base_tick_ && tick < base_tick_ + size) {
+            return static_cast<size_t>(tick - base_tick_);
+        }
+
+        // Double at least (up to the band), toward the new tick; an empty
+        // ladder centres on it. Only empty levels fall outside.
+        int64_t low = tick;
+        int64_t high = tick;
+        if (live_levels_ > 0) {
+            live_range(low, high);
+            low = std::min(low, tick);
+            high = std::max(high, tick);
+        }
+        int64_t new_size = std::max<int64_t>(std::max<int64_t>(2 * size, high - low + 1), kMinLadder);
+        new_size = std::max(std::min(new_size, max_ticks_), high - low + 1);
+        int64_t new_base = live_levels_ == 0 ? tick - new_size / 2 : (tick == low ? high - new_size + 1 : low);
+        if (new_base < 0) {
+            new_base = 0;
+        }
+
+        std::vector<Level> grown(static_cast<size_t>(new_size));
+        for (int64_t i = 0; i < size; ++i) {
+            int64_t moved = base_tick_ - new_base + i;
+            if (moved >= 0 && moved < new_size) {
+                grown[static_cast<size_t>(moved)] = std::move(levels_[static_cast<size_t>(i)]);
+            }
+        }
+        levels_.swap(grown);
+        base_tick_ = new_base;
+
+        depth_scratch_.assign(levels_.size(), DepthSum{});
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            depth_scratch_[rank(i)] = depth_of(i, levels_[i].quantity);
+        }
+        depth_.assign(depth_scratch_);
+        return static_cast<size_t>(tick - base_tick_);
+    }
+
+    bool is_buy_;
+    double tick_size_;
+    int64_t max_ticks_;
+    int64_t base_tick_{0};
+    size_t live_levels_{0};
+    std::vector<Level> levels_;
+    FenwickTree<DepthSum> depth_;
+    std::vector<QueueSum> queue_scratch_;
+    std::vector<DepthSum> depth_scratch_;
+};
+
+} // namespace quasar
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "Order.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace quasar {
+
+// Pre-trade limits for a client; 0 leaves a check off
+struct RiskLimits {
+    uint64_t max_order_quantity{0};
+    double max_order_notional{0.0};  // quantity * price, at the reference price for unpriced orders
+    double price_collar{0.0};        // furthest a limit price may be from the reference, as a fraction of it
+    uint32_t max_open_orders{0};     // orders entered and not yet filled, cancelled or expired
+};
+
+enum class RiskReject {
+    NONE,
+    ORDER_QUANTITY,
+    ORDER_NOTIONAL,
+    PRICE_COLLAR,
+    OPEN_ORDERS
+};
+
+// Per-client risk state: open order counts and limit overrides. Clients live
+// in flat parallel arrays addressed by open addressing on the client id, so
+// a check is one probe and a few compares, and a client's slot is dropped
+// once it has nothing open and no limits of its own (backward-shift
+// deletion, no tombstones). Not thread safe; the engine guards it.
+class RiskTable {
+public:
+    void set_default_limits(const RiskLimits& limits) {
+        default_limits_ = limits;
+        note_reference(limits);
+    }
+    const RiskLimits& default_limits() const { return default_limits_; }
+
+    void set_client_limits(uint64_t client_id, const RiskLimits& limits) {
+        size_t slot = find_or_add(client_id);
+        if (limit_index_[slot] == 0) {
+            limits_.push_back(limits);
+            limit_index_[slot] = static_cast<uint32_t>(limits_.size());
+        } else {
+            limits_[limit_index_[slot] - 1] = limits;
+        }
+        note_reference(limits);
+    }
+
+    const RiskLimits& limits_for(uint64_t client_id) const {
+        size_t slot = find(client_id);
+        return slot == kNotFound || limit_index_[slot] == 0 ? default_limits_ : limits_[limit_index_[slot] - 1];
+    }
+
+    // Whether any limit in force compares against a reference price
+    bool uses_reference() const { return uses_reference_; }
+
+    // Size, notional and collar checks of an order (or of a quote side's new
+    // price and size). reference_price 0 skips the collar, and the notional
+    // of an unpriced order.
+    static RiskReject check_order(const RiskLimits& limits, OrderType type, double price, uint64_t quantity,
+                                  double reference_price) {
+        if (limits.max_order_quantity != 0 && quantity > limits.max_order_quantity) {
+            return RiskReject::ORDER_QUANTITY;
+        }
+        bool priced = type == OrderType::LIMIT || type == OrderType::STOP_LIMIT;
+        double notional = (priced ? price : reference_price) * static_cast<double>(quantity);
+        if (limits.max_order_notional > 0.0 && notional > limits.max_order_notional) {
+            return RiskReject::ORDER_NOTIONAL;
+        }
+        if (limits.price_collar > 0.0 && reference_price > 0.0 && type == OrderType::LIMIT &&
+            std::fabs(price - reference_price) > limits.price_collar * reference_price) {
+            return RiskReject::PRICE_COLLAR;
+        }
+        return RiskReject::NONE;
+    }
+
+    // Full check of a new order; on success it counts as open for its client
+    RiskReject open(const Order& order, double reference_price) {
+        size_t slot = find_or_add(order.client_id);
+        const RiskLimits& limits = limit_index_[slot] == 0 ? default_limits_ : limits_[limit_index_[slot] - 1];
+        RiskReject reject = check_order(limits, order.type, order.price, order.quantity, reference_price);
+        if (reject == RiskReject::NONE && limits.max_open_orders != 0 &&
+            open_orders_[slot] >= limits.max_open_orders) {
+            reject = RiskReject::OPEN_ORDERS;
+        }
+        if (reject != RiskReject::NONE) {
+            release_if_idle(slot);
+            return reject;
+        }
+        open_orders_[slot]++;
+        return RiskReject::NONE;
+    }
+
+    // The checks of open() that need neither a reference price nor a book,
+    // counting nothing: an order for a symbol not yet traded is turned away
+    // before the symbol takes an id
+    RiskReject check(const Order& order) const {
+        const RiskLimits& limits = limits_for(order.client_id);
+        RiskReject reject = check_order(limits, order.type, order.price, order.quantity, 0.0);
+        if (reject == RiskReject::NONE && limits.max_open_orders != 0 &&
+            open_orders(order.client_id) >= limits.max_open_orders) {
+            reject = RiskReject::OPEN_ORDERS;
+        }
+        return reject;
+    }
+
+    // An order entered elsewhere joins the client's open orders unchecked
+    // (a symbol handed over from another engine)
+    void adopt(uint64_t client_id) {
+        open_orders_[find_or_add(client_id)]++;
+    }
+
+    // An order of the client left the engine
+    void close(uint64_t client_id) {
+        size_t slot = find(client_id);
+        if (slot != kNotFound && open_orders_[slot] > 0) {
+            open_orders_[slot]--;
+            release_if_idle(slot);
+        }
+    }
+
+    uint32_t open_orders(uint64_t client_id) const {
+        size_t slot = find(client_id);
+        return slot == kNotFound ? 0 : open_orders_[slot];
+    }
+
+    size_t clients() const { return clients_; }
+
+private:
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    void note_reference(const RiskLimits& limits) {
+        uses_reference_ = uses_reference_ || limits.max_order_notional > 0.0 || limits.price_collar > 0.0;
+    }
+
+    static size_t hash(uint64_t client_id) {
+        return static_cast<size_t>((client_id * 0x9e3779b97f4a7c15ULL) >> 20);
+    }
+
+    size_t find(uint64_t client_id) const {
+        if (used_.empty()) {
+            return kNotFound;
+        }
+        size_t mask = used_.size() - 1;
+        for (size_t slot = hash(client_id) & mask;; slot = (slot + 1) & mask) {
+            if (!used_[slot]) {
+                return kNotFound;
+            }
+            if (client_ids_[slot] == client_id) {
+                return slot;
+            }
+        }
+    }
+
+    size_t find_or_add(uint64_t client_id) {
+        size_t slot = find(client_id);
+        if (slot != kNotFound) {
+            return slot;
+        }
+        if ((clients_ + 1) * 2 > used_.size()) {
+            grow();
+        }
+        size_t mask = used_.size() - 1;
+        slot = hash(client_id) & mask;
+        while (used_[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        used_[slot] = 1;
+        client_ids_[slot] = client_id;
+        open_orders_[slot] = 0;
+        limit_index_[slot] = 0;
+        clients_++;
+        return slot;
+    }
+
+    // Clients with nothing open and default limits need no slot. Later
+    // entries of the probe run move back so lookups never cross a gap.
+    void release_if_idle(size_t slot) {
+        if (open_orders_[slot] != 0 || limit_index_[slot] != 0) {
+            return;
+        }
+        size_t mask = used_.size() - 1;
+        used_[slot] = 0;
+        clients_--;
+        for (size_t next = (slot + 1) & mask; used_[next]; next = (next + 1) & mask) {
+            size_t home = hash(client_ids_[next]) & mask;
+            // Move next into the gap unless its home lies cyclically in (slot, next]
+            bool stays = slot <= next ? (home > slot && home <= next) : (home > slot || home <= next);
+            if (stays) {
+                continue;
+            }
+            used_[slot] = 1;
+            client_ids_[slot] = client_ids_[next];
+            open_orders_[slot] = open_orders_[next];
+            limit_index_[slot] = limit_index_[next];
+            used_[next] = 0;
+            slot = next;
+        }
+    }
+
+    void grow() {
+        std::vector<uint8_t> used(used_.empty() ? 64 : used_.size() * 2, 0);
+        std::vector<uint64_t> client_ids(used.size());
+        std::vector<uint32_t> open_orders(used.size());
+        std::vector<uint32_t> limit_index(used.size());
+        size_t mask = used.size() - 1;
+        for (size_t i = 0; i < used_.size(); ++i) {
+            if (!used_[i]) {
+                continue;
+            }
+            size_t slot = hash(client_ids_[i]) & mask;
+            while (used[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            used[slot] = 1;
+            client_ids[slot] = client_ids_[i];
+            open_orders[slot] = open_orders_[i];
+            limit_index[slot] = limit_index_[i];
+        }
+        used_.swap(used);
+        client_ids_.swap(client_ids);
+        open_orders_.swap(open_orders);
+        limit_index_.swap(limit_index);
+    }
+
+    RiskLimits default_limits_;
+    std::vector<RiskLimits> limits_;   // client overrides, by limit_index_ - 1
+    std::vector<uint8_t> used_;
+    std::vector<uint64_t> client_ids_;
+    std::vector<uint32_t> open_orders_;
+    std::vector<uint32_t> limit_index_; // 0: default limits
+    size_t clients_{0};
+    bool uses_reference_{false};
+};
+
+} // namespace quasar
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "HashRing.h"
+#include "MatchingEngine.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace quasar {
+
+struct ShardedEngineConfig {
+    uint32_t shards{2};
+    uint32_t virtual_nodes{64};
+    BookType book_type{BookType::INTRUSIVE};
+
+    // Shards are compared by pressure: the share of wall time spent matching
+    // plus commands queued over hot_queue_depth. A backlog keeps growing once
+    // a shard is saturated, so it ranks shards that all show full
+    // utilization. The rebalancer acts on a shard at hot_utilization pressure
+    // that is at least min_imbalance above the least loaded one.
+    double hot_utilization{0.75};
+    uint64_t hot_queue_depth{4096};
+    double min_imbalance{0.2};
+    uint32_t max_moves_per_pass{4};
+
+    // Run rebalance() on a thread of its own every interval (0: only when called)
+    uint32_t rebalance_interval_ms{0};
+
+    // A shard asleep for lack of commands wakes every interval for one
+    // MatchingEngine::warm() pass (0: never), so the first order after a
+    // quiet spell does not find the book and code cold. A command arriving
+    // mid-pass waits for it (a few microseconds). Passes do not count as busy.
+    uint32_t warm_interval_us{0};
+    size_t warm_books{8};  // books read per pass
+};
+
+// Symbols spread over shard threads, one MatchingEngine per shard (the shard
+// index is its order id shard). Symbols start where a consistent-hash ring
+// puts them; the rebalancer then moves cold symbols off hot shards.
+//
+// Commands go through a router that appends them to the owning shard's
+// inbox, so each symbol's commands are applied in submission order by one
+// thread. Moving a symbol from shard A to B never stops either shard:
+//
+//   1. Under the router lock, PARK(symbol) goes to B's inbox, HAND_OFF to
+//      A's, and the route flips to B. Later commands for the symbol queue
+//      on B behind the PARK.
+//   2. B meets the PARK and sets the symbol's commands aside as they come.
+//   3. A meets the HAND_OFF after every earlier command for the symbol,
+//      takes the book out (MatchingEngine::hand_off_symbol) and sends it to
+//      B as ADOPT.
+//   4. B adopts the book and applies the commands it set aside, in order.
+//
+// Nothing is dropped or reordered, and B keeps matching its other symbols
+// while it waits. Cancels carry the symbol so that they follow it.
+class ShardedEngine {
+public:
+    explicit ShardedEngine(const ShardedEngineConfig& config = ShardedEngineConfig{});
+    ~ShardedEngine();
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    // Shard threads (and the rebalancer, if it has an interval). Without
+    // them, flush() applies queued commands on the calling thread.
+    void start();
+    // Applies whatever is still queued before returning
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // Queue a command and return its token (see AckCallback); safe from any thread
+    uint64_t submit_order(uint64_t client_id, const std::string& symbol, Side side, double price,
+                          uint64_t quantity);
+    uint64_t cancel_order(const std::string& symbol, uint64_t order_id);
+
+    // Wait until every command queued before the call, and every move in
+    // flight, has been applied
+    void flush();
+
+    // Queue a move of symbol to shard; false if it is already there, the
+    // shard does not exist or the symbol is still moving
+    bool move_symbol(const std::string& symbol, uint32_t shard);
+
+    // One rebalancing pass; returns the moves it queued
+    size_t rebalance();
+
+    uint32_t shard_of(const std::string& symbol) const;
+    uint32_t shard_count() const { return static_cast<uint32_t>(shards_.size()); }
+
+    // The shard's engine. Safe to query while running; submit through the
+    // router only. Shards report their inbox depth to it, so admission
+    // limits set on it (MatchingEngine::set_admission_limits) see the backlog.
+    // With book views on (MatchingEngine::set_book_views) queries read them
+    // instead of the books; the shard refreshes views held back by a reader
+    // after each batch and before it sleeps.
+    MatchingEngine& engine(uint32_t shard) { return *shards_[shard]->engine; }
+    const MatchingEngine& engine(uint32_t shard) const { return *shards_[shard]->engine; }
+
+    struct ShardLoad {
+        uint32_t shard{0};
+        double utilization{0.0};  // busy share of wall time since the last rebalance pass
+        uint64_t busy_ns{0};      // total
+        uint64_t commands{0};     // total applied
+        uint64_t queue_depth{0};  // queued, not yet applied
+        double pressure{0.0};     // utilization + queue_depth / hot_queue_depth
+        size_t symbols{0};        // routed here
+        uint64_t warm_passes{0};  // idle warming passes run
+    };
+    std::vector<ShardLoad> get_loads() const;
+    uint64_t get_moves() const { return moves_.load(); }
+
+    // Called on the shard thread for each new order: its token and the
+    // engine's order id (0 if rejected). Set before start().
+    using AckCallback = std::function<void(uint64_t token, uint64_t order_id)>;
+    void set_ack_callback(AckCallback callback);
+
+    // Installed on every shard's engine; runs on the shard threads
+    void set_trade_callback(MatchingEngine::TradeCallback callback);
+
+private:
+    enum class TaskType : uint8_t {
+        NEW_ORDER,
+        CANCEL,
+        PARK,      // the symbol is coming here; hold its commands
+        HAND_OFF,  // send the symbol's book to shard
+        ADOPT      // the book has arrived
+    };
+
+    struct Task {
+        TaskType type{TaskType::NEW_ORDER};
+        Side side{Side::BUY};
+        uint32_t shard{0};
+        uint64_t token{0};
+        uint64_t client_id{0};
+        uint64_t order_id{0};
+        double price{0.0};
+        uint64_t quantity{0};
+        std::string symbol;
+        std::shared_ptr<BookSnapshot> snapshot;  // ADOPT; null if the symbol had no book
+    };
+
+    struct Shard {
+        uint32_t index{0};
+        std::unique_ptr<MatchingEngine> engine;
+
+        // Producer side
+        std::mutex inbox_mutex;
+        std::condition_variable inbox_cv;
+        std::condition_variable applied_cv;
+        std::vector<Task> inbox;
+        std::atomic<uint64_t> enqueued{0};  // written under inbox_mutex
+        uint64_t applied{0};                // under inbox_mutex
+        bool sleeping{false};
+
+        // Shard side
+        std::mutex drain_mutex;
+        std::vector<Task> batch;
+        std::unordered_map<std::string, std::vector<Task>> parked;
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> commands{0};
+        uint64_t window_busy_ns{0};  // busy_ns at the start of the rebalance window
+
+        std::thread thread;
+    };
+
+    static constexpr int kIdleYields = 256;
+
+    void run(Shard& shard);
+    void enqueue(Shard& shard, Task&& task);
+    size_t drain(Shard& shard);
+    void apply(Shard& shard, Task& task);
+    void execute(Shard& shard, const Task& task);
+    void run_rebalancer();
+    void flush_shard(Shard& shard);
+    bool move_locked(const std::string& symbol, uint32_t shard);
+    std::vector<ShardLoad> loads_locked(std::chrono::steady_clock::time_point now) const;
+
+    ShardedEngineConfig config_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    // Router; held while a command is appended, so routes and inboxes agree
+    mutable std::mutex router_mutex_;
+    HashRing ring_;
+    std::unordered_map<std::string, uint64_t> symbol_commands_;  // routed since the last pass
+    std::unordered_set<std::string> moving_;
+    uint64_t next_token_{0};
+    std::chrono::steady_clock::time_point window_start_;
+    std::atomic<uint64_t> moves_in_flight_{0};
+    std::atomic<uint64_t> moves_{0};
+
+    AckCallback ack_callback_;
+
+    std::atomic<bool> running_{false};
+    std::mutex rebalancer_mutex_;
+    std::condition_variable rebalancer_cv_;
+    std::thread rebalancer_;
+};
+
+} // namespace quasar
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Order.h"
+#include "NodePool.h"
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace quasar {
+
+// Pending stop orders of one book, held off the book in price-sorted sets per
+// side: buy stops ascending by stop price, sell stops descending, ties by
+// order id. The stops a trade triggers are always a prefix of one of the sets,
+// so checking a new last price pops exactly the k triggered stops in
+// O(k log n) and costs O(1) when nothing triggers.
+class StopBook {
+public:
+    explicit StopBook(NodePool& pool)
+        : buy_stops_(BuyStopCompare(), PoolAllocator<Order*>(pool)),
+          sell_stops_(SellStopCompare(), PoolAllocator<Order*>(pool)) {}
+
+    void insert(Order* order) {
+        if (order->is_buy()) {
+            buy_stops_.insert(order);
+        } else {
+            sell_stops_.insert(order);
+        }
+    }
+
+    bool erase(Order* order) {
+        return order->is_buy() ? buy_stops_.erase(order) > 0 : sell_stops_.erase(order) > 0;
+    }
+
+    // Move every stop triggered by last_price into out, in arrival (order id)
+    // order so that simultaneous triggers are released deterministically
+    void pop_triggered(double last_price, std::vector<Order*>& out) {
+        size_t first = out.size();
+        while (!buy_stops_.empty() && (*buy_stops_.begin())->stop_triggered_by(last_price)) {
+            out.push_back(*buy_stops_.begin());
+            buy_stops_.erase(buy_stops_.begin());
+        }
+        while (!sell_stops_.empty() && (*sell_stops_.begin())->stop_triggered_by(last_price)) {
+            out.push_back(*sell_stops_.begin());
+            sell_stops_.erase(sell_stops_.begin());
+        }
+        std::sort(out.begin() + first, out.end(),
+                  [](const Order* a, const Order* b) { return a->order_id < b->order_id; });
+    }
+
+    size_t size() const { return buy_stops_.size() + sell_stops_.size(); }
+
+    // Every pending stop, buys then sells, each in trigger order
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (Order* order : buy_stops_) {
+            fn(order);
+        }
+        for (Order* order : sell_stops_) {
+            fn(order);
+        }
+    }
+
+private:
+    struct BuyStopCompare {
+        bool operator()(const Order* a, const Order* b) const {
+            if (a->stop_price != b->stop_price) {
+                return a->stop_price < b->stop_price;
+            }
+            return a->order_id < b->order_id;
+        }
+    };
+
+    struct SellStopCompare {
+        bool operator()(const Order* a, const Order* b) const {
+            if (a->stop_price != b->stop_price) {
+                return a->stop_price > b->stop_price;
+            }
+            return a->order_id < b->order_id;
+        }
+    };
+
+    std::set<Order*, BuyStopCompare, PoolAllocator<Order*>> buy_stops_;
+    std::set<Order*, SellStopCompare, PoolAllocator<Order*>> sell_stops_;
+};
+
+} // namespace quasar
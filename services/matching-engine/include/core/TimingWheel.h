@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace quasar {
+
+// Hierarchical timing wheel of (value, deadline tick) entries. Four levels of
+// 256 slots cover 2^32 ticks ahead of the current tick; anything further out
+// waits in an overflow list. Level 0 holds deadlines within the current
+// 256-tick window, one slot per tick. A slot of level L > 0 holds a 256^L-tick
+// span and is cascaded into the levels below when the clock enters it, so each
+// entry is moved at most once per level. Scheduling is O(1). Advancing costs
+// O(entries fired + entries cascaded) plus one step per tick that has
+// entries in reach; stretches with nothing due are skipped a window at a time.
+// Cancelled values are not removed; whoever handles a fired batch skips the
+// ones that are gone. Slots keep their capacity, so a steady load stops allocating.
+template<typename T>
+class TimingWheel {
+public:
+    static constexpr int kLevels = 4;
+    static constexpr uint32_t kSlotBits = 8;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+
+    explicit TimingWheel(uint64_t start_tick = 0) : current_(start_tick) {}
+
+    uint64_t current_tick() const { return current_; }
+    size_t size() const { return size_; }
+
+    // Deadlines not after the current tick fire on the next tick
+    void schedule(const T& value, uint64_t deadline) {
+        if (deadline <= current_) {
+            deadline = current_ + 1;
+        }
+        place(Entry{value, deadline});
+        size_++;
+    }
+
+    // Move the clock to target, calling on_tick(tick, values) once for every
+    // tick that has entries, with all the values due on it
+    template<typename OnTick>
+    void advance(uint64_t target, OnTick&& on_tick) {
+        while (current_ < target) {
+            if (size_ == 0) {
+                current_ = target;
+                break;
+            }
+
+            // Jump to the next boundary of the lowest level holding entries
+            int lowest = 0;
+            while (lowest < kLevels && counts_[lowest] == 0) {
+                lowest++;
+            }
+            if (lowest > 0) {
+                uint32_t shift = kSlotBits * static_cast<uint32_t>(lowest);
+                uint64_t boundary = ((current_ >> shift) + 1) << shift;
+                if (boundary > target) {
+                    current_ = target;
+                    break;
+                }
+                current_ = boundary - 1;
+            }
+
+            current_++;
+            cascade(current_);
+
+            auto& slot = slots_[0][current_ & (kSlots - 1)];
+            if (!slot.empty()) {
+                firing_.clear();
+                for (const Entry& entry : slot) {
+                    firing_.push_back(entry.value);
+                }
+                counts_[0] -= slot.size();
+                size_ -= slot.size();
+                slot.clear();
+                on_tick(current_, static_cast<const std::vector<T>&>(firing_));
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        T value;
+        uint64_t deadline;
+    };
+
+    // The level is the lowest one whose window (relative to the current
+    // tick) contains the deadline, so a slot never aliases an earlier round
+    void place(const Entry& entry) {
+        for (int level = 0; level < kLevels; ++level) {
+            uint32_t shift = kSlotBits * static_cast<uint32_t>(level + 1);
+            if ((entry.deadline >> shift) == (current_ >> shift)) {
+                uint32_t index = (entry.deadline >> (kSlotBits * static_cast<uint32_t>(level))) & (kSlots - 1);
+                slots_[level][index].push_back(entry);
+                counts_[level]++;
+                return;
+            }
+        }
+        overflow_.push_back(entry);
+    }
+
+    // On entering a new window of level L, its slot is spread over the levels
+    // below. Higher levels go first so entries can fall through several.
+    void cascade(uint64_t tick) {
+        if (tick & (kSlots - 1)) {
+            return;
+        }
+        constexpr uint32_t top_shift = kSlotBits * kLevels;
+        if ((tick & ((uint64_t{1} << top_shift) - 1)) == 0 && !overflow_.empty()) {
+            reinsert_.swap(overflow_);
+            for (const Entry& entry : reinsert_) {
+                place(entry);
+            }
+            reinsert_.clear();
+        }
+        for (int level = kLevels - 1; level >= 1; --level) {
+            uint32_t shift = kSlotBits * static_cast<uint32_t>(level);
+            if (tick & ((uint64_t{1} << shift) - 1)) {
+                continue;
+            }
+            auto& slot = slots_[level][(tick >> shift) & (kSlots - 1)];
+            if (slot.empty()) {
+                continue;
+            }
+            counts_[level] -= slot.size();
+            reinsert_.swap(slot);
+            for (const Entry& entry : reinsert_) {
+                place(entry);
+            }
+            reinsert_.clear();
+        }
+    }
+
+    std::array<std::array<std::vector<Entry>, kSlots>, kLevels> slots_;
+    std::array<size_t, kLevels> counts_{};
+    std::vector<Entry> overflow_;
+    std::vector<Entry> reinsert_;
+    std::vector<T> firing_;
+    uint64_t current_;
+    size_t size_{0};
+};
+
+} // namespace quasar
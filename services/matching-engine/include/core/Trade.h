@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Order.h"
 #include <cstdint>
 #include <chrono>
 #include <string>
@@ -16,6 +17,9 @@ struct Trade {
     std::string symbol;
     double price{0.0};
     uint64_t quantity{0};
+    Side taker_side{Side::BUY}; // The incoming order's side; the maker took the other
+    bool maker_filled{false}; // This trade completed the resting order
+    bool taker_filled{false}; // This trade completed the incoming order
     std::chrono::system_clock::time_point timestamp;
 
     Trade() = default;
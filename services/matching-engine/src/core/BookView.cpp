@@ -0,0 +1,18 @@
+#include "core/BookView.h"
+
+namespace quasar {
+
+BookReplica::BookReplica(size_t depth) : depth_(depth), front_(&buffers_[0]) {
+    // Rebuilds then only copy into the buffers, never allocate
+    for (BookView& buffer : buffers_) {
+        buffer.bids.reserve(depth);
+        buffer.asks.reserve(depth);
+    }
+}
+
+EpochDomain& BookReplica::domain() {
+    static EpochDomain* domain = new EpochDomain();
+    return *domain;
+}
+
+} // namespace quasar
@@ -0,0 +1,88 @@
+#include "core/CommandLog.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace quasar {
+
+Command Command::new_order(uint64_t client_id, const std::string& symbol, Side side, double price,
+                           uint64_t quantity) {
+    Command command;
+    command.type = CommandType::NEW_ORDER;
+    command.client_id = client_id;
+    command.side = side == Side::BUY ? 0 : 1;
+    command.price = price;
+    command.quantity = quantity;
+    command.set_symbol(symbol);
+    return command;
+}
+
+Command Command::cancel(const std::string& symbol, uint64_t order_id) {
+    Command command;
+    command.type = CommandType::CANCEL;
+    command.order_id = order_id;
+    command.set_symbol(symbol);
+    return command;
+}
+
+Command Command::handoff(const std::string& symbol, uint32_t partition) {
+    Command command;
+    command.type = CommandType::HANDOFF;
+    command.partition = partition;
+    command.set_symbol(symbol);
+    return command;
+}
+
+bool Command::set_symbol(const std::string& name) {
+    std::memset(symbol, 0, sizeof(symbol));
+    if (name.size() > kMaxSymbolLength) {
+        return false;
+    }
+    std::memcpy(symbol, name.data(), name.size());
+    return true;
+}
+
+CommandLog::CommandLog(const std::string& path) : path_(path) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+}
+
+CommandLog::~CommandLog() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool CommandLog::append(const Command& command, uint64_t* offset) {
+    if (fd_ < 0 || command.symbol[0] == '\0') {
+        return false;
+    }
+    // The lock keeps this handle's write and the offset read after it together
+    std::lock_guard<std::mutex> lock(append_mutex_);
+    if (::write(fd_, &command, sizeof(Command)) != static_cast<ssize_t>(sizeof(Command))) {
+        return false;
+    }
+    if (offset) {
+        off_t end = ::lseek(fd_, 0, SEEK_CUR);
+        *offset = static_cast<uint64_t>(end) / sizeof(Command) - 1;
+    }
+    return true;
+}
+
+size_t CommandLog::read(uint64_t offset, Command* out, size_t max) const {
+    if (fd_ < 0 || max == 0) {
+        return 0;
+    }
+    ssize_t bytes = ::pread(fd_, out, max * sizeof(Command), static_cast<off_t>(offset * sizeof(Command)));
+    return bytes > 0 ? static_cast<size_t>(bytes) / sizeof(Command) : 0;
+}
+
+uint64_t CommandLog::size() const {
+    struct stat info;
+    if (fd_ < 0 || ::fstat(fd_, &info) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(info.st_size) / sizeof(Command);
+}
+
+} // namespace quasar
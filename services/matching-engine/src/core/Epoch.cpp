@@ -0,0 +1,252 @@
+#include "core/Epoch.h"
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+namespace quasar {
+
+namespace {
+
+// Domains alive, by serial. A thread exiting hands its records back under
+// this lock, so a domain cannot be destroyed in the middle of it.
+std::mutex& registry_mutex() {
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+}
+
+std::unordered_set<uint64_t>& live_domains() {
+    static std::unordered_set<uint64_t>* domains = new std::unordered_set<uint64_t>();
+    return *domains;
+}
+
+std::atomic<uint64_t> next_serial{1};
+
+} // namespace
+
+// This thread's record in each domain it has used
+class EpochThreadRecords {
+public:
+    struct Entry {
+        EpochDomain* domain;
+        uint64_t serial;
+        EpochDomain::Record* record;
+    };
+
+    ~EpochThreadRecords() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (const Entry& entry : entries) {
+            if (live_domains().count(entry.serial) != 0) {
+                entry.domain->release(entry.record);
+            }
+        }
+    }
+
+    std::vector<Entry> entries;
+};
+
+namespace {
+
+thread_local EpochThreadRecords thread_records;
+
+} // namespace
+
+EpochDomain::EpochDomain() : serial_(next_serial.fetch_add(1)) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    live_domains().insert(serial_);
+}
+
+EpochDomain::~EpochDomain() {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        live_domains().erase(serial_);
+    }
+    Record* record = records_.load();
+    while (record) {
+        for (const Retired& retired : record->retired) {
+            retired.deleter(retired.object);
+        }
+        Record* next = record->next;
+        delete record;
+        record = next;
+    }
+    for (const Retired& retired : orphans_) {
+        retired.deleter(retired.object);
+    }
+}
+
+EpochDomain& EpochDomain::global() {
+    static EpochDomain* domain = new EpochDomain();
+    return *domain;
+}
+
+EpochDomain::Record* EpochDomain::local() {
+    for (const EpochThreadRecords::Entry& entry : thread_records.entries) {
+        if (entry.domain == this && entry.serial == serial_) {
+            return entry.record;
+        }
+    }
+    Record* record = claim();
+    thread_records.entries.push_back({this, serial_, record});
+    return record;
+}
+
+// A record given up by an exited thread, or a new one
+EpochDomain::Record* EpochDomain::claim() {
+    for (Record* record = records_.load(); record; record = record->next) {
+        bool expected = false;
+        if (!record->claimed.load(std::memory_order_relaxed) &&
+            record->claimed.compare_exchange_strong(expected, true)) {
+            return record;
+        }
+    }
+    Record* record = new Record();
+    record->claimed.store(true, std::memory_order_relaxed);
+    record->retired.reserve(4 * kCollectEvery);  // the most kept between collections
+    Record* head = records_.load();
+    do {
+        record->next = head;
+    } while (!records_.compare_exchange_weak(head, record));
+    return record;
+}
+
+// Called with the registry lock held, by the exiting owner
+void EpochDomain::release(Record* record) {
+    {
+        std::lock_guard<std::mutex> lock(orphans_mutex_);
+        orphans_.insert(orphans_.end(), record->retired.begin(), record->retired.end());
+    }
+    record->retired.clear();
+    record->depth = 0;
+    record->since_collect = 0;
+    record->pinned.store(0);
+    record->claimed.store(false);
+}
+
+void EpochDomain::enter() {
+    Record* record = local();
+    if (record->depth++ != 0) {
+        return;
+    }
+    // Pin, then make sure the epoch did not move before the pin was visible
+    uint64_t epoch = epoch_.load();
+    while (true) {
+        record->pinned.store(epoch);
+        uint64_t now = epoch_.load();
+        if (now == epoch) {
+            break;
+        }
+        epoch = now;
+    }
+}
+
+void EpochDomain::exit() {
+    Record* record = local();
+    if (--record->depth == 0) {
+        record->pinned.store(0, std::memory_order_release);
+    }
+}
+
+void EpochDomain::retire(void* object, Deleter deleter) {
+    // No reader pinned now: any reader that pins later cannot reach the
+    // object any more, so it goes straight away (and the limbo stays empty
+    // while nobody reads)
+    if (!any_pinned()) {
+        deleter(object);
+        return;
+    }
+    Record* record = local();
+    record->retired.push_back({object, deleter, epoch_.load()});
+    retired_.fetch_add(1, std::memory_order_relaxed);
+    if (++record->since_collect >= kCollectEvery) {
+        record->since_collect = 0;
+        try_advance();
+        free_safe(record->retired);
+    }
+}
+
+bool EpochDomain::any_pinned() const {
+    for (Record* record = records_.load(); record; record = record->next) {
+        if (record->pinned.load() != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The epoch moves on once every pinned reader is in it
+bool EpochDomain::try_advance() {
+    uint64_t epoch = epoch_.load();
+    for (Record* record = records_.load(); record; record = record->next) {
+        uint64_t pinned = record->pinned.load();
+        if (pinned != 0 && pinned != epoch) {
+            return false;
+        }
+    }
+    return epoch_.compare_exchange_strong(epoch, epoch + 1);
+}
+
+// Free the entries retired at least two epochs ago
+size_t EpochDomain::free_safe(std::vector<Retired>& list) {
+    uint64_t epoch = epoch_.load();
+    auto safe_end = std::partition_point(list.begin(), list.end(),
+                                         [epoch](const Retired& retired) { return retired.epoch + 2 <= epoch; });
+    size_t count = static_cast<size_t>(safe_end - list.begin());
+    for (auto it = list.begin(); it != safe_end; ++it) {
+        it->deleter(it->object);
+    }
+    list.erase(list.begin(), safe_end);
+    freed_.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+size_t EpochDomain::collect() {
+    Record* record = local();
+    try_advance();
+    size_t freed = free_safe(record->retired);
+    std::unique_lock<std::mutex> lock(orphans_mutex_, std::try_to_lock);
+    if (lock.owns_lock() && !orphans_.empty()) {
+        // Orphans come from several threads, so their epochs are not in order
+        uint64_t epoch = epoch_.load();
+        auto unsafe = std::stable_partition(orphans_.begin(), orphans_.end(), [epoch](const Retired& retired) {
+            return retired.epoch + 2 <= epoch;
+        });
+        std::vector<Retired> safe(orphans_.begin(), unsafe);
+        orphans_.erase(orphans_.begin(), unsafe);
+        lock.unlock();
+        for (const Retired& retired : safe) {
+            retired.deleter(retired.object);
+        }
+        freed_.fetch_add(safe.size(), std::memory_order_relaxed);
+        freed += safe.size();
+    }
+    return freed;
+}
+
+bool EpochDomain::synchronize() {
+    Record* record = local();
+    if (record->depth != 0) {
+        return false;
+    }
+    uint64_t target = epoch_.load() + 2;
+    while (epoch_.load() < target) {
+        if (!try_advance()) {
+            std::this_thread::yield();
+        }
+    }
+    collect();
+    return true;
+}
+
+bool EpochDomain::quiesced(uint64_t since) {
+    if (!any_pinned()) {
+        return true;
+    }
+    // Twice: the first move may only have caught the epoch up with readers
+    // pinned since
+    for (int attempt = 0; attempt < 2 && epoch_.load() < since + 2; ++attempt) {
+        try_advance();
+    }
+    return epoch_.load() >= since + 2;
+}
+
+} // namespace quasar
@@ -1,141 +1,1111 @@
 #include "core/MatchingEngine.h"
+#include "common/AllocationTracker.h"
+#include "core/Epoch.h"
+#include <chrono>
 #include <iostream>
 
 namespace quasar {
 
-MatchingEngine::MatchingEngine() {}
+namespace {
+
+struct Scratch {
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired_ids;
+    std::vector<EngineEvent> events;
+};
+
+// Per-thread trade buffers that keep their capacity between calls, one set
+// per Tag. A call re-entered from a trade callback gets buffers of its own.
+template<typename Tag>
+class ScratchLease {
+public:
+    ScratchLease() : reuse_(!busy_) {
+        scratch_ = reuse_ ? &reusable_ : &nested_;
+        scratch_->trades.clear();
+        scratch_->expired_ids.clear();
+        scratch_->events.clear();
+        busy_ = true;
+    }
+
+    ~ScratchLease() {
+        if (reuse_) {
+            busy_ = false;
+        }
+    }
+
+    Scratch& get() { return *scratch_; }
+
+private:
+    static thread_local Scratch reusable_;
+    static thread_local bool busy_;
+    bool reuse_;
+    Scratch nested_;
+    Scratch* scratch_;
+};
+
+template<typename Tag>
+thread_local Scratch ScratchLease<Tag>::reusable_;
+template<typename Tag>
+thread_local bool ScratchLease<Tag>::busy_ = false;
+
+struct SubmitTag {};
+struct RequoteTag {};
+struct CancelTag {};
+struct WarmTag {};
+
+// A book's event lock, held while events are streamed (see
+// OrderBookBase::event_mutex); an empty lock otherwise
+std::unique_lock<std::mutex> lock_events(OrderBookBase* book, bool streaming) {
+    return streaming ? std::unique_lock<std::mutex>(book->event_mutex()) : std::unique_lock<std::mutex>();
+}
+
+EngineEvent order_event(EngineEventType type, uint64_t order_id, uint64_t client_id, uint32_t symbol_id) {
+    EngineEvent event;
+    event.type = type;
+    event.order_id = order_id;
+    event.client_id = client_id;
+    event.symbol_id = symbol_id;
+    return event;
+}
+
+EngineEvent order_event(EngineEventType type, const Order& order, uint32_t symbol_id) {
+    EngineEvent event = order_event(type, order.order_id, order.client_id, symbol_id);
+    event.side = order.side;
+    event.order_type = order.type;
+    event.price = order.price;
+    event.quantity = type == EngineEventType::RESTED ? order.remaining_quantity() : order.quantity;
+    return event;
+}
+
+EngineEvent fill_event(const Trade& trade, uint32_t symbol_id) {
+    EngineEvent event = order_event(EngineEventType::FILL, trade.taker_order_id, trade.taker_client_id, symbol_id);
+    event.contra_order_id = trade.maker_order_id;
+    event.contra_client_id = trade.maker_client_id;
+    event.trade_id = trade.trade_id;
+    event.side = trade.taker_side;
+    event.price = trade.price;
+    event.quantity = trade.quantity;
+    event.detail = (trade.taker_filled ? kTakerFilled : 0) | (trade.maker_filled ? kMakerFilled : 0);
+    return event;
+}
+
+RejectReason reject_reason(RiskReject reject) {
+    switch (reject) {
+        case RiskReject::ORDER_QUANTITY: return RejectReason::ORDER_QUANTITY;
+        case RiskReject::ORDER_NOTIONAL: return RejectReason::ORDER_NOTIONAL;
+        case RiskReject::PRICE_COLLAR: return RejectReason::PRICE_COLLAR;
+        case RiskReject::OPEN_ORDERS: return RejectReason::OPEN_ORDERS;
+        case RiskReject::NONE: break;
+    }
+    return RejectReason::NONE;
+}
+
+RejectReason reject_reason(BookReject reject) {
+    switch (reject) {
+        case BookReject::UNPRICED_PEG: return RejectReason::UNPRICED_PEG;
+        case BookReject::INVALID_PRICE: return RejectReason::INVALID_PRICE;
+        case BookReject::NONE: break;
+    }
+    return RejectReason::NONE;
+}
+
+EngineEvent reject_event(uint64_t order_id, uint64_t client_id, uint32_t symbol_id, RejectReason reason) {
+    EngineEvent event = order_event(EngineEventType::REJECTED, order_id, client_id, symbol_id);
+    event.detail = static_cast<uint8_t>(reason);
+    return event;
+}
+
+} // namespace
+
+MatchingEngine::MatchingEngine(BookType default_book_type, uint32_t shard)
+    : shard_(shard % kMaxShards),
+      default_book_type_(default_book_type),
+      open_orders_(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+                   PoolAllocator<std::pair<const uint64_t, uint64_t>>(order_map_pool_)) {}
+
+bool MatchingEngine::set_book_type(const std::string& symbol, BookType type,
+                                   const BookConfig& config) {
+    // The heap policy has no per-level queues to share a fill across
+    if (type == BookType::HEAP && config.matching != MatchingAlgorithm::FIFO) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    if (order_books_.count(symbol)) {
+        return false;
+    }
+    book_types_[symbol] = {type, config};
+    return true;
+}
+
+BookType MatchingEngine::get_book_type(const std::string& symbol) const {
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    auto it = order_books_.find(symbol);
+    if (it != order_books_.end()) {
+        return it->second->get_book_type();
+    }
+    auto type_it = book_types_.find(symbol);
+    return type_it != book_types_.end() ? type_it->second.first : default_book_type_;
+}
 
 uint64_t MatchingEngine::submit_order(uint64_t client_id, const std::string& symbol,
                                       Side side, double price, uint64_t quantity) {
-    // Generate order ID
-    uint64_t order_id = next_order_id_.fetch_add(1);
+    QUASAR_HOT_REGION("MatchingEngine::submit_order");
 
-    // Create order
-    auto order = std::make_unique<Order>(order_id, client_id, symbol, side, price, quantity);
-    Order* order_ptr = order.get();
+    // The id is given by the order's book (see submit)
+    return submit(std::make_unique<Order>(0, client_id, symbol, side, price, quantity));
+}
+
+uint64_t MatchingEngine::submit_order(uint64_t client_id, const std::string& symbol, Side side, double price,
+                                      uint64_t quantity, TimeInForce time_in_force, uint64_t expire_time) {
+    auto order = std::make_unique<Order>(0, client_id, symbol, side, price, quantity);
+    order->time_in_force = time_in_force;
+    order->expire_time = expire_time;
+    return submit(std::move(order));
+}
+
+uint64_t MatchingEngine::submit_stop_order(uint64_t client_id, const std::string& symbol, Side side,
+                                           OrderType type, double stop_price, double limit_price,
+                                           uint64_t quantity) {
+    auto order = std::make_unique<Order>(0, client_id, symbol, side,
+                                         type == OrderType::STOP_LIMIT ? limit_price : 0.0, quantity);
+    order->type = type == OrderType::STOP_LIMIT ? OrderType::STOP_LIMIT : OrderType::STOP;
+    order->stop_price = stop_price;
+    return submit(std::move(order));
+}
+
+uint64_t MatchingEngine::submit_iceberg_order(uint64_t client_id, const std::string& symbol, Side side,
+                                              double price, uint64_t quantity, uint64_t display_quantity) {
+    auto order = std::make_unique<Order>(0, client_id, symbol, side, price, quantity);
+    // A peak at or above the total is an ordinary, fully displayed order
+    order->display_quantity = display_quantity < quantity ? display_quantity : 0;
+    return submit(std::move(order));
+}
+
+uint64_t MatchingEngine::submit_peg_order(uint64_t client_id, const std::string& symbol, Side side,
+                                          OrderType type, double peg_offset, uint64_t quantity) {
+    auto order = std::make_unique<Order>(0, client_id, symbol, side, 0.0, quantity);
+    order->type = type == OrderType::PEG_MIDPOINT ? OrderType::PEG_MIDPOINT : OrderType::PEG_PRIMARY;
+    order->peg_offset = peg_offset > 0.0 ? peg_offset : 0.0;
+    return submit(std::move(order));
+}
+
+// Order entry, timed while a latency limit is set. Every order counts toward
+// the average, shed ones too: those are quick, so the average comes back
+// down while the engine is overloaded and new orders are let in again.
+uint64_t MatchingEngine::submit(std::unique_ptr<Order> order) {
+    if (!admission_.timed()) {
+        return enter_order(std::move(order), true);
+    }
+    auto start = std::chrono::steady_clock::now();
+    uint64_t order_id = enter_order(std::move(order), true);
+    admission_.record_latency(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    if (admission_.update()) {
+        publish_overload();
+    }
+    return order_id;
+}
+
+uint64_t MatchingEngine::enter_order(std::unique_ptr<Order> order, bool admit, size_t* trade_count) {
+    const std::string& symbol = order->symbol;
+    bool streaming = events_.active();
+
+    // Shed new orders while overloaded, before any work for them: no book
+    // lookup, no order id, no new symbol
+    if (admit && admission_.overloaded()) {
+        {
+            std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+            stats_.total_orders++;
+            stats_.rejected_orders++;
+            stats_.busy_rejects++;
+        }
+        if (streaming) {
+            publish_reject(0, order->client_id, 0, RejectReason::SYSTEM_BUSY);
+        }
+        return 0;
+    }
+
+    // Get or create order book. A new symbol only takes an id (and a book)
+    // for an order the checks needing no book let through.
+    OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        RiskReject reject;
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            reject = risk_.check(*order);
+        }
+        if (reject != RiskReject::NONE) {
+            {
+                std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                stats_.total_orders++;
+                stats_.rejected_orders++;
+            }
+            if (streaming) {
+                publish_reject(0, order->client_id, 0, reject_reason(reject));
+            }
+            return 0;
+        }
+        book = get_or_create_book(symbol);
+    }
+    if (!book) {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        stats_.total_orders++;
+        stats_.rejected_orders++;
+        return 0;
+    }
+
+    // The book numbers the order
+    uint64_t order_id = book->next_order_id();
+    order->order_id = order_id;
+
+    // Orders with a time in force need an expiry still ahead of the clock
+    bool expires = order->time_in_force != TimeInForce::GTC;
+    if (expires) {
+        bool expired;
+        {
+            std::lock_guard<std::mutex> lock(expiry_mutex_);
+            if (order->time_in_force == TimeInForce::DAY) {
+                order->expire_time = session_close_us_;
+            }
+            expired = order->expire_time <= now_us_;
+        }
+        if (expired) {
+            {
+                std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                stats_.total_orders++;
+                stats_.rejected_orders++;
+            }
+            if (streaming) {
+                publish_reject(order_id, order->client_id, book->get_symbol_id(), RejectReason::EXPIRE_TIME);
+            }
+            return 0;
+        }
+    }
+    uint64_t expire_time = order->expire_time;
+
+    // Risk checks, then track order to symbol mapping. The reference price is
+    // only read when a limit needs it.
+    double reference_price = risk_uses_reference_.load(std::memory_order_relaxed) ? book->get_reference_price() : 0.0;
+    RiskReject reject;
+    {
+        std::lock_guard<std::mutex> lock(order_map_mutex_);
+        reject = risk_.open(*order, reference_price);
+        if (reject == RiskReject::NONE) {
+            open_orders_.emplace(order_id, order->client_id);
+        }
+    }
 
     // Update stats
     {
         std::lock_guard<std::mutex> lock(stats_mutex_);
         stats_.total_orders++;
-        stats_.active_orders++;
+        if (reject != RiskReject::NONE) {
+            stats_.rejected_orders++;
+        } else {
+            stats_.active_orders++;
+        }
+    }
+    if (reject != RiskReject::NONE) {
+        if (streaming) {
+            publish_reject(order_id, order->client_id, book->get_symbol_id(), reject_reason(reject));
+        }
+        return 0;
     }
 
-    // Track order to symbol mapping
-    {
-        std::lock_guard<std::mutex> lock(order_map_mutex_);
-        order_to_symbol_[order_id] = symbol;
+    // Trades (and events) go into per-thread buffers that keep their capacity between orders
+    ScratchLease<SubmitTag> lease;
+    Scratch& scratch = lease.get();
+    uint64_t client_id = order->client_id;
+    if (streaming) {
+        scratch.events.push_back(order_event(EngineEventType::ACCEPTED, *order, book->get_symbol_id()));
     }
 
-    // Get or create order book
-    OrderBook* book = get_or_create_book(symbol);
+    // Process the order (plus any stops it triggers), keeping the book's
+    // events in book order until they are published
+    std::unique_lock<std::mutex> sequence = lock_events(book, streaming);
+    BookReject book_reject = book->process_order(std::move(order), scratch.trades, &scratch.expired_ids);
+    if (book_reject != BookReject::NONE) {
+        // The book kept nothing: take back the accept, and report a reject
+        // in place of the ACCEPTED event
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            forget_order(order_id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.rejected_orders++;
+            stats_.active_orders--;
+        }
+        if (streaming) {
+            scratch.events.clear();
+            scratch.events.push_back(reject_event(order_id, client_id, book->get_symbol_id(), reject_reason(book_reject)));
+            events_.publish(scratch.events.data(), scratch.events.size());
+        }
+        return 0;
+    }
+    settle(book, scratch.trades, scratch.expired_ids, streaming ? &scratch.events : nullptr);
+    if (trade_count) {
+        *trade_count = scratch.trades.size();
+    }
 
-    // Process the order
-    std::vector<Trade> trades = book->process_order(std::move(order));
+    // Only an order left resting needs an expiry (rounded up to the next
+    // tick) or a RESTED event; the book still holds it then
+    if (expires || streaming) {
+        bool resting;
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            resting = open_orders_.count(order_id) > 0;
+        }
+        if (resting && expires) {
+            std::lock_guard<std::mutex> lock(expiry_mutex_);
+            expiry_wheel_.schedule(ScheduledExpiry{book, order_id},
+                                   (expire_time + kExpiryTickMicros - 1) / kExpiryTickMicros);
+        }
+        if (streaming) {
+            if (resting) {
+                append_rested(book, order_id, scratch.events);
+            }
+            append_level_changes(book, scratch.events);
+            events_.publish(scratch.events.data(), scratch.events.size());
+        }
+    }
+    if (sequence.owns_lock()) {
+        sequence.unlock();
+    }
+    report_trades(scratch.trades);
+    return order_id;
+}
+
+// Bookkeeping after a book call: forget orders that no longer rest in the
+// book (the book has released them), count expirations and build events
+void MatchingEngine::settle(OrderBookBase* book, const std::vector<Trade>& trades,
+                            const std::vector<uint64_t>& expired_ids, std::vector<EngineEvent>* events) {
+    {
+        std::lock_guard<std::mutex> lock(order_map_mutex_);
+        for (const auto& trade : trades) {
+            if (trade.taker_filled) {
+                forget_order(trade.taker_order_id);
+            }
+            if (trade.maker_filled) {
+                forget_order(trade.maker_order_id);
+            }
+            if (events) {
+                events->push_back(fill_event(trade, book->get_symbol_id()));
+            }
+        }
+        for (uint64_t expired_id : expired_ids) {
+            uint64_t client_id = 0;
+            forget_order(expired_id, &client_id);
+            if (events) {
+                events->push_back(order_event(EngineEventType::CANCELLED, expired_id, client_id, book->get_symbol_id()));
+            }
+        }
+    }
 
-    // Check if the submitted (taker) order was filled
-    if (order_ptr->is_filled()) {
+    if (!expired_ids.empty()) {
         std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.active_orders--;
+        stats_.cancelled_orders += expired_ids.size();
+        stats_.active_orders -= expired_ids.size();
     }
+}
 
-    //Process trades
+// Trade callbacks and stats for a settled book call, made once the book's
+// event lock is released: a callback may call back into the engine
+void MatchingEngine::report_trades(const std::vector<Trade>& trades) {
     for (const auto& trade : trades) {
         notify_trade(trade);
-        update_stats_for_trade(trade, book);
+        update_stats_for_trade(trade);
     }
+}
 
-    return order_id;
+// Drop a resting order's mapping and its client's open order (order map lock held)
+bool MatchingEngine::forget_order(uint64_t order_id, uint64_t* client_id) {
+    auto it = open_orders_.find(order_id);
+    if (it == open_orders_.end()) {
+        return false;
+    }
+    if (client_id) {
+        *client_id = it->second;
+    }
+    risk_.close(it->second);
+    open_orders_.erase(it);
+    return true;
 }
 
-bool MatchingEngine::cancel_order(uint64_t order_id) {
-    // Find symbol for this order
-    std::string symbol;
-    {
-        std::lock_guard<std::mutex> lock(order_map_mutex_);
-        auto it = order_to_symbol_.find(order_id);
-        if (it == order_to_symbol_.end()) {
-            return false;
+void MatchingEngine::unsubscribe_events(const void* sink) {
+    events_.unsubscribe(sink);
+    if (!events_.active()) {
+        set_level_tracking(false);
+    }
+}
+
+uint64_t MatchingEngine::get_last_event_sequence() const {
+    return events_.last_sequence();
+}
+
+std::string MatchingEngine::get_symbol_name(uint32_t symbol_id) const {
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    return symbol_id != 0 && symbol_id <= symbol_names_.size() ? symbol_names_[symbol_id - 1] : std::string();
+}
+
+void MatchingEngine::set_level_tracking(bool on) {
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    for (auto& [symbol, book] : order_books_) {
+        book->track_level_changes(on);
+    }
+}
+
+// RESTED for an order a book call left open. The book owns the order: another
+// thread (or a trade callback) may fill or cancel it as soon as the book lock
+// drops, so it is only read through get_order under a guard, never through a
+// pointer kept from before the call.
+void MatchingEngine::append_rested(OrderBookBase* book, uint64_t order_id, std::vector<EngineEvent>& events) {
+    EpochGuard guard;
+    const Order* order = book->get_order(order_id);
+    if (order && order->is_active() && !order->is_pending_stop()) {
+        events.push_back(order_event(EngineEventType::RESTED, *order, book->get_symbol_id()));
+    }
+}
+
+// BOOK_DELTA events for the levels a book call changed
+void MatchingEngine::append_level_changes(OrderBookBase* book, std::vector<EngineEvent>& events) {
+    thread_local std::vector<LevelUpdate> updates;
+    updates.clear();
+    book->take_level_changes(updates);
+    for (const LevelUpdate& update : updates) {
+        EngineEvent event = order_event(EngineEventType::BOOK_DELTA, 0, 0, book->get_symbol_id());
+        event.side = update.side;
+        event.price = update.price;
+        event.quantity = update.quantity;
+        event.trade_id = update.order_count;
+        events.push_back(event);
+    }
+}
+
+void MatchingEngine::publish_reject(uint64_t order_id, uint64_t client_id, uint32_t symbol_id,
+                                    RejectReason reason) {
+    EngineEvent event = reject_event(order_id, client_id, symbol_id, reason);
+    events_.publish(&event, 1);
+}
+
+void MatchingEngine::set_admission_limits(const AdmissionLimits& limits) {
+    bool was = admission_.overloaded();
+    admission_.set_limits(limits);
+    if (admission_.update() || was != admission_.overloaded()) {
+        publish_overload();
+    }
+}
+
+void MatchingEngine::report_queue_depth(uint64_t depth) {
+    if (!admission_.enabled()) {
+        return;
+    }
+    admission_.set_queue_depth(depth);
+    if (admission_.update()) {
+        publish_overload();
+    }
+}
+
+void MatchingEngine::publish_overload() {
+    if (!events_.active()) {
+        return;
+    }
+    EngineEvent event = order_event(EngineEventType::OVERLOAD, 0, 0, 0);
+    event.detail = admission_.overloaded() ? 1 : 0;
+    event.quantity = admission_.queue_depth();
+    event.price = admission_.latency_ns() / 1000.0;
+    events_.publish(&event, 1);
+}
+
+void MatchingEngine::set_risk_limits(const RiskLimits& limits) {
+    std::lock_guard<std::mutex> lock(order_map_mutex_);
+    risk_.set_default_limits(limits);
+    risk_uses_reference_.store(risk_.uses_reference());
+}
+
+void MatchingEngine::set_client_risk_limits(uint64_t client_id, const RiskLimits& limits) {
+    std::lock_guard<std::mutex> lock(order_map_mutex_);
+    risk_.set_client_limits(client_id, limits);
+    risk_uses_reference_.store(risk_.uses_reference());
+}
+
+uint32_t MatchingEngine::get_open_order_count(uint64_t client_id) const {
+    std::lock_guard<std::mutex> lock(order_map_mutex_);
+    return risk_.open_orders(client_id);
+}
+
+// Both quoted sides against the client's size, notional and collar limits.
+// No book yet (a symbol not yet traded) means no reference price.
+RiskReject MatchingEngine::quote_within_limits(uint64_t client_id, const OrderBookBase* book,
+                                               const QuoteEntry& quote) {
+    double reference_price =
+        book && risk_uses_reference_.load(std::memory_order_relaxed) ? book->get_reference_price() : 0.0;
+    std::lock_guard<std::mutex> lock(order_map_mutex_);
+    const RiskLimits& limits = risk_.limits_for(client_id);
+    RiskReject reject = RiskReject::NONE;
+    if (quote.bid_quantity != 0) {
+        reject = RiskTable::check_order(limits, OrderType::LIMIT, quote.bid_price, quote.bid_quantity, reference_price);
+    }
+    if (reject == RiskReject::NONE && quote.ask_quantity != 0) {
+        reject = RiskTable::check_order(limits, OrderType::LIMIT, quote.ask_price, quote.ask_quantity, reference_price);
+    }
+    return reject;
+}
+
+MatchingEngine::MassQuoteAck MatchingEngine::mass_quote(uint64_t client_id, uint64_t quote_id,
+                                                        const std::vector<QuoteEntry>& quotes) {
+    QUASAR_HOT_REGION("MatchingEngine::mass_quote");
+
+    MassQuoteAck ack;
+    ack.quote_id = quote_id;
+    ack.entries = static_cast<uint32_t>(quotes.size());
+
+    for (const QuoteEntry& quote : quotes) {
+        bool bid_ok = quote.bid_quantity == 0 || quote.bid_price > 0.0;
+        bool ask_ok = quote.ask_quantity == 0 || quote.ask_price > 0.0;
+        bool crossed = quote.bid_quantity > 0 && quote.ask_quantity > 0 && quote.bid_price >= quote.ask_price;
+        if (quote.symbol.empty() || !bid_ok || !ask_ok || crossed) {
+            ack.rejected_entries++;
+            if (events_.active()) {
+                publish_reject(0, client_id, 0, RejectReason::INVALID_QUOTE);
+            }
+            continue;
+        }
+
+        // Checked before a new symbol takes a book
+        OrderBookBase* book = find_book(quote.symbol);
+        RiskReject reject = quote_within_limits(client_id, book, quote);
+        if (reject != RiskReject::NONE) {
+            ack.rejected_entries++;
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                stats_.rejected_orders++;
+            }
+            if (events_.active()) {
+                publish_reject(0, client_id, book ? book->get_symbol_id() : 0, reject_reason(reject));
+            }
+            continue;
+        }
+        if (!book && !(book = get_or_create_book(quote.symbol))) {
+            ack.rejected_entries++;
+            continue;
         }
-        symbol = it->second;
+
+        // The slot is read and written back around the book calls, so trade
+        // callbacks are free to quote too
+        QuoteSlot slot;
+        {
+            std::lock_guard<std::mutex> lock(quotes_mutex_);
+            slot = quote_slots_[client_id][quote.symbol];
+        }
+        slot.bid_order_id = requote_side(client_id, book, Side::BUY, slot.bid_order_id,
+                                         quote.bid_price, quote.bid_quantity, ack);
+        slot.ask_order_id = requote_side(client_id, book, Side::SELL, slot.ask_order_id,
+                                         quote.ask_price, quote.ask_quantity, ack);
+
+        std::lock_guard<std::mutex> lock(quotes_mutex_);
+        quote_slots_[client_id][quote.symbol] = slot;
     }
+    return ack;
+}
 
-    // Find order book
-    OrderBook* book = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(order_books_mutex_);
-        auto it = order_books_.find(symbol);
-        if (it != order_books_.end()) {
-            book = it->second.get();
+// Bring one quote side to (price, quantity), returning the order id now in the slot
+uint64_t MatchingEngine::requote_side(uint64_t client_id, OrderBookBase* book, Side side, uint64_t order_id,
+                                      double price, uint64_t quantity, MassQuoteAck& ack) {
+    if (quantity == 0) {
+        if (order_id != 0 && cancel_order(order_id)) {
+            ack.sides_pulled++;
+        }
+        return 0;
+    }
+
+    if (order_id != 0) {
+        ScratchLease<RequoteTag> lease;
+        Scratch& scratch = lease.get();
+        bool streaming = events_.active();
+        std::unique_lock<std::mutex> sequence = lock_events(book, streaming);
+        ReplaceResult result = book->replace_order(order_id, price, quantity, scratch.trades, &scratch.expired_ids);
+        if (result != ReplaceResult::REJECTED) {
+            if (result == ReplaceResult::RESIZED) {
+                ack.sides_resized++;
+            } else {
+                ack.sides_reentered++;
+            }
+            ack.trades += static_cast<uint32_t>(scratch.trades.size());
+            if (streaming) {
+                // Accepted again at its new price and open size, ahead of its fills
+                EngineEvent accepted = order_event(EngineEventType::ACCEPTED, order_id, client_id, book->get_symbol_id());
+                accepted.side = side;
+                accepted.price = price;
+                accepted.quantity = quantity;
+                scratch.events.push_back(accepted);
+            }
+            settle(book, scratch.trades, scratch.expired_ids, streaming ? &scratch.events : nullptr);
+            if (streaming) {
+                // and RESTED there, unless it filled
+                bool resting;
+                {
+                    std::lock_guard<std::mutex> lock(order_map_mutex_);
+                    resting = open_orders_.count(order_id) > 0;
+                }
+                if (resting) {
+                    append_rested(book, order_id, scratch.events);
+                }
+                append_level_changes(book, scratch.events);
+                events_.publish(scratch.events.data(), scratch.events.size());
+                sequence.unlock();
+            }
+            report_trades(scratch.trades);
+            return order_id;
+        }
+        // Filled since the last quote, or not movable in place
+        if (streaming) {
+            sequence.unlock();
         }
+        cancel_order(order_id);
     }
 
+    size_t trades = 0;
+    uint64_t new_id = enter_order(std::make_unique<Order>(0, client_id, book->get_symbol(), side, price, quantity),
+                                 false, &trades);
+    if (new_id != 0) {
+        ack.trades += static_cast<uint32_t>(trades);
+        ack.sides_entered++;
+    }
+    return new_id;
+}
+
+bool MatchingEngine::cancel_order(uint64_t order_id) {
+    QUASAR_HOT_REGION("MatchingEngine::cancel_order");
+
+    // The id names the book; an unknown or foreign id finds none
+    OrderBookBase* book = book_of(order_id);
     if (!book) {
         return false;
     }
 
     // Cancel the order
+    std::unique_lock<std::mutex> sequence = lock_events(book, events_.active());
     bool success = book->cancel_order(order_id);
 
     if (success) {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.cancelled_orders++;
-        stats_.active_orders--;
+        uint64_t client_id = 0;
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            forget_order(order_id, &client_id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.cancelled_orders++;
+            stats_.active_orders--;
+        }
+        if (sequence.owns_lock()) {
+            ScratchLease<CancelTag> lease;
+            Scratch& scratch = lease.get();
+            scratch.events.push_back(order_event(EngineEventType::CANCELLED, order_id, client_id, book->get_symbol_id()));
+            append_level_changes(book, scratch.events);
+            events_.publish(scratch.events.data(), scratch.events.size());
+        }
     }
 
     return success;
 }
 
-double MatchingEngine::get_best_bid(const std::string& symbol) const {
+void MatchingEngine::start_auction(const std::string& symbol) {
+    if (OrderBookBase* book = get_or_create_book(symbol)) {
+        book->start_auction();
+    }
+}
+
+AuctionResult MatchingEngine::get_indicative_auction(const std::string& symbol) const {
     std::lock_guard<std::mutex> lock(order_books_mutex_);
     auto it = order_books_.find(symbol);
     if (it != order_books_.end()) {
-        return it->second->get_best_bid();
+        return it->second->indicative_auction();
     }
-    return 0.0;
+    return AuctionResult{};
 }
 
-double MatchingEngine::get_best_ask(const std::string& symbol) const {
+AuctionResult MatchingEngine::uncross(const std::string& symbol, bool continue_auction) {
+    OrderBookBase* book = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(order_books_mutex_);
+        auto it = order_books_.find(symbol);
+        if (it == order_books_.end()) {
+            return AuctionResult{};
+        }
+        book = it->second.get();
+    }
+
+    ScratchLease<SubmitTag> lease;
+    Scratch& scratch = lease.get();
+    bool streaming = events_.active();
+    std::unique_lock<std::mutex> sequence = lock_events(book, streaming);
+    AuctionResult result = book->uncross(scratch.trades, &scratch.expired_ids, continue_auction);
+    settle(book, scratch.trades, scratch.expired_ids, streaming ? &scratch.events : nullptr);
+    if (streaming) {
+        append_level_changes(book, scratch.events);
+        events_.publish(scratch.events.data(), scratch.events.size());
+        sequence.unlock();
+    }
+    report_trades(scratch.trades);
+    return result;
+}
+
+size_t MatchingEngine::advance_time(uint64_t now_us) {
+    // Collect what is due under the clock lock, then expire it tick by tick
+    // without it, so callbacks may submit orders
+    thread_local std::vector<ScheduledExpiry> due;
+    thread_local std::vector<size_t> tick_ends;
+    due.clear();
+    tick_ends.clear();
+    {
+        std::lock_guard<std::mutex> lock(expiry_mutex_);
+        if (now_us <= now_us_) {
+            return 0;
+        }
+        now_us_ = now_us;
+        expiry_wheel_.advance(now_us / kExpiryTickMicros, [](uint64_t, const std::vector<ScheduledExpiry>& tick) {
+            due.insert(due.end(), tick.begin(), tick.end());
+            tick_ends.push_back(due.size());
+        });
+    }
+
+    size_t expired_before = get_stats().expired_orders;
+    size_t begin = 0;
+    for (size_t end : tick_ends) {
+        expire_batch(due.data() + begin, end - begin);
+        begin = end;
+    }
+    return get_stats().expired_orders - expired_before;
+}
+
+// Expire one tick's orders: grouped by book, each book removes its group under
+// one lock (skipping orders already filled or cancelled) and reports each
+// level it changed once
+void MatchingEngine::expire_batch(const ScheduledExpiry* due, size_t count) {
+    thread_local std::unordered_map<OrderBookBase*, size_t> group_index;
+    thread_local std::vector<std::pair<OrderBookBase*, std::vector<uint64_t>>> groups;
+    thread_local std::vector<uint64_t> expired_ids;
+    thread_local std::vector<LevelUpdate> updates;
+    thread_local std::vector<EngineEvent> events;
+    group_index.clear();
+    size_t group_count = 0;
+
+    OrderBookBase* last_book = nullptr;
+    std::vector<uint64_t>* last_ids = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        if (due[i].book != last_book) {
+            auto [it, inserted] = group_index.try_emplace(due[i].book, group_count);
+            if (inserted) {
+                if (groups.size() == group_count) {
+                    groups.emplace_back();
+                }
+                groups[group_count].first = due[i].book;
+                groups[group_count].second.clear();
+                group_count++;
+            }
+            last_book = due[i].book;
+            last_ids = &groups[it->second].second;
+        }
+        last_ids->push_back(due[i].order_id);
+    }
+
+    for (size_t g = 0; g < group_count; ++g) {
+        OrderBookBase* book = groups[g].first;
+        expired_ids.clear();
+        updates.clear();
+        bool streaming = events_.active();
+        std::unique_lock<std::mutex> sequence = lock_events(book, streaming);
+        book->expire_orders(groups[g].second, expired_ids, updates);
+        if (expired_ids.empty()) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            for (uint64_t expired_id : expired_ids) {
+                uint64_t client_id = 0;
+                forget_order(expired_id, &client_id);
+                if (streaming) {
+                    events.push_back(order_event(EngineEventType::EXPIRED, expired_id, client_id, book->get_symbol_id()));
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.expired_orders += expired_ids.size();
+            stats_.active_orders -= expired_ids.size();
+        }
+        if (streaming) {
+            append_level_changes(book, events);
+            events_.publish(events.data(), events.size());
+            events.clear();
+            sequence.unlock();
+        }
+
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        if (level_update_callback_) {
+            for (const LevelUpdate& update : updates) {
+                level_update_callback_(book->get_symbol(), update);
+            }
+        }
+    }
+}
+
+uint64_t MatchingEngine::get_time() const {
+    std::lock_guard<std::mutex> lock(expiry_mutex_);
+    return now_us_;
+}
+
+void MatchingEngine::set_session_close(uint64_t close_time_us) {
+    std::lock_guard<std::mutex> lock(expiry_mutex_);
+    session_close_us_ = close_time_us;
+}
+
+bool MatchingEngine::set_book_views(size_t depth) {
     std::lock_guard<std::mutex> lock(order_books_mutex_);
-    auto it = order_books_.find(symbol);
-    if (it != order_books_.end()) {
-        return it->second->get_best_ask();
+    if (depth == 0 || view_depth_.load(std::memory_order_relaxed) != 0) {
+        return false;
+    }
+    for (auto& [symbol, book] : order_books_) {
+        book->enable_view(depth, &view_backlog_);
+    }
+    view_depth_.store(depth, std::memory_order_release);
+    return true;
+}
+
+size_t MatchingEngine::refresh_book_views() {
+    if (view_depth_.load(std::memory_order_acquire) == 0) {
+        return 0;
+    }
+    // Only the books that queued themselves, no walk of every book
+    size_t behind = 0;
+    view_backlog_.drain([&behind](OrderBookBase* book) {
+        if (!book->refresh_view()) {
+            behind++;
+        }
+    });
+    return behind;
+}
+
+double MatchingEngine::get_best_bid(const std::string& symbol) const {
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    if (const BookReplica* view = book->view()) {
+        return view->read([](const BookView& current) { return current.best_bid(); });
     }
-    return 0.0;
+    return book->get_best_bid();
+}
+
+double MatchingEngine::get_best_ask(const std::string& symbol) const {
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    if (const BookReplica* view = book->view()) {
+        return view->read([](const BookView& current) { return current.best_ask(); });
+    }
+    return book->get_best_ask();
 }
 
 double MatchingEngine::get_spread(const std::string& symbol) const {
-    std::lock_guard<std::mutex> lock(order_books_mutex_);
-    auto it = order_books_.find(symbol);
-    if (it != order_books_.end()) {
-        return it->second->get_spread();
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    if (const BookReplica* view = book->view()) {
+        return view->read([](const BookView& current) { return current.spread(); });
     }
-    return 0.0;
+    return book->get_spread();
 }
 
-std::vector<OrderBook::BookLevel> MatchingEngine::get_bid_levels(const std::string& symbol,
+std::vector<BookLevel> MatchingEngine::get_bid_levels(const std::string& symbol,
                                                                  size_t max_levels) const {
-    std::lock_guard<std::mutex> lock(order_books_mutex_);
-    auto it = order_books_.find(symbol);
-    if (it != order_books_.end()) {
-        return it->second->get_bid_levels(max_levels);
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return {};
     }
-    return {};
+    const BookReplica* view = book->view();
+    if (view && max_levels <= view->depth()) {
+        return view->read([max_levels](const BookView& current) {
+            return std::vector<BookLevel>(current.bids.begin(),
+                                          current.bids.begin() + std::min(max_levels, current.bids.size()));
+        });
+    }
+    return book->get_bid_levels(max_levels);
 }
 
-std::vector<OrderBook::BookLevel> MatchingEngine::get_ask_levels(const std::string& symbol,
+std::vector<BookLevel> MatchingEngine::get_ask_levels(const std::string& symbol,
                                                                  size_t max_levels) const {
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return {};
+    }
+    const BookReplica* view = book->view();
+    if (view && max_levels <= view->depth()) {
+        return view->read([max_levels](const BookView& current) {
+            return std::vector<BookLevel>(current.asks.begin(),
+                                          current.asks.begin() + std::min(max_levels, current.asks.size()));
+        });
+    }
+    return book->get_ask_levels(max_levels);
+}
+
+uint64_t MatchingEngine::get_bid_volume(const std::string& symbol) const {
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return 0;
+    }
+    if (const BookReplica* view = book->view()) {
+        return view->read([](const BookView& current) { return current.bid_volume; });
+    }
+    return book->get_bid_volume();
+}
+
+uint64_t MatchingEngine::get_ask_volume(const std::string& symbol) const {
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return 0;
+    }
+    if (const BookReplica* view = book->view()) {
+        return view->read([](const BookView& current) { return current.ask_volume; });
+    }
+    return book->get_ask_volume();
+}
+
+double MatchingEngine::get_last_trade_price(const std::string& symbol) const {
+    const OrderBookBase* book = find_book(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    if (const BookReplica* view = book->view()) {
+        return view->read([](const BookView& current) { return current.last_trade_price; });
+    }
+    return book->get_last_trade_price();
+}
+
+bool MatchingEngine::queue_position(uint64_t order_id, QueuePosition& position) const {
+    const OrderBookBase* book = book_of(order_id);
+    return book && book->queue_position(order_id, position);
+}
+
+bool MatchingEngine::depth_to_price(const std::string& symbol, Side side, double price, uint64_t& quantity) const {
     std::lock_guard<std::mutex> lock(order_books_mutex_);
     auto it = order_books_.find(symbol);
-    if (it != order_books_.end()) {
-        return it->second->get_ask_levels(max_levels);
+    return it != order_books_.end() && it->second->depth_to_price(side, price, quantity);
+}
+
+bool MatchingEngine::cost_to_fill(const std::string& symbol, Side side, uint64_t quantity,
+                                  FillEstimate& estimate) const {
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    auto it = order_books_.find(symbol);
+    return it != order_books_.end() && it->second->cost_to_fill(side, quantity, estimate);
+}
+
+void MatchingEngine::warm(size_t max_books) {
+    static constexpr size_t kWarmLevels = 5;
+    static constexpr uint64_t kWarmOrders = 8;
+
+    std::lock_guard<std::mutex> warm_lock(warm_mutex_);
+    std::vector<OrderBookBase*> books;
+    {
+        std::lock_guard<std::mutex> lock(order_books_mutex_);
+        size_t count = std::min(max_books, symbol_names_.size());
+        for (size_t i = 0; i < count; ++i) {
+            auto it = order_books_.find(symbol_names_[warm_cursor_++ % symbol_names_.size()]);
+            if (it != order_books_.end()) {
+                books.push_back(it->second.get());
+            }
+        }
+        if (!warm_book_) {
+            warm_book_ = make_order_book("WARM", default_book_type_);
+            warm_book_->set_order_id_base(make_order_id(shard_, 0, 0));
+        }
+    }
+
+    // Read-only passes over the real books
+    double sink = 0.0;
+    FillEstimate estimate;
+    for (OrderBookBase* book : books) {
+        sink += book->get_best_bid() + book->get_best_ask();
+        for (const BookLevel& level : book->get_bid_levels(kWarmLevels)) {
+            sink += level.price;
+        }
+        for (const BookLevel& level : book->get_ask_levels(kWarmLevels)) {
+            sink += level.price;
+        }
+        if (book->cost_to_fill(Side::BUY, kWarmOrders, estimate)) {
+            sink += estimate.notional;
+        }
+        if (book->cost_to_fill(Side::SELL, kWarmOrders, estimate)) {
+            sink += estimate.notional;
+        }
+    }
+
+    // A small cross in the shadow book: resting sells, then one buy that
+    // takes them all and leaves it empty again
+    ScratchLease<WarmTag> lease;
+    Scratch& scratch = lease.get();
+    for (uint64_t i = 0; i < kWarmOrders; ++i) {
+        auto order = std::make_unique<Order>(warm_book_->next_order_id(), 0, "WARM", Side::SELL,
+                                             100.0 + static_cast<double>(i) * 0.01, 1);
+        scratch.events.push_back(order_event(EngineEventType::ACCEPTED, *order, 0));
+        warm_book_->process_order(std::move(order), scratch.trades, &scratch.expired_ids);
     }
-    return {};
+    auto taker = std::make_unique<Order>(warm_book_->next_order_id(), 0, "WARM", Side::BUY,
+                                         100.0 + static_cast<double>(kWarmOrders) * 0.01, kWarmOrders);
+    scratch.events.push_back(order_event(EngineEventType::ACCEPTED, *taker, 0));
+    warm_book_->process_order(std::move(taker), scratch.trades, &scratch.expired_ids);
+    for (const Trade& trade : scratch.trades) {
+        scratch.events.push_back(fill_event(trade, 0));
+    }
+    for (const EngineEvent& event : scratch.events) {
+        sink += event.price;
+    }
+
+    // Keep the reads from being optimized away
+    volatile double result = sink;
+    (void)result;
+    warm_passes_.fetch_add(1, std::memory_order_relaxed);
 }
 
 MatchingEngine::EngineStats MatchingEngine::get_stats() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    return stats_;
+    EngineStats stats;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats = stats_;
+    }
+    stats.overload_episodes = admission_.episodes();
+    stats.overloaded = admission_.overloaded();
+    stats.queue_depth = admission_.queue_depth();
+    stats.matching_latency_ns = admission_.latency_ns();
+    return stats;
+}
+
+MatchingEngine::StorageStats MatchingEngine::get_storage_stats() const {
+    StorageStats stats;
+    {
+        std::lock_guard<std::mutex> lock(order_map_mutex_);
+        stats.order_map_entries = open_orders_.size();
+        stats.order_map_buckets = open_orders_.bucket_count();
+        stats.order_map_pool_chunks = order_map_pool_.chunk_count();
+    }
+
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    stats.books = order_books_.size();
+    for (const auto& [symbol, book] : order_books_) {
+        BookStorageStats book_stats = book->get_storage_stats();
+        stats.book_totals.indexed_orders += book_stats.indexed_orders;
+        stats.book_totals.index_buckets += book_stats.index_buckets;
+        stats.book_totals.side_entries += book_stats.side_entries;
+        stats.book_totals.pool_chunks += book_stats.pool_chunks;
+        stats.book_totals.pending_stops += book_stats.pending_stops;
+        stats.book_totals.pegged_orders += book_stats.pegged_orders;
+    }
+    return stats;
 }
 
 void MatchingEngine::set_trade_callback(TradeCallback callback) {
@@ -143,6 +1113,11 @@ void MatchingEngine::set_trade_callback(TradeCallback callback) {
     trade_callback_ = callback;
 }
 
+void MatchingEngine::set_level_update_callback(LevelUpdateCallback callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    level_update_callback_ = callback;
+}
+
 std::vector<std::string> MatchingEngine::get_all_symbols() const {
     std::lock_guard<std::mutex> lock(order_books_mutex_);
     std::vector<std::string> symbols;
@@ -155,22 +1130,155 @@ std::vector<std::string> MatchingEngine::get_all_symbols() const {
     return symbols;
 }
 
-OrderBook* MatchingEngine::get_or_create_book(const std::string& symbol) {
+OrderBookBase* MatchingEngine::get_or_create_book(const std::string& symbol) {
     std::lock_guard<std::mutex> lock(order_books_mutex_);
 
     auto it = order_books_.find(symbol);
     if (it != order_books_.end()) {
         return it->second.get();
     }
+    if (symbol_names_.size() >= kMaxSymbolId) {
+        return nullptr;  // no symbol id left for its order ids
+    }
 
-    // Create new order book
-    auto book = std::make_unique<OrderBook>(symbol);
-    OrderBook* book_ptr = book.get();
+    // Create new order book of the type selected for this symbol
+    std::unique_ptr<OrderBookBase> book;
+    auto type_it = book_types_.find(symbol);
+    if (type_it != book_types_.end()) {
+        book = make_order_book(symbol, type_it->second.first, type_it->second.second);
+    } else {
+        book = make_order_book(symbol, default_book_type_);
+    }
+    OrderBookBase* book_ptr = book.get();
+    symbol_names_.push_back(symbol);
+    book_ptr->set_symbol_id(static_cast<uint32_t>(symbol_names_.size()));
+    book_ptr->set_order_id_base(make_order_id(shard_, book_ptr->get_symbol_id(), 0));
+    if (events_.active()) {
+        book_ptr->track_level_changes(true);
+    }
+    if (size_t depth = view_depth_.load(std::memory_order_relaxed)) {
+        book_ptr->enable_view(depth, &view_backlog_);
+    }
     order_books_[symbol] = std::move(book);
+    books_by_id_.publish(book_ptr->get_symbol_id(), book_ptr);
 
     return book_ptr;
 }
 
+// Books are never destroyed while the engine lives, so the lock only covers
+// the lookup; queries then read the book (or its view) without it
+OrderBookBase* MatchingEngine::find_book(const std::string& symbol) const {
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    auto it = order_books_.find(symbol);
+    return it != order_books_.end() ? it->second.get() : nullptr;
+}
+
+// The book an order id was issued by; nullptr for an id of no book here.
+// The engine's own ids resolve without a lock.
+OrderBookBase* MatchingEngine::book_of(uint64_t order_id) const {
+    if (order_id_shard(order_id) == shard_) {
+        return books_by_id_.find(order_id_symbol(order_id));
+    }
+    std::lock_guard<std::mutex> lock(order_books_mutex_);
+    auto it = adopted_routes_.find(order_id >> kOrderIdSequenceBits);
+    return it != adopted_routes_.end() ? it->second : nullptr;
+}
+
+bool MatchingEngine::snapshot_symbol(const std::string& symbol, BookSnapshot& snapshot) {
+    OrderBookBase* book = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(order_books_mutex_);
+        auto it = order_books_.find(symbol);
+        if (it == order_books_.end()) {
+            return false;
+        }
+        book = it->second.get();
+    }
+    book->snapshot(snapshot, false);
+    return true;
+}
+
+bool MatchingEngine::hand_off_symbol(const std::string& symbol, BookSnapshot& snapshot) {
+    OrderBookBase* book = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(order_books_mutex_);
+        auto it = order_books_.find(symbol);
+        if (it == order_books_.end()) {
+            return false;
+        }
+        book = it->second.get();
+    }
+
+    bool streaming = events_.active();
+    std::unique_lock<std::mutex> sequence = lock_events(book, streaming);
+    book->snapshot(snapshot, true);
+    {
+        std::lock_guard<std::mutex> lock(order_map_mutex_);
+        for (const Order& order : snapshot.orders) {
+            forget_order(order.order_id);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.active_orders -= snapshot.orders.size();
+    }
+    if (streaming) {
+        ScratchLease<CancelTag> lease;
+        Scratch& scratch = lease.get();
+        append_level_changes(book, scratch.events);
+        events_.publish(scratch.events.data(), scratch.events.size());
+    }
+    return true;
+}
+
+bool MatchingEngine::adopt_symbol(const BookSnapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(order_books_mutex_);
+        if (!order_books_.count(snapshot.symbol) && !book_types_.count(snapshot.symbol)) {
+            book_types_[snapshot.symbol] = {snapshot.type, snapshot.config};
+        }
+    }
+    OrderBookBase* book = get_or_create_book(snapshot.symbol);
+    if (!book || book->get_book_type() != snapshot.type || book->get_storage_stats().indexed_orders != 0) {
+        return false;
+    }
+
+    bool streaming = events_.active();
+    std::unique_lock<std::mutex> sequence = lock_events(book, streaming);
+    book->restore(snapshot);
+    if (order_id_shard(snapshot.order_id_base) != shard_) {
+        std::lock_guard<std::mutex> lock(order_books_mutex_);
+        adopted_routes_[snapshot.order_id_base >> kOrderIdSequenceBits] = book;
+    }
+    {
+        std::lock_guard<std::mutex> lock(order_map_mutex_);
+        for (const Order& order : snapshot.orders) {
+            open_orders_.emplace(order.order_id, order.client_id);
+            risk_.adopt(order.client_id);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.active_orders += snapshot.orders.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(expiry_mutex_);
+        for (const Order& order : snapshot.orders) {
+            if (order.time_in_force != TimeInForce::GTC) {
+                expiry_wheel_.schedule(ScheduledExpiry{book, order.order_id},
+                                       (order.expire_time + kExpiryTickMicros - 1) / kExpiryTickMicros);
+            }
+        }
+    }
+    if (streaming) {
+        ScratchLease<CancelTag> lease;
+        Scratch& scratch = lease.get();
+        append_level_changes(book, scratch.events);
+        events_.publish(scratch.events.data(), scratch.events.size());
+    }
+    return true;
+}
+
 void MatchingEngine::notify_trade(const Trade& trade) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
     if (trade_callback_) {
@@ -178,13 +1286,15 @@ void MatchingEngine::notify_trade(const Trade& trade) {
     }
 }
 
-void MatchingEngine::update_stats_for_trade(const Trade& trade, OrderBook* book) {
+void MatchingEngine::update_stats_for_trade(const Trade& trade) {
     std::lock_guard<std::mutex> lock(stats_mutex_);
     stats_.total_trades++;
 
-    // Check if the maker order was filled
-    const Order* maker_order = book->get_order(trade.maker_order_id);
-    if (maker_order && maker_order->is_filled()) {
+    // Check if either order was filled
+    if (trade.maker_filled) {
+        stats_.active_orders--;
+    }
+    if (trade.taker_filled) {
         stats_.active_orders--;
     }
 }
@@ -0,0 +1,61 @@
+#include "core/NodePool.h"
+
+namespace quasar {
+
+NodePool::NodePool(size_t blocks_per_chunk) : blocks_per_chunk_(blocks_per_chunk) {}
+
+NodePool::~NodePool() {
+    for (void* chunk : chunks_) {
+        ::operator delete(chunk);
+    }
+}
+
+size_t NodePool::round_up(size_t size) {
+    constexpr size_t alignment = alignof(std::max_align_t);
+    size = size < sizeof(FreeBlock) ? sizeof(FreeBlock) : size;
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+NodePool::SizeClass& NodePool::size_class(size_t block_size) {
+    // Containers use only a handful of node sizes, so a linear scan is cheapest
+    for (auto& candidate : size_classes_) {
+        if (candidate.block_size == block_size) {
+            return candidate;
+        }
+    }
+    size_classes_.push_back({block_size, nullptr});
+    return size_classes_.back();
+}
+
+void NodePool::grow(SizeClass& size_class) {
+    char* chunk = static_cast<char*>(::operator new(size_class.block_size * blocks_per_chunk_));
+    chunks_.push_back(chunk);
+
+    for (size_t i = blocks_per_chunk_; i-- > 0;) {
+        auto* block = reinterpret_cast<FreeBlock*>(chunk + i * size_class.block_size);
+        block->next = size_class.free_list;
+        size_class.free_list = block;
+    }
+}
+
+void* NodePool::allocate(size_t size) {
+    SizeClass& cls = size_class(round_up(size));
+    if (!cls.free_list) {
+        grow(cls);
+    }
+    FreeBlock* block = cls.free_list;
+    cls.free_list = block->next;
+    return block;
+}
+
+void NodePool::deallocate(void* ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    SizeClass& cls = size_class(round_up(size));
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = cls.free_list;
+    cls.free_list = block;
+}
+
+} // namespace quasar
@@ -1,9 +1,151 @@
 #include "core/Order.h"
+#include "core/NodePool.h"
 #include <sstream>
 #include <iomanip>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
 
 namespace quasar {
 
+namespace {
+
+// Per-thread order pools, so that entering and releasing orders takes no
+// lock. Each order carries the pool it came from in a header. Released on the
+// thread that owns that pool, it goes straight back on the pool's free list;
+// released on any other thread (epoch reclamation, a cancel from another
+// session), it is pushed onto the pool's return stack, which the owner takes
+// back in one exchange the next time it allocates. A thread that exits leaves
+// its pool to the next thread that enters orders, so orders still resting
+// always have a live pool. Pools are intentionally never destroyed: orders
+// owned by static objects may be released during static destruction.
+class OrderPool {
+public:
+    struct Header {
+        OrderPool* owner;
+        size_t size;
+    };
+
+    // Keeps the order behind it aligned like any other block
+    static constexpr size_t kHeaderSize =
+        (sizeof(Header) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static Header* header_of(void* ptr) {
+        return reinterpret_cast<Header*>(static_cast<char*>(ptr) - kHeaderSize);
+    }
+
+    // Owner thread only
+    void* allocate(size_t size) {
+        if (returned_.load(std::memory_order_relaxed)) {
+            Returned* block = returned_.exchange(nullptr, std::memory_order_acquire);
+            while (block) {
+                Returned* next = block->next;
+                Header* header = header_of(block);
+                blocks_.deallocate(header, kHeaderSize + header->size);
+                block = next;
+            }
+        }
+        auto* header = static_cast<Header*>(blocks_.allocate(kHeaderSize + size));
+        header->owner = this;
+        header->size = size;
+        return reinterpret_cast<char*>(header) + kHeaderSize;
+    }
+
+    void release(Header* header) { blocks_.deallocate(header, kHeaderSize + header->size); }
+
+    // Any thread
+    void give_back(void* ptr) {
+        auto* block = static_cast<Returned*>(ptr);
+        block->next = returned_.load(std::memory_order_relaxed);
+        while (!returned_.compare_exchange_weak(block->next, block, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    // A returned order's body links the return stack
+    struct Returned {
+        Returned* next;
+    };
+
+    NodePool blocks_{4096};
+    std::atomic<Returned*> returned_{nullptr};
+};
+
+// Pools left by threads that exited (never destroyed, see above)
+struct IdlePools {
+    std::mutex mutex;
+    std::vector<OrderPool*> pools;
+};
+
+IdlePools& idle_pools() {
+    static IdlePools* idle = new IdlePools();
+    return *idle;
+}
+
+OrderPool* take_idle_pool() {
+    IdlePools& idle = idle_pools();
+    std::lock_guard<std::mutex> lock(idle.mutex);
+    if (idle.pools.empty()) {
+        return new OrderPool();
+    }
+    OrderPool* pool = idle.pools.back();
+    idle.pools.pop_back();
+    return pool;
+}
+
+void leave_idle_pool(OrderPool* pool) {
+    IdlePools& idle = idle_pools();
+    std::lock_guard<std::mutex> lock(idle.mutex);
+    idle.pools.push_back(pool);
+}
+
+// The calling thread's pool (nullptr before its first order and once it is
+// exiting), and the thread exit hook handing it on
+thread_local OrderPool* t_pool = nullptr;
+thread_local bool t_exiting = false;
+
+struct PoolOwner {
+    ~PoolOwner() {
+        if (t_pool) {
+            leave_idle_pool(t_pool);
+            t_pool = nullptr;
+        }
+        t_exiting = true;
+    }
+};
+thread_local PoolOwner t_pool_owner;
+
+} // namespace
+
+void* Order::operator new(size_t size) {
+    if (!t_pool) {
+        if (t_exiting) {
+            // Past this thread's exit hook: borrow a pool for this one order
+            OrderPool* pool = take_idle_pool();
+            void* ptr = pool->allocate(size);
+            leave_idle_pool(pool);
+            return ptr;
+        }
+        (void)&t_pool_owner;  // registers the exit hook
+        t_pool = take_idle_pool();
+    }
+    return t_pool->allocate(size);
+}
+
+void Order::operator delete(void* ptr, size_t) noexcept {
+    if (!ptr) {
+        return;
+    }
+    OrderPool::Header* header = OrderPool::header_of(ptr);
+    if (header->owner == t_pool) {
+        header->owner->release(header);
+    } else {
+        header->owner->give_back(ptr);
+    }
+}
+
 // Convert Side enum to string
 std::string to_string(Side side) {
     switch (side) {
@@ -18,6 +160,10 @@ std::string to_string(OrderType type) {
     switch (type) {
         case OrderType::LIMIT: return "LIMIT";
         case OrderType::MARKET: return "MARKET";
+        case OrderType::STOP: return "STOP";
+        case OrderType::STOP_LIMIT: return "STOP_LIMIT";
+        case OrderType::PEG_PRIMARY: return "PEG_PRIMARY";
+        case OrderType::PEG_MIDPOINT: return "PEG_MIDPOINT";
         default: return "UNKNOWN";
     }
 }
@@ -34,6 +180,15 @@ std::string to_string(OrderStatus status) {
     }
 }
 
+std::string to_string(TimeInForce time_in_force) {
+    switch (time_in_force) {
+        case TimeInForce::GTC: return "GTC";
+        case TimeInForce::DAY: return "DAY";
+        case TimeInForce::GTD: return "GTD";
+        default: return "UNKNOWN";
+    }
+}
+
 // Update timestamp when order is modified
 void Order::update_timestamp() {
     updated_time = std::chrono::system_clock::now();
@@ -41,6 +196,15 @@ void Order::update_timestamp() {
         updated_time.time_since_epoch()).count();
 }
 
+void Order::trigger() {
+    if (type == OrderType::STOP) {
+        type = OrderType::MARKET;
+    } else if (type == OrderType::STOP_LIMIT) {
+        type = OrderType::LIMIT;
+    }
+    update_timestamp();
+}
+
 // Fill the order and update status
 void Order::fill(uint64_t fill_quantity) {
     if (fill_quantity > remaining_quantity()) {
@@ -48,6 +212,9 @@ void Order::fill(uint64_t fill_quantity) {
     }
 
     filled_quantity += fill_quantity;
+    if (is_iceberg()) {
+        shown_quantity -= fill_quantity < shown_quantity ? fill_quantity : shown_quantity;
+    }
 
     if (is_filled()) {
         status = OrderStatus::FILLED;
@@ -1,300 +1,924 @@
 #include "core/OrderBook.h"
+#include "core/Epoch.h"
 #include <algorithm>
-#include <map>
 
 namespace quasar {
 
-OrderBook::OrderBook(const std::string& symbol, bool use_map_implementation)
-    : symbol_(symbol), use_map_implementation_(use_map_implementation) {}
+std::string to_string(BookType type) {
+    switch (type) {
+        case BookType::HEAP: return HeapBookPolicy::name;
+        case BookType::MAP: return MapBookPolicy::name;
+        case BookType::INTRUSIVE: return IntrusiveBookPolicy::name;
+        case BookType::LADDER: return LadderBookPolicy::name;
+        default: return "unknown";
+    }
+}
+
+bool parse_book_type(const std::string& name, BookType& type) {
+    for (BookType candidate : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        if (name == to_string(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string to_string(MatchingAlgorithm algorithm) {
+    switch (algorithm) {
+        case MatchingAlgorithm::FIFO: return "fifo";
+        case MatchingAlgorithm::PRO_RATA: return "pro-rata";
+        case MatchingAlgorithm::TOP_PRO_RATA: return "top-pro-rata";
+        default: return "unknown";
+    }
+}
+
+bool parse_matching_algorithm(const std::string& name, MatchingAlgorithm& algorithm) {
+    for (MatchingAlgorithm candidate :
+         {MatchingAlgorithm::FIFO, MatchingAlgorithm::PRO_RATA, MatchingAlgorithm::TOP_PRO_RATA}) {
+        if (name == to_string(candidate)) {
+            algorithm = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+double OrderBookBase::get_spread() const {
+    double best_bid = get_best_bid();
+    double best_ask = get_best_ask();
+
+    if (best_bid == 0.0 || best_ask == 0.0) {
+        return 0.0;
+    }
+
+    return best_ask - best_bid;
+}
+
+std::vector<Trade> OrderBookBase::process_order(std::unique_ptr<Order> order) {
+    std::vector<Trade> trades;
+    process_order(std::move(order), trades);
+    return trades;
+}
+
+template<typename Policy>
+BasicOrderBook<Policy>::BasicOrderBook(const std::string& symbol, const BookConfig& config)
+    : OrderBookBase(symbol),
+      orders_(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+              PoolAllocator<std::pair<const uint64_t, std::unique_ptr<Order>>>(node_pool_)),
+      bids_(config, node_pool_),
+      asks_(config, node_pool_),
+      stops_(node_pool_),
+      config_(config),
+      matching_(Policy::BidSide::level_access ? config.matching : MatchingAlgorithm::FIFO),
+      min_allocation_(config.pro_rata_min_allocation),
+      tick_size_(config.tick_size) {
+    if (config.queue_index) {
+        bid_index_ = std::make_unique<QueueIndex>(true, config.tick_size, config.max_band_ticks);
+        ask_index_ = std::make_unique<QueueIndex>(false, config.tick_size, config.max_band_ticks);
+    }
+}
 
-void OrderBook::add_order(std::unique_ptr<Order> order) {
+template<typename Policy>
+void BasicOrderBook<Policy>::add_order(std::unique_ptr<Order> order) {
     std::lock_guard<std::mutex> lock(mutex_);
     add_order_unlocked(std::move(order));
+    publish_view();
 }
 
-void OrderBook::add_order_unlocked(std::unique_ptr<Order> order) {
+template<typename Policy>
+void BasicOrderBook<Policy>::add_order_unlocked(std::unique_ptr<Order> order) {
     Order* order_ptr = order.get();
     uint64_t order_id = order->order_id;
 
     // Store the order
     orders_[order_id] = std::move(order);
 
-    // Add to appropriate heap
-    if (order_ptr->is_buy()) {
-        bids_.push(order_ptr);
+    insert_into_side(order_ptr);
+}
+
+template<typename Policy>
+void BasicOrderBook<Policy>::insert_into_side(Order* order, bool show_slice) {
+    // An iceberg rests showing its first slice
+    if (show_slice && order->is_iceberg()) {
+        order->show_next_slice();
+    }
+
+    // Rest it on the appropriate side (pegs in their own groups)
+    if (order->is_pegged()) {
+        (order->is_buy() ? bid_pegs_ : ask_pegs_).insert(order);
     } else {
-        asks_.push(order_ptr);
+        if (order->is_buy()) {
+            bids_.insert(order);
+        } else {
+            asks_.insert(order);
+        }
+        if (QueueIndex* index = index_for(order)) {
+            index->insert(order);
+        }
+        note_level(order);
     }
 }
 
-bool OrderBook::cancel_order(uint64_t order_id) {
+template<typename Policy>
+bool BasicOrderBook<Policy>::cancel_order(uint64_t order_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     auto it = orders_.find(order_id);
-    if (it == orders_.end()) {
+    if (it == orders_.end() || !it->second->is_active()) {
         return false;
     }
 
-    it->second->cancel();
+    remove_resting(it->second.get());
+    release_cancelled();
+    publish_view();
     return true;
 }
 
-std::vector<Trade> OrderBook::process_order(std::unique_ptr<Order> order) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // First try to match the order
-    std::vector<Trade> trades = match_order(order.get());
-
-    // If order is not fully filled, add it to the book (without acquiring lock again)
-    if (!order->is_filled() && order->status != OrderStatus::CANCELLED) {
-        add_order_unlocked(std::move(order));
+// Take a live order out of whichever structure holds it and release it
+template<typename Policy>
+void BasicOrderBook<Policy>::remove_resting(Order* order) {
+    if (order->is_pending_stop()) {
+        stops_.erase(order);
+        erase_order(order->order_id);
+        return;
+    }
+    if (order->is_pegged()) {
+        (order->is_buy() ? bid_pegs_ : ask_pegs_).erase(order);
+        erase_order(order->order_id);
+        return;
     }
 
-    // Clean up any fully filled orders from the heaps
-    clean_filled_orders();
+    order->cancel();
+    if (order->is_buy()) {
+        bids_.erase(order);
+    } else {
+        asks_.erase(order);
+    }
+    if (QueueIndex* index = index_for(order)) {
+        index->erase(order);
+    }
+    note_level(order);
 
-    return trades;
+    // Lazy-cancel sides still point at the order until it surfaces
+    if constexpr (!Policy::BidSide::lazy_cancel) {
+        erase_order(order->order_id);
+    }
 }
 
-std::vector<Trade> OrderBook::match_order(Order* incoming_order) {
-    std::vector<Trade> trades;
-
-    // Match against opposite side
-    if (incoming_order->is_buy()) {
-        // Buy order matches against asks
-        while (!asks_.empty() && incoming_order->remaining_quantity() > 0) {
-            Order* top_order = asks_.top();
+template<typename Policy>
+ReplaceResult BasicOrderBook<Policy>::replace_order(uint64_t order_id, double price, uint64_t quantity,
+                                                    std::vector<Trade>& trades,
+                                                    std::vector<uint64_t>* expired_ids) {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-            // Skip cancelled orders
-            if (top_order->status == OrderStatus::CANCELLED) {
-                asks_.pop();
-                continue;
-            }
+    auto it = orders_.find(order_id);
+    if (it == orders_.end() || !it->second->is_active() || quantity == 0) {
+        return ReplaceResult::REJECTED;
+    }
+    Order* order = it->second.get();
+    if (order->is_pending_stop() || order->is_pegged() || order->is_iceberg()) {
+        return ReplaceResult::REJECTED;
+    }
 
-            // Check if prices cross (buy price >= ask price)
-            if (incoming_order->price < top_order->price) {
-                break; // No more matches possible
+    // Shrinking in place keeps the order where it is in its level
+    if (price == order->price && quantity <= order->remaining_quantity()) {
+        uint64_t reduction = order->remaining_quantity() - quantity;
+        if (reduction > 0) {
+            order->quantity -= reduction;
+            if (order->is_buy()) {
+                bids_.on_fill(order, reduction);
+            } else {
+                asks_.on_fill(order, reduction);
             }
-
-            // Calculate trade quantity
-            uint64_t trade_quantity = std::min(
-                incoming_order->remaining_quantity(),
-                top_order->remaining_quantity()
-            );
-
-            // Create trade
-            Trade trade(
-                next_trade_id_++,
-                incoming_order->order_id,
-                top_order->order_id,
-                incoming_order->client_id,
-                top_order->client_id,
-                symbol_,
-                top_order->price, // Trade at maker's price
-                trade_quantity
-            );
-            trades.push_back(trade);
-
-            // Update order quantities
-            incoming_order->fill(trade_quantity);
-            top_order->fill(trade_quantity);
-
-            // Remove fully filled orders
-            if (top_order->is_filled()) {
-                asks_.pop();
+            if (QueueIndex* index = index_for(order)) {
+                index->on_fill(order, reduction);
             }
+            note_level(order);
+            publish_view();
         }
-    } else {
-        // Sell order matches against bids
-        while (!bids_.empty() && incoming_order->remaining_quantity() > 0) {
-            Order* top_order = bids_.top();
+        return ReplaceResult::RESIZED;
+    }
 
-            // Skip cancelled orders
-            if (top_order->status == OrderStatus::CANCELLED) {
-                bids_.pop();
-                continue;
-            }
+    if constexpr (Policy::BidSide::lazy_cancel) {
+        return ReplaceResult::REJECTED;
+    } else {
+        if (price != order->price && !can_rest(order->side, price)) {
+            return ReplaceResult::REJECTED;
+        }
+        if (order->is_buy()) {
+            bids_.erase(order);
+        } else {
+            asks_.erase(order);
+        }
+        if (QueueIndex* index = index_for(order)) {
+            index->erase(order);
+        }
+        note_level(order);
+        order->price = price;
+        order->quantity = quantity;
+        order->filled_quantity = 0;
+        order->status = OrderStatus::NEW;
+
+        size_t first_trade = trades.size();
+        if (execute(order, trades, expired_ids)) {
+            insert_into_side(order);
+        } else {
+            erase_order(order_id);
+        }
+        if (trades.size() > first_trade && stops_.size() > 0) {
+            trigger_stops(trades, expired_ids);
+        }
+        publish_view();
+        return ReplaceResult::REENTERED;
+    }
+}
 
-            // Check if prices cross (sell price <= bid price)
-            if (incoming_order->price > top_order->price) {
-                break; // No more matches possible
-            }
+template<typename Policy>
+void BasicOrderBook<Policy>::expire_orders(const std::vector<uint64_t>& order_ids,
+                                           std::vector<uint64_t>& expired_ids,
+                                           std::vector<LevelUpdate>& updates) {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-            // Calculate trade quantity
-            uint64_t trade_quantity = std::min(
-                incoming_order->remaining_quantity(),
-                top_order->remaining_quantity()
-            );
-
-            // Create trade
-            Trade trade(
-                next_trade_id_++,
-                incoming_order->order_id,
-                top_order->order_id,
-                incoming_order->client_id,
-                top_order->client_id,
-                symbol_,
-                top_order->price, // Trade at maker's price
-                trade_quantity
-            );
-            trades.push_back(trade);
-
-            // Update order quantities
-            incoming_order->fill(trade_quantity);
-            top_order->fill(trade_quantity);
-
-            // Remove fully filled orders
-            if (top_order->is_filled()) {
-                bids_.pop();
-            }
+    touched_levels_.clear();
+    for (uint64_t order_id : order_ids) {
+        auto it = orders_.find(order_id);
+        if (it == orders_.end() || !it->second->is_active()) {
+            continue;
         }
+        Order* order = it->second.get();
+        // Stops and pegs are not displayed, so removing them changes no level
+        if (!order->is_pending_stop() && !order->is_pegged()) {
+            touched_levels_.insert(order->side, order->price);
+        }
+        expired_ids.push_back(order_id);
+        remove_resting(order);
     }
+    release_cancelled();
+    publish_view();
 
-    return trades;
+    // One update per level, whatever the number of orders it lost
+    for (const auto& [side, price] : touched_levels_.keys()) {
+        BookLevel level = side == Side::BUY ? bids_.level_at(price) : asks_.level_at(price);
+        updates.push_back(LevelUpdate{side, price, level.quantity, level.order_count});
+    }
 }
 
-void OrderBook::clean_filled_orders() {
-    // Clean bid side
-    while (!bids_.empty() &&
-           (bids_.top()->is_filled() || bids_.top()->status == OrderStatus::CANCELLED)) {
-        bids_.pop();
-    }
+template<typename Policy>
+void BasicOrderBook<Policy>::track_level_changes(bool on) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    track_levels_ = on;
+    changed_levels_.clear();
+}
 
-    // Clean ask side
-    while (!asks_.empty() &&
-           (asks_.top()->is_filled() || asks_.top()->status == OrderStatus::CANCELLED)) {
-        asks_.pop();
+template<typename Policy>
+void BasicOrderBook<Policy>::take_level_changes(std::vector<LevelUpdate>& updates) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [side, price] : changed_levels_.keys()) {
+        BookLevel level = side == Side::BUY ? bids_.level_at(price) : asks_.level_at(price);
+        updates.push_back(LevelUpdate{side, price, level.quantity, level.order_count});
     }
+    changed_levels_.clear();
 }
 
-double OrderBook::get_best_bid() const {
+template<typename Policy>
+void BasicOrderBook<Policy>::snapshot(BookSnapshot& snapshot, bool release) {
     std::lock_guard<std::mutex> lock(mutex_);
+    snapshot.symbol = symbol_;
+    snapshot.type = Policy::type;
+    snapshot.config = config_;
+    snapshot.order_id_base = order_id_base_;
+    snapshot.next_order_sequence = next_order_sequence_.load(std::memory_order_relaxed);
+    snapshot.next_trade_id = next_trade_id_;
+    snapshot.last_trade_price = last_trade_price_;
+    snapshot.in_auction = in_auction_;
+    snapshot.orders.clear();
+
+    auto copy = [&snapshot](const Order* order) {
+        snapshot.orders.push_back(*order);
+        Order& copied = snapshot.orders.back();
+        copied.prev_in_level = nullptr;
+        copied.next_in_level = nullptr;
+        copied.level = nullptr;
+        copied.queue_slot = 0;
+    };
+    bids_.for_each_order(copy);
+    asks_.for_each_order(copy);
+    bid_pegs_.for_each(copy);
+    ask_pegs_.for_each(copy);
+    stops_.for_each(copy);
+
+    if (release) {
+        for (const Order& order : snapshot.orders) {
+            remove_resting(orders_.find(order.order_id)->second.get());
+        }
+        // An emptied book holds no tombstones either
+        if constexpr (Policy::BidSide::lazy_cancel) {
+            bids_.purge();
+            asks_.purge();
+        }
+        release_cancelled();
+        publish_view();
+    }
+}
 
-    // Clean out any stale orders from the top
-    while (!bids_.empty() &&
-           (bids_.top()->is_filled() || bids_.top()->status == OrderStatus::CANCELLED)) {
-        bids_.pop();
+template<typename Policy>
+void BasicOrderBook<Policy>::restore(const BookSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    order_id_base_ = snapshot.order_id_base;
+    next_order_sequence_.store(snapshot.next_order_sequence, std::memory_order_relaxed);
+    next_trade_id_ = snapshot.next_trade_id;
+    last_trade_price_ = snapshot.last_trade_price;
+    in_auction_ = snapshot.in_auction;
+
+    // Inserting in snapshot order puts each order back in its place
+    for (const Order& order : snapshot.orders) {
+        auto restored = std::make_unique<Order>(order);
+        Order* order_ptr = restored.get();
+        orders_[order_ptr->order_id] = std::move(restored);
+        if (order_ptr->is_pending_stop()) {
+            stops_.insert(order_ptr);
+        } else {
+            insert_into_side(order_ptr, false);
+        }
+    }
+    if (replica_) {
+        replica_->note_all();
+        publish_view();
     }
+}
 
-    if (bids_.empty()) {
-        return 0.0;
+template<typename Policy>
+bool BasicOrderBook<Policy>::enable_view(size_t depth, ViewBacklog* backlog) {
+    // A side without level access (the heap) walks its levels by sorting a
+    // copy of its orders, which no publish on the matching thread should pay
+    if constexpr (!Policy::BidSide::level_access) {
+        return false;
     }
-    return bids_.top()->price;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (depth == 0 || replica_) {
+        return false;
+    }
+    replica_ = std::make_unique<BookReplica>(depth);
+    view_backlog_ = backlog;
+    replica_->note_all();
+    publish_view();
+    view_.store(replica_.get(), std::memory_order_release);
+    return true;
 }
 
-double OrderBook::get_best_ask() const {
+template<typename Policy>
+bool BasicOrderBook<Policy>::refresh_view() {
     std::lock_guard<std::mutex> lock(mutex_);
+    if (replica_) {
+        replica_->release_backlog();  // off the backlog now; put off again, it requeues
+    }
+    publish_view();
+    return !replica_ || !replica_->dirty();
+}
 
-    // Clean out any stale orders from the top
-    while (!asks_.empty() &&
-           (asks_.top()->is_filled() || asks_.top()->status == OrderStatus::CANCELLED)) {
-        asks_.pop();
+// Drop an order from the index. The Order is retired, not deleted: a reader
+// inside an EpochGuard may still hold it from get_order.
+template<typename Policy>
+void BasicOrderBook<Policy>::erase_order(uint64_t order_id) {
+    auto it = orders_.find(order_id);
+    if (it == orders_.end()) {
+        return;
     }
+    EpochDomain::global().retire(it->second.release());
+    orders_.erase(it);
+}
 
-    if (asks_.empty()) {
-        return 0.0;
+template<typename Policy>
+void BasicOrderBook<Policy>::release_cancelled() {
+    if constexpr (Policy::BidSide::lazy_cancel) {
+        for (auto* side : {&bids_.released(), &asks_.released()}) {
+            for (Order* order : *side) {
+                erase_order(order->order_id);
+            }
+            side->clear();
+        }
     }
-    return asks_.top()->price;
 }
 
-double OrderBook::get_spread() const {
-    double best_bid = get_best_bid();
-    double best_ask = get_best_ask();
+template<typename Policy>
+BookReject BasicOrderBook<Policy>::process_order(std::unique_ptr<Order> order, std::vector<Trade>& trades,
+                                                 std::vector<uint64_t>* expired_ids) {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    if (best_bid == 0.0 || best_ask == 0.0) {
-        return 0.0;
+    // A limit price the sides cannot hold is rejected (market orders and
+    // stops have none; pegs rest in their own groups)
+    bool limit_priced = order->type == OrderType::LIMIT || order->type == OrderType::STOP_LIMIT;
+    if (limit_priced && !can_rest(order->side, order->price)) {
+        return BookReject::INVALID_PRICE;
     }
 
-    return best_ask - best_bid;
+    // Stops wait off the book unless the last trade is already through their
+    // stop price, and through an auction in any case (released by uncross)
+    if (order->is_pending_stop()) {
+        if (in_auction_ || last_trade_price_ == 0.0 || !order->stop_triggered_by(last_trade_price_)) {
+            Order* stop = order.get();
+            orders_[stop->order_id] = std::move(order);
+            stops_.insert(stop);
+            return BookReject::NONE;
+        }
+        order->trigger();
+    }
+
+    // Pegs enter at the price their reference gives them now (not in
+    // auctions or on pro-rata books)
+    if (order->is_pegged()) {
+        bool pegs_allowed = !in_auction_ && matching_ == MatchingAlgorithm::FIFO;
+        order->price = pegs_allowed ? current_peg_price(order.get()) : 0.0;
+        if (order->price <= 0.0) {
+            return BookReject::UNPRICED_PEG;
+        }
+    }
+
+    size_t first_trade = trades.size();
+
+    // If order is not fully filled, add it to the book (without acquiring lock again)
+    if (execute(order.get(), trades, expired_ids)) {
+        add_order_unlocked(std::move(order));
+    }
+
+    if (trades.size() > first_trade && stops_.size() > 0) {
+        trigger_stops(trades, expired_ids);
+    }
+
+    release_cancelled();
+    publish_view();
+    return BookReject::NONE;
 }
 
-std::vector<OrderBook::BookLevel> OrderBook::get_bid_levels(size_t max_levels) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return aggregate_levels(bids_, max_levels);
+// Match an order against the opposite side. Returns true if a remainder is
+// left to rest; a market order's remainder is cancelled instead.
+template<typename Policy>
+bool BasicOrderBook<Policy>::execute(Order* order, std::vector<Trade>& trades,
+                                     std::vector<uint64_t>* expired_ids) {
+    // Orders accumulate unmatched during an auction
+    if (!in_auction_) {
+        if (matching_ != MatchingAlgorithm::FIFO) {
+            if (order->is_buy()) {
+                match_pro_rata(order, asks_, trades);
+            } else {
+                match_pro_rata(order, bids_, trades);
+            }
+        } else if (order->is_buy()) {
+            match_order(order, asks_, ask_pegs_, trades);
+        } else {
+            match_order(order, bids_, bid_pegs_, trades);
+        }
+    }
+
+    if (order->is_filled() || order->status == OrderStatus::CANCELLED) {
+        return false;
+    }
+    if (order->type == OrderType::MARKET) {
+        order->cancel();
+        if (expired_ids) {
+            expired_ids->push_back(order->order_id);
+        }
+        return false;
+    }
+    return true;
 }
 
-std::vector<OrderBook::BookLevel> OrderBook::get_ask_levels(size_t max_levels) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return aggregate_levels(asks_, max_levels);
+// Release the stops triggered by the last trade price. Everything triggered by
+// one price update runs as a batch in order id order; the trades of a batch
+// may move the price again and trigger the next batch (a cascade).
+template<typename Policy>
+void BasicOrderBook<Policy>::trigger_stops(std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids) {
+    triggered_.clear();
+    stops_.pop_triggered(last_trade_price_, triggered_);
+    while (!triggered_.empty()) {
+        for (Order* order : triggered_) {
+            order->trigger();
+            // The band may have moved since the stop was entered
+            if (order->type == OrderType::LIMIT && !can_rest(order->side, order->price)) {
+                order->cancel();
+                if (expired_ids) {
+                    expired_ids->push_back(order->order_id);
+                }
+                erase_order(order->order_id);
+                continue;
+            }
+            if (execute(order, trades, expired_ids)) {
+                insert_into_side(order);
+            } else {
+                erase_order(order->order_id);
+            }
+        }
+        triggered_.clear();
+        stops_.pop_triggered(last_trade_price_, triggered_);
+    }
+}
+
+template<typename Policy>
+double BasicOrderBook<Policy>::current_peg_price(const Order* order) const {
+    const Order* best_bid = bids_.front();
+    const Order* best_ask = asks_.front();
+    return PegSide::peg_price(order->is_buy(), order->type, order->peg_offset,
+                              best_bid ? best_bid->price : 0.0, best_ask ? best_ask->price : 0.0);
 }
 
-template<typename Container>
-std::vector<OrderBook::BookLevel> aggregate_levels_impl(Container container, size_t max_levels) {
-    std::map<double, OrderBook::BookLevel> level_map;
+template<typename Policy>
+template<typename OppositeSide>
+void BasicOrderBook<Policy>::match_order(Order* incoming_order, OppositeSide& opposite,
+                                         PegSide& opposite_pegs, std::vector<Trade>& trades) {
+    while (incoming_order->remaining_quantity() > 0) {
+        Order* top_order = opposite.front();
+        double maker_price = top_order ? top_order->price : 0.0;
+
+        // The best peg group is priced off the displayed BBO as it stands now,
+        // which moves as the displayed side is consumed
+        bool from_pegs = false;
+        if (opposite_pegs.size() > 0) {
+            const Order* best_bid = bids_.front();
+            const Order* best_ask = asks_.front();
+            double peg_price = 0.0;
+            Order* peg = opposite_pegs.front(best_bid ? best_bid->price : 0.0,
+                                             best_ask ? best_ask->price : 0.0, peg_price);
+            if (peg && (!top_order ||
+                        (incoming_order->is_buy() ? peg_price < maker_price : peg_price > maker_price) ||
+                        (peg_price == maker_price && peg->order_id < top_order->order_id))) {
+                top_order = peg;
+                maker_price = peg_price;
+                from_pegs = true;
+            }
+        }
+        if (!top_order) {
+            break;
+        }
 
-    while (!container.empty() && level_map.size() < max_levels) {
-        Order* order = container.top();
-        container.pop();
+        // Check if prices cross (buy price >= ask price, sell price <= bid price);
+        // market orders take any price
+        if (incoming_order->type != OrderType::MARKET &&
+            (incoming_order->is_buy() ? incoming_order->price < maker_price
+                                      : incoming_order->price > maker_price)) {
+            break; // No more matches possible
+        }
 
-        if (order->status == OrderStatus::CANCELLED || order->is_filled()) {
+        // Calculate trade quantity (an iceberg maker trades its shown slice only)
+        uint64_t trade_quantity = std::min(
+            incoming_order->remaining_quantity(),
+            top_order->displayed_quantity()
+        );
+
+        // Create trade
+        trades.emplace_back(
+            next_trade_id_++,
+            incoming_order->order_id,
+            top_order->order_id,
+            incoming_order->client_id,
+            top_order->client_id,
+            symbol_,
+            maker_price, // Trade at maker's price
+            trade_quantity
+        );
+        trades.back().taker_side = incoming_order->side;
+
+        // Update order quantities
+        incoming_order->fill(trade_quantity);
+        top_order->fill(trade_quantity);
+        last_trade_price_ = maker_price;
+        trades.back().taker_filled = incoming_order->is_filled();
+
+        if (from_pegs) {
+            top_order->price = maker_price;
+            if (top_order->is_filled()) {
+                trades.back().maker_filled = true;
+                opposite_pegs.erase(top_order);
+                erase_order(top_order->order_id);
+            }
             continue;
         }
-
-        auto& level = level_map[order->price];
-        level.price = order->price;
-        level.quantity += order->remaining_quantity();
-        level.order_count++;
+        opposite.on_fill(top_order, trade_quantity);
+        if (QueueIndex* index = index_for(top_order)) {
+            index->on_fill(top_order, trade_quantity);
+        }
+        note_level(top_order);
+        trades.back().maker_filled = top_order->is_filled();
+        release_front(opposite, top_order);
     }
+}
 
-    std::vector<OrderBook::BookLevel> result;
-    result.reserve(level_map.size());
+// Pro-rata matching, one price level at a time. An order covering the whole
+// level fills everything there. Otherwise, in one walk over the level using
+// its aggregated quantity, each order is allotted floor(displayed * wanted /
+// level quantity); shares below the minimum allocation are dropped, and what
+// rounding leaves is handed out in time priority. With TOP_PRO_RATA the
+// level's first order fills first and the rest share what it leaves.
+template<typename Policy>
+template<typename OppositeSide>
+void BasicOrderBook<Policy>::match_pro_rata(Order* incoming_order, OppositeSide& opposite,
+                                            std::vector<Trade>& trades) {
+    if constexpr (OppositeSide::level_access) {
+        while (incoming_order->remaining_quantity() > 0) {
+            Order* head = opposite.front();
+            if (!head) {
+                break;
+            }
+            double price = head->price;
+            if (incoming_order->type != OrderType::MARKET &&
+                (incoming_order->is_buy() ? incoming_order->price < price : incoming_order->price > price)) {
+                break;
+            }
+
+            uint64_t wanted = incoming_order->remaining_quantity();
+            uint64_t level_quantity = opposite.front_level_quantity();
+            allocations_.clear();
+            if (wanted >= level_quantity) {
+                opposite.for_each_at_front([this](Order* order) {
+                    allocations_.emplace_back(order, order->displayed_quantity());
+                });
+            } else {
+                uint64_t shared = wanted;
+                uint64_t pool = level_quantity;
+                bool top = matching_ == MatchingAlgorithm::TOP_PRO_RATA;
+                uint64_t allocated = 0;
+                opposite.for_each_at_front([&](Order* order) {
+                    uint64_t shown = order->displayed_quantity();
+                    uint64_t share = 0;
+                    if (top) {
+                        share = std::min(shown, shared);
+                        shared -= share;
+                        pool -= shown;
+                        top = false;
+                    } else if (pool > 0) {
+                        share = static_cast<uint64_t>(static_cast<unsigned __int128>(shown) * shared / pool);
+                        if (share < min_allocation_) {
+                            share = 0;
+                        }
+                    }
+                    allocated += share;
+                    allocations_.emplace_back(order, share);
+                });
+
+                uint64_t leftover = wanted - allocated;
+                for (auto& [order, quantity] : allocations_) {
+                    if (leftover == 0) {
+                        break;
+                    }
+                    uint64_t extra = std::min(order->displayed_quantity() - quantity, leftover);
+                    quantity += extra;
+                    leftover -= extra;
+                }
+            }
 
-    for (const auto& [price, level] : level_map) {
-        result.push_back(level);
+            for (const auto& [order, quantity] : allocations_) {
+                if (quantity == 0) {
+                    continue;
+                }
+                trades.emplace_back(next_trade_id_++, incoming_order->order_id, order->order_id,
+                                    incoming_order->client_id, order->client_id, symbol_, price, quantity);
+                trades.back().taker_side = incoming_order->side;
+                incoming_order->fill(quantity);
+                order->fill(quantity);
+                trades.back().taker_filled = incoming_order->is_filled();
+                trades.back().maker_filled = order->is_filled();
+                opposite.on_fill(order, quantity);
+                QueueIndex* index = index_for(order);
+                if (index) {
+                    index->on_fill(order, quantity);
+                }
+                note_level(order);
+
+                if (order->is_filled()) {
+                    opposite.erase(order);
+                    if (index) {
+                        index->erase(order);
+                    }
+                    erase_order(order->order_id);
+                } else if (order->is_iceberg() && order->shown_quantity == 0) {
+                    order->show_next_slice();
+                    opposite.requeue(order);
+                    if (index) {
+                        index->requeue(order);
+                    }
+                }
+            }
+            last_trade_price_ = price;
+        }
     }
+}
 
-    return result;
+// After a fill of a side's front order: release it once filled, or show an
+// iceberg's next slice behind the rest of its level (same order and id)
+template<typename Policy>
+template<typename SideT>
+void BasicOrderBook<Policy>::release_front(SideT& side, Order* order) {
+    QueueIndex* index = index_for(order);
+    if (order->is_filled()) {
+        side.pop_front();
+        if (index) {
+            index->erase(order);
+        }
+        erase_order(order->order_id);
+    } else if (order->is_iceberg() && order->shown_quantity == 0) {
+        order->show_next_slice();
+        side.requeue_front();
+        if (index) {
+            index->requeue(order);
+        }
+    }
 }
 
-std::vector<OrderBook::BookLevel> OrderBook::aggregate_levels(
-    const std::priority_queue<Order*, std::vector<Order*>, BuyOrderComparator>& orders,
-    size_t max_levels) const {
-    return aggregate_levels_impl(orders, max_levels);
+template<typename Policy>
+void BasicOrderBook<Policy>::start_auction() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_auction_ = true;
 }
 
-std::vector<OrderBook::BookLevel> OrderBook::aggregate_levels(
-    const std::priority_queue<Order*, std::vector<Order*>, SellOrderComparator>& orders,
-    size_t max_levels) const {
-    return aggregate_levels_impl(orders, max_levels);
+template<typename Policy>
+bool BasicOrderBook<Policy>::in_auction() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_auction_;
 }
 
-uint64_t OrderBook::get_bid_volume() const {
+template<typename Policy>
+AuctionResult BasicOrderBook<Policy>::indicative_auction() const {
     std::lock_guard<std::mutex> lock(mutex_);
+    return compute_auction();
+}
+
+// Only the crossed range [best ask, best bid] of each side takes part
+template<typename Policy>
+AuctionResult BasicOrderBook<Policy>::compute_auction() const {
+    const Order* best_bid = bids_.front();
+    const Order* best_ask = asks_.front();
+    if (!best_bid || !best_ask || best_bid->price < best_ask->price) {
+        return AuctionResult{};
+    }
+    double bid_limit = best_ask->price;
+    double ask_limit = best_bid->price;
+
+    auction_bids_.clear();
+    auction_asks_.clear();
+    bids_.for_each_level([&](const BookLevel& level) {
+        if (level.price < bid_limit) {
+            return false;
+        }
+        auction_bids_.push_back(level);
+        return true;
+    });
+    asks_.for_each_level([&](const BookLevel& level) {
+        if (level.price > ask_limit) {
+            return false;
+        }
+        auction_asks_.push_back(level);
+        return true;
+    });
+    return auction_.compute(auction_bids_, auction_asks_, tick_size_, last_trade_price_);
+}
 
-    uint64_t total_volume = 0;
-    auto temp_bids = bids_;
+template<typename Policy>
+AuctionResult BasicOrderBook<Policy>::uncross(std::vector<Trade>& trades, std::vector<uint64_t>* expired_ids,
+                                              bool continue_auction) {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    while (!temp_bids.empty()) {
-        Order* order = temp_bids.top();
-        temp_bids.pop();
+    AuctionResult result = compute_auction();
+    uint64_t remaining = result.volume;
+    while (remaining > 0) {
+        Order* bid = bids_.front();
+        Order* ask = asks_.front();
+        if (!bid || !ask || bid->price < result.price || ask->price > result.price) {
+            break;
+        }
 
-        if (order->status != OrderStatus::CANCELLED && !order->is_filled()) {
-            total_volume += order->remaining_quantity();
+        uint64_t quantity = std::min({remaining, bid->displayed_quantity(), ask->displayed_quantity()});
+        Order* taker = bid->order_id > ask->order_id ? bid : ask;
+        Order* maker = taker == bid ? ask : bid;
+        trades.emplace_back(next_trade_id_++, taker->order_id, maker->order_id, taker->client_id,
+                            maker->client_id, symbol_, result.price, quantity);
+        trades.back().taker_side = taker->side;
+        bid->fill(quantity);
+        ask->fill(quantity);
+        remaining -= quantity;
+        trades.back().taker_filled = taker->is_filled();
+        trades.back().maker_filled = maker->is_filled();
+
+        bids_.on_fill(bid, quantity);
+        asks_.on_fill(ask, quantity);
+        if (bid_index_) {
+            bid_index_->on_fill(bid, quantity);
+            ask_index_->on_fill(ask, quantity);
         }
+        note_level(bid);
+        note_level(ask);
+        release_front(bids_, bid);
+        release_front(asks_, ask);
+    }
+    if (result.volume > 0) {
+        last_trade_price_ = result.price;
     }
 
-    return total_volume;
+    // Stops held through the auction are released once continuous matching
+    // is back, those the auction price triggered included; a book staying in
+    // auction keeps them all
+    in_auction_ = continue_auction;
+    if (!in_auction_ && last_trade_price_ != 0.0 && stops_.size() > 0) {
+        trigger_stops(trades, expired_ids);
+    }
+    release_cancelled();
+    publish_view();
+    return result;
 }
 
-uint64_t OrderBook::get_ask_volume() const {
+template<typename Policy>
+bool BasicOrderBook<Policy>::queue_position(uint64_t order_id, QueuePosition& position) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    auto it = orders_.find(order_id);
+    if (!bid_index_ || it == orders_.end() || !it->second->is_active()) {
+        return false;
+    }
+    const Order* order = it->second.get();
+    if (order->is_pending_stop() || order->is_pegged()) {
+        return false;
+    }
+    return index_for(order)->position(order, position);
+}
 
-    uint64_t total_volume = 0;
-    auto temp_asks = asks_;
-
-    while (!temp_asks.empty()) {
-        Order* order = temp_asks.top();
-        temp_asks.pop();
+template<typename Policy>
+bool BasicOrderBook<Policy>::depth_to_price(Side side, double price, uint64_t& quantity) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!bid_index_) {
+        return false;
+    }
+    quantity = (side == Side::BUY ? bid_index_ : ask_index_)->depth_to_price(price);
+    return true;
+}
 
-        if (order->status != OrderStatus::CANCELLED && !order->is_filled()) {
-            total_volume += order->remaining_quantity();
-        }
+template<typename Policy>
+bool BasicOrderBook<Policy>::cost_to_fill(Side side, uint64_t quantity, FillEstimate& estimate) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!bid_index_) {
+        return false;
     }
+    estimate = (side == Side::BUY ? bid_index_ : ask_index_)->cost_to_fill(quantity);
+    return true;
+}
+
+template<typename Policy>
+double BasicOrderBook<Policy>::get_best_bid() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Order* best = bids_.front();
+    return best ? best->price : 0.0;
+}
+
+template<typename Policy>
+double BasicOrderBook<Policy>::get_best_ask() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Order* best = asks_.front();
+    return best ? best->price : 0.0;
+}
+
+template<typename Policy>
+std::vector<BookLevel> BasicOrderBook<Policy>::get_bid_levels(size_t max_levels) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bids_.levels(max_levels);
+}
+
+template<typename Policy>
+std::vector<BookLevel> BasicOrderBook<Policy>::get_ask_levels(size_t max_levels) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return asks_.levels(max_levels);
+}
+
+template<typename Policy>
+uint64_t BasicOrderBook<Policy>::get_bid_volume() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bids_.volume();
+}
+
+template<typename Policy>
+uint64_t BasicOrderBook<Policy>::get_ask_volume() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return asks_.volume();
+}
+
+template<typename Policy>
+double BasicOrderBook<Policy>::get_last_trade_price() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_trade_price_;
+}
 
-    return total_volume;
+template<typename Policy>
+double BasicOrderBook<Policy>::get_reference_price() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (last_trade_price_ > 0.0) {
+        return last_trade_price_;
+    }
+    const Order* best_bid = bids_.front();
+    const Order* best_ask = asks_.front();
+    if (best_bid && best_ask) {
+        return (best_bid->price + best_ask->price) / 2.0;
+    }
+    return best_bid ? best_bid->price : (best_ask ? best_ask->price : 0.0);
 }
 
-const Order* OrderBook::get_order(uint64_t order_id) const {
+template<typename Policy>
+const Order* BasicOrderBook<Policy>::get_order(uint64_t order_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = orders_.find(order_id);
     if (it != orders_.end()) {
@@ -303,4 +927,39 @@ const Order* OrderBook::get_order(uint64_t order_id) const {
     return nullptr;
 }
 
-} // namespace quasar
\ No newline at end of file
+template<typename Policy>
+BookType BasicOrderBook<Policy>::get_book_type() const {
+    return Policy::type;
+}
+
+template<typename Policy>
+BookStorageStats BasicOrderBook<Policy>::get_storage_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BookStorageStats stats;
+    stats.indexed_orders = orders_.size();
+    stats.index_buckets = orders_.bucket_count();
+    stats.side_entries = bids_.entries() + asks_.entries();
+    stats.pool_chunks = node_pool_.chunk_count();
+    stats.pending_stops = stops_.size();
+    stats.pegged_orders = bid_pegs_.size() + ask_pegs_.size();
+    return stats;
+}
+
+std::unique_ptr<OrderBookBase> make_order_book(const std::string& symbol, BookType type,
+                                               const BookConfig& config) {
+    switch (type) {
+        case BookType::HEAP: return std::make_unique<HeapOrderBook>(symbol, config);
+        case BookType::MAP: return std::make_unique<MapOrderBook>(symbol, config);
+        case BookType::LADDER: return std::make_unique<LadderOrderBook>(symbol, config);
+        case BookType::INTRUSIVE:
+        default: return std::make_unique<IntrusiveOrderBook>(symbol, config);
+    }
+}
+
+// Explicit instantiations for every supported policy
+template class BasicOrderBook<HeapBookPolicy>;
+template class BasicOrderBook<MapBookPolicy>;
+template class BasicOrderBook<IntrusiveBookPolicy>;
+template class BasicOrderBook<LadderBookPolicy>;
+
+} // namespace quasar
@@ -0,0 +1,235 @@
+#include "core/PartitionedEngine.h"
+#include <cstdio>
+#include <fstream>
+#include <type_traits>
+
+namespace quasar {
+
+namespace {
+
+constexpr uint32_t kSnapshotMagic = 0x51534e50;  // "QSNP"
+constexpr uint32_t kSnapshotVersion = 1;
+
+template<typename T>
+void put(std::ostream& out, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw field");
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool get(std::istream& in, T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw field");
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void put_time(std::ostream& out, std::chrono::system_clock::time_point time) {
+    put(out, static_cast<int64_t>(time.time_since_epoch().count()));
+}
+
+bool get_time(std::istream& in, std::chrono::system_clock::time_point& time) {
+    int64_t ticks = 0;
+    if (!get(in, ticks)) {
+        return false;
+    }
+    time = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks));
+    return true;
+}
+
+} // namespace
+
+PartitionedEngine::PartitionedEngine(CommandLog& log, const PartitionConfig& config)
+    : log_(log),
+      config_(config),
+      engine_(config.book_type, config.partition),
+      ring_(config.partitions, config.virtual_nodes),
+      buffer_(256) {}
+
+size_t PartitionedEngine::poll(size_t max) {
+    if (buffer_.size() < max) {
+        buffer_.resize(max);
+    }
+    size_t count = log_.read(offset_, buffer_.data(), max);
+    size_t done = 0;
+    waiting_ = false;
+    error_.clear();
+    while (done < count) {
+        if (!apply(buffer_[done])) {
+            waiting_ = true;
+            break;
+        }
+        offset_++;
+        done++;
+    }
+    return done;
+}
+
+bool PartitionedEngine::apply(const Command& command) {
+    if (command.type == CommandType::HANDOFF) {
+        return apply_handoff(command);
+    }
+
+    std::string symbol = command.get_symbol();
+    if (!owns(symbol)) {
+        stats_.skipped++;
+        return true;
+    }
+    stats_.applied++;
+    if (command.type == CommandType::NEW_ORDER) {
+        uint64_t order_id =
+            engine_.submit_order(command.client_id, symbol, command.get_side(), command.price, command.quantity);
+        if (ack_callback_) {
+            ack_callback_(offset_, order_id);
+        }
+    } else if (command.type == CommandType::CANCEL) {
+        engine_.cancel_order(command.order_id);
+    }
+    return true;
+}
+
+bool PartitionedEngine::apply_handoff(const Command& command) {
+    std::string symbol = command.get_symbol();
+    uint32_t from = ring_.partition_of(symbol);
+    uint32_t to = command.partition;
+    if (from != to) {
+        std::string path = snapshot_path(config_.snapshot_dir, symbol, offset_);
+        if (from == config_.partition) {
+            // The snapshot is on disk before the orders leave, so a failed
+            // write loses nothing: the book stays here and the next poll
+            // tries again. Commands only reach the engine from this thread,
+            // so the orders taken out are the ones written.
+            BookSnapshot snapshot;
+            bool has_book = engine_.snapshot_symbol(symbol, snapshot);
+            if (!has_book) {
+                snapshot.symbol = symbol;
+            }
+            if (!write_snapshot(path, snapshot, has_book)) {
+                return fail_handoff("cannot write snapshot " + path);
+            }
+            if (has_book) {
+                engine_.hand_off_symbol(symbol, snapshot);
+            }
+            stats_.handed_off++;
+        } else if (to == config_.partition) {
+            BookSnapshot snapshot;
+            bool has_book = false;
+            if (!read_snapshot(path, snapshot, has_book)) {
+                return false;  // the owner has not got here yet
+            }
+            if (has_book && !engine_.adopt_symbol(snapshot)) {
+                return fail_handoff("cannot adopt " + symbol + " from " + path);
+            }
+            stats_.adopted++;
+        }
+    }
+    ring_.assign(symbol, to);
+    return true;
+}
+
+// The handoff at offset_ stays unapplied; poll stops there
+bool PartitionedEngine::fail_handoff(const std::string& error) {
+    error_ = error;
+    stats_.failed_handoffs++;
+    return false;
+}
+
+std::string PartitionedEngine::snapshot_path(const std::string& dir, const std::string& symbol, uint64_t offset) {
+    std::string name;
+    for (char c : symbol) {
+        bool plain = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '-';
+        name += plain ? c : '_';
+    }
+    return (dir.empty() ? std::string(".") : dir) + "/" + name + "." + std::to_string(offset) + ".snapshot";
+}
+
+bool PartitionedEngine::write_snapshot(const std::string& path, const BookSnapshot& snapshot, bool has_book) {
+    // Written aside and renamed, so a reader sees the whole file or none
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        put(out, kSnapshotMagic);
+        put(out, kSnapshotVersion);
+        put(out, static_cast<uint8_t>(has_book));
+        put(out, static_cast<uint32_t>(snapshot.symbol.size()));
+        out.write(snapshot.symbol.data(), static_cast<std::streamsize>(snapshot.symbol.size()));
+        put(out, snapshot.type);
+        put(out, snapshot.config);
+        put(out, snapshot.order_id_base);
+        put(out, snapshot.next_order_sequence);
+        put(out, snapshot.next_trade_id);
+        put(out, snapshot.last_trade_price);
+        put(out, static_cast<uint8_t>(snapshot.in_auction));
+        put(out, static_cast<uint64_t>(snapshot.orders.size()));
+        for (const Order& order : snapshot.orders) {
+            put(out, order.order_id);
+            put(out, order.client_id);
+            put(out, order.side);
+            put(out, order.type);
+            put(out, order.price);
+            put(out, order.stop_price);
+            put(out, order.peg_offset);
+            put(out, order.quantity);
+            put(out, order.filled_quantity);
+            put(out, order.display_quantity);
+            put(out, order.shown_quantity);
+            put(out, order.time_in_force);
+            put(out, order.expire_time);
+            put(out, order.status);
+            put_time(out, order.created_time);
+            put_time(out, order.updated_time);
+            put(out, order.timestamp);
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool PartitionedEngine::read_snapshot(const std::string& path, BookSnapshot& snapshot, bool& has_book) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint8_t flag = 0;
+    uint32_t symbol_length = 0;
+    if (!get(in, magic) || magic != kSnapshotMagic || !get(in, version) || version != kSnapshotVersion ||
+        !get(in, flag) || !get(in, symbol_length)) {
+        return false;
+    }
+    has_book = flag != 0;
+    snapshot.symbol.resize(symbol_length);
+    in.read(&snapshot.symbol[0], symbol_length);
+    uint8_t in_auction = 0;
+    uint64_t count = 0;
+    if (!in || !get(in, snapshot.type) || !get(in, snapshot.config) || !get(in, snapshot.order_id_base) ||
+        !get(in, snapshot.next_order_sequence) || !get(in, snapshot.next_trade_id) ||
+        !get(in, snapshot.last_trade_price) || !get(in, in_auction) || !get(in, count)) {
+        return false;
+    }
+    snapshot.in_auction = in_auction != 0;
+    snapshot.orders.clear();
+    snapshot.orders.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        Order order;
+        order.symbol = snapshot.symbol;
+        bool ok = get(in, order.order_id) && get(in, order.client_id) && get(in, order.side) &&
+                  get(in, order.type) && get(in, order.price) && get(in, order.stop_price) &&
+                  get(in, order.peg_offset) && get(in, order.quantity) && get(in, order.filled_quantity) &&
+                  get(in, order.display_quantity) && get(in, order.shown_quantity) &&
+                  get(in, order.time_in_force) && get(in, order.expire_time) && get(in, order.status) &&
+                  get_time(in, order.created_time) && get_time(in, order.updated_time) &&
+                  get(in, order.timestamp);
+        if (!ok) {
+            return false;
+        }
+        snapshot.orders.push_back(std::move(order));
+    }
+    return true;
+}
+
+} // namespace quasar
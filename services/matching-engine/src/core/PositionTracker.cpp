@@ -0,0 +1,410 @@
+#include "core/PositionTracker.h"
+#include "core/MatchingEngine.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace quasar {
+
+PositionTracker::~PositionTracker() {
+    if (engine_) {
+        engine_->unsubscribe_events(this);
+    }
+    stop();
+}
+
+void PositionTracker::follow(MatchingEngine& engine) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        engine_ = &engine;
+    }
+    engine.subscribe_events(*this);
+}
+
+void PositionTracker::on_events(const EngineEvent* events, size_t count) {
+    std::lock_guard<std::mutex> lock(inbox_mutex_);
+    uint64_t queued = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const EngineEvent& source = events[i];
+        if (source.type != EngineEventType::FILL && source.type != EngineEventType::BOOK_DELTA) {
+            continue;
+        }
+        Event event;
+        event.kind = source.type == EngineEventType::FILL ? EventKind::FILL : EventKind::LEVEL;
+        event.taker_side = source.side;
+        event.taker_client_id = source.client_id;
+        event.maker_client_id = source.contra_client_id;
+        event.quantity = source.quantity;
+        event.price = source.price;
+        event.symbol_id = source.symbol_id;
+        inbox_.push_back(std::move(event));
+        queued++;
+    }
+    if (queued != 0) {
+        enqueued_.store(enqueued_.load(std::memory_order_relaxed) + queued, std::memory_order_relaxed);
+        if (sleeping_) {
+            inbox_cv_.notify_one();
+        }
+    }
+}
+
+void PositionTracker::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&PositionTracker::run, this);
+}
+
+void PositionTracker::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(inbox_mutex_);
+        inbox_cv_.notify_all();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    drain();
+}
+
+void PositionTracker::run() {
+    while (running_.load(std::memory_order_relaxed)) {
+        if (drain() != 0) {
+            continue;
+        }
+        // Yield a while before sleeping: a waking producer pays for a futex
+        // call on the matching thread, a yielding tracker only costs its own core
+        uint64_t seen = enqueued_.load(std::memory_order_relaxed);
+        bool pending = false;
+        for (int spin = 0; spin < kIdleYields && !pending; ++spin) {
+            std::this_thread::yield();
+            pending = enqueued_.load(std::memory_order_relaxed) != seen;
+        }
+        if (pending) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(inbox_mutex_);
+        sleeping_ = true;
+        inbox_cv_.wait(lock, [this] { return !inbox_.empty() || !running_.load(std::memory_order_relaxed); });
+        sleeping_ = false;
+    }
+}
+
+void PositionTracker::on_trade(const Trade& trade) {
+    Event event;
+    event.taker_side = trade.taker_side;
+    event.taker_client_id = trade.taker_client_id;
+    event.maker_client_id = trade.maker_client_id;
+    event.quantity = trade.quantity;
+    event.price = trade.price;
+    event.symbol = trade.symbol;
+    enqueue(std::move(event));
+}
+
+void PositionTracker::update_mark(const std::string& symbol, double best_bid, double best_ask) {
+    Event event;
+    event.kind = EventKind::MARK;
+    event.price = best_bid;
+    event.ask = best_ask;
+    event.symbol = symbol;
+    enqueue(std::move(event));
+}
+
+void PositionTracker::enqueue(Event&& event) {
+    std::lock_guard<std::mutex> lock(inbox_mutex_);
+    inbox_.push_back(std::move(event));
+    enqueued_.store(enqueued_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (sleeping_) {
+        inbox_cv_.notify_one();
+    }
+}
+
+void PositionTracker::flush() {
+    if (!running_.load()) {
+        drain();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(inbox_mutex_);
+    uint64_t target = enqueued_.load(std::memory_order_relaxed);
+    applied_cv_.wait(lock, [this, target] { return applied_ >= target || !running_.load(); });
+    if (applied_ < target) {
+        lock.unlock();
+        drain();
+    }
+}
+
+size_t PositionTracker::drain() {
+    // One drainer at a time keeps batches in arrival order
+    std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(inbox_mutex_);
+        batch_.swap(inbox_);
+    }
+    size_t count = batch_.size();
+    if (count != 0) {
+        apply(batch_);
+        batch_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(inbox_mutex_);
+        applied_ += count;
+    }
+    applied_cv_.notify_all();
+    return count;
+}
+
+void PositionTracker::apply(const std::vector<Event>& events) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    uint64_t fills = 0;
+    for (const Event& event : events) {
+        uint32_t symbol = symbol_index(event);
+        if (event.kind == EventKind::MARK) {
+            marks_[symbol].bid = event.price;
+            marks_[symbol].ask = event.ask;
+            continue;
+        }
+        if (event.kind == EventKind::LEVEL) {
+            apply_level(symbol, event.taker_side, event.price, event.quantity);
+            continue;
+        }
+        Side maker_side = event.taker_side == Side::BUY ? Side::SELL : Side::BUY;
+        apply_fill(client_index(event.taker_client_id), symbol, event.taker_side, event.quantity, event.price);
+        apply_fill(client_index(event.maker_client_id), symbol, maker_side, event.quantity, event.price);
+        marks_[symbol].last = event.price;
+        fills += 2;
+    }
+    fills_processed_.fetch_add(fills, std::memory_order_relaxed);
+}
+
+void PositionTracker::apply_fill(uint32_t client, uint32_t symbol, Side side, uint64_t quantity, double price) {
+    Cell& cell = this->cell(client, symbol);
+    int64_t signed_quantity = side == Side::BUY ? static_cast<int64_t>(quantity) : -static_cast<int64_t>(quantity);
+    if (side == Side::BUY) {
+        cell.bought += quantity;
+    } else {
+        cell.sold += quantity;
+    }
+
+    int64_t open = cell.net_quantity;
+    if (open == 0 || (open > 0) == (signed_quantity > 0)) {
+        // Opening or adding: the average price takes in the fill
+        double held = static_cast<double>(std::llabs(open));
+        cell.average_price = (cell.average_price * held + price * static_cast<double>(quantity)) /
+                             (held + static_cast<double>(quantity));
+        cell.net_quantity = open + signed_quantity;
+        return;
+    }
+
+    // Reducing: the closed part realizes against the average, and anything
+    // beyond a flat position opens the other way at the fill price
+    uint64_t closed = std::min<uint64_t>(quantity, static_cast<uint64_t>(std::llabs(open)));
+    double per_unit = open > 0 ? price - cell.average_price : cell.average_price - price;
+    cell.realized_pnl += per_unit * static_cast<double>(closed);
+    cell.net_quantity = open + signed_quantity;
+    if (cell.net_quantity == 0) {
+        cell.average_price = 0.0;
+    } else if ((cell.net_quantity > 0) != (open > 0)) {
+        cell.average_price = price;
+    }
+}
+
+uint32_t PositionTracker::client_index(uint64_t client_id) {
+    auto [it, inserted] = client_indices_.try_emplace(client_id, static_cast<uint32_t>(client_ids_.size()));
+    if (inserted) {
+        client_ids_.push_back(client_id);
+        client_cells_.emplace_back();
+    }
+    return it->second;
+}
+
+uint32_t PositionTracker::symbol_index(const std::string& symbol) {
+    auto [it, inserted] = symbol_indices_.try_emplace(symbol, static_cast<uint32_t>(symbols_.size()));
+    if (!inserted) {
+        return it->second;
+    }
+    symbols_.push_back(symbol);
+    marks_.emplace_back();
+    ladders_.emplace_back();
+    return it->second;
+}
+
+// A stream event names its symbol by the engine's id, resolved once
+uint32_t PositionTracker::symbol_index(const Event& event) {
+    if (!event.symbol.empty() || !engine_) {
+        return symbol_index(event.symbol);
+    }
+    if (event.symbol_id >= symbols_by_id_.size()) {
+        symbols_by_id_.resize(event.symbol_id + 1, 0);
+    }
+    uint32_t& index = symbols_by_id_[event.symbol_id];
+    if (index == 0) {
+        index = symbol_index(engine_->get_symbol_name(event.symbol_id)) + 1;
+    }
+    return index - 1;
+}
+
+// A level of a followed book changed: the mark is its best bid and ask
+void PositionTracker::apply_level(uint32_t symbol, Side side, double price, uint64_t quantity) {
+    Ladder& ladder = ladders_[symbol];
+    Mark& mark = marks_[symbol];
+    if (side == Side::BUY) {
+        if (quantity == 0) {
+            ladder.bids.erase(price);
+        } else {
+            ladder.bids[price] = quantity;
+        }
+        mark.bid = ladder.bids.empty() ? 0.0 : ladder.bids.begin()->first;
+    } else {
+        if (quantity == 0) {
+            ladder.asks.erase(price);
+        } else {
+            ladder.asks[price] = quantity;
+        }
+        mark.ask = ladder.asks.empty() ? 0.0 : ladder.asks.begin()->first;
+    }
+}
+
+size_t PositionTracker::home_slot(uint32_t client, uint32_t symbol) const {
+    uint64_t key = (static_cast<uint64_t>(client) << 32) | symbol;
+    return static_cast<size_t>((key * 0x9e3779b97f4a7c15ULL) >> 20) & slot_mask_;
+}
+
+const PositionTracker::Cell* PositionTracker::find_cell(uint32_t client, uint32_t symbol) const {
+    if (slots_.empty()) {
+        return nullptr;
+    }
+    for (size_t slot = home_slot(client, symbol);; slot = (slot + 1) & slot_mask_) {
+        if (slots_[slot] == 0) {
+            return nullptr;
+        }
+        const Cell& cell = cells_[slots_[slot] - 1];
+        if (cell.client == client && cell.symbol == symbol) {
+            return &cell;
+        }
+    }
+}
+
+// The client's cell in the symbol, added on its first fill
+PositionTracker::Cell& PositionTracker::cell(uint32_t client, uint32_t symbol) {
+    if ((cells_.size() + 1) * 2 > slots_.size()) {
+        grow_slots();
+    }
+    size_t slot = home_slot(client, symbol);
+    for (; slots_[slot] != 0; slot = (slot + 1) & slot_mask_) {
+        Cell& cell = cells_[slots_[slot] - 1];
+        if (cell.client == client && cell.symbol == symbol) {
+            return cell;
+        }
+    }
+    Cell added;
+    added.client = client;
+    added.symbol = symbol;
+    cells_.push_back(added);
+    slots_[slot] = static_cast<uint32_t>(cells_.size());
+    client_cells_[client].push_back(static_cast<uint32_t>(cells_.size() - 1));
+    return cells_.back();
+}
+
+// Doubles the table and re-inserts every cell; amortized O(1) per position
+void PositionTracker::grow_slots() {
+    size_t size = std::max<size_t>(64, slots_.size() * 2);
+    slots_.assign(size, 0);
+    slot_mask_ = size - 1;
+    for (size_t index = 0; index < cells_.size(); ++index) {
+        size_t slot = home_slot(cells_[index].client, cells_[index].symbol);
+        while (slots_[slot] != 0) {
+            slot = (slot + 1) & slot_mask_;
+        }
+        slots_[slot] = static_cast<uint32_t>(index + 1);
+    }
+}
+
+PositionTracker::Position PositionTracker::make_position(const Cell& cell) const {
+    const Mark& mark = marks_[cell.symbol];
+    Position position;
+    position.client_id = client_ids_[cell.client];
+    position.symbol = symbols_[cell.symbol];
+    position.net_quantity = cell.net_quantity;
+    position.average_price = cell.average_price;
+    position.realized_pnl = cell.realized_pnl;
+    position.bought = cell.bought;
+    position.sold = cell.sold;
+
+    // A long would sell at the bid and a short buy at the ask
+    double quote = cell.net_quantity > 0 ? mark.bid : mark.ask;
+    position.mark_price = cell.net_quantity != 0 && quote > 0.0 ? quote : mark.last;
+    if (cell.net_quantity != 0) {
+        position.unrealized_pnl = (position.mark_price - cell.average_price) * static_cast<double>(cell.net_quantity);
+    }
+    return position;
+}
+
+bool PositionTracker::get_position(uint64_t client_id, const std::string& symbol, Position& position) const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    auto client = client_indices_.find(client_id);
+    auto sym = symbol_indices_.find(symbol);
+    if (client == client_indices_.end() || sym == symbol_indices_.end()) {
+        return false;
+    }
+    const Cell* cell = find_cell(client->second, sym->second);
+    if (!cell) {
+        return false;
+    }
+    position = make_position(*cell);
+    return true;
+}
+
+std::vector<PositionTracker::Position> PositionTracker::get_positions(uint64_t client_id) const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    std::vector<Position> positions;
+    auto client = client_indices_.find(client_id);
+    if (client == client_indices_.end()) {
+        return positions;
+    }
+    positions.reserve(client_cells_[client->second].size());
+    for (uint32_t index : client_cells_[client->second]) {
+        positions.push_back(make_position(cells_[index]));
+    }
+    return positions;
+}
+
+std::vector<PositionTracker::Position> PositionTracker::snapshot() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    std::vector<Position> positions;
+    positions.reserve(cells_.size());
+    for (const std::vector<uint32_t>& cells : client_cells_) {
+        for (uint32_t index : cells) {
+            positions.push_back(make_position(cells_[index]));
+        }
+    }
+    return positions;
+}
+
+double PositionTracker::get_realized_pnl(uint64_t client_id) const {
+    double total = 0.0;
+    for (const Position& position : get_positions(client_id)) {
+        total += position.realized_pnl;
+    }
+    return total;
+}
+
+double PositionTracker::get_unrealized_pnl(uint64_t client_id) const {
+    double total = 0.0;
+    for (const Position& position : get_positions(client_id)) {
+        total += position.unrealized_pnl;
+    }
+    return total;
+}
+
+size_t PositionTracker::client_count() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return client_ids_.size();
+}
+
+size_t PositionTracker::symbol_count() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return symbols_.size();
+}
+
+} // namespace quasar
@@ -0,0 +1,388 @@
+#include "core/ShardedEngine.h"
+#include <algorithm>
+
+namespace quasar {
+
+ShardedEngine::ShardedEngine(const ShardedEngineConfig& config)
+    : config_(config),
+      ring_(std::max<uint32_t>(1, std::min(config.shards, kMaxShards)), config.virtual_nodes),
+      window_start_(std::chrono::steady_clock::now()) {
+    uint32_t shards = std::max<uint32_t>(1, std::min(config.shards, kMaxShards));
+    for (uint32_t index = 0; index < shards; ++index) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = index;
+        shard->engine = std::make_unique<MatchingEngine>(config.book_type, index);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+ShardedEngine::~ShardedEngine() {
+    stop();
+}
+
+void ShardedEngine::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (auto& shard : shards_) {
+        shard->thread = std::thread(&ShardedEngine::run, this, std::ref(*shard));
+    }
+    if (config_.rebalance_interval_ms != 0) {
+        rebalancer_ = std::thread(&ShardedEngine::run_rebalancer, this);
+    }
+}
+
+void ShardedEngine::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(rebalancer_mutex_);
+        rebalancer_cv_.notify_all();
+    }
+    if (rebalancer_.joinable()) {
+        rebalancer_.join();
+    }
+    for (auto& shard : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(shard->inbox_mutex);
+            shard->inbox_cv.notify_all();
+        }
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    flush();
+}
+
+void ShardedEngine::set_ack_callback(AckCallback callback) {
+    ack_callback_ = std::move(callback);
+}
+
+void ShardedEngine::set_trade_callback(MatchingEngine::TradeCallback callback) {
+    for (auto& shard : shards_) {
+        shard->engine->set_trade_callback(callback);
+    }
+}
+
+uint64_t ShardedEngine::submit_order(uint64_t client_id, const std::string& symbol, Side side, double price,
+                                     uint64_t quantity) {
+    Task task;
+    task.type = TaskType::NEW_ORDER;
+    task.side = side;
+    task.client_id = client_id;
+    task.price = price;
+    task.quantity = quantity;
+    task.symbol = symbol;
+
+    std::lock_guard<std::mutex> lock(router_mutex_);
+    task.token = ++next_token_;
+    uint64_t token = task.token;
+    symbol_commands_[symbol]++;
+    enqueue(*shards_[ring_.partition_of(symbol)], std::move(task));
+    return token;
+}
+
+uint64_t ShardedEngine::cancel_order(const std::string& symbol, uint64_t order_id) {
+    Task task;
+    task.type = TaskType::CANCEL;
+    task.order_id = order_id;
+    task.symbol = symbol;
+
+    std::lock_guard<std::mutex> lock(router_mutex_);
+    task.token = ++next_token_;
+    uint64_t token = task.token;
+    symbol_commands_[symbol]++;
+    enqueue(*shards_[ring_.partition_of(symbol)], std::move(task));
+    return token;
+}
+
+uint32_t ShardedEngine::shard_of(const std::string& symbol) const {
+    std::lock_guard<std::mutex> lock(router_mutex_);
+    return ring_.partition_of(symbol);
+}
+
+bool ShardedEngine::move_symbol(const std::string& symbol, uint32_t shard) {
+    std::lock_guard<std::mutex> lock(router_mutex_);
+    return move_locked(symbol, shard);
+}
+
+bool ShardedEngine::move_locked(const std::string& symbol, uint32_t shard) {
+    uint32_t from = ring_.partition_of(symbol);
+    if (shard >= shards_.size() || shard == from || moving_.count(symbol)) {
+        return false;
+    }
+    moving_.insert(symbol);
+    moves_in_flight_.fetch_add(1);
+    moves_.fetch_add(1, std::memory_order_relaxed);
+
+    // PARK first: nothing for the symbol may reach the new shard ahead of it
+    Task park;
+    park.type = TaskType::PARK;
+    park.symbol = symbol;
+    enqueue(*shards_[shard], std::move(park));
+
+    Task hand_off;
+    hand_off.type = TaskType::HAND_OFF;
+    hand_off.shard = shard;
+    hand_off.symbol = symbol;
+    enqueue(*shards_[from], std::move(hand_off));
+
+    ring_.assign(symbol, shard);
+    return true;
+}
+
+void ShardedEngine::enqueue(Shard& shard, Task&& task) {
+    std::lock_guard<std::mutex> lock(shard.inbox_mutex);
+    shard.inbox.push_back(std::move(task));
+    shard.enqueued.store(shard.enqueued.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (shard.sleeping) {
+        shard.inbox_cv.notify_one();
+    }
+}
+
+void ShardedEngine::run(Shard& shard) {
+    while (running_.load(std::memory_order_relaxed)) {
+        if (drain(shard) != 0) {
+            continue;
+        }
+        // Views a reader held back go out before the thread sleeps
+        if (shard.engine->refresh_book_views() != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint64_t seen = shard.enqueued.load(std::memory_order_relaxed);
+        bool pending = false;
+        for (int spin = 0; spin < kIdleYields && !pending; ++spin) {
+            std::this_thread::yield();
+            pending = shard.enqueued.load(std::memory_order_relaxed) != seen;
+        }
+        if (pending) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(shard.inbox_mutex);
+        auto ready = [this, &shard] {
+            return !shard.inbox.empty() || !running_.load(std::memory_order_relaxed);
+        };
+        bool woken = true;
+        shard.sleeping = true;
+        if (config_.warm_interval_us == 0) {
+            shard.inbox_cv.wait(lock, ready);
+        } else {
+            woken = shard.inbox_cv.wait_for(lock, std::chrono::microseconds(config_.warm_interval_us), ready);
+        }
+        shard.sleeping = false;
+        lock.unlock();
+        if (!woken) {
+            std::lock_guard<std::mutex> drain_lock(shard.drain_mutex);
+            shard.engine->warm(config_.warm_books);
+        }
+    }
+}
+
+size_t ShardedEngine::drain(Shard& shard) {
+    std::lock_guard<std::mutex> drain_lock(shard.drain_mutex);
+    {
+        std::lock_guard<std::mutex> lock(shard.inbox_mutex);
+        shard.batch.swap(shard.inbox);
+    }
+    size_t count = shard.batch.size();
+    if (count != 0) {
+        // The backlog behind each command (the rest of the batch and whatever
+        // has been queued since) feeds the engine's admission control
+        uint64_t base = shard.applied + count;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            shard.engine->report_queue_depth(shard.enqueued.load(std::memory_order_relaxed) - base + count - i);
+            apply(shard, shard.batch[i]);
+        }
+        shard.batch.clear();
+        shard.engine->refresh_book_views();
+        auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        shard.busy_ns.fetch_add(static_cast<uint64_t>(busy.count()), std::memory_order_relaxed);
+        shard.commands.fetch_add(count, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(shard.inbox_mutex);
+        shard.applied += count;
+    }
+    shard.applied_cv.notify_all();
+    return count;
+}
+
+void ShardedEngine::apply(Shard& shard, Task& task) {
+    switch (task.type) {
+        case TaskType::PARK:
+            shard.parked[task.symbol];
+            return;
+        case TaskType::HAND_OFF: {
+            Task adopt;
+            adopt.type = TaskType::ADOPT;
+            adopt.symbol = task.symbol;
+            adopt.snapshot = std::make_shared<BookSnapshot>();
+            if (!shard.engine->hand_off_symbol(task.symbol, *adopt.snapshot)) {
+                adopt.snapshot.reset();
+            }
+            enqueue(*shards_[task.shard], std::move(adopt));
+            return;
+        }
+        case TaskType::ADOPT: {
+            if (task.snapshot) {
+                shard.engine->adopt_symbol(*task.snapshot);
+            }
+            auto it = shard.parked.find(task.symbol);
+            if (it != shard.parked.end()) {
+                std::vector<Task> held = std::move(it->second);
+                shard.parked.erase(it);
+                for (const Task& command : held) {
+                    execute(shard, command);
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(router_mutex_);
+                moving_.erase(task.symbol);
+            }
+            moves_in_flight_.fetch_sub(1);
+            return;
+        }
+        default:
+            break;
+    }
+    if (!shard.parked.empty()) {
+        auto it = shard.parked.find(task.symbol);
+        if (it != shard.parked.end()) {
+            it->second.push_back(std::move(task));
+            return;
+        }
+    }
+    execute(shard, task);
+}
+
+void ShardedEngine::execute(Shard& shard, const Task& task) {
+    if (task.type == TaskType::NEW_ORDER) {
+        uint64_t order_id = shard.engine->submit_order(task.client_id, task.symbol, task.side, task.price,
+                                                       task.quantity);
+        if (ack_callback_) {
+            ack_callback_(task.token, order_id);
+        }
+    } else if (task.type == TaskType::CANCEL) {
+        shard.engine->cancel_order(task.order_id);
+    }
+}
+
+void ShardedEngine::flush_shard(Shard& shard) {
+    if (!running_.load()) {
+        drain(shard);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(shard.inbox_mutex);
+    uint64_t target = shard.enqueued.load(std::memory_order_relaxed);
+    shard.applied_cv.wait(lock, [this, &shard, target] { return shard.applied >= target || !running_.load(); });
+    if (shard.applied < target) {
+        lock.unlock();
+        drain(shard);
+    }
+}
+
+void ShardedEngine::flush() {
+    // A hand-off queues its ADOPT on another shard, so go round until no
+    // move is left in flight
+    do {
+        for (auto& shard : shards_) {
+            flush_shard(*shard);
+        }
+    } while (moves_in_flight_.load() != 0);
+}
+
+std::vector<ShardedEngine::ShardLoad> ShardedEngine::get_loads() const {
+    std::lock_guard<std::mutex> lock(router_mutex_);
+    return loads_locked(std::chrono::steady_clock::now());
+}
+
+std::vector<ShardedEngine::ShardLoad> ShardedEngine::loads_locked(std::chrono::steady_clock::time_point now) const {
+    double window_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - window_start_).count());
+    std::vector<ShardLoad> loads(shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard& shard = *shards_[i];
+        ShardLoad& load = loads[i];
+        load.shard = shard.index;
+        load.busy_ns = shard.busy_ns.load(std::memory_order_relaxed);
+        load.commands = shard.commands.load(std::memory_order_relaxed);
+        load.warm_passes = shard.engine->get_warm_passes();
+        load.utilization = window_ns > 0.0 ? std::min(1.0, (load.busy_ns - shard.window_busy_ns) / window_ns) : 0.0;
+        std::lock_guard<std::mutex> inbox_lock(shard.inbox_mutex);
+        load.queue_depth = shard.enqueued.load(std::memory_order_relaxed) - shard.applied;
+        load.pressure = load.utilization + static_cast<double>(load.queue_depth) /
+                                               static_cast<double>(std::max<uint64_t>(1, config_.hot_queue_depth));
+    }
+    for (const auto& [symbol, commands] : symbol_commands_) {
+        loads[ring_.partition_of(symbol)].symbols++;
+    }
+    return loads;
+}
+
+size_t ShardedEngine::rebalance() {
+    std::lock_guard<std::mutex> lock(router_mutex_);
+    auto now = std::chrono::steady_clock::now();
+    std::vector<ShardLoad> loads = loads_locked(now);
+
+    auto calmer = [](const ShardLoad& a, const ShardLoad& b) { return a.pressure < b.pressure; };
+    const ShardLoad& hot = *std::max_element(loads.begin(), loads.end(), calmer);
+    const ShardLoad& cold = *std::min_element(loads.begin(), loads.end(), calmer);
+
+    size_t moved = 0;
+    if (hot.pressure > cold.pressure && hot.pressure >= config_.hot_utilization &&
+        hot.pressure - cold.pressure >= config_.min_imbalance) {
+        // The hot shard's symbols by commands this window. The busiest stays:
+        // moving it only moves the hot spot, and its book is the largest to
+        // hand over. The others move coldest-last while they fit in half the gap.
+        std::vector<std::pair<uint64_t, const std::string*>> candidates;
+        uint64_t hot_commands = 0;
+        for (const auto& [symbol, commands] : symbol_commands_) {
+            if (ring_.partition_of(symbol) == hot.shard) {
+                hot_commands += commands;
+                if (commands != 0 && !moving_.count(symbol)) {
+                    candidates.emplace_back(commands, &symbol);
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        // Commands to move: the hot shard's share of half the gap
+        double budget = (hot.pressure - cold.pressure) / 2.0 / hot.pressure * static_cast<double>(hot_commands);
+        std::vector<std::string> chosen;
+        for (size_t i = 1; i < candidates.size() && chosen.size() < config_.max_moves_per_pass; ++i) {
+            if (static_cast<double>(candidates[i].first) <= budget) {
+                budget -= static_cast<double>(candidates[i].first);
+                chosen.push_back(*candidates[i].second);
+            }
+        }
+        for (const std::string& symbol : chosen) {
+            moved += move_locked(symbol, cold.shard) ? 1 : 0;
+        }
+    }
+
+    // Start the next window
+    for (auto& shard : shards_) {
+        shard->window_busy_ns = shard->busy_ns.load(std::memory_order_relaxed);
+    }
+    for (auto& entry : symbol_commands_) {
+        entry.second = 0;
+    }
+    window_start_ = now;
+    return moved;
+}
+
+void ShardedEngine::run_rebalancer() {
+    std::unique_lock<std::mutex> lock(rebalancer_mutex_);
+    while (running_.load()) {
+        rebalancer_cv_.wait_for(lock, std::chrono::milliseconds(config_.rebalance_interval_ms),
+                                [this] { return !running_.load(); });
+        if (running_.load()) {
+            rebalance();
+        }
+    }
+}
+
+} // namespace quasar
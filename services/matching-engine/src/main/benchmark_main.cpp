@@ -1,4 +1,8 @@
 #include "core/MatchingEngine.h"
+#include "core/Epoch.h"
+#include "common/HiccupMonitor.h"
+#include "core/PositionTracker.h"
+#include "core/ShardedEngine.h"
 #include "core/Trade.h"
 #include <iostream>
 #include <string>
@@ -11,24 +15,282 @@
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
 
 using namespace quasar;
 
+// Current and peak resident set size of this process
+struct MemoryUsage {
+    uint64_t rss_kb{0};
+    uint64_t peak_rss_kb{0};
+};
+
+MemoryUsage read_memory_usage() {
+    MemoryUsage usage;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            usage.rss_kb = std::stoull(line.substr(6));
+        } else if (line.rfind("VmHWM:", 0) == 0) {
+            usage.peak_rss_kb = std::stoull(line.substr(6));
+        }
+    }
+
+    // No procfs (e.g. macOS): fall back to the peak reported by getrusage
+    if (usage.peak_rss_kb == 0) {
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+        usage.peak_rss_kb = static_cast<uint64_t>(ru.ru_maxrss) / 1024;
+#else
+        usage.peak_rss_kb = static_cast<uint64_t>(ru.ru_maxrss);
+#endif
+        usage.rss_kb = usage.peak_rss_kb;
+    }
+    return usage;
+}
+
+// Percentile of an already sorted sample
+double percentile(const std::vector<double>& sorted, double pct) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(pct / 100.0 * sorted.size());
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Two-sided 95% critical value of Student's t with df degrees of freedom.
+// Tabulated up to 30; beyond that 1.96 + 2.4/df is within 0.002 of the table.
+double t_critical_95(double df) {
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1.0) {
+        return table[0];
+    }
+    if (df <= 30.0) {
+        // Round fractional (Welch) df down: conservative
+        return table[static_cast<size_t>(df) - 1];
+    }
+    return 1.96 + 2.4 / df;
+}
+
+// Mean, sample standard deviation and 95% confidence interval of one metric over repeated trials
+struct MetricSummary {
+    std::string test_name;
+    std::string metric;
+    size_t trials{0};
+    double mean{0.0};
+    double stddev{0.0};
+    double ci95_half_width{0.0};
+};
+
+MetricSummary summarize_metric(const std::string& test_name, const std::string& metric,
+                               const std::vector<double>& values) {
+    MetricSummary summary;
+    summary.test_name = test_name;
+    summary.metric = metric;
+    summary.trials = values.size();
+    if (values.empty()) {
+        return summary;
+    }
+    for (double value : values) {
+        summary.mean += value;
+    }
+    summary.mean /= values.size();
+    if (values.size() > 1) {
+        double sum_sq = 0.0;
+        for (double value : values) {
+            sum_sq += (value - summary.mean) * (value - summary.mean);
+        }
+        summary.stddev = std::sqrt(sum_sq / (values.size() - 1));
+        summary.ci95_half_width = t_critical_95(values.size() - 1.0) * summary.stddev / std::sqrt(values.size());
+    }
+    return summary;
+}
+
+// Summary files written by repeated trials, and a Welch's t-test comparison
+// between two of them
+class TrialComparison {
+public:
+    // Metrics summarised per test; true where a larger value is better
+    static const std::vector<std::pair<std::string, bool>>& metrics() {
+        static const std::vector<std::pair<std::string, bool>> list = {
+            {"actual_rate", true},
+            {"trades_per_second", true},
+            {"avg_latency_us", false},
+            {"p50_latency_us", false},
+            {"p95_latency_us", false},
+            {"p99_latency_us", false},
+            {"max_latency_us", false},
+        };
+        return list;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "test_name,metric,trials,mean,stddev,ci95_low,ci95_high" << std::endl;
+    }
+
+    static void print_csv_row(const MetricSummary& summary, std::ostream& out) {
+        out << summary.test_name << ","
+            << summary.metric << ","
+            << summary.trials << ","
+            << std::fixed << std::setprecision(4) << summary.mean << ","
+            << summary.stddev << ","
+            << summary.mean - summary.ci95_half_width << ","
+            << summary.mean + summary.ci95_half_width << std::endl;
+    }
+
+    static void print_summary(const std::vector<MetricSummary>& summaries, std::ostream& out) {
+        out << "\n--- " << summaries.front().test_name << ": " << summaries.front().trials
+            << " trials, mean +/- 95% CI (stddev) ---" << std::endl;
+        for (const auto& summary : summaries) {
+            out << "  " << std::left << std::setw(18) << summary.metric << std::right
+                << std::fixed << std::setprecision(2) << std::setw(12) << summary.mean
+                << " +/- " << std::setw(10) << summary.ci95_half_width
+                << "  (" << summary.stddev << ")" << std::endl;
+        }
+    }
+
+    static std::vector<MetricSummary> load(const std::string& filename) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("cannot open " + filename);
+        }
+        std::vector<MetricSummary> summaries;
+        std::string line;
+        std::getline(file, line); // header
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            std::string field;
+            std::vector<std::string> fields;
+            while (std::getline(ss, field, ',')) {
+                fields.push_back(field);
+            }
+            if (fields.size() != 7) {
+                continue;
+            }
+            MetricSummary summary;
+            summary.test_name = fields[0];
+            summary.metric = fields[1];
+            summary.trials = std::stoull(fields[2]);
+            summary.mean = std::stod(fields[3]);
+            summary.stddev = std::stod(fields[4]);
+            summary.ci95_half_width = (std::stod(fields[6]) - std::stod(fields[5])) / 2.0;
+            summaries.push_back(summary);
+        }
+        return summaries;
+    }
+
+    // Welch's t-test per (test, metric) present in both files. Returns the
+    // number of statistically significant regressions.
+    static size_t compare(const std::vector<MetricSummary>& baseline,
+                          const std::vector<MetricSummary>& candidate, std::ostream& out) {
+        size_t regressions = 0;
+        out << std::left << std::setw(28) << "test" << std::setw(18) << "metric" << std::right
+            << std::setw(14) << "baseline" << std::setw(14) << "candidate" << std::setw(10) << "change"
+            << std::setw(9) << "t" << "  verdict" << std::endl;
+
+        for (const auto& base : baseline) {
+            auto it = std::find_if(candidate.begin(), candidate.end(), [&](const MetricSummary& c) {
+                return c.test_name == base.test_name && c.metric == base.metric;
+            });
+            if (it == candidate.end()) {
+                continue;
+            }
+            const MetricSummary& cand = *it;
+            auto metric = std::find_if(metrics().begin(), metrics().end(),
+                                       [&](const auto& m) { return m.first == base.metric; });
+            bool higher_is_better = metric != metrics().end() && metric->second;
+
+            double change = base.mean != 0.0 ? (cand.mean - base.mean) / base.mean : 0.0;
+            double t = 0.0;
+            bool significant = false;
+            if (base.trials < 2 || cand.trials < 2) {
+                // No variance estimate: cannot test
+            } else {
+                double var_base = base.stddev * base.stddev / base.trials;
+                double var_cand = cand.stddev * cand.stddev / cand.trials;
+                double se = std::sqrt(var_base + var_cand);
+                if (se > 0.0) {
+                    t = (cand.mean - base.mean) / se;
+                    double df = (var_base + var_cand) * (var_base + var_cand) /
+                                (var_base * var_base / (base.trials - 1) + var_cand * var_cand / (cand.trials - 1));
+                    significant = std::abs(t) > t_critical_95(df);
+                } else {
+                    significant = cand.mean != base.mean;
+                }
+            }
+
+            std::string verdict = "no significant change";
+            if (base.trials < 2 || cand.trials < 2) {
+                verdict = "need >= 2 trials each";
+            } else if (significant) {
+                bool better = higher_is_better ? cand.mean > base.mean : cand.mean < base.mean;
+                verdict = better ? "IMPROVED" : "REGRESSED";
+                regressions += better ? 0 : 1;
+            }
+
+            out << std::left << std::setw(28) << base.test_name << std::setw(18) << base.metric << std::right
+                << std::fixed << std::setprecision(2) << std::setw(14) << base.mean << std::setw(14) << cand.mean
+                << std::setw(9) << std::setprecision(1) << change * 100.0 << "%"
+                << std::setw(9) << std::setprecision(2) << t << "  " << verdict << std::endl;
+        }
+        return regressions;
+    }
+};
+
 class PerformanceBenchmark {
+public:
+    // Unmeasured orders run before each test until per-block median latency
+    // settles: the last stable_blocks medians all lie within tolerance of
+    // their mean. Stops at max_orders either way (0 disables warm-up).
+    struct WarmupConfig {
+        uint64_t max_orders{1000};
+        uint64_t block_size{100};
+        double tolerance{0.10};
+        size_t stable_blocks{3};
+    };
+
 private:
     std::unique_ptr<MatchingEngine> engine_;
     std::vector<double> order_latencies_;
     std::atomic<uint64_t> trade_count_{0};
     std::mt19937 rng_;
+    uint32_t seed_{42};
+    WarmupConfig warmup_;
 
 public:
     PerformanceBenchmark() : engine_(std::make_unique<MatchingEngine>()) {
-        rng_.seed(std::chrono::steady_clock::now().time_since_epoch().count());
-        engine_->set_trade_callback([this](const Trade& trade) {
-            trade_count_.fetch_add(1);
-        });
+        rng_.seed(seed_);
+        count_trades();
+    }
+
+    // Every run starts from this seed, so repeated trials replay the same workload
+    void set_seed(uint32_t seed) {
+        seed_ = seed;
+        rng_.seed(seed_);
     }
 
+    void set_warmup(const WarmupConfig& warmup) { warmup_ = warmup; }
+
     struct BenchmarkConfig {
         std::string test_name;
         uint64_t total_orders;
@@ -56,6 +318,11 @@ public:
         double max_latency_us;
 
         MatchingEngine::EngineStats engine_stats;
+
+        uint64_t warmup_orders{0};
+        bool warmup_steady{false};
+        uint32_t trial{0};
+        uint32_t seed{0};
     };
 
     struct OrderSpec {
@@ -111,35 +378,18 @@ public:
             warmup_order_book(config.symbol, config.mid_price, config.spread * 2.0);
         }
 
-        auto start_time = std::chrono::steady_clock::now();
         auto inter_order_delay = std::chrono::nanoseconds(static_cast<long>(1e9 / config.target_rate));
+        bool warmup_steady = false;
+        uint64_t warmup_orders = run_warmup(config, inter_order_delay, warmup_steady);
+        trade_count_.store(0);
+
+        auto start_time = std::chrono::steady_clock::now();
 
         // Progress tracking
         uint64_t progress_interval = std::max(config.total_orders / 20, static_cast<uint64_t>(1));
 
         for (uint64_t i = 0; i < config.total_orders; ++i) {
-            auto order_start = std::chrono::steady_clock::now();
-
-            // Generate order based on mode
-            OrderSpec order_spec;
-            if (config.aggressive_mode && config.warmup_book) {
-                double best_bid = engine_->get_best_bid(config.symbol);
-                double best_ask = engine_->get_best_ask(config.symbol);
-                if (best_bid > 0 && best_ask > 0) {
-                    order_spec = generate_aggressive_order(config.symbol, best_bid, best_ask);
-                } else {
-                    order_spec = generate_market_making_order(config.symbol, config.mid_price, config.spread);
-                }
-            } else {
-                order_spec = generate_market_making_order(config.symbol, config.mid_price, config.spread);
-            }
-
-            // Submit order
-            uint64_t order_id = engine_->submit_order(i, order_spec.symbol, order_spec.side, order_spec.price, order_spec.quantity);
-
-            auto order_end = std::chrono::steady_clock::now();
-            auto latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(order_end - order_start).count();
-            order_latencies_.push_back(static_cast<double>(latency_ns));
+            order_latencies_.push_back(submit_next_order(config, i));
 
             // Progress update
             if (i % progress_interval == 0) {
@@ -158,7 +408,83 @@ public:
 
         std::cout << "\rProgress: 100.0%" << std::endl;
 
-        return calculate_results(config, total_duration.count() / 1e6);
+        auto results = calculate_results(config, total_duration.count() / 1e6);
+        results.warmup_orders = warmup_orders;
+        results.warmup_steady = warmup_steady;
+        results.seed = seed_;
+        return results;
+    }
+
+    // Generate and submit one order of the test's workload; returns its latency in ns
+    double submit_next_order(const BenchmarkConfig& config, uint64_t client_id) {
+        auto order_start = std::chrono::steady_clock::now();
+
+        // Generate order based on mode
+        OrderSpec order_spec;
+        if (config.aggressive_mode && config.warmup_book) {
+            double best_bid = engine_->get_best_bid(config.symbol);
+            double best_ask = engine_->get_best_ask(config.symbol);
+            if (best_bid > 0 && best_ask > 0) {
+                order_spec = generate_aggressive_order(config.symbol, best_bid, best_ask);
+            } else {
+                order_spec = generate_market_making_order(config.symbol, config.mid_price, config.spread);
+            }
+        } else {
+            order_spec = generate_market_making_order(config.symbol, config.mid_price, config.spread);
+        }
+
+        // Submit order
+        engine_->submit_order(client_id, order_spec.symbol, order_spec.side, order_spec.price, order_spec.quantity);
+
+        auto order_end = std::chrono::steady_clock::now();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(order_end - order_start).count());
+    }
+
+    // Paced like the measured run. Returns the number of warm-up orders sent;
+    // steady is set if the block medians settled before the cap.
+    uint64_t run_warmup(const BenchmarkConfig& config, std::chrono::nanoseconds inter_order_delay, bool& steady) {
+        steady = false;
+        if (warmup_.max_orders == 0 || warmup_.block_size == 0) {
+            return 0;
+        }
+
+        std::vector<double> block;
+        std::vector<double> medians;
+        block.reserve(warmup_.block_size);
+        uint64_t sent = 0;
+        while (sent < warmup_.max_orders && !steady) {
+            block.push_back(submit_next_order(config, sent));
+            sent++;
+            std::this_thread::sleep_for(inter_order_delay);
+
+            if (block.size() == warmup_.block_size) {
+                std::sort(block.begin(), block.end());
+                medians.push_back(percentile(block, 50.0));
+                block.clear();
+                steady = is_steady(medians);
+            }
+        }
+
+        std::cout << "Warm-up: " << sent << " orders ("
+                  << (steady ? "steady state reached" : "cap reached before steady state") << ")" << std::endl;
+        return sent;
+    }
+
+    bool is_steady(const std::vector<double>& medians) const {
+        if (medians.size() < warmup_.stable_blocks) {
+            return false;
+        }
+        double mean = 0.0;
+        for (size_t i = medians.size() - warmup_.stable_blocks; i < medians.size(); ++i) {
+            mean += medians[i];
+        }
+        mean /= warmup_.stable_blocks;
+        for (size_t i = medians.size() - warmup_.stable_blocks; i < medians.size(); ++i) {
+            if (std::abs(medians[i] - mean) > warmup_.tolerance * mean) {
+                return false;
+            }
+        }
+        return true;
     }
 
     BenchmarkResults calculate_results(const BenchmarkConfig& config, double duration_seconds) {
@@ -206,6 +532,9 @@ public:
         std::cout << "  Duration: " << std::fixed << std::setprecision(2) << results.duration_seconds << " seconds" << std::endl;
         std::cout << "  Actual Rate: " << std::fixed << std::setprecision(0) << results.actual_rate << " orders/sec" << std::endl;
         std::cout << "  Trade Rate: " << std::fixed << std::setprecision(0) << results.trades_per_second << " trades/sec" << std::endl;
+        std::cout << "  Warm-up Orders: " << results.warmup_orders
+                  << (results.warmup_steady ? " (steady)" : "") << std::endl;
+        std::cout << "  Trial / Seed: " << results.trial << " / " << results.seed << std::endl;
 
         std::cout << "\nLatency (μs):" << std::endl;
         std::cout << "  Min: " << std::fixed << std::setprecision(2) << results.min_latency_us << std::endl;
@@ -239,7 +568,7 @@ public:
     void print_csv_header(std::ostream& out = std::cout) {
         out << "test_name,total_orders,total_trades,duration_seconds,actual_rate,trades_per_second,";
         out << "min_latency_us,avg_latency_us,p50_latency_us,p95_latency_us,p99_latency_us,max_latency_us,";
-        out << "active_orders,engine_total_trades,cancelled_orders" << std::endl;
+        out << "active_orders,engine_total_trades,cancelled_orders,warmup_orders,trial,seed" << std::endl;
     }
 
     void print_csv_row(const BenchmarkResults& results, std::ostream& out = std::cout) {
@@ -257,7 +586,10 @@ public:
             << std::fixed << std::setprecision(2) << results.max_latency_us << ","
             << results.engine_stats.active_orders << ","
             << results.engine_stats.total_trades << ","
-            << results.engine_stats.cancelled_orders << std::endl;
+            << results.engine_stats.cancelled_orders << ","
+            << results.warmup_orders << ","
+            << results.trial << ","
+            << results.seed << std::endl;
     }
 
     // Auto-save results to timestamped CSV file
@@ -277,133 +609,3310 @@ public:
         }
     }
 
+    double metric_value(const BenchmarkResults& results, const std::string& metric) const {
+        if (metric == "actual_rate") return results.actual_rate;
+        if (metric == "trades_per_second") return results.trades_per_second;
+        if (metric == "avg_latency_us") return results.avg_latency_us;
+        if (metric == "p50_latency_us") return results.p50_latency_us;
+        if (metric == "p95_latency_us") return results.p95_latency_us;
+        if (metric == "p99_latency_us") return results.p99_latency_us;
+        if (metric == "max_latency_us") return results.max_latency_us;
+        return 0.0;
+    }
+
+    // Per-test mean/stddev/CI, the input to --compare
+    void save_summary(const std::vector<MetricSummary>& summaries, const std::string& suite_name) {
+        std::string filename = generate_timestamped_filename("benchmark_" + suite_name + "_summary");
+        std::ofstream file(filename);
+
+        if (file.is_open()) {
+            TrialComparison::print_csv_header(file);
+            for (const auto& summary : summaries) {
+                TrialComparison::print_csv_row(summary, file);
+            }
+            file.close();
+            std::cout << "Summary saved to: " << filename << std::endl;
+        } else {
+            std::cerr << "Failed to save summary to: " << filename << std::endl;
+        }
+    }
+
+    // Save hiccup windows next to the benchmark results they were measured alongside
+    void save_hiccup_report(const std::vector<std::pair<std::string, HiccupMonitor::Report>>& windows,
+                            const std::string& suite_name) {
+        std::string filename = generate_timestamped_filename("hiccup_" + suite_name);
+        std::ofstream file(filename);
+
+        if (file.is_open()) {
+            HiccupMonitor::print_csv_header(file);
+            for (const auto& [label, report] : windows) {
+                HiccupMonitor::print_csv_row(label, report, file);
+            }
+            file.close();
+            std::cout << "Hiccup report saved to: " << filename << std::endl;
+        } else {
+            std::cerr << "Failed to save hiccup report to: " << filename << std::endl;
+        }
+    }
+
     void reset() {
+        rng_.seed(seed_);
         engine_ = std::make_unique<MatchingEngine>();
-        engine_->set_trade_callback([this](const Trade& trade) {
-            trade_count_.fetch_add(1);
-        });
+        count_trades();
         order_latencies_.clear();
         trade_count_.store(0);
     }
+
+private:
+    // Count the trades of the current engine
+    void count_trades() {
+        engine_->set_trade_callback([this](const Trade&) { trade_count_.fetch_add(1); });
+    }
 };
 
-void print_usage(const char* program_name) {
-    std::cout << "Usage: " << program_name << " [options]" << std::endl;
-    std::cout << "Options:" << std::endl;
-    std::cout << "  --help                    Show this help message" << std::endl;
-    std::cout << "  --quick                   Run quick benchmark suite (default)" << std::endl;
-    std::cout << "  --full                    Run full benchmark suite" << std::endl;
-    std::cout << "  --extreme                 Run extreme stress tests" << std::endl;
-    std::cout << "  --csv                     Output results in CSV format" << std::endl;
-    std::cout << "  --custom N R              Run custom test with N orders at R orders/sec" << std::endl;
-    std::cout << "  --symbol SYM              Use symbol SYM (default: BTC-USD)" << std::endl;
-    std::cout << "  --mid-price P             Use mid price P (default: 50000)" << std::endl;
-    std::cout << "  --spread S                Use spread S (default: 10)" << std::endl;
-}
+// Parameter sweep over resting depth, symbol count, cancel ratio and
+// aggressor ratio. Every cell runs on a fresh engine: the book is seeded with
+// the requested depth (unmeasured), then a fixed number of commands are
+// submitted back-to-back and timed individually.
+class ScalabilitySweep {
+public:
+    struct EventCounter {
+        SequenceGapDetector detector;
+        uint64_t events{0};
 
-int main(int argc, char* argv[]) {
-    PerformanceBenchmark benchmark;
-    std::vector<PerformanceBenchmark::BenchmarkConfig> configs;
-    bool csv_output = false;
-    std::string symbol = "BTC-USD";
-    double mid_price = 50000.0;
-    double spread = 10.0;
+        void on_events(const EngineEvent* begin, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                detector.check(begin[i]);
+            }
+            events += count;
+        }
+    };
 
-    // Parse command line arguments
-    for (int i = 1; i < argc; ++i) {
-        std::string arg = argv[i];
+    struct SweepConfig {
+        std::vector<uint64_t> depths{100, 1000, 10000, 100000, 1000000, 10000000};
+        std::vector<uint64_t> symbol_counts{1, 10, 100, 1000, 10000};
+        std::vector<double> cancel_ratios{0.0, 0.5, 0.9, 0.99};
+        // Fraction of non-cancel commands that cross the spread
+        std::vector<double> aggressor_ratios{0.05, 0.25, 0.5};
+        uint64_t measured_orders{100000};
+        uint32_t seed{42};
+        BookType book_type{BookType::INTRUSIVE};
+        double mid_price{100.0};
+        double tick_size{0.01};
+        int price_band_ticks{500};
+        // Every check of the pre-trade risk stage on, with limits no order hits
+        bool risk_limits{false};
+        // A subscriber on the engine event stream (counts and gap-checks events)
+        bool event_stream{false};
+    };
 
-        if (arg == "--help") {
-            print_usage(argv[0]);
-            return 0;
-        } else if (arg == "--csv") {
-            csv_output = true;
-        } else if (arg == "--symbol" && i + 1 < argc) {
-            symbol = argv[++i];
-        } else if (arg == "--mid-price" && i + 1 < argc) {
-            mid_price = std::stod(argv[++i]);
-        } else if (arg == "--spread" && i + 1 < argc) {
-            spread = std::stod(argv[++i]);
-        } else if (arg == "--custom" && i + 2 < argc) {
-            uint64_t orders = std::stoull(argv[++i]);
-            double rate = std::stod(argv[++i]);
-            configs.push_back({"Custom", orders, rate, symbol, mid_price, spread, false, false});
-        } else if (arg == "--quick") {
-            configs = {
-                {"Quick_LowVolume", 1000, 100.0, symbol, mid_price, spread, false, false},
-                {"Quick_MediumVolume", 5000, 500.0, symbol, mid_price, spread, false, false},
-                {"Quick_Aggressive", 2000, 200.0, symbol, mid_price, spread, true, true}
-            };
-        } else if (arg == "--full") {
-            configs = {
-                {"LowVolume_MarketMaking", 1000, 100.0, symbol, mid_price, spread, false, false},
-                {"MediumVolume_MarketMaking", 5000, 500.0, symbol, mid_price, spread, false, false},
-                {"HighVolume_MarketMaking", 10000, 1000.0, symbol, mid_price, spread, false, false},
-                {"Aggressive_Trading", 5000, 500.0, symbol, mid_price, spread, true, true},
-                {"HighFrequency_Burst", 20000, 2000.0, symbol, mid_price, spread, false, false}
-            };
-        } else if (arg == "--extreme") {
-            configs = {
-                {"Extreme_HighFrequency", 50000, 5000.0, symbol, mid_price, spread, false, false},
-                {"Extreme_Aggressive", 25000, 2500.0, symbol, mid_price, spread, true, true},
-                {"Extreme_Sustained", 100000, 10000.0, symbol, mid_price, spread, false, false}
-            };
+    struct CellResult {
+        uint64_t depth;
+        uint64_t symbols;
+        double cancel_ratio;
+        double aggressor_ratio;
+        uint64_t commands;
+        uint64_t trades;
+        double duration_seconds;
+        double commands_per_second;
+        double p50_latency_ns;
+        double p99_latency_ns;
+        double p999_latency_ns;
+        double max_latency_ns;
+        uint64_t active_orders;
+        uint64_t rss_kb;
+        uint64_t peak_rss_kb;
+    };
+
+    explicit ScalabilitySweep(const SweepConfig& config) : config_(config) {}
+
+    void run(std::ostream& out) {
+        print_csv_header(out);
+        size_t total_cells = config_.depths.size() * config_.symbol_counts.size() *
+                             config_.cancel_ratios.size() * config_.aggressor_ratios.size();
+        size_t cell_index = 0;
+
+        for (uint64_t depth : config_.depths) {
+            for (uint64_t symbols : config_.symbol_counts) {
+                for (double cancel_ratio : config_.cancel_ratios) {
+                    for (double aggressor_ratio : config_.aggressor_ratios) {
+                        std::cerr << "[sweep " << ++cell_index << "/" << total_cells << "] depth=" << depth
+                                  << " symbols=" << symbols << " cancel=" << cancel_ratio
+                                  << " aggressor=" << aggressor_ratio << std::endl;
+                        auto result = run_cell(depth, symbols, cancel_ratio, aggressor_ratio);
+                        // Rows are flushed as they complete so a partial sweep is still usable
+                        print_csv_row(result, out);
+                        out.flush();
+                    }
+                }
+            }
         }
     }
 
-    // Default to quick if no specific suite chosen
-    if (configs.empty()) {
-        configs = {
-            {"Quick_LowVolume", 1000, 100.0, symbol, mid_price, spread, false, false},
-            {"Quick_MediumVolume", 5000, 500.0, symbol, mid_price, spread, false, false},
-            {"Quick_Aggressive", 2000, 200.0, symbol, mid_price, spread, true, true}
+    CellResult run_cell(uint64_t depth, uint64_t symbols, double cancel_ratio, double aggressor_ratio) {
+        MatchingEngine engine(config_.book_type);
+        if (config_.risk_limits) {
+            RiskLimits limits;
+            limits.max_order_quantity = 1000000000;
+            limits.max_order_notional = 1e15;
+            limits.price_collar = 0.5;
+            limits.max_open_orders = 100000000;
+            engine.set_risk_limits(limits);
+        }
+        std::atomic<uint64_t> trades{0};
+        engine.set_trade_callback([&trades](const Trade&) {
+            trades.fetch_add(1, std::memory_order_relaxed);
+        });
+        EventCounter event_counter;
+        if (config_.event_stream) {
+            engine.subscribe_events(event_counter);
+        }
+
+        std::mt19937 rng(config_.seed);
+        std::vector<std::string> symbol_names;
+        symbol_names.reserve(symbols);
+        for (uint64_t i = 0; i < symbols; ++i) {
+            symbol_names.push_back("SYM" + std::to_string(i));
+        }
+
+        std::uniform_int_distribution<uint64_t> symbol_dist(0, symbols - 1);
+        std::uniform_int_distribution<int> side_dist(0, 1);
+        std::uniform_int_distribution<int> offset_dist(1, config_.price_band_ticks);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+        std::uniform_real_distribution<double> action_dist(0.0, 1.0);
+
+        std::vector<uint64_t> resting_ids;
+        resting_ids.reserve(depth + config_.measured_orders);
+
+        auto submit = [&](bool aggressive) {
+            const std::string& symbol = symbol_names[symbol_dist(rng)];
+            Side side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+            int offset = offset_dist(rng);
+            int ticks = (side == Side::BUY) == aggressive ? offset : -offset;
+            double price = config_.mid_price + ticks * config_.tick_size;
+            uint64_t order_id = engine.submit_order(order_count_++ % 1024, symbol, side, price, quantity_dist(rng));
+            resting_ids.push_back(order_id);
         };
-    }
 
-    std::cout << "Quasar Matching Engine Performance Benchmark" << std::endl;
-    std::cout << "=============================================" << std::endl;
+        // Seed resting depth (not measured)
+        for (uint64_t i = 0; i < depth; ++i) {
+            submit(false);
+        }
+        trades.store(0);
 
-    std::vector<PerformanceBenchmark::BenchmarkResults> all_results;
-    std::string suite_name = "custom";
+        std::vector<double> latencies;
+        latencies.reserve(config_.measured_orders);
 
-    // Determine suite name for auto-saving
-    if (configs.size() > 1) {
-        if (configs[0].test_name.find("Quick") != std::string::npos) {
-            suite_name = "quick";
-        } else if (configs[0].test_name.find("Extreme") != std::string::npos) {
-            suite_name = "extreme";
-        } else if (configs.size() >= 5) {
-            suite_name = "full";
+        auto start_time = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < config_.measured_orders; ++i) {
+            bool is_cancel = action_dist(rng) < cancel_ratio && !resting_ids.empty();
+            bool aggressive = action_dist(rng) < aggressor_ratio;
+            size_t cancel_index = 0;
+            if (is_cancel) {
+                std::uniform_int_distribution<size_t> pick(0, resting_ids.size() - 1);
+                cancel_index = pick(rng);
+            }
+
+            auto op_start = std::chrono::steady_clock::now();
+            if (is_cancel) {
+                engine.cancel_order(resting_ids[cancel_index]);
+            } else {
+                submit(aggressive);
+            }
+            auto op_end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count()));
+
+            if (is_cancel) {
+                resting_ids[cancel_index] = resting_ids.back();
+                resting_ids.pop_back();
+            }
         }
+        auto end_time = std::chrono::steady_clock::now();
+
+        CellResult result{};
+        result.depth = depth;
+        result.symbols = symbols;
+        result.cancel_ratio = cancel_ratio;
+        result.aggressor_ratio = aggressor_ratio;
+        result.commands = latencies.size();
+        result.trades = trades.load();
+        result.duration_seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+            end_time - start_time).count() / 1e6;
+        result.commands_per_second = result.commands / result.duration_seconds;
+
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_latency_ns = percentile(latencies, 50.0);
+        result.p99_latency_ns = percentile(latencies, 99.0);
+        result.p999_latency_ns = percentile(latencies, 99.9);
+        result.max_latency_ns = latencies.empty() ? 0.0 : latencies.back();
+
+        result.active_orders = engine.get_stats().active_orders;
+        if (config_.event_stream && event_counter.detector.gaps() != 0) {
+            std::cerr << "Event stream gaps: " << event_counter.detector.gaps() << std::endl;
+        }
+        MemoryUsage memory = read_memory_usage();
+        result.rss_kb = memory.rss_kb;
+        result.peak_rss_kb = memory.peak_rss_kb;
+        return result;
     }
 
-    if (csv_output) {
-        benchmark.print_csv_header();
+    static void print_csv_header(std::ostream& out) {
+        out << "depth,symbols,cancel_ratio,aggressor_ratio,commands,trades,duration_seconds,"
+            << "commands_per_second,p50_latency_ns,p99_latency_ns,p999_latency_ns,max_latency_ns,"
+            << "active_orders,rss_kb,peak_rss_kb" << std::endl;
     }
 
-    // Run benchmarks
-    for (const auto& config : configs) {
-        auto results = benchmark.run_benchmark(config);
-        all_results.push_back(results);
+    static void print_csv_row(const CellResult& result, std::ostream& out) {
+        out << result.depth << ","
+            << result.symbols << ","
+            << std::fixed << std::setprecision(2) << result.cancel_ratio << ","
+            << std::fixed << std::setprecision(2) << result.aggressor_ratio << ","
+            << result.commands << ","
+            << result.trades << ","
+            << std::fixed << std::setprecision(4) << result.duration_seconds << ","
+            << std::fixed << std::setprecision(0) << result.commands_per_second << ","
+            << result.p50_latency_ns << ","
+            << result.p99_latency_ns << ","
+            << result.p999_latency_ns << ","
+            << result.max_latency_ns << ","
+            << result.active_orders << ","
+            << result.rss_kb << ","
+            << result.peak_rss_kb << std::endl;
+    }
 
-        if (csv_output) {
-            benchmark.print_csv_row(results);
-        } else {
-            benchmark.print_results(results);
+private:
+    SweepConfig config_;
+    uint64_t order_count_{0};
+};
+
+// Unbounded FIFO between benchmark stages. Depth is observable so that a
+// backlog growing without bound can be detected.
+template<typename T>
+class StageQueue {
+public:
+    void push(const T& item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_.push_back(item);
+        }
+        cv_.notify_one();
+    }
+
+    // Wait up to timeout for an item; false if none arrived or the queue is closed and empty
+    bool pop(T& item, std::chrono::microseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_for(lock, timeout, [this] { return !items_.empty() || closed_; })) {
+            return false;
+        }
+        if (items_.empty()) {
+            return false;
+        }
+        item = items_.front();
+        items_.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
         }
+        cv_.notify_all();
+    }
 
-        benchmark.reset(); // Reset for next test
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
 
-        if (!csv_output && &config != &configs.back()) {
-            std::cout << "\nPausing 2 seconds before next test...\n" << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(2));
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    std::deque<T> drain() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::deque<T> rest;
+        rest.swap(items_);
+        return rest;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<T> items_;
+    bool closed_{false};
+};
+
+// Open-loop saturation search. Offered load is stepped up geometrically; in
+// every step a generator emits orders on a fixed schedule regardless of how
+// fast they are processed, and latency is measured from each order's
+// scheduled send time (so queueing delay is never hidden). Targets:
+//   engine          generator -> queue -> engine thread
+//   pipeline-inproc generator -> framed bytes queue -> gateway decode thread -> queue -> engine thread
+//   pipeline-tcp    generator -> loopback TCP socket -> gateway decode thread -> queue -> engine thread
+class LatencyKneeFinder {
+public:
+    enum class Target {
+        ENGINE,
+        PIPELINE_INPROC,
+        PIPELINE_TCP
+    };
+
+    struct KneeConfig {
+        double start_rate{10000.0};
+        double max_rate{2000000.0};
+        double step_factor{1.5};
+        double step_seconds{2.0};
+        double slo_p99_us{100.0};
+        // p99 growth over the best step that counts as the latency knee
+        double knee_multiplier{3.0};
+        uint64_t seed_depth{10000};
+        uint32_t seed{42};
+        uint32_t symbols{4};
+        BookType book_type{BookType::INTRUSIVE};
+    };
+
+    struct StepResult {
+        double offered_rate;
+        double achieved_rate;
+        uint64_t commands;
+        uint64_t completed;
+        double p50_latency_us;
+        double p99_latency_us;
+        double p999_latency_us;
+        double max_latency_us;
+        size_t max_queue_depth;
+        size_t end_queue_depth;
+        double queue_slope_per_sec;
+        bool slo_met;
+        bool queue_growing;
+    };
+
+    LatencyKneeFinder(Target target, const KneeConfig& config) : target_(target), config_(config) {}
+
+    static std::string target_name(Target target) {
+        switch (target) {
+            case Target::ENGINE: return "engine";
+            case Target::PIPELINE_INPROC: return "pipeline-inproc";
+            case Target::PIPELINE_TCP: return "pipeline-tcp";
+            default: return "unknown";
+        }
+    }
+
+    std::vector<StepResult> run(std::ostream& csv_out) {
+        std::vector<StepResult> steps;
+        int failing_steps = 0;
+
+        std::cout << "\n=== Latency Knee Search: " << target_name(target_) << " ===" << std::endl;
+        std::cout << std::defaultfloat << "SLO: P99 <= " << config_.slo_p99_us << " us, step " << config_.step_seconds
+                  << " s, rate x" << config_.step_factor << " per step" << std::endl;
+
+        for (double rate = config_.start_rate; rate <= config_.max_rate; rate *= config_.step_factor) {
+            StepResult step = run_step(rate);
+            steps.push_back(step);
+            print_csv_row(step, csv_out);
+            csv_out.flush();
+
+            std::cout << "  offered=" << std::fixed << std::setprecision(0) << step.offered_rate
+                      << " achieved=" << step.achieved_rate
+                      << std::setprecision(2) << " p50=" << step.p50_latency_us
+                      << "us p99=" << step.p99_latency_us
+                      << "us backlog=" << step.end_queue_depth
+                      << (step.slo_met ? "" : " [SLO MISS]")
+                      << (step.queue_growing ? " [QUEUE GROWING]" : "") << std::endl;
+
+            // Two consecutive overloaded steps: everything beyond is saturated too
+            failing_steps = (step.queue_growing || !step.slo_met) ? failing_steps + 1 : 0;
+            if (failing_steps >= 2 && step.queue_growing) {
+                break;
+            }
+        }
+
+        print_summary(steps);
+        return steps;
+    }
+
+    void print_csv_header(std::ostream& out) const {
+        out << "target,offered_rate,achieved_rate,commands,completed,p50_latency_us,p99_latency_us,"
+            << "p999_latency_us,max_latency_us,max_queue_depth,end_queue_depth,queue_slope_per_sec,"
+            << "slo_met,queue_growing" << std::endl;
+    }
+
+private:
+    // Fixed-size wire frame used by the pipeline targets
+    static constexpr size_t kPayloadSize = 8 + 4 + 1 + 8 + 8;
+    static constexpr size_t kFrameSize = 4 + kPayloadSize;
+    using Frame = std::array<uint8_t, kFrameSize>;
+
+    struct Command {
+        int64_t scheduled_ns;
+        uint32_t symbol_index;
+        Side side;
+        double price;
+        uint64_t quantity;
+    };
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void encode(const Command& command, Frame& frame) {
+        uint32_t length = static_cast<uint32_t>(kPayloadSize);
+        frame[0] = (length >> 24) & 0xFF;
+        frame[1] = (length >> 16) & 0xFF;
+        frame[2] = (length >> 8) & 0xFF;
+        frame[3] = length & 0xFF;
+        uint8_t* p = frame.data() + 4;
+        uint8_t side = command.side == Side::BUY ? 0 : 1;
+        std::memcpy(p, &command.scheduled_ns, 8); p += 8;
+        std::memcpy(p, &command.symbol_index, 4); p += 4;
+        std::memcpy(p, &side, 1); p += 1;
+        std::memcpy(p, &command.price, 8); p += 8;
+        std::memcpy(p, &command.quantity, 8);
+    }
+
+    static Command decode(const uint8_t* payload) {
+        Command command{};
+        uint8_t side = 0;
+        std::memcpy(&command.scheduled_ns, payload, 8); payload += 8;
+        std::memcpy(&command.symbol_index, payload, 4); payload += 4;
+        std::memcpy(&side, payload, 1); payload += 1;
+        std::memcpy(&command.price, payload, 8); payload += 8;
+        std::memcpy(&command.quantity, payload, 8);
+        command.side = side == 0 ? Side::BUY : Side::SELL;
+        return command;
+    }
+
+    static bool read_exact(int fd, uint8_t* buffer, size_t length) {
+        size_t received = 0;
+        while (received < length) {
+            ssize_t n = recv(fd, buffer + received, length - received, 0);
+            if (n <= 0) {
+                return false;
+            }
+            received += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Connected loopback socket pair: (client, server)
+    static std::pair<int, int> open_loopback_connection() {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t addr_len = sizeof(addr);
+        if (listener < 0 ||
+            bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listener, 1) < 0 ||
+            getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0) {
+            throw std::runtime_error("Failed to open loopback listener");
+        }
+
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        if (client < 0 || connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(listener);
+            throw std::runtime_error("Failed to connect loopback client");
+        }
+        int server = accept(listener, nullptr, nullptr);
+        close(listener);
+        if (server < 0) {
+            close(client);
+            throw std::runtime_error("Failed to accept loopback client");
+        }
+
+        int flag = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        return {client, server};
+    }
+
+    StepResult run_step(double rate) {
+        MatchingEngine engine(config_.book_type);
+        std::vector<std::string> symbols;
+        for (uint32_t i = 0; i < config_.symbols; ++i) {
+            symbols.push_back("KNEE" + std::to_string(i));
+        }
+
+        std::mt19937 rng(config_.seed);
+        std::uniform_int_distribution<uint32_t> symbol_dist(0, config_.symbols - 1);
+        std::uniform_int_distribution<int> side_dist(0, 1);
+        std::uniform_int_distribution<int> offset_dist(-100, 100);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+
+        auto next_command = [&]() {
+            Command command{};
+            command.symbol_index = symbol_dist(rng);
+            command.side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+            command.price = 100.0 + offset_dist(rng) * 0.01;
+            command.quantity = quantity_dist(rng);
+            return command;
+        };
+
+        // Seed resting depth so matching does real work from the first order
+        for (uint64_t i = 0; i < config_.seed_depth; ++i) {
+            Command command = next_command();
+            double price = command.side == Side::BUY ? 99.0 - (i % 100) * 0.01 : 101.0 + (i % 100) * 0.01;
+            engine.submit_order(0, symbols[command.symbol_index], command.side, price, command.quantity);
+        }
+
+        uint64_t total_commands = static_cast<uint64_t>(rate * config_.step_seconds);
+        std::vector<double> latencies;
+        latencies.reserve(total_commands);
+
+        StageQueue<Command> engine_queue;
+        StageQueue<Frame> frame_queue;
+        std::atomic<bool> abort{false};
+        std::atomic<uint64_t> completed{0};
+        int client_fd = -1;
+        int server_fd = -1;
+        if (target_ == Target::PIPELINE_TCP) {
+            std::tie(client_fd, server_fd) = open_loopback_connection();
+        }
+
+        // Engine stage
+        std::thread engine_thread([&]() {
+            Command command;
+            while (!abort.load(std::memory_order_relaxed)) {
+                if (!engine_queue.pop(command, std::chrono::microseconds(1000))) {
+                    if (engine_queue.closed() && engine_queue.size() == 0) {
+                        break;
+                    }
+                    continue;
+                }
+                engine.submit_order(1, symbols[command.symbol_index], command.side,
+                                    command.price, command.quantity);
+                latencies.push_back((now_ns() - command.scheduled_ns) / 1000.0);
+                completed.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        // Gateway stage: decode frames and hand them to the engine
+        std::thread gateway_thread;
+        if (target_ == Target::PIPELINE_INPROC) {
+            gateway_thread = std::thread([&]() {
+                Frame frame;
+                while (!abort.load(std::memory_order_relaxed)) {
+                    if (!frame_queue.pop(frame, std::chrono::microseconds(1000))) {
+                        if (frame_queue.closed() && frame_queue.size() == 0) {
+                            break;
+                        }
+                        continue;
+                    }
+                    engine_queue.push(decode(frame.data() + 4));
+                }
+                engine_queue.close();
+            });
+        } else if (target_ == Target::PIPELINE_TCP) {
+            gateway_thread = std::thread([&]() {
+                uint8_t length_buffer[4];
+                uint8_t payload[kPayloadSize];
+                while (read_exact(server_fd, length_buffer, 4)) {
+                    uint32_t length = (static_cast<uint32_t>(length_buffer[0]) << 24) |
+                                      (static_cast<uint32_t>(length_buffer[1]) << 16) |
+                                      (static_cast<uint32_t>(length_buffer[2]) << 8) |
+                                      static_cast<uint32_t>(length_buffer[3]);
+                    if (length != kPayloadSize || !read_exact(server_fd, payload, length)) {
+                        break;
+                    }
+                    engine_queue.push(decode(payload));
+                }
+                engine_queue.close();
+            });
+        }
+
+        // Queue depth sampler
+        std::vector<std::pair<double, size_t>> depth_samples;
+        std::atomic<bool> sampling{true};
+        auto step_start_ns = now_ns();
+        std::thread sampler([&]() {
+            while (sampling.load()) {
+                double t = (now_ns() - step_start_ns) / 1e9;
+                depth_samples.emplace_back(t, engine_queue.size() + frame_queue.size());
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+
+        // Open-loop generator: send times are fixed by the schedule
+        int64_t interval_ns = static_cast<int64_t>(1e9 / rate);
+        Frame frame;
+        for (uint64_t i = 0; i < total_commands; ++i) {
+            Command command = next_command();
+            command.scheduled_ns = step_start_ns + static_cast<int64_t>(i) * interval_ns;
+
+            int64_t wait_ns = command.scheduled_ns - now_ns();
+            if (wait_ns > 200000) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns - 100000));
+            }
+            while (now_ns() < command.scheduled_ns) {
+                std::this_thread::yield();
+            }
+
+            if (target_ == Target::ENGINE) {
+                engine_queue.push(command);
+            } else {
+                encode(command, frame);
+                if (target_ == Target::PIPELINE_INPROC) {
+                    frame_queue.push(frame);
+                } else if (send(client_fd, frame.data(), frame.size(), MSG_NOSIGNAL) !=
+                           static_cast<ssize_t>(frame.size())) {
+                    break;
+                }
+            }
+        }
+        int64_t generation_end_ns = now_ns();
+        uint64_t completed_in_window = completed.load();
+
+        // Let the backlog drain for at most one more step duration
+        frame_queue.close();
+        if (target_ == Target::ENGINE) {
+            engine_queue.close();
+        }
+        if (client_fd >= 0) {
+            shutdown(client_fd, SHUT_WR);
+        }
+        int64_t drain_deadline = generation_end_ns + static_cast<int64_t>(config_.step_seconds * 1e9);
+        while (completed.load() < total_commands && now_ns() < drain_deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        abort.store(true);
+        sampling.store(false);
+        engine_queue.close();
+        engine_thread.join();
+        if (client_fd >= 0) {
+            close(client_fd);
+        }
+        if (gateway_thread.joinable()) {
+            if (server_fd >= 0) {
+                shutdown(server_fd, SHUT_RDWR);
+            }
+            gateway_thread.join();
+        }
+        if (server_fd >= 0) {
+            close(server_fd);
+        }
+        sampler.join();
+
+        // Commands never processed still count, with a lower-bound latency
+        int64_t abort_ns = now_ns();
+        uint64_t undrained = total_commands - std::min<uint64_t>(completed.load(), total_commands);
+        int64_t last_scheduled = step_start_ns + static_cast<int64_t>(total_commands) * interval_ns;
+        for (uint64_t i = 0; i < undrained; ++i) {
+            latencies.push_back((abort_ns - last_scheduled) / 1000.0);
+        }
+
+        StepResult result{};
+        result.offered_rate = rate;
+        result.commands = total_commands;
+        result.completed = completed.load();
+        double window_seconds = (generation_end_ns - step_start_ns) / 1e9;
+        result.achieved_rate = window_seconds > 0 ? completed_in_window / window_seconds : 0.0;
+
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_latency_us = percentile(latencies, 50.0);
+        result.p99_latency_us = percentile(latencies, 99.0);
+        result.p999_latency_us = percentile(latencies, 99.9);
+        result.max_latency_us = latencies.empty() ? 0.0 : latencies.back();
+
+        // Backlog trend during the generation window (least-squares slope)
+        double sum_t = 0, sum_d = 0, sum_tt = 0, sum_td = 0;
+        size_t n = 0;
+        for (const auto& [t, depth] : depth_samples) {
+            result.max_queue_depth = std::max(result.max_queue_depth, depth);
+            if (t > window_seconds) {
+                break;
+            }
+            sum_t += t;
+            sum_d += depth;
+            sum_tt += t * t;
+            sum_td += t * depth;
+            n++;
+            result.end_queue_depth = depth;
+        }
+        if (n > 1 && (n * sum_tt - sum_t * sum_t) > 0) {
+            result.queue_slope_per_sec = (n * sum_td - sum_t * sum_d) / (n * sum_tt - sum_t * sum_t);
+        }
+
+        // Growing: backlog rises by more than 2% of the offered rate per second
+        result.queue_growing = result.queue_slope_per_sec > 0.02 * rate || undrained > 0;
+        result.slo_met = result.p99_latency_us <= config_.slo_p99_us && !result.queue_growing;
+        return result;
+    }
+
+    void print_csv_row(const StepResult& step, std::ostream& out) const {
+        out << target_name(target_) << ","
+            << std::fixed << std::setprecision(0) << step.offered_rate << ","
+            << std::fixed << std::setprecision(0) << step.achieved_rate << ","
+            << step.commands << ","
+            << step.completed << ","
+            << std::fixed << std::setprecision(2) << step.p50_latency_us << ","
+            << std::fixed << std::setprecision(2) << step.p99_latency_us << ","
+            << std::fixed << std::setprecision(2) << step.p999_latency_us << ","
+            << std::fixed << std::setprecision(2) << step.max_latency_us << ","
+            << step.max_queue_depth << ","
+            << step.end_queue_depth << ","
+            << std::fixed << std::setprecision(1) << step.queue_slope_per_sec << ","
+            << (step.slo_met ? 1 : 0) << ","
+            << (step.queue_growing ? 1 : 0) << std::endl;
+    }
+
+    void print_summary(const std::vector<StepResult>& steps) const {
+        double max_sustainable = 0.0;
+        double knee_rate = 0.0;
+        double saturation_rate = 0.0;
+        double best_p99 = std::numeric_limits<double>::max();
+
+        for (const auto& step : steps) {
+            if (step.slo_met) {
+                max_sustainable = std::max(max_sustainable, step.offered_rate);
+            }
+            if (knee_rate == 0.0 && step.p99_latency_us > config_.knee_multiplier * best_p99) {
+                knee_rate = step.offered_rate;
+            }
+            best_p99 = std::min(best_p99, step.p99_latency_us);
+            if (saturation_rate == 0.0 && step.queue_growing) {
+                saturation_rate = step.offered_rate;
+            }
+        }
+
+        std::cout << "\n--- Knee Summary (" << target_name(target_) << ") ---" << std::endl;
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "  Max sustainable rate (P99 <= " << config_.slo_p99_us << "us): "
+                  << (max_sustainable > 0 ? std::to_string(static_cast<uint64_t>(max_sustainable)) : "none")
+                  << " orders/sec" << std::endl;
+        std::cout << "  Latency knee (P99 > " << config_.knee_multiplier << "x best): "
+                  << (knee_rate > 0 ? std::to_string(static_cast<uint64_t>(knee_rate)) : "not reached")
+                  << " orders/sec" << std::endl;
+        std::cout << "  Unbounded queue growth from: "
+                  << (saturation_rate > 0 ? std::to_string(static_cast<uint64_t>(saturation_rate)) : "not reached")
+                  << " orders/sec" << std::endl;
+    }
+
+    Target target_;
+    KneeConfig config_;
+};
+
+// Monotonic drift in a per-interval series. Kendall's tau against time says
+// how consistently the series moves one way; the least-squares change over the
+// run, relative to the mean, says by how much. Both must be large, so noise
+// around a flat level and one-off steps (a pool growing once) are not flagged.
+struct DriftResult {
+    double tau{0.0};
+    double relative_change{0.0};
+    bool drifting{false};
+};
+
+DriftResult detect_drift(const std::vector<double>& series, double min_tau = 0.6, double min_change = 0.10) {
+    DriftResult result;
+    size_t n = series.size();
+    if (n < 4) {
+        return result;
+    }
+
+    int64_t concordant = 0;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+            concordant += (series[j] > series[i]) - (series[j] < series[i]);
+        }
+    }
+    result.tau = static_cast<double>(concordant) / (n * (n - 1) / 2.0);
+
+    double sum_t = 0, sum_v = 0, sum_tt = 0, sum_tv = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum_t += i;
+        sum_v += series[i];
+        sum_tt += static_cast<double>(i) * i;
+        sum_tv += i * series[i];
+    }
+    double mean = sum_v / n;
+    double slope = (n * sum_tv - sum_t * sum_v) / (n * sum_tt - sum_t * sum_t);
+    result.relative_change = mean != 0.0 ? slope * (n - 1) / mean : 0.0;
+    result.drifting = result.tau >= min_tau && result.relative_change >= min_change;
+    return result;
+}
+
+// Long-running steady workload. Commands are paced at a fixed rate and every
+// sample interval one row of the time series is written: latency percentiles
+// for the interval, RSS, open orders and the engine's container sizes. The
+// workload itself is stationary (new orders recycle a fixed ring of slots and
+// an order still resting when its slot comes round again is cancelled), so
+// anything that keeps growing is the engine's doing, not the generator's.
+class SoakTest {
+public:
+    struct SoakConfig {
+        double duration_seconds{3600.0};
+        double sample_seconds{60.0};
+        double rate{20000.0};
+        uint32_t symbols{10};
+        // Upper bound on open orders: size of the recycled order slot ring
+        uint64_t max_resting{100000};
+        double cancel_ratio{0.3};
+        // Fraction of new orders that cross the spread
+        double aggressor_ratio{0.2};
+        uint32_t seed{42};
+        BookType book_type{BookType::INTRUSIVE};
+        double mid_price{100.0};
+        double tick_size{0.01};
+        int price_band_ticks{500};
+        // Leading samples left out of drift detection while pools and tables fill
+        size_t warmup_samples{2};
+    };
+
+    struct Sample {
+        double elapsed_seconds;
+        uint64_t commands;
+        uint64_t trades;
+        double commands_per_second;
+        double p50_latency_ns;
+        double p99_latency_ns;
+        double p999_latency_ns;
+        double max_latency_ns;
+        uint64_t rss_kb;
+        uint64_t active_orders;
+        MatchingEngine::StorageStats storage;
+        uint64_t hiccup_p9999_ns;
+        uint64_t hiccup_max_ns;
+    };
+
+    SoakTest(const SoakConfig& config, HiccupMonitor* hiccup = nullptr) : config_(config), hiccup_(hiccup) {}
+
+    std::vector<Sample> run(std::ostream& csv_out) {
+        MatchingEngine engine(config_.book_type);
+        std::atomic<uint64_t> trades{0};
+        engine.set_trade_callback([&trades](const Trade&) {
+            trades.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        std::mt19937 rng(config_.seed);
+        std::vector<std::string> symbol_names;
+        for (uint32_t i = 0; i < config_.symbols; ++i) {
+            symbol_names.push_back("SYM" + std::to_string(i));
+        }
+        std::uniform_int_distribution<uint32_t> symbol_dist(0, config_.symbols - 1);
+        std::uniform_int_distribution<int> side_dist(0, 1);
+        std::uniform_int_distribution<int> offset_dist(1, config_.price_band_ticks);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+        std::uniform_real_distribution<double> action_dist(0.0, 1.0);
+        std::uniform_int_distribution<uint64_t> slot_dist(0, config_.max_resting - 1);
+
+        std::vector<uint64_t> slots(config_.max_resting, 0);
+        uint64_t next_slot = 0;
+
+        // Sized for one interval up front so the harness itself does not grow
+        std::vector<double> latencies;
+        latencies.reserve(static_cast<size_t>(config_.rate * config_.sample_seconds * 1.1) + 1);
+
+        auto timed = [&latencies](auto&& command) {
+            auto op_start = std::chrono::steady_clock::now();
+            command();
+            auto op_end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count()));
+        };
+
+        std::cout << "\n=== Soak Test ===" << std::endl;
+        std::cout << std::defaultfloat << "Duration " << config_.duration_seconds << " s, sample every "
+                  << config_.sample_seconds << " s, " << config_.rate << " commands/sec, "
+                  << config_.symbols << " symbols, book " << to_string(config_.book_type) << std::endl;
+
+        print_csv_header(csv_out);
+        std::vector<Sample> samples;
+        auto start = std::chrono::steady_clock::now();
+        auto interval_start = start;
+        auto interval = std::chrono::duration<double>(config_.sample_seconds);
+        auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(config_.duration_seconds));
+        auto command_interval = std::chrono::duration<double>(1.0 / config_.rate);
+        uint64_t scheduled = 0;
+        uint64_t interval_trades = 0;
+
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - interval_start >= interval || now >= end) {
+                Sample sample = take_sample(engine, latencies, trades.load() - interval_trades,
+                                            now - start, now - interval_start);
+                interval_trades = trades.load();
+                samples.push_back(sample);
+                print_csv_row(sample, csv_out);
+                csv_out.flush();
+                print_progress(sample);
+                latencies.clear();
+                interval_start = now;
+                if (now >= end) {
+                    break;
+                }
+            }
+
+            // Fixed schedule: sleep only when ahead of it
+            auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                command_interval * static_cast<double>(scheduled));
+            if (due > now) {
+                std::this_thread::sleep_until(due);
+            }
+            scheduled++;
+
+            if (action_dist(rng) < config_.cancel_ratio) {
+                uint64_t& slot = slots[slot_dist(rng)];
+                if (slot != 0) {
+                    uint64_t order_id = slot;
+                    slot = 0;
+                    timed([&] { engine.cancel_order(order_id); });
+                    continue;
+                }
+            }
+
+            // Recycle the next slot, cancelling its previous order if still resting
+            uint64_t& slot = slots[next_slot];
+            next_slot = (next_slot + 1) % config_.max_resting;
+            if (slot != 0) {
+                uint64_t order_id = slot;
+                timed([&] { engine.cancel_order(order_id); });
+            }
+
+            const std::string& symbol = symbol_names[symbol_dist(rng)];
+            Side side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+            bool aggressive = action_dist(rng) < config_.aggressor_ratio;
+            int offset = offset_dist(rng);
+            int ticks = (side == Side::BUY) == aggressive ? offset : -offset;
+            double price = config_.mid_price + ticks * config_.tick_size;
+            uint64_t quantity = quantity_dist(rng);
+            timed([&] { slot = engine.submit_order(scheduled % 1024, symbol, side, price, quantity); });
+        }
+
+        return samples;
+    }
+
+    // Drift verdict per tracked metric, skipping the warm-up samples
+    bool print_drift_report(const std::vector<Sample>& samples) const {
+        std::vector<std::pair<std::string, std::function<double(const Sample&)>>> metrics = {
+            {"p50_latency_ns", [](const Sample& s) { return s.p50_latency_ns; }},
+            {"p99_latency_ns", [](const Sample& s) { return s.p99_latency_ns; }},
+            {"p999_latency_ns", [](const Sample& s) { return s.p999_latency_ns; }},
+            {"rss_kb", [](const Sample& s) { return static_cast<double>(s.rss_kb); }},
+            {"active_orders", [](const Sample& s) { return static_cast<double>(s.active_orders); }},
+            {"order_map_entries", [](const Sample& s) { return static_cast<double>(s.storage.order_map_entries); }},
+            {"order_map_buckets", [](const Sample& s) { return static_cast<double>(s.storage.order_map_buckets); }},
+            {"book_indexed_orders", [](const Sample& s) { return static_cast<double>(s.storage.book_totals.indexed_orders); }},
+            {"book_index_buckets", [](const Sample& s) { return static_cast<double>(s.storage.book_totals.index_buckets); }},
+            {"book_side_entries", [](const Sample& s) { return static_cast<double>(s.storage.book_totals.side_entries); }},
+            {"pool_chunks", [](const Sample& s) {
+                return static_cast<double>(s.storage.book_totals.pool_chunks + s.storage.order_map_pool_chunks); }},
+        };
+
+        std::cout << "\n--- Drift Report ---" << std::endl;
+        if (samples.size() < config_.warmup_samples + 4) {
+            std::cout << "  Not enough samples after warm-up (" << samples.size() << " taken, need "
+                      << config_.warmup_samples + 4 << ")" << std::endl;
+            return false;
+        }
+
+        bool any_drift = false;
+        for (const auto& [name, value] : metrics) {
+            std::vector<double> series;
+            for (size_t i = config_.warmup_samples; i < samples.size(); ++i) {
+                series.push_back(value(samples[i]));
+            }
+            DriftResult drift = detect_drift(series);
+            any_drift = any_drift || drift.drifting;
+            std::cout << "  " << std::left << std::setw(22) << name << std::right
+                      << " tau=" << std::fixed << std::setprecision(2) << std::setw(5) << drift.tau
+                      << " change=" << std::setprecision(1) << std::setw(6) << drift.relative_change * 100.0 << "%"
+                      << (drift.drifting ? "  [DRIFT]" : "") << std::endl;
+        }
+        std::cout << (any_drift ? "  Monotonic drift detected" : "  No monotonic drift") << std::endl;
+        return any_drift;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "elapsed_seconds,commands,trades,commands_per_second,p50_latency_ns,p99_latency_ns,"
+            << "p999_latency_ns,max_latency_ns,rss_kb,active_orders,books,order_map_entries,"
+            << "order_map_buckets,book_indexed_orders,book_index_buckets,book_side_entries,pool_chunks,"
+            << "hiccup_p9999_ns,hiccup_max_ns" << std::endl;
+    }
+
+    static void print_csv_row(const Sample& sample, std::ostream& out) {
+        out << std::fixed << std::setprecision(1) << sample.elapsed_seconds << ","
+            << sample.commands << ","
+            << sample.trades << ","
+            << std::fixed << std::setprecision(0) << sample.commands_per_second << ","
+            << sample.p50_latency_ns << ","
+            << sample.p99_latency_ns << ","
+            << sample.p999_latency_ns << ","
+            << sample.max_latency_ns << ","
+            << sample.rss_kb << ","
+            << sample.active_orders << ","
+            << sample.storage.books << ","
+            << sample.storage.order_map_entries << ","
+            << sample.storage.order_map_buckets << ","
+            << sample.storage.book_totals.indexed_orders << ","
+            << sample.storage.book_totals.index_buckets << ","
+            << sample.storage.book_totals.side_entries << ","
+            << sample.storage.book_totals.pool_chunks + sample.storage.order_map_pool_chunks << ","
+            << sample.hiccup_p9999_ns << ","
+            << sample.hiccup_max_ns << std::endl;
+    }
+
+private:
+    Sample take_sample(const MatchingEngine& engine, std::vector<double>& latencies, uint64_t trades,
+                       std::chrono::steady_clock::duration elapsed,
+                       std::chrono::steady_clock::duration window) {
+        Sample sample{};
+        sample.elapsed_seconds = std::chrono::duration<double>(elapsed).count();
+        sample.commands = latencies.size();
+        sample.trades = trades;
+        double window_seconds = std::chrono::duration<double>(window).count();
+        sample.commands_per_second = window_seconds > 0 ? sample.commands / window_seconds : 0.0;
+
+        std::sort(latencies.begin(), latencies.end());
+        sample.p50_latency_ns = percentile(latencies, 50.0);
+        sample.p99_latency_ns = percentile(latencies, 99.0);
+        sample.p999_latency_ns = percentile(latencies, 99.9);
+        sample.max_latency_ns = latencies.empty() ? 0.0 : latencies.back();
+
+        sample.rss_kb = read_memory_usage().rss_kb;
+        sample.active_orders = engine.get_stats().active_orders;
+        sample.storage = engine.get_storage_stats();
+
+        if (hiccup_) {
+            auto report = hiccup_->report();
+            sample.hiccup_p9999_ns = report.p9999_ns;
+            sample.hiccup_max_ns = report.max_ns;
+            hiccup_->reset();
+        }
+        return sample;
+    }
+
+    static void print_progress(const Sample& sample) {
+        std::cout << "  t=" << std::fixed << std::setprecision(0) << sample.elapsed_seconds
+                  << "s rate=" << sample.commands_per_second
+                  << " p99=" << sample.p99_latency_ns << "ns p99.9=" << sample.p999_latency_ns
+                  << "ns rss=" << sample.rss_kb << "kB open=" << sample.active_orders
+                  << " index=" << sample.storage.book_totals.indexed_orders
+                  << " side_entries=" << sample.storage.book_totals.side_entries << std::endl;
+    }
+
+    SoakConfig config_;
+    HiccupMonitor* hiccup_;
+};
+
+// Cascading stop trigger storm. An ask ladder is built with one maker per
+// level and the pending buy stops are spread across it, stops_per_level per
+// level, each buying one lot at market. Lifting the first level prints its
+// price, which triggers that level's stops; they consume the next level,
+// print its price and trigger the next batch, until every stop has fired.
+// A second phase times a trade that triggers nothing with the stops pending
+// against the same trade on a book with none, to show that idle stops cost
+// nothing on the matching path.
+class StopStormBenchmark {
+public:
+    struct StormConfig {
+        uint64_t pending_stops{100000};
+        uint64_t levels{1000};
+        uint64_t probes{10000};
+        BookType book_type{BookType::INTRUSIVE};
+        double base_price{100.0};
+        double tick_size{0.01};
+    };
+
+    struct StormResult {
+        uint64_t pending_stops;
+        double insert_ns_per_stop;
+        double cascade_ms;
+        uint64_t stops_triggered;
+        uint64_t trades;
+        double ns_per_trigger;
+        double idle_p50_ns_without_stops;
+        double idle_p99_ns_without_stops;
+        double idle_p50_ns_with_stops;
+        double idle_p99_ns_with_stops;
+    };
+
+    explicit StopStormBenchmark(const StormConfig& config) : config_(config) {}
+
+    StormResult run() {
+        StormResult result{};
+        result.pending_stops = config_.pending_stops;
+        uint64_t levels = std::max<uint64_t>(1, std::min(config_.levels, config_.pending_stops));
+        uint64_t stops_per_level = (config_.pending_stops + levels - 1) / levels;
+        const std::string symbol = "STORM";
+
+        std::cout << "\n=== Stop Trigger Storm ===" << std::endl;
+        std::cout << config_.pending_stops << " pending buy stops over " << levels << " levels, book "
+                  << to_string(config_.book_type) << std::endl;
+
+        MatchingEngine engine(config_.book_type);
+        uint64_t trades = 0;
+        engine.set_trade_callback([&trades](const Trade&) { trades++; });
+
+        // Level 0 is lifted by the trigger order; level j + 1 feeds the stops triggered at level j
+        for (uint64_t level = 0; level <= levels; ++level) {
+            engine.submit_order(1, symbol, Side::SELL, price_at(level), level == 0 ? 1 : stops_per_level);
+        }
+
+        auto insert_start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < config_.pending_stops; ++i) {
+            engine.submit_stop_order(2, symbol, Side::BUY, OrderType::STOP, price_at(i % levels), 0.0, 1);
+        }
+        auto insert_end = std::chrono::steady_clock::now();
+        result.insert_ns_per_stop = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(insert_end - insert_start).count()) /
+            std::max<uint64_t>(1, config_.pending_stops);
+
+        // Idle cost: trades below every stop trigger while all of them are pending
+        auto with_stops = time_idle_trades(engine, symbol);
+        result.idle_p50_ns_with_stops = with_stops.first;
+        result.idle_p99_ns_with_stops = with_stops.second;
+
+        uint64_t pending_before = engine.get_storage_stats().book_totals.pending_stops;
+        trades = 0;
+        auto cascade_start = std::chrono::steady_clock::now();
+        engine.submit_order(3, symbol, Side::BUY, price_at(0), 1);
+        auto cascade_end = std::chrono::steady_clock::now();
+
+        result.cascade_ms = std::chrono::duration<double, std::milli>(cascade_end - cascade_start).count();
+        result.stops_triggered = pending_before - engine.get_storage_stats().book_totals.pending_stops;
+        result.trades = trades;
+        result.ns_per_trigger = result.stops_triggered > 0
+            ? result.cascade_ms * 1e6 / static_cast<double>(result.stops_triggered) : 0.0;
+
+        MatchingEngine baseline(config_.book_type);
+        baseline.submit_order(1, symbol, Side::SELL, price_at(0), 1);
+        auto without_stops = time_idle_trades(baseline, symbol);
+        result.idle_p50_ns_without_stops = without_stops.first;
+        result.idle_p99_ns_without_stops = without_stops.second;
+
+        print_result(result);
+        return result;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "pending_stops,insert_ns_per_stop,cascade_ms,stops_triggered,trades,ns_per_trigger,"
+            << "idle_p50_ns_without_stops,idle_p99_ns_without_stops,idle_p50_ns_with_stops,"
+            << "idle_p99_ns_with_stops" << std::endl;
+    }
+
+    static void print_csv_row(const StormResult& result, std::ostream& out) {
+        out << result.pending_stops << ","
+            << std::fixed << std::setprecision(1) << result.insert_ns_per_stop << ","
+            << std::setprecision(3) << result.cascade_ms << ","
+            << result.stops_triggered << ","
+            << result.trades << ","
+            << std::setprecision(1) << result.ns_per_trigger << ","
+            << std::setprecision(0) << result.idle_p50_ns_without_stops << ","
+            << result.idle_p99_ns_without_stops << ","
+            << result.idle_p50_ns_with_stops << ","
+            << result.idle_p99_ns_with_stops << std::endl;
+    }
+
+private:
+    double price_at(uint64_t level) const {
+        return config_.base_price + static_cast<double>(level) * config_.tick_size;
+    }
+
+    // Median and P99 latency of a crossing buy well below every stop price: each
+    // probe rests a sell under the ladder and times the buy that takes it
+    std::pair<double, double> time_idle_trades(MatchingEngine& engine, const std::string& symbol) {
+        double price = config_.base_price - 100.0 * config_.tick_size;
+        std::vector<double> latencies;
+        latencies.reserve(config_.probes);
+        for (uint64_t i = 0; i < config_.probes; ++i) {
+            engine.submit_order(4, symbol, Side::SELL, price, 1);
+            auto start = std::chrono::steady_clock::now();
+            engine.submit_order(5, symbol, Side::BUY, price, 1);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+        std::sort(latencies.begin(), latencies.end());
+        return {percentile(latencies, 50.0), percentile(latencies, 99.0)};
+    }
+
+    static void print_result(const StormResult& result) {
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "  Stop insert:           " << result.insert_ns_per_stop << " ns/stop" << std::endl;
+        std::cout << "  Cascade:               " << std::setprecision(3) << result.cascade_ms << " ms, "
+                  << result.stops_triggered << " stops triggered, " << result.trades << " trades, "
+                  << std::setprecision(1) << result.ns_per_trigger << " ns/trigger" << std::endl;
+        std::cout << std::setprecision(0);
+        std::cout << "  Idle trade, no stops:  P50 " << result.idle_p50_ns_without_stops << " ns, P99 "
+                  << result.idle_p99_ns_without_stops << " ns" << std::endl;
+        std::cout << "  Idle trade, " << result.pending_stops << " stops: P50 " << result.idle_p50_ns_with_stops
+                  << " ns, P99 " << result.idle_p99_ns_with_stops << " ns" << std::endl;
+    }
+
+    StormConfig config_;
+};
+
+// Cost of a BBO change against the number of resting pegs. Each change adds
+// or cancels a displayed bid inside the spread, which moves every primary and
+// midpoint peg. With pegs held in groups priced off the BBO the change costs
+// the same at any peg count. For comparison the same number of pegs is
+// emulated with limit orders re-priced the naive way, cancelling and
+// re-entering each one on every change.
+class PegRepricingBenchmark {
+public:
+    struct PegConfig {
+        std::vector<uint64_t> peg_counts{0, 100, 1000, 10000, 100000};
+        uint64_t bbo_changes{10000};
+        // Cap on naive cancel/re-enter operations per peg count
+        uint64_t naive_operation_budget{2000000};
+        BookType book_type{BookType::INTRUSIVE};
+    };
+
+    struct PegResult {
+        uint64_t pegs;
+        uint64_t peg_groups;
+        double p50_change_ns;
+        double p99_change_ns;
+        double mean_change_ns;
+        uint64_t naive_changes;
+        double naive_mean_change_ns;
+    };
+
+    explicit PegRepricingBenchmark(const PegConfig& config) : config_(config) {}
+
+    void run(std::ostream& out) {
+        std::cout << "\n=== Peg Re-pricing ===" << std::endl;
+        std::cout << std::left << std::setw(10) << "pegs" << std::setw(8) << "groups"
+                  << std::setw(14) << "p50 ns" << std::setw(14) << "p99 ns" << std::setw(14) << "mean ns"
+                  << "naive mean ns" << std::right << std::endl;
+        out << "pegs,peg_groups,p50_change_ns,p99_change_ns,mean_change_ns,naive_changes,naive_mean_change_ns"
+            << std::endl;
+
+        for (uint64_t pegs : config_.peg_counts) {
+            PegResult result = measure(pegs);
+            std::cout << std::left << std::fixed << std::setprecision(0) << std::setw(10) << result.pegs
+                      << std::setw(8) << result.peg_groups << std::setw(14) << result.p50_change_ns
+                      << std::setw(14) << result.p99_change_ns << std::setw(14) << result.mean_change_ns
+                      << result.naive_mean_change_ns << std::right << std::endl;
+            out << result.pegs << "," << result.peg_groups << ","
+                << std::fixed << std::setprecision(1) << result.p50_change_ns << ","
+                << result.p99_change_ns << "," << result.mean_change_ns << ","
+                << result.naive_changes << "," << result.naive_mean_change_ns << std::endl;
+        }
+    }
+
+private:
+    static constexpr double kBid = 100.0;
+    static constexpr double kAsk = 101.0;
+    static constexpr double kInside = 100.5;
+
+    PegResult measure(uint64_t pegs) {
+        PegResult result{};
+        result.pegs = pegs;
+        const std::string symbol = "PEG";
+
+        MatchingEngine engine(config_.book_type);
+        engine.submit_order(1, symbol, Side::BUY, kBid, 1000000);
+        engine.submit_order(1, symbol, Side::SELL, kAsk, 1000000);
+
+        // Spread over primary and midpoint groups at a few offsets on both sides
+        for (uint64_t i = 0; i < pegs; ++i) {
+            Side side = i % 2 == 0 ? Side::BUY : Side::SELL;
+            OrderType type = (i / 2) % 2 == 0 ? OrderType::PEG_PRIMARY : OrderType::PEG_MIDPOINT;
+            double offset = 0.01 * static_cast<double>(1 + (i / 4) % 4);
+            engine.submit_peg_order(2, symbol, side, type, offset, 1);
+        }
+        // 2 sides x 2 peg types x 4 offsets
+        result.peg_groups = std::min<uint64_t>(pegs, 16);
+
+        std::vector<double> latencies;
+        latencies.reserve(config_.bbo_changes);
+        uint64_t inside_id = 0;
+        for (uint64_t change = 0; change < config_.bbo_changes; ++change) {
+            auto start = std::chrono::steady_clock::now();
+            if (inside_id == 0) {
+                inside_id = engine.submit_order(3, symbol, Side::BUY, kInside, 1);
+            } else {
+                engine.cancel_order(inside_id);
+                inside_id = 0;
+            }
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+        double total = 0.0;
+        for (double latency : latencies) {
+            total += latency;
+        }
+        result.mean_change_ns = latencies.empty() ? 0.0 : total / static_cast<double>(latencies.size());
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_change_ns = percentile(latencies, 50.0);
+        result.p99_change_ns = percentile(latencies, 99.0);
+
+        measure_naive(pegs, result);
+        return result;
+    }
+
+    // Limit orders standing in for the pegs, each cancelled and re-entered at
+    // its new price on every BBO change
+    void measure_naive(uint64_t pegs, PegResult& result) {
+        const std::string symbol = "NAIVE";
+        MatchingEngine engine(config_.book_type);
+        engine.submit_order(1, symbol, Side::BUY, kBid, 1000000);
+        engine.submit_order(1, symbol, Side::SELL, kAsk, 1000000);
+
+        std::vector<uint64_t> ids(pegs);
+        auto place = [&](double bid) {
+            for (uint64_t i = 0; i < pegs; ++i) {
+                Side side = i % 2 == 0 ? Side::BUY : Side::SELL;
+                bool midpoint = (i / 2) % 2 != 0;
+                double offset = 0.01 * static_cast<double>(1 + (i / 4) % 4);
+                double reference = midpoint ? (bid + kAsk) / 2.0 : (side == Side::BUY ? bid : kAsk);
+                double price = side == Side::BUY ? reference - offset : reference + offset;
+                ids[i] = engine.submit_order(2, symbol, side, price, 1);
+            }
+        };
+        place(kBid);
+
+        result.naive_changes = std::max<uint64_t>(
+            1, std::min(config_.bbo_changes, config_.naive_operation_budget / std::max<uint64_t>(1, pegs)));
+        uint64_t inside_id = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t change = 0; change < result.naive_changes; ++change) {
+            if (inside_id == 0) {
+                inside_id = engine.submit_order(3, symbol, Side::BUY, kInside, 1);
+            } else {
+                engine.cancel_order(inside_id);
+                inside_id = 0;
+            }
+            for (uint64_t id : ids) {
+                engine.cancel_order(id);
+            }
+            place(inside_id != 0 ? kInside : kBid);
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.naive_mean_change_ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+            static_cast<double>(result.naive_changes);
+    }
+
+    PegConfig config_;
+};
+
+// Session close: N resting DAY orders over a few symbols and price levels
+// all expire on the close tick. Times the expiry (one batch per book, one
+// level update per level) against cancelling the same orders one at a time
+// through cancel_order, the only way to clear them before time in force.
+class SessionCloseBenchmark {
+public:
+    struct CloseConfig {
+        uint64_t orders{1000000};
+        uint32_t symbols{10};
+        uint32_t levels_per_side{500};
+        BookType book_type{BookType::INTRUSIVE};
+    };
+
+    struct CloseResult {
+        uint64_t orders;
+        uint64_t expired;
+        uint64_t level_updates;
+        double expiry_ms;
+        double expiry_ns_per_order;
+        double cancel_ms;
+        double cancel_ns_per_order;
+        uint64_t rss_kb_loaded;
+    };
+
+    explicit SessionCloseBenchmark(const CloseConfig& config) : config_(config) {}
+
+    CloseResult run() {
+        CloseResult result{};
+        result.orders = config_.orders;
+        constexpr uint64_t kOpen = 1000000;
+        constexpr uint64_t kClose = 2000000;
+
+        std::cout << "\n=== Session Close Expiry ===" << std::endl;
+        std::cout << config_.orders << " DAY orders over " << config_.symbols << " symbols x "
+                  << config_.levels_per_side << " levels per side, book " << to_string(config_.book_type)
+                  << std::endl;
+
+        MatchingEngine engine(config_.book_type);
+        uint64_t level_updates = 0;
+        engine.set_level_update_callback([&level_updates](const std::string&, const LevelUpdate&) {
+            level_updates++;
+        });
+        engine.advance_time(kOpen);
+        engine.set_session_close(kClose);
+        load(engine, [&](const std::string& symbol, Side side, double price) {
+            engine.submit_order(1, symbol, side, price, 1, TimeInForce::DAY);
+        });
+        result.rss_kb_loaded = read_memory_usage().rss_kb;
+
+        auto start = std::chrono::steady_clock::now();
+        result.expired = engine.advance_time(kClose);
+        auto end = std::chrono::steady_clock::now();
+        result.expiry_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.level_updates = level_updates;
+        result.expiry_ns_per_order = result.expired > 0 ? result.expiry_ms * 1e6 / result.expired : 0.0;
+
+        // Baseline: the same book cleared by individual cancels
+        MatchingEngine baseline(config_.book_type);
+        std::vector<uint64_t> ids;
+        ids.reserve(config_.orders);
+        load(baseline, [&](const std::string& symbol, Side side, double price) {
+            ids.push_back(baseline.submit_order(1, symbol, side, price, 1));
+        });
+        start = std::chrono::steady_clock::now();
+        for (uint64_t id : ids) {
+            baseline.cancel_order(id);
+        }
+        end = std::chrono::steady_clock::now();
+        result.cancel_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.cancel_ns_per_order = ids.empty() ? 0.0 : result.cancel_ms * 1e6 / ids.size();
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "  Expiry at close:   " << result.expiry_ms << " ms for " << result.expired
+                  << " orders (" << result.expiry_ns_per_order << " ns/order), "
+                  << result.level_updates << " level updates" << std::endl;
+        std::cout << "  One-by-one cancel: " << result.cancel_ms << " ms (" << result.cancel_ns_per_order
+                  << " ns/order)" << std::endl;
+        return result;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "orders,expired,level_updates,expiry_ms,expiry_ns_per_order,cancel_ms,cancel_ns_per_order,"
+            << "rss_kb_loaded" << std::endl;
+    }
+
+    static void print_csv_row(const CloseResult& result, std::ostream& out) {
+        out << result.orders << "," << result.expired << "," << result.level_updates << ","
+            << std::fixed << std::setprecision(3) << result.expiry_ms << ","
+            << std::setprecision(1) << result.expiry_ns_per_order << ","
+            << std::setprecision(3) << result.cancel_ms << ","
+            << std::setprecision(1) << result.cancel_ns_per_order << ","
+            << result.rss_kb_loaded << std::endl;
+    }
+
+private:
+    // Bids below 100 and asks above it, so nothing crosses
+    template<typename Submit>
+    void load(MatchingEngine&, Submit&& submit) {
+        std::vector<std::string> symbols;
+        for (uint32_t i = 0; i < config_.symbols; ++i) {
+            symbols.push_back("SYM" + std::to_string(i));
+        }
+        for (uint64_t i = 0; i < config_.orders; ++i) {
+            const std::string& symbol = symbols[i % config_.symbols];
+            uint64_t level = (i / config_.symbols / 2) % config_.levels_per_side;
+            Side side = (i / config_.symbols) % 2 == 0 ? Side::BUY : Side::SELL;
+            double price = side == Side::BUY ? 99.99 - 0.01 * level : 100.01 + 0.01 * level;
+            submit(symbol, side, price);
+        }
+    }
+
+    CloseConfig config_;
+};
+
+// Quote update throughput of one market maker re-quoting every symbol each
+// round: one mass_quote per round against the same updates sent as a cancel
+// and a new order per side. Some updates only cut size at the same price
+// (kept in place with priority), the rest move the price.
+class MassQuoteBenchmark {
+public:
+    struct QuoteConfig {
+        uint32_t symbols{500};
+        uint32_t rounds{400};
+        uint32_t resting_per_side{100};  // other participants' orders behind the quotes
+        double shrink_ratio{0.5};        // share of side updates that only cut size
+        uint32_t seed{42};
+        BookType book_type{BookType::INTRUSIVE};
+    };
+
+    struct QuoteResult {
+        uint64_t side_updates;
+        uint64_t resized;
+        uint64_t reentered;
+        uint64_t entered;
+        double mass_quote_ms;
+        double mass_quote_ns_per_side;
+        double p50_batch_us;
+        double p99_batch_us;
+        double baseline_ms;
+        double baseline_ns_per_side;
+    };
+
+    explicit MassQuoteBenchmark(const QuoteConfig& config) : config_(config) {}
+
+    QuoteResult run() {
+        QuoteResult result{};
+        std::cout << "\n=== Mass Quote Throughput ===" << std::endl;
+        std::cout << config_.symbols << " symbols x " << config_.rounds << " rounds, shrink ratio "
+                  << config_.shrink_ratio << ", book " << to_string(config_.book_type) << std::endl;
+
+        auto rounds = generate_rounds();
+        result.side_updates = uint64_t{2} * config_.symbols * config_.rounds;
+
+        MatchingEngine engine(config_.book_type);
+        load(engine);
+        std::vector<double> batch_us;
+        batch_us.reserve(rounds.size());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds.size(); ++r) {
+            auto batch_start = std::chrono::steady_clock::now();
+            auto ack = engine.mass_quote(kMarketMaker, r + 1, rounds[r]);
+            auto batch_end = std::chrono::steady_clock::now();
+            batch_us.push_back(std::chrono::duration<double, std::micro>(batch_end - batch_start).count());
+            // The first round enters the quotes; later ones are what is measured
+            if (r > 0) {
+                result.resized += ack.sides_resized;
+                result.reentered += ack.sides_reentered;
+                result.entered += ack.sides_entered;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.mass_quote_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.mass_quote_ns_per_side = result.mass_quote_ms * 1e6 / result.side_updates;
+        std::sort(batch_us.begin(), batch_us.end());
+        result.p50_batch_us = batch_us[batch_us.size() / 2];
+        result.p99_batch_us = batch_us[std::min(batch_us.size() - 1, batch_us.size() * 99 / 100)];
+
+        // Baseline: each side update as a cancel followed by a new order
+        MatchingEngine baseline(config_.book_type);
+        load(baseline);
+        std::vector<std::pair<uint64_t, uint64_t>> live(config_.symbols, {0, 0});
+        start = std::chrono::steady_clock::now();
+        for (const auto& round : rounds) {
+            for (size_t s = 0; s < round.size(); ++s) {
+                const auto& quote = round[s];
+                if (live[s].first) {
+                    baseline.cancel_order(live[s].first);
+                }
+                live[s].first = baseline.submit_order(kMarketMaker, quote.symbol, Side::BUY,
+                                                      quote.bid_price, quote.bid_quantity);
+                if (live[s].second) {
+                    baseline.cancel_order(live[s].second);
+                }
+                live[s].second = baseline.submit_order(kMarketMaker, quote.symbol, Side::SELL,
+                                                       quote.ask_price, quote.ask_quantity);
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        result.baseline_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.baseline_ns_per_side = result.baseline_ms * 1e6 / result.side_updates;
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "  mass_quote:      " << result.mass_quote_ms << " ms (" << result.mass_quote_ns_per_side
+                  << " ns/side), batch p50 " << result.p50_batch_us << " us, p99 " << result.p99_batch_us
+                  << " us" << std::endl;
+        std::cout << "    resized " << result.resized << ", re-entered " << result.reentered
+                  << ", new " << result.entered << std::endl;
+        std::cout << "  cancel + submit: " << result.baseline_ms << " ms (" << result.baseline_ns_per_side
+                  << " ns/side)" << std::endl;
+        return result;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "side_updates,resized,reentered,entered,mass_quote_ms,mass_quote_ns_per_side,p50_batch_us,"
+            << "p99_batch_us,baseline_ms,baseline_ns_per_side" << std::endl;
+    }
+
+    static void print_csv_row(const QuoteResult& result, std::ostream& out) {
+        out << result.side_updates << "," << result.resized << "," << result.reentered << ","
+            << result.entered << "," << std::fixed << std::setprecision(3) << result.mass_quote_ms << ","
+            << std::setprecision(1) << result.mass_quote_ns_per_side << ","
+            << std::setprecision(2) << result.p50_batch_us << "," << result.p99_batch_us << ","
+            << std::setprecision(3) << result.baseline_ms << ","
+            << std::setprecision(1) << result.baseline_ns_per_side << std::endl;
+    }
+
+private:
+    static constexpr uint64_t kMarketMaker = 1;
+
+    std::string symbol_name(uint32_t index) const { return "SYM" + std::to_string(index); }
+
+    // Quotes stay inside 99.50-100.50 and never cross each other or the
+    // resting orders outside that band, so the comparison has no trades
+    std::vector<std::vector<MatchingEngine::QuoteEntry>> generate_rounds() const {
+        std::mt19937 rng(config_.seed);
+        std::uniform_int_distribution<int> tick_dist(0, 40);
+        std::uniform_int_distribution<uint64_t> size_dist(50, 100);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        std::vector<std::vector<MatchingEngine::QuoteEntry>> rounds(config_.rounds);
+        for (uint32_t r = 0; r < config_.rounds; ++r) {
+            rounds[r].reserve(config_.symbols);
+            for (uint32_t s = 0; s < config_.symbols; ++s) {
+                MatchingEngine::QuoteEntry quote;
+                quote.symbol = symbol_name(s);
+                if (r == 0) {
+                    quote.bid_price = 99.90 - 0.01 * tick_dist(rng);
+                    quote.ask_price = 100.10 + 0.01 * tick_dist(rng);
+                    quote.bid_quantity = size_dist(rng);
+                    quote.ask_quantity = size_dist(rng);
+                } else {
+                    const auto& last = rounds[r - 1][s];
+                    next_side(last.bid_price, last.bid_quantity, 99.90 - 0.01 * tick_dist(rng),
+                              quote.bid_price, quote.bid_quantity, rng, unit, size_dist);
+                    next_side(last.ask_price, last.ask_quantity, 100.10 + 0.01 * tick_dist(rng),
+                              quote.ask_price, quote.ask_quantity, rng, unit, size_dist);
+                }
+                rounds[r].push_back(quote);
+            }
+        }
+        return rounds;
+    }
+
+    // Cut the size at the same price (down to 1 lot, then start over at a new
+    // price) or move to the candidate price with a fresh size
+    void next_side(double last_price, uint64_t last_quantity, double candidate, double& price,
+                   uint64_t& quantity, std::mt19937& rng, std::uniform_real_distribution<double>& unit,
+                   std::uniform_int_distribution<uint64_t>& size_dist) const {
+        if (unit(rng) < config_.shrink_ratio && last_quantity > 1) {
+            price = last_price;
+            quantity = last_quantity - 1;
+        } else {
+            price = candidate != last_price ? candidate : candidate + (candidate < 100.0 ? -0.01 : 0.01);
+            quantity = size_dist(rng);
+        }
+    }
+
+    void load(MatchingEngine& engine) {
+        for (uint32_t s = 0; s < config_.symbols; ++s) {
+            std::string symbol = symbol_name(s);
+            for (uint32_t i = 0; i < config_.resting_per_side; ++i) {
+                engine.submit_order(2, symbol, Side::BUY, 99.49 - 0.01 * (i % 50), 10);
+                engine.submit_order(2, symbol, Side::SELL, 100.51 + 0.01 * (i % 50), 10);
+            }
+        }
+    }
+
+    QuoteConfig config_;
+};
+
+// Uncross time of a call auction holding N accumulated orders in one symbol.
+// Orders are spread normally around 100.00 on a 0.01 grid, so the book is
+// deeply crossed. The dense run uses a 0.01 book tick, which lets the
+// equilibrium search index levels by tick. The sparse run uses a 0.0001 tick
+// for the same orders, so the crossed range is mostly empty ticks and the
+// levels are merged instead.
+class AuctionUncrossBenchmark {
+public:
+    struct AuctionConfig {
+        uint64_t orders{1000000};
+        double price_stddev{1.0};
+        uint32_t seed{42};
+        BookType book_type{BookType::INTRUSIVE};
+    };
+
+    struct AuctionResult {
+        std::string grid;
+        uint64_t orders;
+        double load_ms;
+        double equilibrium_us;
+        double uncross_ms;
+        double price;
+        uint64_t volume;
+        uint64_t imbalance;
+        uint64_t trades;
+    };
+
+    explicit AuctionUncrossBenchmark(const AuctionConfig& config) : config_(config) {}
+
+    std::vector<AuctionResult> run() {
+        std::cout << "\n=== Call Auction Uncross ===" << std::endl;
+        std::cout << config_.orders << " orders, price stddev " << config_.price_stddev << ", book "
+                  << to_string(config_.book_type) << std::endl;
+        return {run_one("dense", 0.01), run_one("sparse", 0.0001)};
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "grid,orders,load_ms,equilibrium_us,uncross_ms,price,volume,imbalance,trades" << std::endl;
+    }
+
+    static void print_csv_row(const AuctionResult& result, std::ostream& out) {
+        out << result.grid << "," << result.orders << "," << std::fixed << std::setprecision(3)
+            << result.load_ms << "," << std::setprecision(1) << result.equilibrium_us << ","
+            << std::setprecision(3) << result.uncross_ms << "," << std::setprecision(2) << result.price << ","
+            << result.volume << "," << result.imbalance << "," << result.trades << std::endl;
+    }
+
+private:
+    AuctionResult run_one(const std::string& grid, double tick_size) {
+        AuctionResult result{};
+        result.grid = grid;
+        result.orders = config_.orders;
+
+        const std::string symbol = "AUCT";
+        MatchingEngine engine(config_.book_type);
+        BookConfig book_config;
+        book_config.tick_size = tick_size;
+        engine.set_book_type(symbol, config_.book_type, book_config);
+        engine.start_auction(symbol);
+
+        std::mt19937 rng(config_.seed);
+        std::normal_distribution<double> price_dist(100.0, config_.price_stddev);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+        std::uniform_int_distribution<int> side_dist(0, 1);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < config_.orders; ++i) {
+            double price = std::max(0.01, std::round(price_dist(rng) * 100.0) / 100.0);
+            Side side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+            engine.submit_order(1 + i % 1000, symbol, side, price, quantity_dist(rng));
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.load_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        start = std::chrono::steady_clock::now();
+        auto indicative = engine.get_indicative_auction(symbol);
+        end = std::chrono::steady_clock::now();
+        result.equilibrium_us = std::chrono::duration<double, std::micro>(end - start).count();
+
+        uint64_t trades_before = engine.get_stats().total_trades;
+        start = std::chrono::steady_clock::now();
+        auto uncrossed = engine.uncross(symbol);
+        end = std::chrono::steady_clock::now();
+        result.uncross_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.trades = engine.get_stats().total_trades - trades_before;
+        result.price = uncrossed.price;
+        result.volume = uncrossed.volume;
+        result.imbalance = uncrossed.imbalance;
+        if (indicative.price != uncrossed.price || indicative.volume != uncrossed.volume) {
+            std::cerr << "Indicative and executed auctions differ" << std::endl;
+        }
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "  " << std::left << std::setw(7) << grid << std::right << "equilibrium "
+                  << result.equilibrium_us << " us, uncross " << std::setprecision(2) << result.uncross_ms
+                  << " ms (" << result.trades << " trades, " << result.volume << " @ " << result.price
+                  << ", imbalance " << result.imbalance << ")" << std::endl;
+        return result;
+    }
+
+    AuctionConfig config_;
+};
+
+// Position tracker throughput: fills applied per second by the tracker, once
+// drained in a single batch and once with its thread keeping up with a
+// producer that enqueues as fast as it can (the matching thread's side of the
+// cost is the enqueue time).
+class PositionTrackerBenchmark {
+public:
+    struct PositionConfig {
+        uint64_t trades{2000000};
+        uint64_t clients{1000};
+        uint64_t symbols{100};
+        uint32_t seed{42};
+    };
+
+    struct PositionResult {
+        std::string mode;
+        uint64_t trades;
+        uint64_t fills;
+        double seconds;
+        double fills_per_second;
+        double enqueue_ns;
+    };
+
+    explicit PositionTrackerBenchmark(const PositionConfig& config) : config_(config) {}
+
+    std::vector<PositionResult> run() {
+        std::cout << "\n=== Position Tracker ===" << std::endl;
+        std::cout << config_.trades << " trades, " << config_.clients << " clients, " << config_.symbols
+                  << " symbols" << std::endl;
+        std::vector<Trade> trades = make_trades();
+        return {run_batch(trades), run_threaded(trades)};
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "mode,trades,fills,seconds,fills_per_second,enqueue_ns" << std::endl;
+    }
+
+    static void print_csv_row(const PositionResult& result, std::ostream& out) {
+        out << result.mode << "," << result.trades << "," << result.fills << "," << std::fixed
+            << std::setprecision(4) << result.seconds << "," << std::setprecision(0) << result.fills_per_second
+            << "," << std::setprecision(1) << result.enqueue_ns << std::endl;
+    }
+
+private:
+    std::vector<Trade> make_trades() const {
+        std::mt19937 rng(config_.seed);
+        std::uniform_int_distribution<uint64_t> client_dist(1, config_.clients);
+        std::uniform_int_distribution<uint64_t> symbol_dist(0, config_.symbols - 1);
+        std::uniform_int_distribution<int> tick_dist(-500, 500);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+        std::uniform_int_distribution<int> side_dist(0, 1);
+        std::vector<std::string> symbols;
+        for (uint64_t i = 0; i < config_.symbols; ++i) {
+            symbols.push_back("SYM" + std::to_string(i));
+        }
+
+        std::vector<Trade> trades;
+        trades.reserve(config_.trades);
+        for (uint64_t i = 0; i < config_.trades; ++i) {
+            trades.emplace_back(i + 1, 0, 0, client_dist(rng), client_dist(rng), symbols[symbol_dist(rng)],
+                                100.0 + tick_dist(rng) * 0.01, quantity_dist(rng));
+            trades.back().taker_side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+        }
+        return trades;
+    }
+
+    PositionResult run_batch(const std::vector<Trade>& trades) {
+        PositionTracker tracker;
+        // Unmeasured passes size both inbox buffers and register every client and symbol
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const Trade& trade : trades) {
+                tracker.on_trade(trade);
+            }
+            tracker.drain();
+        }
+        uint64_t fills_before = tracker.fills_processed();
+        auto start = std::chrono::steady_clock::now();
+        for (const Trade& trade : trades) {
+            tracker.on_trade(trade);
+        }
+        auto queued = std::chrono::steady_clock::now();
+        tracker.drain();
+        auto end = std::chrono::steady_clock::now();
+        return report("batch", tracker.fills_processed() - fills_before,
+                      std::chrono::duration<double>(end - queued).count(),
+                      std::chrono::duration<double, std::nano>(queued - start).count());
+    }
+
+    PositionResult run_threaded(const std::vector<Trade>& trades) {
+        PositionTracker tracker;
+        tracker.start();
+        auto start = std::chrono::steady_clock::now();
+        for (const Trade& trade : trades) {
+            tracker.on_trade(trade);
+        }
+        auto queued = std::chrono::steady_clock::now();
+        tracker.flush();
+        auto end = std::chrono::steady_clock::now();
+        tracker.stop();
+        return report("threaded", tracker.fills_processed(), std::chrono::duration<double>(end - start).count(),
+                      std::chrono::duration<double, std::nano>(queued - start).count());
+    }
+
+    PositionResult report(const std::string& mode, uint64_t fills, double seconds, double enqueue_total_ns) const {
+        PositionResult result{};
+        result.mode = mode;
+        result.trades = config_.trades;
+        result.fills = fills;
+        result.seconds = seconds;
+        result.fills_per_second = seconds > 0.0 ? static_cast<double>(result.fills) / seconds : 0.0;
+        result.enqueue_ns = enqueue_total_ns / static_cast<double>(std::max<uint64_t>(1, config_.trades));
+
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  " << std::left << std::setw(9) << mode << std::right << result.fills_per_second / 1e6
+                  << " M fills/sec (" << result.fills << " fills in " << std::setprecision(3) << seconds
+                  << " s), enqueue " << std::setprecision(1) << result.enqueue_ns << " ns/trade" << std::endl;
+        return result;
+    }
+
+    PositionConfig config_;
+};
+
+class ShardRebalanceBenchmark {
+public:
+    struct RebalanceConfig {
+        uint64_t orders{2000000};
+        uint32_t shards{4};
+        uint32_t symbols{64};
+        double hot_share{0.5};  // flow to the one hot symbol; the rest is uniform
+        uint32_t interval_ms{20};
+        uint32_t seed{42};
+    };
+
+    struct RebalanceResult {
+        std::string mode;
+        uint64_t orders;
+        double seconds;
+        double orders_per_second;
+        uint64_t moves;
+        double busiest_share;  // of all commands, applied by the busiest shard
+    };
+
+    explicit ShardRebalanceBenchmark(const RebalanceConfig& config) : config_(config) {}
+
+    std::vector<RebalanceResult> run() {
+        std::cout << "\n=== Shard Rebalancing (skewed flow) ===" << std::endl;
+        std::cout << config_.orders << " orders, " << config_.shards << " shards, " << config_.symbols
+                  << " symbols, " << config_.hot_share * 100.0 << "% to one symbol" << std::endl;
+        std::vector<uint32_t> flow = make_flow();
+        return {run_mode("static", flow, false), run_mode("rebalanced", flow, true)};
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "mode,orders,seconds,orders_per_second,moves,busiest_share" << std::endl;
+    }
+
+    static void print_csv_row(const RebalanceResult& result, std::ostream& out) {
+        out << result.mode << "," << result.orders << "," << std::fixed << std::setprecision(4) << result.seconds
+            << "," << std::setprecision(0) << result.orders_per_second << "," << result.moves << ","
+            << std::setprecision(3) << result.busiest_share << std::endl;
+    }
+
+private:
+    // Symbol index per order: the hot symbol is 0
+    std::vector<uint32_t> make_flow() const {
+        std::mt19937 rng(config_.seed);
+        std::uniform_real_distribution<double> share_dist(0.0, 1.0);
+        std::uniform_int_distribution<uint32_t> cold_dist(1, std::max<uint32_t>(1, config_.symbols - 1));
+        std::vector<uint32_t> flow(config_.orders);
+        for (uint32_t& symbol : flow) {
+            symbol = share_dist(rng) < config_.hot_share ? 0 : cold_dist(rng);
+        }
+        return flow;
+    }
+
+    RebalanceResult run_mode(const std::string& mode, const std::vector<uint32_t>& flow, bool rebalance) {
+        ShardedEngineConfig engine_config;
+        engine_config.shards = config_.shards;
+        engine_config.rebalance_interval_ms = rebalance ? config_.interval_ms : 0;
+        ShardedEngine sharded(engine_config);
+
+        std::vector<std::string> symbols;
+        for (uint32_t i = 0; i < config_.symbols; ++i) {
+            symbols.push_back("SYM" + std::to_string(i));
+        }
+        std::mt19937 rng(config_.seed);
+        std::uniform_int_distribution<int> tick_dist(-20, 20);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+
+        sharded.start();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < flow.size(); ++i) {
+            Side side = (rng() & 1) == 0 ? Side::BUY : Side::SELL;
+            sharded.submit_order(1 + i % 100, symbols[flow[i]], side, 100.0 + tick_dist(rng) * 0.01,
+                                 quantity_dist(rng));
+        }
+        sharded.flush();
+        auto end = std::chrono::steady_clock::now();
+        sharded.stop();
+
+        RebalanceResult result{};
+        result.mode = mode;
+        result.orders = flow.size();
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        result.orders_per_second = result.seconds > 0.0 ? static_cast<double>(result.orders) / result.seconds : 0.0;
+        result.moves = sharded.get_moves();
+        uint64_t total = 0;
+        uint64_t busiest = 0;
+        for (const ShardedEngine::ShardLoad& load : sharded.get_loads()) {
+            total += load.commands;
+            busiest = std::max(busiest, load.commands);
+        }
+        result.busiest_share = total != 0 ? static_cast<double>(busiest) / static_cast<double>(total) : 0.0;
+
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  " << std::left << std::setw(11) << mode << std::right << result.orders_per_second / 1e6
+                  << " M orders/sec (" << std::setprecision(3) << result.seconds << " s), " << result.moves
+                  << " moves, busiest shard applied " << std::setprecision(1) << result.busiest_share * 100.0
+                  << "% of commands" << std::endl;
+        return result;
+    }
+
+    RebalanceConfig config_;
+};
+
+// Open-loop overload: orders arrive faster than the engine matches them,
+// once with no admission limits and once with a queue depth limit. The
+// generator sends on a fixed schedule (as in LatencyKneeFinder) and latency
+// runs from each order's scheduled send time. Unprotected, the backlog and
+// with it every order's latency grow for the whole run; with the limit the
+// engine sheds what it cannot take and the orders it accepts stay fast.
+class OverloadBenchmark {
+public:
+    struct OverloadConfig {
+        double load_factor{1.5};      // offered rate over the measured capacity
+        double seconds{2.0};
+        uint64_t max_queue_depth{2000};
+        uint32_t symbols{10};
+        uint64_t seed_depth{10000};
+        uint64_t calibration_orders{200000};
+        uint32_t seed{42};
+    };
+
+    struct OverloadResult {
+        std::string mode;
+        double offered_rate;
+        uint64_t offered;
+        uint64_t accepted;
+        uint64_t busy_rejects;
+        uint64_t overload_episodes;
+        double p50_latency_us;
+        double p99_latency_us;
+        double p999_latency_us;
+        double max_latency_us;
+        size_t max_queue_depth;
+    };
+
+    explicit OverloadBenchmark(const OverloadConfig& config) : config_(config) {}
+
+    std::vector<OverloadResult> run() {
+        std::cout << "\n=== Admission Control (open-loop overload) ===" << std::endl;
+        double capacity = measure_capacity();
+        double rate = capacity * config_.load_factor;
+        std::cout << std::fixed << std::setprecision(0) << "Capacity " << capacity << " orders/sec, offering "
+                  << rate << " orders/sec for " << std::setprecision(1) << config_.seconds << " s" << std::endl;
+        return {run_mode("unprotected", rate, false), run_mode("admission", rate, true)};
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "mode,offered_rate,offered,accepted,busy_rejects,overload_episodes,p50_latency_us,p99_latency_us,"
+            << "p999_latency_us,max_latency_us,max_queue_depth" << std::endl;
+    }
+
+    static void print_csv_row(const OverloadResult& result, std::ostream& out) {
+        out << result.mode << "," << std::fixed << std::setprecision(0) << result.offered_rate << ","
+            << result.offered << "," << result.accepted << "," << result.busy_rejects << ","
+            << result.overload_episodes << "," << std::setprecision(2) << result.p50_latency_us << ","
+            << result.p99_latency_us << "," << result.p999_latency_us << "," << result.max_latency_us << ","
+            << result.max_queue_depth << std::endl;
+    }
+
+private:
+    struct Command {
+        int64_t scheduled_ns;
+        uint32_t symbol_index;
+        Side side;
+        double price;
+        uint64_t quantity;
+    };
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct Workload {
+        std::vector<std::string> symbols;
+        std::mt19937 rng;
+        std::uniform_int_distribution<uint32_t> symbol_dist;
+        std::uniform_int_distribution<int> offset_dist{-100, 100};
+        std::uniform_int_distribution<uint64_t> quantity_dist{1, 100};
+
+        Workload(uint32_t symbol_count, uint32_t seed) : rng(seed), symbol_dist(0, symbol_count - 1) {
+            for (uint32_t i = 0; i < symbol_count; ++i) {
+                symbols.push_back("OVER" + std::to_string(i));
+            }
+        }
+
+        Command next() {
+            Command command{};
+            command.symbol_index = symbol_dist(rng);
+            command.side = (rng() & 1) == 0 ? Side::BUY : Side::SELL;
+            command.price = 100.0 + offset_dist(rng) * 0.01;
+            command.quantity = quantity_dist(rng);
+            return command;
+        }
+    };
+
+    // Resting depth so matching does real work from the first order
+    void seed_book(MatchingEngine& engine, Workload& workload) const {
+        for (uint64_t i = 0; i < config_.seed_depth; ++i) {
+            Command command = workload.next();
+            double price = command.side == Side::BUY ? 99.0 - (i % 100) * 0.01 : 101.0 + (i % 100) * 0.01;
+            engine.submit_order(0, workload.symbols[command.symbol_index], command.side, price, command.quantity);
+        }
+    }
+
+    // Rate of the same workload through the same queue and engine thread,
+    // with the generator sending as fast as it can
+    double measure_capacity() const {
+        MatchingEngine engine;
+        Workload workload(config_.symbols, config_.seed);
+        seed_book(engine, workload);
+        StageQueue<Command> queue;
+        auto start = std::chrono::steady_clock::now();
+        std::thread engine_thread([&]() {
+            Command command{};
+            while (queue.pop(command, std::chrono::microseconds(1000)) || !queue.closed() || queue.size() != 0) {
+                if (command.quantity != 0) {
+                    engine.submit_order(1, workload.symbols[command.symbol_index], command.side, command.price,
+                                        command.quantity);
+                    command.quantity = 0;
+                }
+            }
+        });
+        Workload generator(config_.symbols, config_.seed + 1);
+        for (uint64_t i = 0; i < config_.calibration_orders; ++i) {
+            queue.push(generator.next());
+        }
+        queue.close();
+        engine_thread.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds > 0.0 ? config_.calibration_orders / seconds : 0.0;
+    }
+
+    OverloadResult run_mode(const std::string& mode, double rate, bool admission) {
+        MatchingEngine engine;
+        Workload workload(config_.symbols, config_.seed);
+        seed_book(engine, workload);
+        if (admission) {
+            AdmissionLimits limits;
+            limits.max_queue_depth = config_.max_queue_depth;
+            engine.set_admission_limits(limits);
+        }
+
+        uint64_t total = static_cast<uint64_t>(rate * config_.seconds);
+        std::vector<double> latencies;
+        latencies.reserve(total);
+        uint64_t rejected = 0;
+        size_t max_depth = 0;
+
+        // Engine stage: report the backlog, then enter the order
+        StageQueue<Command> queue;
+        std::thread engine_thread([&]() {
+            Command command;
+            while (true) {
+                if (!queue.pop(command, std::chrono::microseconds(1000))) {
+                    if (queue.closed() && queue.size() == 0) {
+                        break;
+                    }
+                    continue;
+                }
+                size_t depth = queue.size();
+                max_depth = std::max(max_depth, depth);
+                engine.report_queue_depth(depth);
+                uint64_t order_id = engine.submit_order(1, workload.symbols[command.symbol_index], command.side,
+                                                        command.price, command.quantity);
+                if (order_id != 0) {
+                    latencies.push_back((now_ns() - command.scheduled_ns) / 1000.0);
+                } else {
+                    rejected++;
+                }
+            }
+        });
+
+        // Open-loop generator; its own stream so both modes send the same orders
+        Workload generator(config_.symbols, config_.seed + 1);
+        int64_t start_ns = now_ns();
+        int64_t interval_ns = static_cast<int64_t>(1e9 / rate);
+        for (uint64_t i = 0; i < total; ++i) {
+            Command command = generator.next();
+            command.scheduled_ns = start_ns + static_cast<int64_t>(i) * interval_ns;
+            int64_t wait_ns = command.scheduled_ns - now_ns();
+            if (wait_ns > 200000) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns - 100000));
+            }
+            while (now_ns() < command.scheduled_ns) {
+                std::this_thread::yield();
+            }
+            queue.push(command);
+        }
+        queue.close();
+        engine_thread.join();
+
+        MatchingEngine::EngineStats stats = engine.get_stats();
+        OverloadResult result{};
+        result.mode = mode;
+        result.offered_rate = rate;
+        result.offered = total;
+        result.accepted = latencies.size();
+        result.busy_rejects = stats.busy_rejects;
+        result.overload_episodes = stats.overload_episodes;
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_latency_us = percentile(latencies, 50.0);
+        result.p99_latency_us = percentile(latencies, 99.0);
+        result.p999_latency_us = percentile(latencies, 99.9);
+        result.max_latency_us = latencies.empty() ? 0.0 : latencies.back();
+        result.max_queue_depth = max_depth;
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "  " << std::left << std::setw(12) << mode << std::right << result.accepted << " accepted, "
+                  << rejected << " rejected (" << result.busy_rejects << " busy, " << result.overload_episodes
+                  << " episodes), P50 " << result.p50_latency_us << " us, P99 " << result.p99_latency_us
+                  << " us, P99.9 " << result.p999_latency_us << " us, max queue " << result.max_queue_depth
+                  << std::endl;
+        return result;
+    }
+
+    OverloadConfig config_;
+};
+
+// First order after a quiet spell. Each round the benchmark evicts the
+// caches (as other work on the host would while the engine idles), sleeps
+// for the idle period and times the next order. With warming, the idle
+// period is spent the way a sleeping shard spends it (ShardedEngineConfig::
+// warm_interval_us): asleep, waking each interval for a MatchingEngine::warm
+// pass. Steady-state latency of back-to-back orders is the reference.
+class IdleWarmingBenchmark {
+public:
+    struct WarmingConfig {
+        uint32_t rounds{200};
+        uint32_t idle_ms{20};
+        uint32_t warm_interval_us{1000};
+        size_t pollute_mb{32};
+        uint32_t symbols{100};
+        uint64_t depth{200};  // resting orders per symbol
+        uint32_t seed{42};
+    };
+
+    struct WarmingResult {
+        std::string mode;
+        uint32_t rounds;
+        double steady_p50_ns;
+        double first_p50_ns;
+        double first_p99_ns;
+        double first_max_ns;
+        uint64_t warm_passes;
+    };
+
+    explicit IdleWarmingBenchmark(const WarmingConfig& config)
+        : config_(config), pollution_(config.pollute_mb * 1024 * 1024, 1) {}
+
+    std::vector<WarmingResult> run() {
+        std::cout << "\n=== Idle Cache Warming (first order after idle) ===" << std::endl;
+        std::cout << config_.rounds << " rounds of " << config_.idle_ms << " ms idle, " << config_.pollute_mb
+                  << " MB evicted per round, " << config_.symbols << " symbols x " << config_.depth
+                  << " resting orders" << std::endl;
+        return {run_mode("cold", false), run_mode("warmed", true)};
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "mode,rounds,steady_p50_ns,first_p50_ns,first_p99_ns,first_max_ns,warm_passes" << std::endl;
+    }
+
+    static void print_csv_row(const WarmingResult& result, std::ostream& out) {
+        out << result.mode << "," << result.rounds << "," << std::fixed << std::setprecision(0)
+            << result.steady_p50_ns << "," << result.first_p50_ns << "," << result.first_p99_ns << ","
+            << result.first_max_ns << "," << result.warm_passes << std::endl;
+    }
+
+private:
+    void pollute() {
+        for (size_t i = 0; i < pollution_.size(); i += 64) {
+            pollution_[i]++;
+        }
+    }
+
+    WarmingResult run_mode(const std::string& mode, bool warming) {
+        MatchingEngine engine;
+        std::vector<std::string> symbols;
+        for (uint32_t i = 0; i < config_.symbols; ++i) {
+            symbols.push_back("IDLE" + std::to_string(i));
+        }
+        std::mt19937 rng(config_.seed);
+        std::uniform_int_distribution<uint32_t> symbol_dist(0, config_.symbols - 1);
+        std::uniform_int_distribution<int> level_dist(1, 50);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+        for (uint32_t symbol = 0; symbol < config_.symbols; ++symbol) {
+            for (uint64_t i = 0; i < config_.depth; ++i) {
+                bool buy = i % 2 == 0;
+                double price = buy ? 100.0 - level_dist(rng) * 0.01 : 100.0 + level_dist(rng) * 0.01;
+                engine.submit_order(0, symbols[symbol], buy ? Side::BUY : Side::SELL, price, quantity_dist(rng));
+            }
+        }
+
+        // Small crossing orders: they take from the top and rest the remainder
+        auto timed_order = [&]() {
+            Side side = (rng() & 1) == 0 ? Side::BUY : Side::SELL;
+            double price = side == Side::BUY ? 100.0 + level_dist(rng) * 0.01 : 100.0 - level_dist(rng) * 0.01;
+            const std::string& symbol = symbols[symbol_dist(rng)];
+            uint64_t quantity = quantity_dist(rng);
+            auto start = std::chrono::steady_clock::now();
+            engine.submit_order(1, symbol, side, price, quantity);
+            return static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        };
+
+        std::vector<double> steady;
+        for (int i = 0; i < 10000; ++i) {
+            steady.push_back(timed_order());
+        }
+
+        std::vector<double> first;
+        for (uint32_t round = 0; round < config_.rounds; ++round) {
+            pollute();
+            auto idle_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.idle_ms);
+            if (warming) {
+                while (std::chrono::steady_clock::now() < idle_end) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(config_.warm_interval_us));
+                    engine.warm();
+                }
+            } else {
+                std::this_thread::sleep_until(idle_end);
+            }
+            first.push_back(timed_order());
+        }
+
+        std::sort(steady.begin(), steady.end());
+        std::sort(first.begin(), first.end());
+        WarmingResult result{};
+        result.mode = mode;
+        result.rounds = config_.rounds;
+        result.steady_p50_ns = percentile(steady, 50.0);
+        result.first_p50_ns = percentile(first, 50.0);
+        result.first_p99_ns = percentile(first, 99.0);
+        result.first_max_ns = first.empty() ? 0.0 : first.back();
+        result.warm_passes = engine.get_warm_passes();
+
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "  " << std::left << std::setw(7) << mode << std::right << "steady P50 " << result.steady_p50_ns
+                  << " ns, first after idle P50 " << result.first_p50_ns << " ns, P99 " << result.first_p99_ns
+                  << " ns (" << std::setprecision(1) << result.first_p50_ns / std::max(1.0, result.steady_p50_ns)
+                  << "x steady), " << result.warm_passes << " warm passes" << std::endl;
+        return result;
+    }
+
+    WarmingConfig config_;
+    std::vector<uint8_t> pollution_;
+};
+
+// Reader scaling of epoch-protected reads. A writer keeps replacing a shared
+// record (as a book republishes its state); readers look at the current one.
+// With epochs a reader pins, loads the pointer and reads, and the writer
+// retires the old record. The baseline readers take a shared_mutex and the
+// writer the exclusive lock. Reads per second are summed over readers.
+class EpochReaderBenchmark {
+public:
+    struct ReaderConfig {
+        std::vector<uint32_t> reader_counts{1, 2, 4, 8};
+        double seconds{1.0};
+        uint32_t write_interval_us{10};
+    };
+
+    struct ReaderResult {
+        std::string mode;
+        uint32_t readers;
+        double reads_per_second;
+        double writes_per_second;
+        uint64_t max_pending;  // retired records not yet freed (epoch mode)
+    };
+
+    explicit EpochReaderBenchmark(const ReaderConfig& config) : config_(config) {}
+
+    std::vector<ReaderResult> run() {
+        std::cout << "\n=== Epoch Reclamation (reader scaling) ===" << std::endl;
+        std::cout << "Writer replaces the record every " << config_.write_interval_us << " us, "
+                  << config_.seconds << " s per run, " << std::thread::hardware_concurrency() << " CPUs" << std::endl;
+        std::vector<ReaderResult> results;
+        for (uint32_t readers : config_.reader_counts) {
+            results.push_back(run_mode("epoch", readers));
+            results.push_back(run_mode("shared_mutex", readers));
+        }
+        return results;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "mode,readers,reads_per_second,writes_per_second,max_pending" << std::endl;
+    }
+
+    static void print_csv_row(const ReaderResult& result, std::ostream& out) {
+        out << result.mode << "," << result.readers << "," << std::fixed << std::setprecision(0)
+            << result.reads_per_second << "," << result.writes_per_second << "," << result.max_pending << std::endl;
+    }
+
+private:
+    struct Record {
+        uint64_t version{0};
+        uint64_t values[7]{};
+    };
+
+    ReaderResult run_mode(const std::string& mode, uint32_t reader_count) {
+        bool epochs = mode == "epoch";
+        EpochDomain domain;
+        std::shared_mutex mutex;
+        std::atomic<Record*> current{new Record()};
+        std::atomic<bool> stop{false};
+        std::vector<uint64_t> reads(reader_count, 0);
+        uint64_t writes = 0;
+        uint64_t max_pending = 0;
+        volatile uint64_t sink = 0;
+
+        std::vector<std::thread> readers;
+        for (uint32_t r = 0; r < reader_count; ++r) {
+            readers.emplace_back([&, r] {
+                uint64_t count = 0;
+                uint64_t sum = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    if (epochs) {
+                        EpochGuard guard(domain);
+                        const Record* record = current.load(std::memory_order_acquire);
+                        sum += record->version + record->values[r % 7];
+                    } else {
+                        std::shared_lock<std::shared_mutex> lock(mutex);
+                        const Record* record = current.load(std::memory_order_relaxed);
+                        sum += record->version + record->values[r % 7];
+                    }
+                    count++;
+                }
+                reads[r] = count;
+                sink = sum;
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(config_.seconds));
+        while (std::chrono::steady_clock::now() < end) {
+            Record* next = new Record();
+            next->version = ++writes;
+            if (epochs) {
+                domain.retire(current.exchange(next, std::memory_order_acq_rel));
+                max_pending = std::max(max_pending, domain.pending());
+            } else {
+                Record* old;
+                {
+                    std::unique_lock<std::shared_mutex> lock(mutex);
+                    old = current.exchange(next, std::memory_order_relaxed);
+                }
+                delete old;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(config_.write_interval_us));
+        }
+        stop = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        domain.synchronize();
+        delete current.load();
+
+        ReaderResult result{};
+        result.mode = mode;
+        result.readers = reader_count;
+        uint64_t total_reads = 0;
+        for (uint64_t count : reads) {
+            total_reads += count;
+        }
+        result.reads_per_second = total_reads / seconds;
+        result.writes_per_second = writes / seconds;
+        result.max_pending = max_pending;
+
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  " << std::left << std::setw(13) << mode << std::right << std::setw(2) << reader_count
+                  << " readers: " << result.reads_per_second / 1e6 << " M reads/sec, " << std::setprecision(0)
+                  << result.writes_per_second << " writes/sec";
+        if (epochs) {
+            std::cout << ", max " << max_pending << " pending";
+        }
+        std::cout << std::endl;
+        return result;
+    }
+
+    ReaderConfig config_;
+};
+
+// Market data readers against matching on one symbol: readers poll the top
+// levels and volume as fast as they can while the matching thread enters a
+// random flow of resting, crossing and cancelled orders. Locked mode queries
+// the book under its lock; view mode turns on the book's read replica.
+class BookViewBenchmark {
+public:
+    struct ViewConfig {
+        std::vector<uint32_t> reader_counts{0, 1, 2, 4};
+        double seconds{1.0};
+        size_t depth{10};
+        uint32_t seed{42};
+    };
+
+    struct ViewResult {
+        std::string mode;
+        uint32_t readers;
+        double orders_per_second;
+        double p50_latency_ns;
+        double p99_latency_ns;
+        double p999_latency_ns;
+        double queries_per_second;
+    };
+
+    explicit BookViewBenchmark(const ViewConfig& config) : config_(config) {}
+
+    std::vector<ViewResult> run() {
+        std::cout << "\n=== Book Read Replicas (matching latency under query load) ===" << std::endl;
+        std::cout << "Readers query " << config_.depth << " levels per side and the bid volume, "
+                  << config_.seconds << " s per run, " << std::thread::hardware_concurrency() << " CPUs" << std::endl;
+        std::vector<ViewResult> results;
+        for (uint32_t readers : config_.reader_counts) {
+            results.push_back(run_mode("locked", readers));
+            results.push_back(run_mode("view", readers));
+        }
+        return results;
+    }
+
+    static void print_csv_header(std::ostream& out) {
+        out << "mode,readers,orders_per_second,p50_latency_ns,p99_latency_ns,p999_latency_ns,queries_per_second"
+            << std::endl;
+    }
+
+    static void print_csv_row(const ViewResult& result, std::ostream& out) {
+        out << result.mode << "," << result.readers << "," << std::fixed << std::setprecision(0)
+            << result.orders_per_second << "," << result.p50_latency_ns << "," << result.p99_latency_ns << ","
+            << result.p999_latency_ns << "," << result.queries_per_second << std::endl;
+    }
+
+private:
+    static constexpr size_t kMaxResting = 2000;
+
+    ViewResult run_mode(const std::string& mode, uint32_t reader_count) {
+        const std::string symbol = "BTC-USD";
+        MatchingEngine engine;
+        if (mode == "view") {
+            engine.set_book_views(config_.depth);
+        }
+        std::mt19937 rng(config_.seed);
+        std::deque<uint64_t> resting;
+        for (int level = 1; level <= 20; ++level) {
+            for (int i = 0; i < 5; ++i) {
+                resting.push_back(engine.submit_order(1, symbol, Side::BUY, 100.0 - level * 0.01, 10));
+                resting.push_back(engine.submit_order(1, symbol, Side::SELL, 100.0 + level * 0.01, 10));
+            }
+        }
+
+        std::atomic<bool> stop{false};
+        std::vector<uint64_t> queries(reader_count, 0);
+        volatile uint64_t sink = 0;
+        std::vector<std::thread> readers;
+        for (uint32_t r = 0; r < reader_count; ++r) {
+            readers.emplace_back([&, r] {
+                uint64_t count = 0;
+                uint64_t sum = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    sum += engine.get_bid_levels(symbol, config_.depth).size();
+                    sum += engine.get_ask_levels(symbol, config_.depth).size();
+                    sum += engine.get_bid_volume(symbol);
+                    count++;
+                }
+                queries[r] = count;
+                sink = sum;
+            });
+        }
+
+        std::vector<double> latencies;
+        latencies.reserve(1 << 20);
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(config_.seconds));
+        std::uniform_int_distribution<int> offset(-15, 15);
+        std::uniform_int_distribution<uint64_t> quantity(1, 20);
+        while (std::chrono::steady_clock::now() < end) {
+            Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+            double price = 100.0 + offset(rng) * 0.01;
+            uint64_t size = quantity(rng);
+            auto order_start = std::chrono::steady_clock::now();
+            uint64_t order_id = engine.submit_order(2, symbol, side, price, size);
+            if (resting.size() >= kMaxResting) {
+                engine.cancel_order(resting.front());
+                resting.pop_front();
+            }
+            latencies.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - order_start).count()));
+            resting.push_back(order_id);
+        }
+        stop = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        ViewResult result{};
+        result.mode = mode;
+        result.readers = reader_count;
+        result.orders_per_second = latencies.size() / seconds;
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_latency_ns = percentile(latencies, 50.0);
+        result.p99_latency_ns = percentile(latencies, 99.0);
+        result.p999_latency_ns = percentile(latencies, 99.9);
+        uint64_t total_queries = 0;
+        for (uint64_t count : queries) {
+            total_queries += count;
+        }
+        result.queries_per_second = total_queries / seconds;
+
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "  " << std::left << std::setw(7) << mode << std::right << std::setw(2) << reader_count
+                  << " readers: " << result.orders_per_second << " orders/sec, p50 " << result.p50_latency_ns
+                  << " ns, p99 " << result.p99_latency_ns << " ns, p99.9 " << result.p999_latency_ns << " ns, "
+                  << result.queries_per_second << " queries/sec" << std::endl;
+        return result;
+    }
+
+    ViewConfig config_;
+};
+
+// Parse a comma separated list such as "100,1000,10000" or "0,0.5,0.9"
+template<typename T>
+std::vector<T> parse_list(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(static_cast<T>(std::stod(item)));
+        }
+    }
+    return values;
+}
+
+// Write a benchmark's CSV rows, whether its run() returns one result or a list
+template<typename Bench, typename Result>
+void print_csv_rows(const Result& result, std::ostream& out) {
+    Bench::print_csv_row(result, out);
+}
+
+template<typename Bench, typename Result>
+void print_csv_rows(const std::vector<Result>& results, std::ostream& out) {
+    for (const auto& result : results) {
+        Bench::print_csv_row(result, out);
+    }
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --help                    Show this help message" << std::endl;
+    std::cout << "  --quick                   Run quick benchmark suite (default)" << std::endl;
+    std::cout << "  --full                    Run full benchmark suite" << std::endl;
+    std::cout << "  --extreme                 Run extreme stress tests" << std::endl;
+    std::cout << "  --csv                     Output results in CSV format" << std::endl;
+    std::cout << "  --custom N R              Run custom test with N orders at R orders/sec" << std::endl;
+    std::cout << "  --symbol SYM              Use symbol SYM (default: BTC-USD)" << std::endl;
+    std::cout << "  --mid-price P             Use mid price P (default: 50000)" << std::endl;
+    std::cout << "  --spread S                Use spread S (default: 10)" << std::endl;
+    std::cout << "  --seed S                  Workload RNG seed for every mode (default: 42)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Repeated trials and comparison:" << std::endl;
+    std::cout << "  --trials N                Run each test N times and report mean/stddev/95% CI (default: 1)" << std::endl;
+    std::cout << "  --warmup N                Max unmeasured warm-up orders per test, 0 disables (default: 1000)" << std::endl;
+    std::cout << "  --warmup-block N          Orders per warm-up block (default: 100)" << std::endl;
+    std::cout << "  --warmup-tolerance X      Steady when 3 block medians are within X of their mean (default: 0.1)" << std::endl;
+    std::cout << "  --compare BASE NEW        Compare two *_summary_*.csv files (exit 1 on significant regression)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Scalability sweep:" << std::endl;
+    std::cout << "  --sweep                   Sweep depth x symbols x cancel ratio x aggressor ratio" << std::endl;
+    std::cout << "  --sweep-quick             Small sweep grid for smoke testing" << std::endl;
+    std::cout << "  --sweep-risk              Run sweep cells with every pre-trade risk check on" << std::endl;
+    std::cout << "  --sweep-events            Run sweep cells with a subscriber on the engine event stream" << std::endl;
+    std::cout << "  --depths LIST             Resting depths, e.g. 100,10000,1000000" << std::endl;
+    std::cout << "  --symbol-counts LIST      Symbol counts, e.g. 1,100,10000" << std::endl;
+    std::cout << "  --cancel-ratios LIST      Cancel ratios, e.g. 0,0.5,0.99" << std::endl;
+    std::cout << "  --aggressor-ratios LIST   Fraction of new orders that cross, e.g. 0.05,0.5" << std::endl;
+    std::cout << "  --sweep-orders N          Measured commands per cell (default: 100000)" << std::endl;
+    std::cout << "  --book TYPE               Book policy: heap, map, intrusive, ladder (default: intrusive)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Latency knee search (open loop):" << std::endl;
+    std::cout << "  --knee TARGET             engine, pipeline-inproc, pipeline-tcp or all" << std::endl;
+    std::cout << "  --knee-start R            First offered rate in orders/sec (default: 10000)" << std::endl;
+    std::cout << "  --knee-max R              Highest offered rate (default: 2000000)" << std::endl;
+    std::cout << "  --knee-factor F           Rate multiplier per step (default: 1.5)" << std::endl;
+    std::cout << "  --knee-step-seconds S     Duration of each step (default: 2)" << std::endl;
+    std::cout << "  --slo-p99-us X            P99 latency SLO in microseconds (default: 100)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Platform jitter:" << std::endl;
+    std::cout << "  --hiccup                  Run a hiccup monitor thread alongside the benchmark" << std::endl;
+    std::cout << "  --hiccup-cpu N            Run the hiccup monitor pinned to CPU N" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Soak test (steady load, per-interval time series, drift detection):" << std::endl;
+    std::cout << "  --soak                    Run a soak test (exit code 1 if a metric drifts)" << std::endl;
+    std::cout << "  --soak-duration S         Total duration in seconds (default: 3600)" << std::endl;
+    std::cout << "  --soak-interval S         Sample interval in seconds (default: 60)" << std::endl;
+    std::cout << "  --soak-rate R             Commands/sec (default: 20000)" << std::endl;
+    std::cout << "  --soak-symbols N          Symbol count (default: 10)" << std::endl;
+    std::cout << "  --soak-resting N          Maximum open orders (default: 100000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Stop trigger storm:" << std::endl;
+    std::cout << "  --stop-storm N            Cascade through N pending buy stops (default: 100000)" << std::endl;
+    std::cout << "  --stop-storm-levels N     Ask levels the stops are spread across (default: 1000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Peg re-pricing:" << std::endl;
+    std::cout << "  --peg-bench [LIST]        BBO change cost per peg count (default: 0,100,1000,10000,100000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Session close expiry:" << std::endl;
+    std::cout << "  --session-close [N]       Expire N resting DAY orders at close (default: 1000000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Mass quote throughput:" << std::endl;
+    std::cout << "  --mass-quote [N]          Re-quote N symbols per round, vs cancel + submit (default: 500)" << std::endl;
+    std::cout << "  --mass-quote-rounds N     Quote rounds (default: 400)" << std::endl;
+    std::cout << "  --mass-quote-shrink X     Share of side updates that only cut size (default: 0.5)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Call auction uncross:" << std::endl;
+    std::cout << "  --auction [N]             Uncross N accumulated orders, dense and sparse grid (default: 1000000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Position tracking:" << std::endl;
+    std::cout << "  --positions [N]           Apply N trades to the position tracker (default: 2000000)" << std::endl;
+    std::cout << "  --position-clients N      Distinct clients (default: 1000)" << std::endl;
+    std::cout << "  --position-symbols N      Distinct symbols (default: 100)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Shard rebalancing:" << std::endl;
+    std::cout << "  --rebalance [N]           N orders, skewed to one symbol, static vs rebalanced shards (default: 2000000)" << std::endl;
+    std::cout << "  --rebalance-shards N      Shard threads (default: 4)" << std::endl;
+    std::cout << "  --rebalance-hot X         Share of orders for the hot symbol (default: 0.5)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Admission control:" << std::endl;
+    std::cout << "  --overload [X]            Offer X times capacity, without and with a queue limit (default: 1.5)" << std::endl;
+    std::cout << "  --overload-seconds S      Duration of each run (default: 2)" << std::endl;
+    std::cout << "  --overload-depth N        Queue depth limit (default: 2000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Idle cache warming:" << std::endl;
+    std::cout << "  --idle-warming [N]        N rounds of idle then one order, cold vs warmed (default: 200)" << std::endl;
+    std::cout << "  --idle-ms N               Idle period per round in ms (default: 20)" << std::endl;
+    std::cout << "  --warm-interval-us N      Interval between warming passes (default: 1000)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Epoch reclamation:" << std::endl;
+    std::cout << "  --epoch-readers [LIST]    Reader thread counts, epoch vs shared_mutex reads (default: 1,2,4,8)" << std::endl;
+    std::cout << "  --epoch-seconds S         Duration of each run (default: 1)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Book read replicas:" << std::endl;
+    std::cout << "  --book-views [LIST]       Query thread counts, locked vs view queries (default: 0,1,2,4)" << std::endl;
+    std::cout << "  --book-view-seconds S     Duration of each run (default: 1)" << std::endl;
+    std::cout << "  --book-view-depth N       Levels per side in the view and each query (default: 10)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    PerformanceBenchmark benchmark;
+    std::vector<PerformanceBenchmark::BenchmarkConfig> configs;
+    bool csv_output = false;
+    std::string symbol = "BTC-USD";
+    double mid_price = 50000.0;
+    double spread = 10.0;
+    bool run_sweep = false;
+    ScalabilitySweep::SweepConfig sweep_config;
+    std::vector<LatencyKneeFinder::Target> knee_targets;
+    LatencyKneeFinder::KneeConfig knee_config;
+    bool run_hiccup = false;
+    HiccupMonitor::Config hiccup_config;
+    bool run_soak = false;
+    SoakTest::SoakConfig soak_config;
+    bool run_stop_storm = false;
+    StopStormBenchmark::StormConfig storm_config;
+    bool run_peg_bench = false;
+    PegRepricingBenchmark::PegConfig peg_config;
+    bool run_session_close = false;
+    SessionCloseBenchmark::CloseConfig close_config;
+    bool run_mass_quote = false;
+    MassQuoteBenchmark::QuoteConfig quote_config;
+    bool run_auction = false;
+    AuctionUncrossBenchmark::AuctionConfig auction_config;
+    bool run_positions = false;
+    PositionTrackerBenchmark::PositionConfig position_config;
+    bool run_rebalance = false;
+    ShardRebalanceBenchmark::RebalanceConfig rebalance_config;
+    bool run_overload = false;
+    OverloadBenchmark::OverloadConfig overload_config;
+    bool run_idle_warming = false;
+    IdleWarmingBenchmark::WarmingConfig warming_config;
+    bool run_epoch_readers = false;
+    EpochReaderBenchmark::ReaderConfig reader_config;
+    bool run_book_views = false;
+    BookViewBenchmark::ViewConfig view_config;
+    uint32_t trials = 1;
+    PerformanceBenchmark::WarmupConfig warmup_config;
+    std::string compare_baseline;
+    std::string compare_candidate;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--csv") {
+            csv_output = true;
+        } else if (arg == "--symbol" && i + 1 < argc) {
+            symbol = argv[++i];
+        } else if (arg == "--mid-price" && i + 1 < argc) {
+            mid_price = std::stod(argv[++i]);
+        } else if (arg == "--spread" && i + 1 < argc) {
+            spread = std::stod(argv[++i]);
+        } else if (arg == "--custom" && i + 2 < argc) {
+            uint64_t orders = std::stoull(argv[++i]);
+            double rate = std::stod(argv[++i]);
+            configs.push_back({"Custom", orders, rate, symbol, mid_price, spread, false, false});
+        } else if (arg == "--sweep") {
+            run_sweep = true;
+        } else if (arg == "--sweep-quick") {
+            run_sweep = true;
+            sweep_config.depths = {100, 10000, 100000};
+            sweep_config.symbol_counts = {1, 100};
+            sweep_config.cancel_ratios = {0.0, 0.9};
+            sweep_config.aggressor_ratios = {0.25};
+            sweep_config.measured_orders = 20000;
+        } else if (arg == "--sweep-risk") {
+            sweep_config.risk_limits = true;
+        } else if (arg == "--sweep-events") {
+            sweep_config.event_stream = true;
+        } else if (arg == "--depths" && i + 1 < argc) {
+            sweep_config.depths = parse_list<uint64_t>(argv[++i]);
+        } else if (arg == "--symbol-counts" && i + 1 < argc) {
+            sweep_config.symbol_counts = parse_list<uint64_t>(argv[++i]);
+        } else if (arg == "--cancel-ratios" && i + 1 < argc) {
+            sweep_config.cancel_ratios = parse_list<double>(argv[++i]);
+        } else if (arg == "--aggressor-ratios" && i + 1 < argc) {
+            sweep_config.aggressor_ratios = parse_list<double>(argv[++i]);
+        } else if (arg == "--sweep-orders" && i + 1 < argc) {
+            sweep_config.measured_orders = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            sweep_config.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+            soak_config.seed = sweep_config.seed;
+            knee_config.seed = sweep_config.seed;
+            quote_config.seed = sweep_config.seed;
+            auction_config.seed = sweep_config.seed;
+            position_config.seed = sweep_config.seed;
+            rebalance_config.seed = sweep_config.seed;
+            overload_config.seed = sweep_config.seed;
+            warming_config.seed = sweep_config.seed;
+            view_config.seed = sweep_config.seed;
+            benchmark.set_seed(sweep_config.seed);
+        } else if (arg == "--trials" && i + 1 < argc) {
+            trials = std::max<uint32_t>(1, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmup_config.max_orders = std::stoull(argv[++i]);
+        } else if (arg == "--warmup-block" && i + 1 < argc) {
+            warmup_config.block_size = std::stoull(argv[++i]);
+        } else if (arg == "--warmup-tolerance" && i + 1 < argc) {
+            warmup_config.tolerance = std::stod(argv[++i]);
+        } else if (arg == "--compare" && i + 2 < argc) {
+            compare_baseline = argv[++i];
+            compare_candidate = argv[++i];
+        } else if (arg == "--book" && i + 1 < argc) {
+            if (!parse_book_type(argv[++i], sweep_config.book_type)) {
+                std::cerr << "Unknown book type: " << argv[i] << std::endl;
+                return 1;
+            }
+            knee_config.book_type = sweep_config.book_type;
+            soak_config.book_type = sweep_config.book_type;
+            storm_config.book_type = sweep_config.book_type;
+            peg_config.book_type = sweep_config.book_type;
+            close_config.book_type = sweep_config.book_type;
+            quote_config.book_type = sweep_config.book_type;
+            auction_config.book_type = sweep_config.book_type;
+        } else if (arg == "--hiccup") {
+            run_hiccup = true;
+        } else if (arg == "--hiccup-cpu" && i + 1 < argc) {
+            run_hiccup = true;
+            hiccup_config.cpu = std::stoi(argv[++i]);
+        } else if (arg == "--soak") {
+            run_soak = true;
+        } else if (arg == "--soak-duration" && i + 1 < argc) {
+            soak_config.duration_seconds = std::stod(argv[++i]);
+        } else if (arg == "--soak-interval" && i + 1 < argc) {
+            soak_config.sample_seconds = std::stod(argv[++i]);
+        } else if (arg == "--soak-rate" && i + 1 < argc) {
+            soak_config.rate = std::stod(argv[++i]);
+        } else if (arg == "--soak-symbols" && i + 1 < argc) {
+            soak_config.symbols = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--soak-resting" && i + 1 < argc) {
+            soak_config.max_resting = std::stoull(argv[++i]);
+        } else if (arg == "--stop-storm") {
+            run_stop_storm = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                storm_config.pending_stops = std::stoull(argv[++i]);
+            }
+        } else if (arg == "--session-close") {
+            run_session_close = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                close_config.orders = std::stoull(argv[++i]);
+            }
+        } else if (arg == "--mass-quote") {
+            run_mass_quote = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                quote_config.symbols = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+        } else if (arg == "--mass-quote-rounds" && i + 1 < argc) {
+            run_mass_quote = true;
+            quote_config.rounds = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--mass-quote-shrink" && i + 1 < argc) {
+            run_mass_quote = true;
+            quote_config.shrink_ratio = std::stod(argv[++i]);
+        } else if (arg == "--auction") {
+            run_auction = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                auction_config.orders = std::stoull(argv[++i]);
+            }
+        } else if (arg == "--positions") {
+            run_positions = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                position_config.trades = std::stoull(argv[++i]);
+            }
+        } else if (arg == "--position-clients" && i + 1 < argc) {
+            run_positions = true;
+            position_config.clients = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--position-symbols" && i + 1 < argc) {
+            run_positions = true;
+            position_config.symbols = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--rebalance") {
+            run_rebalance = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                rebalance_config.orders = std::stoull(argv[++i]);
+            }
+        } else if (arg == "--rebalance-shards" && i + 1 < argc) {
+            run_rebalance = true;
+            rebalance_config.shards = std::max<uint32_t>(2, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--rebalance-hot" && i + 1 < argc) {
+            run_rebalance = true;
+            rebalance_config.hot_share = std::min(1.0, std::max(0.0, std::stod(argv[++i])));
+        } else if (arg == "--overload") {
+            run_overload = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                overload_config.load_factor = std::max(0.1, std::stod(argv[++i]));
+            }
+        } else if (arg == "--overload-seconds" && i + 1 < argc) {
+            run_overload = true;
+            overload_config.seconds = std::max(0.1, std::stod(argv[++i]));
+        } else if (arg == "--overload-depth" && i + 1 < argc) {
+            run_overload = true;
+            overload_config.max_queue_depth = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--idle-warming") {
+            run_idle_warming = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                warming_config.rounds = std::max<uint32_t>(1, static_cast<uint32_t>(std::stoul(argv[++i])));
+            }
+        } else if (arg == "--idle-ms" && i + 1 < argc) {
+            run_idle_warming = true;
+            warming_config.idle_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--warm-interval-us" && i + 1 < argc) {
+            run_idle_warming = true;
+            warming_config.warm_interval_us = std::max<uint32_t>(1, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--epoch-readers") {
+            run_epoch_readers = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                reader_config.reader_counts = parse_list<uint32_t>(argv[++i]);
+            }
+        } else if (arg == "--epoch-seconds" && i + 1 < argc) {
+            run_epoch_readers = true;
+            reader_config.seconds = std::max(0.1, std::stod(argv[++i]));
+        } else if (arg == "--book-views") {
+            run_book_views = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                view_config.reader_counts = parse_list<uint32_t>(argv[++i]);
+            }
+        } else if (arg == "--book-view-seconds" && i + 1 < argc) {
+            run_book_views = true;
+            view_config.seconds = std::max(0.1, std::stod(argv[++i]));
+        } else if (arg == "--book-view-depth" && i + 1 < argc) {
+            run_book_views = true;
+            view_config.depth = std::max<size_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--peg-bench") {
+            run_peg_bench = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                peg_config.peg_counts = parse_list<uint64_t>(argv[++i]);
+            }
+        } else if (arg == "--stop-storm-levels" && i + 1 < argc) {
+            storm_config.levels = std::stoull(argv[++i]);
+        } else if (arg == "--knee" && i + 1 < argc) {
+            std::string target = argv[++i];
+            if (target == "engine" || target == "all") {
+                knee_targets.push_back(LatencyKneeFinder::Target::ENGINE);
+            }
+            if (target == "pipeline-inproc" || target == "all") {
+                knee_targets.push_back(LatencyKneeFinder::Target::PIPELINE_INPROC);
+            }
+            if (target == "pipeline-tcp" || target == "all") {
+                knee_targets.push_back(LatencyKneeFinder::Target::PIPELINE_TCP);
+            }
+            if (knee_targets.empty()) {
+                std::cerr << "Unknown knee target: " << target << std::endl;
+                return 1;
+            }
+        } else if (arg == "--knee-start" && i + 1 < argc) {
+            knee_config.start_rate = std::stod(argv[++i]);
+        } else if (arg == "--knee-max" && i + 1 < argc) {
+            knee_config.max_rate = std::stod(argv[++i]);
+        } else if (arg == "--knee-factor" && i + 1 < argc) {
+            knee_config.step_factor = std::stod(argv[++i]);
+        } else if (arg == "--knee-step-seconds" && i + 1 < argc) {
+            knee_config.step_seconds = std::stod(argv[++i]);
+        } else if (arg == "--slo-p99-us" && i + 1 < argc) {
+            knee_config.slo_p99_us = std::stod(argv[++i]);
+        } else if (arg == "--quick") {
+            configs = {
+                {"Quick_LowVolume", 1000, 100.0, symbol, mid_price, spread, false, false},
+                {"Quick_MediumVolume", 5000, 500.0, symbol, mid_price, spread, false, false},
+                {"Quick_Aggressive", 2000, 200.0, symbol, mid_price, spread, true, true}
+            };
+        } else if (arg == "--full") {
+            configs = {
+                {"LowVolume_MarketMaking", 1000, 100.0, symbol, mid_price, spread, false, false},
+                {"MediumVolume_MarketMaking", 5000, 500.0, symbol, mid_price, spread, false, false},
+                {"HighVolume_MarketMaking", 10000, 1000.0, symbol, mid_price, spread, false, false},
+                {"Aggressive_Trading", 5000, 500.0, symbol, mid_price, spread, true, true},
+                {"HighFrequency_Burst", 20000, 2000.0, symbol, mid_price, spread, false, false}
+            };
+        } else if (arg == "--extreme") {
+            configs = {
+                {"Extreme_HighFrequency", 50000, 5000.0, symbol, mid_price, spread, false, false},
+                {"Extreme_Aggressive", 25000, 2500.0, symbol, mid_price, spread, true, true},
+                {"Extreme_Sustained", 100000, 10000.0, symbol, mid_price, spread, false, false}
+            };
+        }
+    }
+
+    if (!compare_baseline.empty()) {
+        try {
+            auto baseline = TrialComparison::load(compare_baseline);
+            auto candidate = TrialComparison::load(compare_candidate);
+            std::cout << "Baseline:  " << compare_baseline << std::endl;
+            std::cout << "Candidate: " << compare_candidate << std::endl << std::endl;
+            size_t regressions = TrialComparison::compare(baseline, candidate, std::cout);
+            std::cout << std::endl << regressions << " significant regression(s) at 95% confidence" << std::endl;
+            return regressions > 0 ? 1 : 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Comparison failed: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    benchmark.set_warmup(warmup_config);
+
+    // Optional platform jitter measurement, reported per benchmark window
+    std::unique_ptr<HiccupMonitor> hiccup;
+    std::vector<std::pair<std::string, HiccupMonitor::Report>> hiccup_windows;
+    if (run_hiccup) {
+        hiccup = std::make_unique<HiccupMonitor>(hiccup_config);
+        hiccup->start();
+        if (hiccup_config.cpu >= 0 && !hiccup->is_pinned()) {
+            std::cerr << "Warning: could not pin hiccup monitor to CPU " << hiccup_config.cpu << std::endl;
+        }
+    }
+    auto finish_hiccup_window = [&](const std::string& label) {
+        if (!hiccup) {
+            return;
+        }
+        auto report = hiccup->report();
+        hiccup_windows.emplace_back(label, report);
+        if (!csv_output) {
+            std::cout << std::endl;
+            HiccupMonitor::print_report(report, std::cout);
+        }
+        hiccup->reset();
+    };
+    auto save_hiccup_windows = [&](const std::string& suite_name) {
+        if (hiccup) {
+            hiccup->stop();
+            benchmark.save_hiccup_report(hiccup_windows, suite_name);
+        }
+    };
+    // CSV to stdout with --csv, otherwise to a timestamped file named after the mode
+    auto write_results = [&](const std::string& name, const std::function<void(std::ostream&)>& write) {
+        if (csv_output) {
+            write(std::cout);
+            return true;
+        }
+        std::string filename = benchmark.generate_timestamped_filename(name);
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open: " << filename << std::endl;
+            return false;
+        }
+        write(file);
+        std::cout << "\nResults saved to: " << filename << std::endl;
+        return true;
+    };
+    // A mode that runs one benchmark once: run it, close its hiccup window,
+    // write its header and rows, and save the hiccup report
+    auto run_single_result = [&](auto& bench, const std::string& name) {
+        using Bench = std::decay_t<decltype(bench)>;
+        auto results = bench.run();
+        finish_hiccup_window(name);
+        bool written = write_results(name, [&](std::ostream& out) {
+            Bench::print_csv_header(out);
+            print_csv_rows<Bench>(results, out);
+        });
+        if (!written) {
+            return 1;
+        }
+        save_hiccup_windows(name);
+        return 0;
+    };
+
+    if (run_soak) {
+        // The soak samples hiccups itself, one window per interval
+        SoakTest soak(soak_config, hiccup.get());
+        std::string filename = benchmark.generate_timestamped_filename("soak");
+        std::ofstream file(filename);
+        if (!csv_output && !file.is_open()) {
+            std::cerr << "Failed to open: " << filename << std::endl;
+            return 1;
+        }
+        auto samples = soak.run(csv_output ? std::cout : file);
+        bool drift = soak.print_drift_report(samples);
+        if (!csv_output) {
+            std::cout << "\nTime series saved to: " << filename << std::endl;
+        }
+        if (hiccup) {
+            hiccup->stop();
+        }
+        return drift ? 1 : 0;
+    }
+
+    if (run_stop_storm) {
+        StopStormBenchmark storm(storm_config);
+        return run_single_result(storm, "stop_storm");
+    }
+
+    if (run_session_close) {
+        SessionCloseBenchmark close_bench(close_config);
+        return run_single_result(close_bench, "session_close");
+    }
+
+    if (run_mass_quote) {
+        MassQuoteBenchmark quote_bench(quote_config);
+        return run_single_result(quote_bench, "mass_quote");
+    }
+
+    if (run_auction) {
+        AuctionUncrossBenchmark auction_bench(auction_config);
+        return run_single_result(auction_bench, "auction");
+    }
+
+    if (run_positions) {
+        PositionTrackerBenchmark position_bench(position_config);
+        return run_single_result(position_bench, "positions");
+    }
+
+    if (run_rebalance) {
+        ShardRebalanceBenchmark rebalance_bench(rebalance_config);
+        return run_single_result(rebalance_bench, "rebalance");
+    }
+
+    if (run_overload) {
+        OverloadBenchmark overload_bench(overload_config);
+        return run_single_result(overload_bench, "overload");
+    }
+
+    if (run_idle_warming) {
+        IdleWarmingBenchmark warming_bench(warming_config);
+        return run_single_result(warming_bench, "idle_warming");
+    }
+
+    if (run_epoch_readers) {
+        EpochReaderBenchmark reader_bench(reader_config);
+        return run_single_result(reader_bench, "epoch_readers");
+    }
+
+    if (run_book_views) {
+        BookViewBenchmark view_bench(view_config);
+        return run_single_result(view_bench, "book_views");
+    }
+
+    if (run_peg_bench) {
+        // Streams its rows as it runs, so it writes through write_results directly
+        PegRepricingBenchmark peg_bench(peg_config);
+        if (!write_results("peg_bench", [&](std::ostream& out) { peg_bench.run(out); })) {
+            return 1;
+        }
+        finish_hiccup_window("peg_bench");
+        save_hiccup_windows("peg_bench");
+        return 0;
+    }
+
+    if (!knee_targets.empty()) {
+        bool written = write_results("knee", [&](std::ostream& out) {
+            for (size_t t = 0; t < knee_targets.size(); ++t) {
+                LatencyKneeFinder finder(knee_targets[t], knee_config);
+                if (t == 0) {
+                    finder.print_csv_header(out);
+                }
+                finder.run(out);
+                finish_hiccup_window("knee_" + LatencyKneeFinder::target_name(knee_targets[t]));
+            }
+        });
+        if (!written) {
+            return 1;
+        }
+        save_hiccup_windows("knee");
+        return 0;
+    }
+
+    if (run_sweep) {
+        ScalabilitySweep sweep(sweep_config);
+        if (csv_output) {
+            sweep.run(std::cout);
+            finish_hiccup_window("sweep");
+            save_hiccup_windows("sweep");
+            return 0;
+        }
+
+        std::string filename = benchmark.generate_timestamped_filename("sweep");
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open: " << filename << std::endl;
+            return 1;
+        }
+        std::cout << "Scalability sweep, writing results to: " << filename << std::endl;
+        sweep.run(file);
+        std::cout << "Sweep complete: " << filename << std::endl;
+        finish_hiccup_window("sweep");
+        save_hiccup_windows("sweep");
+        return 0;
+    }
+
+    // Default to quick if no specific suite chosen
+    if (configs.empty()) {
+        configs = {
+            {"Quick_LowVolume", 1000, 100.0, symbol, mid_price, spread, false, false},
+            {"Quick_MediumVolume", 5000, 500.0, symbol, mid_price, spread, false, false},
+            {"Quick_Aggressive", 2000, 200.0, symbol, mid_price, spread, true, true}
+        };
+    }
+
+    std::cout << "Quasar Matching Engine Performance Benchmark" << std::endl;
+    std::cout << "=============================================" << std::endl;
+
+    std::vector<PerformanceBenchmark::BenchmarkResults> all_results;
+    std::string suite_name = "custom";
+
+    // Determine suite name for auto-saving
+    if (configs.size() > 1) {
+        if (configs[0].test_name.find("Quick") != std::string::npos) {
+            suite_name = "quick";
+        } else if (configs[0].test_name.find("Extreme") != std::string::npos) {
+            suite_name = "extreme";
+        } else if (configs.size() >= 5) {
+            suite_name = "full";
+        }
+    }
+
+    if (csv_output) {
+        benchmark.print_csv_header();
+    }
+
+    // Run benchmarks, each one `trials` times from the same seed
+    std::vector<MetricSummary> summaries;
+    for (const auto& config : configs) {
+        std::vector<PerformanceBenchmark::BenchmarkResults> test_trials;
+        for (uint32_t trial = 0; trial < trials; ++trial) {
+            if (hiccup) {
+                hiccup->reset();
+            }
+            auto results = benchmark.run_benchmark(config);
+            results.trial = trial;
+            all_results.push_back(results);
+            test_trials.push_back(results);
+
+            if (csv_output) {
+                benchmark.print_csv_row(results);
+            } else {
+                benchmark.print_results(results);
+            }
+            finish_hiccup_window(trials > 1 ? config.test_name + "_" + std::to_string(trial) : config.test_name);
+
+            benchmark.reset(); // Reset for next run
+
+            if (!csv_output && (trial + 1 < trials || &config != &configs.back())) {
+                std::cout << "\nPausing 2 seconds before next run...\n" << std::endl;
+                std::this_thread::sleep_for(std::chrono::seconds(2));
+            }
+        }
+
+        std::vector<MetricSummary> test_summaries;
+        for (const auto& [metric, higher_is_better] : TrialComparison::metrics()) {
+            std::vector<double> values;
+            for (const auto& results : test_trials) {
+                values.push_back(benchmark.metric_value(results, metric));
+            }
+            test_summaries.push_back(summarize_metric(config.test_name, metric, values));
+        }
+        if (trials > 1 && !csv_output) {
+            TrialComparison::print_summary(test_summaries, std::cout);
         }
+        summaries.insert(summaries.end(), test_summaries.begin(), test_summaries.end());
     }
 
     // Auto-save results unless user requested CSV to stdout
     if (!csv_output && !all_results.empty()) {
         benchmark.auto_save_results(all_results, suite_name);
+        benchmark.save_summary(summaries, suite_name);
     }
+    save_hiccup_windows(suite_name);
 
     return 0;
 }
\ No newline at end of file
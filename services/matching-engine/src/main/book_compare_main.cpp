@@ -0,0 +1,420 @@
+#include "core/OrderBook.h"
+#include "core/Trade.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <iomanip>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+using namespace quasar;
+
+// --- Heap accounting ---
+// Every allocation carries a small header with its size so the harness can
+// report live and peak heap bytes owned by each book implementation.
+namespace {
+
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+std::atomic<int64_t> g_live_bytes{0};
+std::atomic<int64_t> g_peak_bytes{0};
+
+void* counted_alloc(size_t size) {
+    void* raw = std::malloc(size + kHeaderSize);
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(raw) = size;
+    int64_t live = g_live_bytes.fetch_add(static_cast<int64_t>(size)) + static_cast<int64_t>(size);
+    int64_t peak = g_peak_bytes.load();
+    while (live > peak && !g_peak_bytes.compare_exchange_weak(peak, live)) {}
+    return static_cast<char*>(raw) + kHeaderSize;
+}
+
+void counted_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    void* raw = static_cast<char*>(ptr) - kHeaderSize;
+    g_live_bytes.fetch_sub(static_cast<int64_t>(*static_cast<size_t*>(raw)));
+    std::free(raw);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { counted_free(ptr); }
+
+class BookPolicyComparison {
+public:
+    struct WorkloadConfig {
+        uint64_t total_orders;
+        uint64_t resting_depth;
+        uint32_t seed;
+        double cancel_ratio;
+        double aggressor_ratio;
+        double mid_price;
+        double tick_size;
+        int price_band_ticks;
+        bool queue_index;
+    };
+
+    // One pre-generated command, replayed identically against every policy
+    struct Command {
+        bool is_cancel;
+        uint64_t order_id;
+        uint64_t client_id;
+        Side side;
+        double price;
+        uint64_t quantity;
+    };
+
+    struct PolicyResults {
+        std::string policy;
+        uint64_t commands;
+        uint64_t trades;
+        double duration_seconds;
+        double commands_per_second;
+
+        double avg_latency_ns;
+        double p50_latency_ns;
+        double p99_latency_ns;
+        double p999_latency_ns;
+        double max_latency_ns;
+
+        int64_t live_bytes;
+        int64_t peak_bytes;
+        bool trades_match;
+
+        // Mean of queue_position, depth_to_price and cost_to_fill after the
+        // replay (0 without --queue-index)
+        double query_ns;
+    };
+
+    explicit BookPolicyComparison(const WorkloadConfig& config) : config_(config) {
+        generate_workload();
+    }
+
+    template<typename Book>
+    PolicyResults run(const std::string& policy_name) {
+        std::cout << "\n=== Policy: " << policy_name << " ===" << std::endl;
+
+        std::vector<double> latencies;
+        latencies.reserve(commands_.size());
+        std::vector<Trade> trades;
+        trades.reserve(commands_.size());
+
+        int64_t baseline_bytes = g_live_bytes.load();
+        g_peak_bytes.store(baseline_bytes);
+
+        PolicyResults results{};
+        results.policy = policy_name;
+        {
+            BookConfig book_config;
+            book_config.tick_size = config_.tick_size;
+            book_config.queue_index = config_.queue_index;
+            Book book("BENCH", book_config);
+
+            auto start_time = std::chrono::steady_clock::now();
+            for (const auto& command : commands_) {
+                auto op_start = std::chrono::steady_clock::now();
+                if (command.is_cancel) {
+                    book.cancel_order(command.order_id);
+                } else {
+                    auto batch = book.process_order(std::make_unique<Order>(
+                        command.order_id, command.client_id, "BENCH",
+                        command.side, command.price, command.quantity));
+                    trades.insert(trades.end(), batch.begin(), batch.end());
+                }
+                auto op_end = std::chrono::steady_clock::now();
+                latencies.push_back(static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count()));
+            }
+            auto end_time = std::chrono::steady_clock::now();
+
+            results.duration_seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                end_time - start_time).count() / 1e6;
+            results.live_bytes = g_live_bytes.load() - baseline_bytes;
+            results.peak_bytes = g_peak_bytes.load() - baseline_bytes;
+            if (config_.queue_index) {
+                results.query_ns = time_queries(book);
+            }
+        }
+
+        results.commands = commands_.size();
+        results.trades = trades.size();
+        results.commands_per_second = results.commands / results.duration_seconds;
+
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0.0;
+        for (double latency : latencies) {
+            sum += latency;
+        }
+        results.avg_latency_ns = sum / latencies.size();
+        results.p50_latency_ns = latencies[latencies.size() * 50 / 100];
+        results.p99_latency_ns = latencies[latencies.size() * 99 / 100];
+        results.p999_latency_ns = latencies[latencies.size() * 999 / 1000];
+        results.max_latency_ns = latencies.back();
+
+        if (!reference_recorded_) {
+            reference_trades_ = trades;
+            reference_recorded_ = true;
+            results.trades_match = true;
+        } else {
+            results.trades_match = same_trades(reference_trades_, trades);
+        }
+
+        return results;
+    }
+
+    // Ask each query once per order command, against the book left by the replay
+    template<typename Book>
+    double time_queries(const Book& book) {
+        uint64_t answered = 0;
+        uint64_t queries = 0;
+        QueuePosition position;
+        FillEstimate estimate;
+        auto start_time = std::chrono::steady_clock::now();
+        for (const auto& command : commands_) {
+            if (command.is_cancel) {
+                continue;
+            }
+            uint64_t depth = 0;
+            answered += book.queue_position(command.order_id, position) ? position.quantity_ahead : 0;
+            answered += book.depth_to_price(command.side, command.price, depth) ? depth : 0;
+            answered += book.cost_to_fill(command.side, command.quantity * 20, estimate) ? estimate.filled_quantity : 0;
+            queries += 3;
+        }
+        auto end_time = std::chrono::steady_clock::now();
+        volatile uint64_t sink = answered;
+        (void)sink;
+        return queries == 0 ? 0.0 : static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()) / queries;
+    }
+
+    void print_results(const PolicyResults& results) {
+        std::cout << "  Commands: " << results.commands << ", Trades: " << results.trades << std::endl;
+        std::cout << "  Rate: " << std::fixed << std::setprecision(0) << results.commands_per_second << " cmds/sec" << std::endl;
+        std::cout << "  Latency (ns): avg=" << std::setprecision(0) << results.avg_latency_ns
+                  << " p50=" << results.p50_latency_ns
+                  << " p99=" << results.p99_latency_ns
+                  << " p99.9=" << results.p999_latency_ns
+                  << " max=" << results.max_latency_ns << std::endl;
+        std::cout << "  Heap (bytes): live=" << results.live_bytes
+                  << " peak=" << results.peak_bytes << std::endl;
+        std::cout << "  Trade stream: " << (results.trades_match ? "IDENTICAL" : "MISMATCH") << std::endl;
+        if (config_.queue_index) {
+            std::cout << "  Queue index query (ns): avg=" << std::setprecision(0) << results.query_ns << std::endl;
+        }
+    }
+
+    void print_csv_header(std::ostream& out = std::cout) {
+        out << "policy,commands,trades,duration_seconds,commands_per_second,"
+            << "avg_latency_ns,p50_latency_ns,p99_latency_ns,p999_latency_ns,max_latency_ns,"
+            << "live_bytes,peak_bytes,trades_match,query_ns" << std::endl;
+    }
+
+    void print_csv_row(const PolicyResults& results, std::ostream& out = std::cout) {
+        out << results.policy << ","
+            << results.commands << ","
+            << results.trades << ","
+            << std::fixed << std::setprecision(4) << results.duration_seconds << ","
+            << std::fixed << std::setprecision(0) << results.commands_per_second << ","
+            << results.avg_latency_ns << ","
+            << results.p50_latency_ns << ","
+            << results.p99_latency_ns << ","
+            << results.p999_latency_ns << ","
+            << results.max_latency_ns << ","
+            << results.live_bytes << ","
+            << results.peak_bytes << ","
+            << (results.trades_match ? 1 : 0) << ","
+            << results.query_ns << std::endl;
+    }
+
+    std::string generate_timestamped_filename(const std::string& base_name, const std::string& extension = "csv") {
+        auto now = std::chrono::system_clock::now();
+        auto time_t = std::chrono::system_clock::to_time_t(now);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now.time_since_epoch()) % 1000;
+
+        std::stringstream ss;
+        ss << "../results/" << base_name << "_"
+           << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S")
+           << "_" << std::setfill('0') << std::setw(3) << ms.count()
+           << "." << extension;
+        return ss.str();
+    }
+
+    void auto_save_results(const std::vector<PolicyResults>& all_results) {
+        std::string filename = generate_timestamped_filename("book_compare");
+        std::ofstream file(filename);
+
+        if (file.is_open()) {
+            print_csv_header(file);
+            for (const auto& results : all_results) {
+                print_csv_row(results, file);
+            }
+            std::cout << "\nResults saved to: " << filename << std::endl;
+        } else {
+            std::cerr << "Failed to save results to: " << filename << std::endl;
+        }
+    }
+
+private:
+    void generate_workload() {
+        std::mt19937 rng(config_.seed);
+        std::uniform_int_distribution<int> side_dist(0, 1);
+        std::uniform_int_distribution<int> offset_dist(1, config_.price_band_ticks);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+        std::uniform_real_distribution<double> action_dist(0.0, 1.0);
+
+        commands_.reserve(config_.resting_depth + config_.total_orders);
+        std::vector<uint64_t> resting_ids;
+        uint64_t next_id = 1;
+
+        auto make_order = [&](bool aggressive) {
+            Side side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+            int offset = offset_dist(rng);
+            // Passive orders rest away from mid, aggressive ones reach across it
+            int ticks = (side == Side::BUY) == aggressive ? offset : -offset;
+            double price = config_.mid_price + ticks * config_.tick_size;
+            Command command{false, next_id++, next_id % 64, side, price, quantity_dist(rng)};
+            resting_ids.push_back(command.order_id);
+            commands_.push_back(command);
+        };
+
+        // Seed the book with non-crossing depth
+        for (uint64_t i = 0; i < config_.resting_depth; ++i) {
+            make_order(false);
+        }
+
+        for (uint64_t i = 0; i < config_.total_orders; ++i) {
+            double action = action_dist(rng);
+            if (action < config_.cancel_ratio && !resting_ids.empty()) {
+                std::uniform_int_distribution<size_t> pick(0, resting_ids.size() - 1);
+                size_t index = pick(rng);
+                commands_.push_back({true, resting_ids[index], 0, Side::BUY, 0.0, 0});
+                resting_ids[index] = resting_ids.back();
+                resting_ids.pop_back();
+            } else {
+                make_order(action < config_.cancel_ratio + config_.aggressor_ratio);
+            }
+        }
+    }
+
+    static bool same_trades(const std::vector<Trade>& expected, const std::vector<Trade>& actual) {
+        if (expected.size() != actual.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i].trade_id != actual[i].trade_id ||
+                expected[i].taker_order_id != actual[i].taker_order_id ||
+                expected[i].maker_order_id != actual[i].maker_order_id ||
+                expected[i].price != actual[i].price ||
+                expected[i].quantity != actual[i].quantity) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    WorkloadConfig config_;
+    std::vector<Command> commands_;
+    std::vector<Trade> reference_trades_;
+    bool reference_recorded_{false};
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --help                    Show this help message" << std::endl;
+    std::cout << "  --orders N                Commands after the book is seeded (default: 200000)" << std::endl;
+    std::cout << "  --depth N                 Resting orders seeded before measuring (default: 10000)" << std::endl;
+    std::cout << "  --seed S                  Workload RNG seed (default: 42)" << std::endl;
+    std::cout << "  --cancel-ratio X          Fraction of commands that cancel (default: 0.3)" << std::endl;
+    std::cout << "  --aggressor-ratio X       Fraction of commands that cross (default: 0.2)" << std::endl;
+    std::cout << "  --band N                  Price band in ticks either side of mid (default: 200)" << std::endl;
+    std::cout << "  --tick T                  Tick size (default: 0.01)" << std::endl;
+    std::cout << "  --queue-index             Keep queue indexes and time queue/depth queries" << std::endl;
+    std::cout << "  --csv                     Output results in CSV format" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BookPolicyComparison::WorkloadConfig config{200000, 10000, 42, 0.3, 0.2, 50000.0, 0.01, 200, false};
+    bool csv_output = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--queue-index") {
+            config.queue_index = true;
+        } else if (arg == "--csv") {
+            csv_output = true;
+        } else if (arg == "--orders" && i + 1 < argc) {
+            config.total_orders = std::stoull(argv[++i]);
+        } else if (arg == "--depth" && i + 1 < argc) {
+            config.resting_depth = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            config.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--cancel-ratio" && i + 1 < argc) {
+            config.cancel_ratio = std::stod(argv[++i]);
+        } else if (arg == "--aggressor-ratio" && i + 1 < argc) {
+            config.aggressor_ratio = std::stod(argv[++i]);
+        } else if (arg == "--band" && i + 1 < argc) {
+            config.price_band_ticks = std::stoi(argv[++i]);
+        } else if (arg == "--tick" && i + 1 < argc) {
+            config.tick_size = std::stod(argv[++i]);
+        }
+    }
+
+    std::cout << "Quasar Order Book Policy Comparison" << std::endl;
+    std::cout << "===================================" << std::endl;
+    std::cout << "Seed: " << config.seed << ", Depth: " << config.resting_depth
+              << ", Commands: " << config.total_orders << std::endl;
+
+    BookPolicyComparison comparison(config);
+    std::vector<BookPolicyComparison::PolicyResults> all_results;
+
+    // The heap policy runs first and provides the reference trade stream
+    all_results.push_back(comparison.run<HeapOrderBook>(HeapBookPolicy::name));
+    all_results.push_back(comparison.run<MapOrderBook>(MapBookPolicy::name));
+    all_results.push_back(comparison.run<IntrusiveOrderBook>(IntrusiveBookPolicy::name));
+    all_results.push_back(comparison.run<LadderOrderBook>(LadderBookPolicy::name));
+
+    bool all_match = true;
+    if (csv_output) {
+        comparison.print_csv_header();
+    }
+    for (const auto& results : all_results) {
+        if (csv_output) {
+            comparison.print_csv_row(results);
+        } else {
+            std::cout << "\n--- " << results.policy << " ---" << std::endl;
+            comparison.print_results(results);
+        }
+        all_match = all_match && results.trades_match;
+    }
+
+    if (!csv_output) {
+        comparison.auto_save_results(all_results);
+    }
+
+    if (!all_match) {
+        std::cerr << "Trade streams differ between policies" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include "core/MatchingEngine.h"
 #include "core/Trade.h"
+#include "common/HiccupMonitor.h"
 #include "kafka/KafkaClient.h"
 #include "messages_generated.h"
 #include <iostream>
@@ -18,8 +19,10 @@ using namespace quasar;
 
 class MatchingEngineConsumer {
 public:
-    MatchingEngineConsumer(const kafka::KafkaConfig& kafka_config)
+    MatchingEngineConsumer(const kafka::KafkaConfig& kafka_config,
+                           std::unique_ptr<HiccupMonitor> hiccup_monitor = nullptr)
         : kafka_config_(kafka_config)
+        , hiccup_monitor_(std::move(hiccup_monitor))
         , engine_(std::make_unique<MatchingEngine>())
         , running_(false) {
 
@@ -67,6 +70,10 @@ public:
         std::cout << "Starting Matching Engine Consumer" << std::endl;
         running_ = true;
 
+        if (hiccup_monitor_) {
+            hiccup_monitor_->start();
+        }
+
         // Start statistics thread
         std::thread stats_thread(&MatchingEngineConsumer::print_stats, this);
 
@@ -75,6 +82,10 @@ public:
             // In real implementation, this would consume from Kafka
             // For now, simulate message processing
             process_mock_messages();
+
+            // Drive the engine clock from wall time so GTD/DAY orders expire
+            engine_->advance_time(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()));
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
 
@@ -84,6 +95,9 @@ public:
         }
 
         // Shutdown
+        if (hiccup_monitor_) {
+            hiccup_monitor_->stop();
+        }
         if (kafka_client_) {
             kafka_client_->shutdown();
         }
@@ -169,12 +183,25 @@ private:
             auto engine_stats = engine_->get_stats();
             std::cout << "Engine Active Orders: " << engine_stats.active_orders << std::endl;
             std::cout << "Engine Total Trades: " << engine_stats.total_trades << std::endl;
+
+            // Container sizes: these should level off under a steady load
+            auto storage = engine_->get_storage_stats();
+            std::cout << "Order Map Entries/Buckets: " << storage.order_map_entries << "/"
+                      << storage.order_map_buckets << std::endl;
+            std::cout << "Book Index Entries/Buckets: " << storage.book_totals.indexed_orders << "/"
+                      << storage.book_totals.index_buckets << std::endl;
+            std::cout << "Book Side Entries: " << storage.book_totals.side_entries << std::endl;
+            if (hiccup_monitor_) {
+                HiccupMonitor::print_report(hiccup_monitor_->report(), std::cout);
+                hiccup_monitor_->reset();
+            }
             std::cout << "===================================" << std::endl;
         }
     }
 
     kafka::KafkaConfig kafka_config_;
     std::unique_ptr<kafka::KafkaClient> kafka_client_;
+    std::unique_ptr<HiccupMonitor> hiccup_monitor_;
     std::unique_ptr<MatchingEngine> engine_;
     std::atomic<bool> running_;
     Statistics stats_;
@@ -203,6 +230,9 @@ int main(int argc, char* argv[]) {
         kafka_config.orders_new_topic = "orders.new";
         kafka_config.trades_topic = "trades";
 
+        bool run_hiccup = false;
+        HiccupMonitor::Config hiccup_config;
+
         // Override with command line arguments or environment variables
         for (int i = 1; i < argc; ++i) {
             std::string arg = argv[i];
@@ -212,6 +242,11 @@ int main(int argc, char* argv[]) {
                 kafka_config.orders_new_topic = argv[++i];
             } else if (arg == "--trades-topic" && i + 1 < argc) {
                 kafka_config.trades_topic = argv[++i];
+            } else if (arg == "--hiccup") {
+                run_hiccup = true;
+            } else if (arg == "--hiccup-cpu" && i + 1 < argc) {
+                run_hiccup = true;
+                hiccup_config.cpu = std::stoi(argv[++i]);
             }
         }
 
@@ -223,7 +258,11 @@ int main(int argc, char* argv[]) {
         std::cout << "====================================" << std::endl;
 
         // Create and run consumer
-        g_consumer = std::make_unique<MatchingEngineConsumer>(kafka_config);
+        std::unique_ptr<HiccupMonitor> hiccup_monitor;
+        if (run_hiccup) {
+            hiccup_monitor = std::make_unique<HiccupMonitor>(hiccup_config);
+        }
+        g_consumer = std::make_unique<MatchingEngineConsumer>(kafka_config, std::move(hiccup_monitor));
         g_consumer->run();
 
         return 0;
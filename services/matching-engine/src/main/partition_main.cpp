@@ -0,0 +1,157 @@
+#include "core/PartitionedEngine.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace quasar;
+
+// One engine partition, or the producer side of its command log. Start one
+// --run process per partition on the same log and snapshot directory, feed
+// the log with --produce, and move a symbol with --migrate while they run:
+//
+//   matching_engine_partition --log cmd.log --produce 1000000 --symbols 200
+//   matching_engine_partition --log cmd.log --run --partition 0 --partitions 3 --snapshots snaps &
+//   matching_engine_partition --log cmd.log --run --partition 1 --partitions 3 --snapshots snaps &
+//   matching_engine_partition --log cmd.log --migrate SYM-7 --to 2
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " --log PATH MODE [options]\n"
+              << "Modes:\n"
+              << "  --produce N          Append N limit orders\n"
+              << "  --migrate SYMBOL     Append a handoff of SYMBOL (with --to P)\n"
+              << "  --run                Apply the log as one partition\n"
+              << "Options:\n"
+              << "  --symbols M          Symbols SYM-0..SYM-(M-1) for --produce (default 100)\n"
+              << "  --seed S             Random seed for --produce (default 42)\n"
+              << "  --to P               Destination partition for --migrate\n"
+              << "  --partition P        This partition for --run (default 0)\n"
+              << "  --partitions K       Partitions on the ring (default 1)\n"
+              << "  --snapshots DIR      Shared handoff directory (default .)\n"
+              << "  --follow             Keep reading after the end of the log\n";
+}
+
+int produce(CommandLog& log, uint64_t orders, uint32_t symbols, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> tick_dist(-50, 50);
+    std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+    for (uint64_t i = 0; i < orders; ++i) {
+        Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+        std::string symbol = "SYM-" + std::to_string(rng() % symbols);
+        if (!log.append(Command::new_order(1 + i % 50, symbol, side, 100.0 + tick_dist(rng) * 0.01,
+                                           quantity_dist(rng)))) {
+            std::cerr << "Append failed at order " << i << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Appended " << orders << " orders; log holds " << log.size() << " commands" << std::endl;
+    return 0;
+}
+
+int run(CommandLog& log, const PartitionConfig& config, bool follow) {
+    PartitionedEngine partition(log, config);
+    auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        size_t applied = partition.poll(4096);
+        if (partition.failed()) {
+            std::cerr << "Handoff at offset " << partition.offset() << " failed: " << partition.error() << std::endl;
+            return 1;
+        }
+        if (applied == 0) {
+            if (!follow && !partition.waiting() && partition.offset() >= log.size()) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PartitionedEngine::PartitionStats stats = partition.get_stats();
+    MatchingEngine::EngineStats engine_stats = partition.engine().get_stats();
+    std::cout << "Partition " << config.partition << " of " << config.partitions << "\n"
+              << "  Commands read:   " << partition.offset() << " in " << seconds << " s ("
+              << static_cast<uint64_t>(partition.offset() / (seconds > 0 ? seconds : 1)) << "/s)\n"
+              << "  Applied:         " << stats.applied << "\n"
+              << "  Skipped:         " << stats.skipped << "\n"
+              << "  Handed off:      " << stats.handed_off << "\n"
+              << "  Adopted:         " << stats.adopted << "\n"
+              << "  Trades:          " << engine_stats.total_trades << "\n"
+              << "  Resting orders:  " << engine_stats.active_orders << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string log_path = "commands.log";
+    std::string mode;
+    std::string symbol;
+    uint64_t orders = 0;
+    uint32_t symbols = 100;
+    uint32_t seed = 42;
+    uint32_t destination = 0;
+    bool follow = false;
+    PartitionConfig config;
+    config.snapshot_dir = ".";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--log" && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (arg == "--produce" && i + 1 < argc) {
+            mode = "produce";
+            orders = std::stoull(argv[++i]);
+        } else if (arg == "--migrate" && i + 1 < argc) {
+            mode = "migrate";
+            symbol = argv[++i];
+        } else if (arg == "--run") {
+            mode = "run";
+        } else if (arg == "--symbols" && i + 1 < argc) {
+            symbols = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--to" && i + 1 < argc) {
+            destination = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--partition" && i + 1 < argc) {
+            config.partition = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--partitions" && i + 1 < argc) {
+            config.partitions = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--snapshots" && i + 1 < argc) {
+            config.snapshot_dir = argv[++i];
+        } else if (arg == "--follow") {
+            follow = true;
+        }
+    }
+
+    CommandLog log(log_path);
+    if (!log.is_open()) {
+        std::cerr << "Cannot open " << log_path << std::endl;
+        return 1;
+    }
+
+    if (mode == "produce") {
+        return produce(log, orders, symbols == 0 ? 1 : symbols, seed);
+    } else if (mode == "migrate") {
+        if (!log.append(Command::handoff(symbol, destination))) {
+            std::cerr << "Append failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Handoff of " << symbol << " to partition " << destination << " appended" << std::endl;
+        return 0;
+    } else if (mode == "run") {
+        if (config.partition >= config.partitions || config.partitions > kMaxShards) {
+            std::cerr << "Partition must be below --partitions (at most " << kMaxShards << ")" << std::endl;
+            return 1;
+        }
+        return run(log, config, follow);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
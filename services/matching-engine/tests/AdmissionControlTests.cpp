@@ -0,0 +1,238 @@
+#include "gtest/gtest.h"
+#include "core/MatchingEngine.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+struct RecordingSink {
+    std::vector<EngineEvent> events;
+
+    void on_events(const EngineEvent* begin, size_t count) {
+        events.insert(events.end(), begin, begin + count);
+    }
+
+    std::vector<EngineEvent> of_type(EngineEventType type) const {
+        std::vector<EngineEvent> out;
+        for (const EngineEvent& event : events) {
+            if (event.type == type) {
+                out.push_back(event);
+            }
+        }
+        return out;
+    }
+};
+
+} // namespace
+
+TEST(AdmissionControlTest, QueueDepthHysteresis) {
+    AdmissionControl admission;
+    EXPECT_FALSE(admission.update());  // no limits: never overloaded
+
+    AdmissionLimits limits;
+    limits.max_queue_depth = 100;
+    admission.set_limits(limits);
+    EXPECT_TRUE(admission.enabled());
+    EXPECT_FALSE(admission.timed());
+
+    admission.set_queue_depth(99);
+    EXPECT_FALSE(admission.update());
+    admission.set_queue_depth(100);
+    EXPECT_TRUE(admission.update());
+    EXPECT_TRUE(admission.overloaded());
+
+    // Stays overloaded until under half the limit
+    admission.set_queue_depth(60);
+    EXPECT_FALSE(admission.update());
+    EXPECT_TRUE(admission.overloaded());
+    admission.set_queue_depth(49);
+    EXPECT_TRUE(admission.update());
+    EXPECT_FALSE(admission.overloaded());
+    EXPECT_EQ(admission.episodes(), 1);
+
+    admission.set_limits(AdmissionLimits{});
+    EXPECT_FALSE(admission.enabled());
+}
+
+TEST(AdmissionControlTest, LatencyAverage) {
+    AdmissionControl admission;
+    AdmissionLimits limits;
+    limits.max_latency_ns = 1000;
+    admission.set_limits(limits);
+    EXPECT_TRUE(admission.timed());
+
+    for (int i = 0; i < 200; ++i) {
+        admission.record_latency(2000);
+    }
+    EXPECT_GE(admission.latency_ns(), 1000);
+    EXPECT_TRUE(admission.update());
+
+    // Quick calls bring the average back down
+    for (int i = 0; i < 200 && admission.overloaded(); ++i) {
+        admission.record_latency(10);
+        admission.update();
+    }
+    EXPECT_FALSE(admission.overloaded());
+    EXPECT_LT(admission.latency_ns(), 500);
+}
+
+TEST(AdmissionControlTest, LimitsChangeWhileOrdersAreTimed) {
+    AdmissionControl admission;
+    AdmissionLimits tight;
+    tight.max_latency_ns = 1000;
+    AdmissionLimits loose;
+    loose.max_latency_ns = 100000;
+    loose.max_queue_depth = 50;
+    loose.resume_ratio = 0.25;
+    admission.set_limits(tight);
+
+    // Samples from several order threads while the limits keep changing
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&admission] {
+            for (int i = 0; i < 20000; ++i) {
+                admission.record_latency(1600);
+                admission.update();
+            }
+        });
+    }
+    for (int i = 0; i < 1000; ++i) {
+        admission.set_limits(i % 2 == 0 ? loose : tight);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // The average settles on the samples (to within the integer rounding)
+    EXPECT_GE(admission.latency_ns(), 1500);
+    EXPECT_LE(admission.latency_ns(), 1615);
+    AdmissionLimits limits = admission.limits();
+    EXPECT_EQ(limits.max_latency_ns, 1000);
+    EXPECT_EQ(limits.max_queue_depth, 0);
+    EXPECT_EQ(limits.resume_ratio, 0.5);
+    admission.update();
+    EXPECT_TRUE(admission.overloaded());
+}
+
+TEST(AdmissionControlTest, OverloadedEngineShedsNewOrdersOnly) {
+    MatchingEngine engine;
+    RecordingSink sink;
+    engine.subscribe_events(sink);
+
+    uint64_t resting = engine.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+    ASSERT_NE(resting, 0);
+
+    AdmissionLimits limits;
+    limits.max_queue_depth = 1000;
+    engine.set_admission_limits(limits);
+    engine.report_queue_depth(1500);
+    EXPECT_TRUE(engine.is_overloaded());
+
+    // New orders are refused with SYSTEM_BUSY
+    EXPECT_EQ(engine.submit_order(2, "BTC-USD", Side::BUY, 100.0, 5), 0);
+    std::vector<EngineEvent> rejects = sink.of_type(EngineEventType::REJECTED);
+    ASSERT_EQ(rejects.size(), 1);
+    EXPECT_EQ(rejects[0].detail, static_cast<uint8_t>(RejectReason::SYSTEM_BUSY));
+    EXPECT_EQ(rejects[0].client_id, 2);
+    EXPECT_EQ(rejects[0].order_id, 0);
+
+    // Quotes and cancels still go through
+    MatchingEngine::QuoteEntry quote{"ETH-USD", 9.0, 10, 11.0, 10};
+    MatchingEngine::MassQuoteAck ack = engine.mass_quote(3, 1, {quote});
+    EXPECT_EQ(ack.rejected_entries, 0);
+    EXPECT_EQ(ack.sides_entered, 2);
+    EXPECT_TRUE(engine.cancel_order(resting));
+
+    MatchingEngine::EngineStats stats = engine.get_stats();
+    EXPECT_TRUE(stats.overloaded);
+    EXPECT_EQ(stats.busy_rejects, 1);
+    EXPECT_EQ(stats.rejected_orders, 1);
+    EXPECT_EQ(stats.overload_episodes, 1);
+    EXPECT_EQ(stats.queue_depth, 1500);
+    EXPECT_EQ(stats.cancelled_orders, 1);
+
+    // Back under half the limit: accepting again
+    engine.report_queue_depth(400);
+    EXPECT_FALSE(engine.is_overloaded());
+    EXPECT_NE(engine.submit_order(2, "BTC-USD", Side::BUY, 100.0, 5), 0);
+
+    std::vector<EngineEvent> signals = sink.of_type(EngineEventType::OVERLOAD);
+    ASSERT_EQ(signals.size(), 2);
+    EXPECT_EQ(signals[0].detail, 1);
+    EXPECT_EQ(signals[0].quantity, 1500);
+    EXPECT_EQ(signals[1].detail, 0);
+    EXPECT_EQ(signals[1].quantity, 400);
+    EXPECT_LT(signals[0].sequence, rejects[0].sequence);
+}
+
+TEST(AdmissionControlTest, ShedOrdersTakeNoBookOrId) {
+    MatchingEngine engine;
+    RecordingSink sink;
+    engine.subscribe_events(sink);
+    uint64_t first = engine.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+
+    AdmissionLimits limits;
+    limits.max_queue_depth = 10;
+    engine.set_admission_limits(limits);
+    engine.report_queue_depth(50);
+
+    // A flood of new symbols is turned away busy, before any book exists
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(engine.submit_order(2, "JUNK-" + std::to_string(i), Side::BUY, 1.0, 1), 0);
+    }
+    EXPECT_EQ(engine.submit_order(2, "BTC-USD", Side::BUY, 90.0, 1), 0);
+    EXPECT_EQ(engine.get_all_symbols(), std::vector<std::string>{"BTC-USD"});
+    std::vector<EngineEvent> rejects = sink.of_type(EngineEventType::REJECTED);
+    ASSERT_EQ(rejects.size(), 101);
+    for (const EngineEvent& reject : rejects) {
+        EXPECT_EQ(reject.detail, static_cast<uint8_t>(RejectReason::SYSTEM_BUSY));
+    }
+    EXPECT_EQ(engine.get_stats().busy_rejects, 101);
+
+    // No symbol id or order id was used up
+    engine.report_queue_depth(0);
+    uint64_t second = engine.submit_order(2, "BTC-USD", Side::BUY, 90.0, 1);
+    EXPECT_EQ(order_id_sequence(second), order_id_sequence(first) + 1);
+    EXPECT_EQ(order_id_symbol(engine.submit_order(2, "ETH-USD", Side::BUY, 1.0, 1)), 2);
+}
+
+TEST(AdmissionControlTest, ClearingLimitsEndsOverload) {
+    MatchingEngine engine;
+    RecordingSink sink;
+    engine.subscribe_events(sink);
+
+    // Without limits the reported depth is ignored
+    engine.report_queue_depth(1000000);
+    EXPECT_FALSE(engine.is_overloaded());
+    EXPECT_EQ(engine.get_stats().queue_depth, 0);
+
+    AdmissionLimits limits;
+    limits.max_queue_depth = 10;
+    engine.set_admission_limits(limits);
+    engine.report_queue_depth(50);
+    EXPECT_EQ(engine.submit_order(1, "BTC-USD", Side::BUY, 100.0, 1), 0);
+
+    engine.set_admission_limits(AdmissionLimits{});
+    EXPECT_FALSE(engine.is_overloaded());
+    EXPECT_NE(engine.submit_order(1, "BTC-USD", Side::BUY, 100.0, 1), 0);
+    std::vector<EngineEvent> signals = sink.of_type(EngineEventType::OVERLOAD);
+    ASSERT_EQ(signals.size(), 2);
+    EXPECT_EQ(signals[1].detail, 0);
+}
+
+TEST(AdmissionControlTest, LatencyLimitTimesOrderEntry) {
+    MatchingEngine engine;
+    AdmissionLimits limits;
+    limits.max_latency_ns = 1000000000;  // never reached
+    engine.set_admission_limits(limits);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_NE(engine.submit_order(1, "BTC-USD", i % 2 == 0 ? Side::BUY : Side::SELL, 100.0, 1), 0);
+    }
+    MatchingEngine::EngineStats stats = engine.get_stats();
+    EXPECT_GT(stats.matching_latency_ns, 0);
+    EXPECT_FALSE(stats.overloaded);
+    EXPECT_EQ(stats.busy_rejects, 0);
+}
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+#include "common/AllocationTracker.h"
+#include "core/MatchingEngine.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace quasar;
+
+// These tests link engine_core_tracked: malloc is interposed and the engine's
+// hot regions are instrumented.
+
+class AllocationTrackerTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        AllocationTracker::disarm();
+        AllocationTracker::reset_violations();
+    }
+};
+
+TEST_F(AllocationTrackerTest, CountsThreadAllocations) {
+    HotRegion region("test");
+    auto value = std::make_unique<int>(42);
+    EXPECT_GE(region.allocations(), 1u);
+    EXPECT_GE(region.bytes(), sizeof(int));
+}
+
+TEST_F(AllocationTrackerTest, ArmedRegionRecordsViolation) {
+    AllocationTracker::arm();
+    {
+        HotRegion region("allocating_region");
+        std::vector<int> values(16);
+    }
+    {
+        HotRegion region("quiet_region");
+    }
+    AllocationTracker::disarm();
+
+    EXPECT_EQ(AllocationTracker::violation_count(), 1u);
+    ASSERT_NE(AllocationTracker::last_violation(), nullptr);
+    EXPECT_STREQ(AllocationTracker::last_violation(), "allocating_region");
+}
+
+// Steady-state engine workload: every cycle rests a ladder of orders on both
+// sides, sweeps part of it with crossing orders (full and partial fills), then
+// cancels what is left. Each cycle returns the book to the same shape, so
+// after warm-up every container is at its high-water mark.
+// Orders released on another thread go back to the pool they came from
+TEST_F(AllocationTrackerTest, OrdersReleasedElsewhereAreReused) {
+    std::thread entering([] {
+        std::vector<std::unique_ptr<Order>> orders;
+        for (int round = 0; round < 3; ++round) {
+            HotRegion region("entering");
+            for (uint64_t i = 0; i < 10000; ++i) {
+                orders.push_back(std::make_unique<Order>(i, 1, "BTC-USD", Side::BUY, 100.0, 1));
+            }
+            if (round > 0) {
+                EXPECT_EQ(region.allocations(), 0u) << "round " << round;
+            }
+            std::thread releasing([&orders] {
+                for (auto& order : orders) {
+                    order.reset();
+                }
+            });
+            releasing.join();
+            orders.clear();
+        }
+    });
+    entering.join();
+}
+
+class HotPathAllocationTest : public ::testing::TestWithParam<BookType> {
+protected:
+    void SetUp() override {
+        engine = std::make_unique<MatchingEngine>(GetParam());
+        resting_ids.reserve(256);
+        engine->set_trade_callback([this](const Trade&) { trades_seen++; });
+    }
+
+    void TearDown() override {
+        AllocationTracker::disarm();
+        AllocationTracker::reset_violations();
+    }
+
+    void run_cycle() {
+        resting_ids.clear();
+        for (int level = 0; level < 10; ++level) {
+            for (int i = 0; i < 5; ++i) {
+                resting_ids.push_back(engine->submit_order(1, "BTC-USD", Side::BUY, 99.90 - level * 0.01, 10));
+                resting_ids.push_back(engine->submit_order(2, "BTC-USD", Side::SELL, 100.10 + level * 0.01, 10));
+            }
+        }
+
+        // Sweep three ask levels and part of a fourth, then the same on the bids
+        engine->submit_order(3, "BTC-USD", Side::BUY, 100.13, 175);
+        engine->submit_order(3, "BTC-USD", Side::SELL, 99.87, 175);
+
+        for (uint64_t order_id : resting_ids) {
+            engine->cancel_order(order_id);
+        }
+    }
+
+    std::unique_ptr<MatchingEngine> engine;
+    std::vector<uint64_t> resting_ids;
+    uint64_t trades_seen{0};
+};
+
+TEST_P(HotPathAllocationTest, SteadyStateMatchingDoesNotAllocate) {
+    for (int cycle = 0; cycle < 5; ++cycle) {
+        run_cycle();
+    }
+    uint64_t warm_trades = trades_seen;
+
+    AllocationTracker::arm();
+    uint64_t allocations = 0;
+    {
+        HotRegion region("steady_state_cycles");
+        for (int cycle = 0; cycle < 50; ++cycle) {
+            run_cycle();
+        }
+        allocations = region.allocations();
+    }
+    AllocationTracker::disarm();
+
+    EXPECT_EQ(trades_seen - warm_trades, 50u * 2u * 18u);
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(AllocationTracker::violation_count(), 0u)
+        << "last allocating region: " << AllocationTracker::last_violation();
+    EXPECT_EQ(engine->get_stats().active_orders, 0u);
+}
+
+TEST_P(HotPathAllocationTest, IcebergReplenishmentDoesNotAllocate) {
+    // Each cycle rests an iceberg and takes it in several slices
+    auto iceberg_cycle = [this] {
+        uint64_t iceberg = engine->submit_iceberg_order(1, "BTC-USD", Side::BUY, 99.95, 100, 10);
+        resting_ids.clear();
+        resting_ids.push_back(engine->submit_order(2, "BTC-USD", Side::BUY, 99.95, 10));
+        for (int i = 0; i < 4; ++i) {
+            engine->submit_order(3, "BTC-USD", Side::SELL, 99.95, 15);
+        }
+        engine->cancel_order(iceberg);
+        engine->cancel_order(resting_ids.front());
+    };
+    for (int cycle = 0; cycle < 5; ++cycle) {
+        iceberg_cycle();
+    }
+    uint64_t warm_trades = trades_seen;
+    uint64_t warm_orders = engine->get_stats().total_orders;
+
+    AllocationTracker::arm();
+    uint64_t allocations = 0;
+    {
+        HotRegion region("iceberg_cycles");
+        for (int cycle = 0; cycle < 50; ++cycle) {
+            iceberg_cycle();
+        }
+        allocations = region.allocations();
+    }
+    AllocationTracker::disarm();
+
+    // Replenishing reuses the order: 6 submits per cycle, however many slices
+    EXPECT_EQ(engine->get_stats().total_orders - warm_orders, 50u * 6u);
+    EXPECT_GT(trades_seen - warm_trades, 50u * 6u);
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(engine->get_stats().active_orders, 0u);
+}
+
+TEST_P(HotPathAllocationTest, PublishingBookViewsDoesNotAllocate) {
+    // Heap books refuse a view, so turning views on costs them nothing
+    ASSERT_TRUE(engine->set_book_views(5));
+    for (int cycle = 0; cycle < 5; ++cycle) {
+        run_cycle();
+    }
+
+    AllocationTracker::arm();
+    uint64_t allocations = 0;
+    {
+        HotRegion region("viewed_cycles");
+        for (int cycle = 0; cycle < 50; ++cycle) {
+            run_cycle();
+        }
+        allocations = region.allocations();
+    }
+    AllocationTracker::disarm();
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(engine->get_bid_volume("BTC-USD"), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllBooks, HotPathAllocationTest,
+                         ::testing::Values(BookType::HEAP, BookType::MAP,
+                                           BookType::INTRUSIVE, BookType::LADDER),
+                         [](const ::testing::TestParamInfo<BookType>& info) {
+                             return to_string(info.param);
+                         });
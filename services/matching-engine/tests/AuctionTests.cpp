@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "core/Auction.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace quasar;
+
+TEST(AuctionCalculatorTest, MaximisesVolumeThenMinimisesImbalance) {
+    AuctionCalculator calculator;
+    std::vector<BookLevel> bids{{101.0, 10, 1}, {100.0, 20, 2}};
+    std::vector<BookLevel> asks{{99.0, 15, 1}, {100.0, 10, 1}};
+
+    // 99: 30 vs 15, 100: 30 vs 25, 101: 10 vs 25
+    AuctionResult result = calculator.compute(bids, asks, 1.0, 0.0);
+    EXPECT_TRUE(calculator.last_was_dense());
+    EXPECT_EQ(result.price, 100.0);
+    EXPECT_EQ(result.volume, 25);
+    EXPECT_EQ(result.imbalance, 5);
+    EXPECT_EQ(result.imbalance_side, Side::BUY);
+
+    // Nothing crosses
+    EXPECT_EQ(calculator.compute({{98.0, 5, 1}}, {{99.0, 5, 1}}, 0.01, 0.0).volume, 0);
+}
+
+TEST(AuctionCalculatorTest, ReferencePriceBreaksRemainingTies) {
+    AuctionCalculator calculator;
+    std::vector<BookLevel> bids{{101.0, 10, 1}};
+    std::vector<BookLevel> asks{{100.0, 10, 1}};
+
+    EXPECT_EQ(calculator.compute(bids, asks, 0.01, 0.0).price, 100.0);
+    EXPECT_EQ(calculator.compute(bids, asks, 0.01, 100.9).price, 101.0);
+    EXPECT_EQ(calculator.compute(bids, asks, 0.0, 100.9).price, 101.0);
+    EXPECT_FALSE(calculator.last_was_dense());
+}
+
+TEST(AuctionCalculatorTest, DenseAndSparsePathsAgree) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> tick_dist(0, 200);
+    std::uniform_int_distribution<uint64_t> quantity_dist(1, 50);
+    std::uniform_int_distribution<int> level_count(1, 60);
+    AuctionCalculator dense;
+    AuctionCalculator sparse;
+    int dense_runs = 0;
+
+    for (int round = 0; round < 200; ++round) {
+        // Distinct ticks per side, best first; asks start low so most books cross
+        std::vector<int> bid_ticks;
+        std::vector<int> ask_ticks;
+        for (int i = level_count(rng); i > 0; --i) {
+            bid_ticks.push_back(tick_dist(rng) + 50);
+            ask_ticks.push_back(tick_dist(rng));
+        }
+        std::sort(bid_ticks.rbegin(), bid_ticks.rend());
+        std::sort(ask_ticks.begin(), ask_ticks.end());
+        bid_ticks.erase(std::unique(bid_ticks.begin(), bid_ticks.end()), bid_ticks.end());
+        ask_ticks.erase(std::unique(ask_ticks.begin(), ask_ticks.end()), ask_ticks.end());
+
+        // Only the crossed range is handed over, as the book does
+        std::vector<BookLevel> bids;
+        std::vector<BookLevel> asks;
+        for (int tick : bid_ticks) {
+            if (tick >= ask_ticks.front()) {
+                bids.push_back({100.0 + tick * 0.01, quantity_dist(rng), 1});
+            }
+        }
+        for (int tick : ask_ticks) {
+            if (tick <= bid_ticks.front()) {
+                asks.push_back({100.0 + tick * 0.01, quantity_dist(rng), 1});
+            }
+        }
+        double reference = 100.0 + tick_dist(rng) * 0.01;
+
+        AuctionResult a = dense.compute(bids, asks, 0.01, reference);
+        AuctionResult b = sparse.compute(bids, asks, 0.0, reference);
+        dense_runs += dense.last_was_dense();
+        EXPECT_EQ(a.price, b.price);
+        EXPECT_EQ(a.volume, b.volume);
+        EXPECT_EQ(a.imbalance, b.imbalance);
+        EXPECT_EQ(a.imbalance_side, b.imbalance_side);
+    }
+    EXPECT_GT(dense_runs, 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "core/BookPolicies.h"
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace quasar {
+
+// Test helper: a book's levels as comparable (price, quantity, order count)
+// tuples, so two books' depth can be checked with one EXPECT_EQ
+using Levels = std::vector<std::tuple<double, uint64_t, uint32_t>>;
+
+inline Levels levels(const std::vector<BookLevel>& book) {
+    Levels out;
+    for (const BookLevel& level : book) {
+        out.emplace_back(level.price, level.quantity, level.order_count);
+    }
+    return out;
+}
+
+} // namespace quasar
@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+#include "core/MatchingEngine.h"
+#include "PinnedReader.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+void expect_same_levels(const std::vector<BookLevel>& actual, const std::vector<BookLevel>& expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].price, expected[i].price);
+        EXPECT_EQ(actual[i].quantity, expected[i].quantity);
+        EXPECT_EQ(actual[i].order_count, expected[i].order_count);
+    }
+}
+
+} // namespace
+
+TEST(BookViewTest, ViewsAnswerLikeTheBook) {
+    for (BookType type : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        SCOPED_TRACE(to_string(type));
+        MatchingEngine viewed(type);
+        MatchingEngine locked(type);
+        viewed.submit_order(1, "BTC-USD", Side::BUY, 90.0, 1);  // a book before views are on
+        locked.submit_order(1, "BTC-USD", Side::BUY, 90.0, 1);
+        ASSERT_TRUE(viewed.set_book_views(5));
+        EXPECT_FALSE(viewed.set_book_views(8));
+        EXPECT_EQ(viewed.get_book_view_depth(), 5);
+
+        std::mt19937 rng(7);
+        std::vector<uint64_t> resting;
+        for (int i = 0; i < 2000; ++i) {
+            if (i % 5 == 4 && !resting.empty()) {
+                size_t pick = rng() % resting.size();
+                viewed.cancel_order(resting[pick]);
+                locked.cancel_order(resting[pick]);
+                resting[pick] = resting.back();
+                resting.pop_back();
+            } else {
+                Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+                double price = 95.0 + static_cast<double>(rng() % 11);
+                uint64_t quantity = 1 + rng() % 20;
+                uint64_t order_id = viewed.submit_order(2, "BTC-USD", side, price, quantity);
+                ASSERT_EQ(locked.submit_order(2, "BTC-USD", side, price, quantity), order_id);
+                resting.push_back(order_id);
+            }
+            if (i % 50 == 0) {
+                EXPECT_EQ(viewed.get_best_bid("BTC-USD"), locked.get_best_bid("BTC-USD"));
+                EXPECT_EQ(viewed.get_best_ask("BTC-USD"), locked.get_best_ask("BTC-USD"));
+                EXPECT_EQ(viewed.get_spread("BTC-USD"), locked.get_spread("BTC-USD"));
+                expect_same_levels(viewed.get_bid_levels("BTC-USD", 5), locked.get_bid_levels("BTC-USD", 5));
+                expect_same_levels(viewed.get_ask_levels("BTC-USD", 3), locked.get_ask_levels("BTC-USD", 3));
+                EXPECT_EQ(viewed.get_bid_volume("BTC-USD"), locked.get_bid_volume("BTC-USD"));
+                EXPECT_EQ(viewed.get_ask_volume("BTC-USD"), locked.get_ask_volume("BTC-USD"));
+                EXPECT_EQ(viewed.get_last_trade_price("BTC-USD"), locked.get_last_trade_price("BTC-USD"));
+            }
+        }
+        // Deeper than the view: answered by the book
+        expect_same_levels(viewed.get_bid_levels("BTC-USD", 20), locked.get_bid_levels("BTC-USD", 20));
+        EXPECT_EQ(viewed.get_best_bid("NONE"), 0.0);
+        EXPECT_TRUE(viewed.get_ask_levels("NONE").empty());
+    }
+}
+
+TEST(BookViewTest, OnlyHeapBooksRefuseAView) {
+    for (BookType type : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        SCOPED_TRACE(to_string(type));
+        auto book = make_order_book("BTC-USD", type);
+        bool heap = type == BookType::HEAP;
+        EXPECT_EQ(book->enable_view(5), !heap);
+        EXPECT_EQ(book->view() == nullptr, heap);
+    }
+}
+
+TEST(BookViewTest, ChangesBelowTheViewOnlyMoveVolume) {
+    MatchingEngine engine;
+    ASSERT_TRUE(engine.set_book_views(2));
+    engine.submit_order(1, "BTC-USD", Side::BUY, 100.0, 10);
+    engine.submit_order(1, "BTC-USD", Side::BUY, 99.0, 10);
+    std::vector<BookLevel> before = engine.get_bid_levels("BTC-USD", 2);
+
+    uint64_t deep = engine.submit_order(1, "BTC-USD", Side::BUY, 90.0, 5);
+    expect_same_levels(engine.get_bid_levels("BTC-USD", 2), before);
+    EXPECT_EQ(engine.get_bid_volume("BTC-USD"), 25);
+    EXPECT_EQ(engine.get_bid_levels("BTC-USD", 3).size(), 3);
+
+    // Taking out a published level pulls the next one up
+    engine.submit_order(2, "BTC-USD", Side::SELL, 99.0, 20);
+    std::vector<BookLevel> after = engine.get_bid_levels("BTC-USD", 2);
+    ASSERT_EQ(after.size(), 1);
+    EXPECT_EQ(after[0].price, 90.0);
+    EXPECT_EQ(engine.get_last_trade_price("BTC-USD"), 99.0);
+    EXPECT_TRUE(engine.cancel_order(deep));
+    EXPECT_EQ(engine.get_best_bid("BTC-USD"), 0.0);
+    EXPECT_EQ(engine.get_bid_volume("BTC-USD"), 0);
+}
+
+TEST(BookViewTest, PinnedReaderHoldsBackThePublish) {
+    MatchingEngine engine;
+    engine.submit_order(1, "BTC-USD", Side::BUY, 100.0, 10);
+    ASSERT_TRUE(engine.set_book_views(4));
+    EXPECT_EQ(engine.refresh_book_views(), 0);
+
+    {
+        // May still be reading the buffer the next publish would reuse
+        PinnedReader reader(BookReplica::domain());
+        engine.submit_order(1, "BTC-USD", Side::BUY, 101.0, 10);
+        EXPECT_EQ(engine.get_best_bid("BTC-USD"), 100.0);
+        EXPECT_EQ(engine.refresh_book_views(), 1);
+        EXPECT_EQ(engine.refresh_book_views(), 1);  // still held back, so queued again
+        engine.submit_order(1, "ETH-USD", Side::SELL, 10.0, 10);
+        engine.submit_order(1, "BTC-USD", Side::BUY, 102.0, 10);
+        EXPECT_EQ(engine.refresh_book_views(), 2);
+    }
+    EXPECT_EQ(engine.refresh_book_views(), 0);
+    EXPECT_EQ(engine.get_best_bid("BTC-USD"), 102.0);
+    EXPECT_EQ(engine.get_best_ask("ETH-USD"), 10.0);
+    EXPECT_EQ(engine.get_bid_volume("BTC-USD"), 30);
+}
+
+TEST(BookViewTest, ConcurrentReadersNeverSeeATornView) {
+    MatchingEngine engine;
+    ASSERT_TRUE(engine.set_book_views(5));
+    engine.submit_order(1, "BTC-USD", Side::BUY, 99.0, 1000000);
+    engine.submit_order(1, "BTC-USD", Side::SELL, 101.0, 1000000);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> bad_reads{0};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                std::vector<BookLevel> bids = engine.get_bid_levels("BTC-USD", 5);
+                double spread = engine.get_spread("BTC-USD");  // both sides from one view
+                bool ordered = !bids.empty();
+                for (size_t i = 1; i < bids.size(); ++i) {
+                    ordered = ordered && bids[i].price < bids[i - 1].price && bids[i].quantity > 0;
+                }
+                if (!ordered || spread <= 0.0) {
+                    bad_reads++;
+                }
+                reads++;
+            }
+        });
+    }
+
+    // Rest and trade through levels between the anchors
+    std::mt19937 rng(11);
+    for (int i = 0; i < 20000; ++i) {
+        Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+        double price = 99.0 + 0.25 * static_cast<double>(rng() % 9);
+        engine.submit_order(2, "BTC-USD", side, price, 1 + rng() % 5);
+        if (i % 1000 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(bad_reads.load(), 0);
+    EXPECT_GT(reads.load(), 0);
+    EXPECT_EQ(engine.refresh_book_views(), 0);
+    std::vector<BookLevel> book = engine.get_bid_levels("BTC-USD", 50);
+    book.resize(std::min<size_t>(book.size(), 5));
+    expect_same_levels(engine.get_bid_levels("BTC-USD", 5), book);
+}
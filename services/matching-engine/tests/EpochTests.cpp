@@ -0,0 +1,255 @@
+#include "gtest/gtest.h"
+#include "core/Epoch.h"
+#include "core/MatchingEngine.h"
+#include "PinnedReader.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+std::atomic<int> g_freed{0};
+
+struct Tracked {
+    uint64_t value{0};
+    ~Tracked() { g_freed.fetch_add(1); }
+};
+
+// Retired nodes are poisoned and kept, not deleted, so a reader reaching one
+// after it was freed shows up as a bad value rather than a crash
+struct Node {
+    std::atomic<uint64_t> value{0};
+};
+
+constexpr uint64_t kPoison = UINT64_MAX;
+std::mutex g_graveyard_mutex;
+std::vector<Node*> g_graveyard;
+
+void poison(void* object) {
+    Node* node = static_cast<Node*>(object);
+    node->value = kPoison;
+    std::lock_guard<std::mutex> lock(g_graveyard_mutex);
+    g_graveyard.push_back(node);
+}
+
+} // namespace
+
+TEST(EpochTest, RetiredObjectsWaitForReaders) {
+    EpochDomain domain;
+    g_freed = 0;
+
+    // Nobody reading: freed at once
+    domain.retire(new Tracked());
+    EXPECT_EQ(g_freed.load(), 1);
+    EXPECT_EQ(domain.pending(), 0);
+
+    PinnedReader reader(domain);
+    uint64_t epoch = domain.epoch();
+    for (int i = 0; i < 10; ++i) {
+        domain.retire(new Tracked());
+    }
+    for (int i = 0; i < 10; ++i) {
+        domain.collect();
+    }
+    EXPECT_EQ(g_freed.load(), 1);
+    EXPECT_EQ(domain.pending(), 10);
+    EXPECT_LE(domain.epoch(), epoch + 1);  // held back by the reader
+
+    reader.leave();
+    EXPECT_TRUE(domain.synchronize());
+    EXPECT_EQ(g_freed.load(), 11);
+    EXPECT_EQ(domain.pending(), 0);
+}
+
+TEST(EpochTest, NestedGuardsPinOnce) {
+    EpochDomain domain;
+    g_freed = 0;
+    {
+        EpochGuard outer(domain);
+        {
+            EpochGuard inner(domain);
+        }
+        // Still inside the outer guard
+        domain.retire(new Tracked());
+        EXPECT_EQ(g_freed.load(), 0);
+        EXPECT_FALSE(domain.synchronize());
+    }
+    EXPECT_TRUE(domain.synchronize());
+    EXPECT_EQ(g_freed.load(), 1);
+}
+
+TEST(EpochTest, QuiescedOnceReadersOfAnEpochLeave) {
+    EpochDomain domain;
+    uint64_t since = domain.epoch();
+    EXPECT_TRUE(domain.quiesced(since));  // nobody reading
+
+    PinnedReader reader(domain);
+    EXPECT_FALSE(domain.quiesced(since));
+    EXPECT_FALSE(domain.quiesced(since));
+    {
+        // A reader pinned later does not hold back an earlier stamp
+        PinnedReader late(domain);
+        reader.leave();
+        EXPECT_TRUE(domain.quiesced(since));
+    }
+    EXPECT_TRUE(domain.quiesced(domain.epoch()));
+}
+
+TEST(EpochTest, ExitedThreadsHandOverWhatTheyRetired) {
+    EpochDomain domain;
+    g_freed = 0;
+    {
+        PinnedReader reader(domain);
+        std::thread writer([&domain] {
+            for (int i = 0; i < 5; ++i) {
+                domain.retire(new Tracked());
+            }
+        });
+        writer.join();
+        EXPECT_EQ(domain.pending(), 5);
+    }
+    // The writer's record is free again and its objects are the domain's
+    EXPECT_TRUE(domain.synchronize());
+    EXPECT_EQ(g_freed.load(), 5);
+
+    // Destroying the domain frees whatever is still retired
+    g_freed = 0;
+    {
+        EpochDomain scoped;
+        PinnedReader reader(scoped);
+        scoped.retire(new Tracked());
+        reader.leave();
+    }
+    EXPECT_EQ(g_freed.load(), 1);
+}
+
+TEST(EpochTest, ReadersNeverSeeAFreedObject) {
+    EpochDomain domain;
+    std::atomic<Node*> current{new Node()};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> bad_reads{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                EpochGuard guard(domain);
+                if (current.load()->value.load() == kPoison) {
+                    bad_reads++;
+                }
+                reads++;
+            }
+        });
+    }
+    for (uint64_t i = 1; i <= 20000; ++i) {
+        Node* next = new Node();
+        next->value = i;
+        domain.retire(current.exchange(next), poison);
+        if (i % 1000 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    EXPECT_TRUE(domain.synchronize());
+    EXPECT_EQ(bad_reads.load(), 0);
+    EXPECT_GT(reads.load(), 0);
+    EXPECT_EQ(domain.pending(), 0);
+
+    std::lock_guard<std::mutex> lock(g_graveyard_mutex);
+    EXPECT_EQ(g_graveyard.size(), 20000);
+    for (Node* node : g_graveyard) {
+        delete node;
+    }
+    g_graveyard.clear();
+    delete current.load();
+}
+
+TEST(EpochTest, BookOrdersOutliveGuardedReaders) {
+    MatchingEngine engine;
+    uint64_t order_id = engine.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+    EpochDomain& global = EpochDomain::global();
+    ASSERT_TRUE(global.synchronize());
+    uint64_t pending = global.pending();
+
+    // While a reader is pinned the filled order is retired, not freed
+    {
+        PinnedReader reader(global);
+        engine.submit_order(2, "BTC-USD", Side::BUY, 100.0, 10);
+        EXPECT_EQ(global.pending(), pending + 1);
+        EXPECT_EQ(engine.get_stats().active_orders, 0);
+    }
+    EXPECT_TRUE(global.synchronize());
+    EXPECT_EQ(global.pending(), pending);
+    EXPECT_NE(order_id, 0);
+}
+
+namespace {
+
+// Order n of the race below rests n % 50 + 1 at 100 + n % 10 ticks, so a
+// RESTED read from a freed order that the pool handed to a later one shows
+// the wrong size or price
+uint64_t race_quantity(uint64_t sequence) { return sequence % 50 + 1; }
+double race_price(uint64_t sequence) { return 100.0 + static_cast<double>(sequence % 10) * 0.01; }
+
+// Counts RESTED events that do not show the order as entered
+struct RestedChecker {
+    std::atomic<uint64_t> rested{0};
+    std::atomic<uint64_t> bad{0};
+
+    void on_events(const EngineEvent* events, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (events[i].type != EngineEventType::RESTED) {
+                continue;
+            }
+            rested++;
+            uint64_t sequence = order_id_sequence(events[i].order_id);
+            if (events[i].price != race_price(sequence) || events[i].quantity != race_quantity(sequence)) {
+                bad++;
+            }
+        }
+    }
+};
+
+} // namespace
+
+TEST(EpochTest, RestedEventsSurviveConcurrentCancels) {
+    MatchingEngine engine;
+    RestedChecker checker;
+    engine.subscribe_events(checker);
+
+    // The canceller chases the newest order while the entering thread is
+    // still building its RESTED event
+    std::atomic<uint64_t> latest{0};
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> cancelled{0};
+    std::thread canceller([&] {
+        uint64_t last = 0;
+        while (!done.load()) {
+            uint64_t order_id = latest.load();
+            if (order_id != last && engine.cancel_order(order_id)) {
+                cancelled++;
+            }
+            last = order_id;
+        }
+    });
+    for (uint64_t sequence = 1; sequence <= 20000; ++sequence) {
+        latest = engine.submit_order(1, "BTC-USD", Side::BUY, race_price(sequence), race_quantity(sequence));
+        if (sequence % 1000 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    canceller.join();
+
+    EXPECT_EQ(checker.bad.load(), 0);
+    EXPECT_GT(checker.rested.load(), 0);
+    EXPECT_GT(cancelled.load(), 0);
+    engine.unsubscribe_events(&checker);
+}
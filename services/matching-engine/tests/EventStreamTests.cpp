@@ -0,0 +1,300 @@
+#include "gtest/gtest.h"
+#include "core/EventStream.h"
+#include "core/MatchingEngine.h"
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+struct RecordingSink {
+    std::vector<EngineEvent> events;
+    size_t spans{0};
+
+    void on_events(const EngineEvent* begin, size_t count) {
+        events.insert(events.end(), begin, begin + count);
+        spans++;
+    }
+
+    std::vector<EngineEventType> types_from(size_t first) const {
+        std::vector<EngineEventType> types;
+        for (size_t i = first; i < events.size(); ++i) {
+            types.push_back(events[i].type);
+        }
+        return types;
+    }
+};
+
+using T = EngineEventType;
+
+} // namespace
+
+TEST(EventStreamTest, RingDropsWhenFullAndTheGapShows) {
+    EventStream stream;
+    EventRing ring(3);
+    EXPECT_EQ(ring.capacity(), 4);
+    EXPECT_FALSE(stream.active());
+    stream.subscribe(ring);
+    EXPECT_TRUE(stream.active());
+
+    std::vector<EngineEvent> span(6);
+    stream.publish(span.data(), span.size());
+    EXPECT_EQ(ring.dropped(), 2);
+
+    std::vector<EngineEvent> out(8);
+    SequenceGapDetector detector;
+    ASSERT_EQ(ring.poll(out.data(), out.size()), 4);
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_TRUE(detector.check(out[i]));
+    }
+
+    // Sequences 5 and 6 never reached the ring
+    stream.publish(span.data(), 2);
+    ASSERT_EQ(ring.poll(out.data(), out.size()), 2);
+    EXPECT_FALSE(detector.check(out[0]));
+    EXPECT_TRUE(detector.check(out[1]));
+    EXPECT_EQ(out[0].sequence, 7);
+    EXPECT_EQ(detector.gaps(), 1);
+    EXPECT_EQ(detector.missed(), 2);
+    EXPECT_EQ(stream.last_sequence(), 8);
+
+    stream.unsubscribe(&ring);
+    EXPECT_FALSE(stream.active());
+}
+
+TEST(EventStreamTest, EngineReportsTheOrderLifecycle) {
+    MatchingEngine engine;
+    RecordingSink sink;
+    engine.submit_order(1, "ETH-USD", Side::BUY, 10.0, 1);  // before anyone listens
+    engine.subscribe_events(sink);
+
+    uint64_t sell = engine.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+    ASSERT_EQ(sink.types_from(0), (std::vector<T>{T::ACCEPTED, T::RESTED, T::BOOK_DELTA}));
+    EXPECT_EQ(engine.get_symbol_name(sink.events[0].symbol_id), "BTC-USD");
+    EXPECT_EQ(sink.events[1].order_id, sell);
+    EXPECT_EQ(sink.events[1].quantity, 10);
+    EXPECT_EQ(sink.events[2].side, Side::SELL);
+    EXPECT_EQ(sink.events[2].price, 100.0);
+    EXPECT_EQ(sink.events[2].quantity, 10);
+    EXPECT_EQ(sink.events[2].trade_id, 1);  // order count
+
+    // A partial fill: the taker fills, the level shrinks
+    size_t mark = sink.events.size();
+    uint64_t buy = engine.submit_order(2, "BTC-USD", Side::BUY, 100.0, 4);
+    ASSERT_EQ(sink.types_from(mark), (std::vector<T>{T::ACCEPTED, T::FILL, T::BOOK_DELTA}));
+    const EngineEvent& fill = sink.events[mark + 1];
+    EXPECT_EQ(fill.order_id, buy);
+    EXPECT_EQ(fill.client_id, 2);
+    EXPECT_EQ(fill.contra_order_id, sell);
+    EXPECT_EQ(fill.contra_client_id, 1);
+    EXPECT_EQ(fill.side, Side::BUY);
+    EXPECT_EQ(fill.quantity, 4);
+    EXPECT_EQ(fill.detail, kTakerFilled);
+    EXPECT_EQ(sink.events[mark + 2].quantity, 6);
+
+    // Cancel empties the level
+    mark = sink.events.size();
+    ASSERT_TRUE(engine.cancel_order(sell));
+    ASSERT_EQ(sink.types_from(mark), (std::vector<T>{T::CANCELLED, T::BOOK_DELTA}));
+    EXPECT_EQ(sink.events[mark].client_id, 1);
+    EXPECT_EQ(sink.events[mark + 1].quantity, 0);
+
+    // A stop already through its price goes in as a market order; with
+    // nothing to trade against it is cancelled at once
+    mark = sink.events.size();
+    engine.submit_stop_order(3, "BTC-USD", Side::BUY, OrderType::STOP, 90.0, 0.0, 5);
+    ASSERT_EQ(sink.types_from(mark), (std::vector<T>{T::ACCEPTED, T::CANCELLED}));
+    EXPECT_EQ(sink.events[mark].order_type, OrderType::STOP);
+
+    // Rejects say why
+    RiskLimits limits;
+    limits.max_order_quantity = 100;
+    engine.set_risk_limits(limits);
+    mark = sink.events.size();
+    EXPECT_EQ(engine.submit_order(3, "BTC-USD", Side::BUY, 99.0, 101), 0);
+    EXPECT_EQ(engine.submit_order(3, "BTC-USD", Side::BUY, 99.0, 1, TimeInForce::GTD, 0), 0);
+    EXPECT_EQ(engine.submit_peg_order(3, "BTC-USD", Side::BUY, OrderType::PEG_MIDPOINT, 0.0, 5), 0);
+    ASSERT_EQ(sink.types_from(mark), (std::vector<T>{T::REJECTED, T::REJECTED, T::REJECTED}));
+    EXPECT_EQ(sink.events[mark].detail, static_cast<uint8_t>(RejectReason::ORDER_QUANTITY));
+    EXPECT_EQ(sink.events[mark + 1].detail, static_cast<uint8_t>(RejectReason::EXPIRE_TIME));
+    EXPECT_EQ(sink.events[mark + 2].detail, static_cast<uint8_t>(RejectReason::UNPRICED_PEG));
+    EXPECT_NE(sink.events[mark].order_id, 0);
+
+    // Expiry
+    uint64_t gtd = engine.submit_order(4, "BTC-USD", Side::BUY, 99.0, 7, TimeInForce::GTD, 5000);
+    mark = sink.events.size();
+    engine.advance_time(10000);
+    ASSERT_EQ(sink.types_from(mark), (std::vector<T>{T::EXPIRED, T::BOOK_DELTA}));
+    EXPECT_EQ(sink.events[mark].order_id, gtd);
+    EXPECT_EQ(sink.events[mark].client_id, 4);
+
+    // One span per engine call, numbered without gaps
+    for (size_t i = 0; i < sink.events.size(); ++i) {
+        EXPECT_EQ(sink.events[i].sequence, i + 1);
+    }
+    EXPECT_EQ(engine.get_last_event_sequence(), sink.events.size());
+    EXPECT_EQ(sink.spans, 9);
+
+    engine.unsubscribe_events(&sink);
+    size_t total = sink.events.size();
+    engine.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+    EXPECT_EQ(sink.events.size(), total);
+}
+
+// Rebuild every book's levels from BOOK_DELTA events alone, and open orders
+// from the order events, under a mixed workload on every book type
+TEST(EventStreamTest, ReplayMatchesTheBooks) {
+    for (BookType type : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        MatchingEngine engine(type);
+        EventRing ring(1 << 20);
+        engine.subscribe_events(ring);
+
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> action_dist(0, 19);
+        std::uniform_int_distribution<int> tick_dist(-30, 30);
+        std::uniform_int_distribution<uint64_t> quantity_dist(1, 40);
+        const std::vector<std::string> symbols{"BTC-USD", "ETH-USD"};
+        std::vector<uint64_t> ids;
+        for (int i = 0; i < 5000; ++i) {
+            const std::string& symbol = symbols[i % 2];
+            Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+            double price = 100.0 + tick_dist(rng) * 0.5;
+            int action = action_dist(rng);
+            uint64_t id = 0;
+            if (action < 5 && !ids.empty()) {
+                engine.cancel_order(ids[rng() % ids.size()]);
+            } else if (action == 5) {
+                id = engine.submit_iceberg_order(1 + i % 9, symbol, side, price, 50, 10);
+            } else if (action == 6) {
+                id = engine.submit_order(1 + i % 9, symbol, side, price, quantity_dist(rng), TimeInForce::GTD,
+                                         engine.get_time() + 3000);
+            } else if (action == 7) {
+                id = engine.submit_stop_order(1 + i % 9, symbol, side, OrderType::STOP_LIMIT, price, price, 5);
+            } else if (action == 8) {
+                id = engine.submit_stop_order(1 + i % 9, symbol, side, OrderType::STOP, price, 0.0,
+                                              quantity_dist(rng));
+            } else if (action == 9) {
+                MatchingEngine::QuoteEntry quote{symbol, price - 1.0, quantity_dist(rng), price + 1.0, quantity_dist(rng)};
+                engine.mass_quote(100, i, {quote});
+            } else {
+                id = engine.submit_order(1 + i % 9, symbol, side, price, quantity_dist(rng));
+            }
+            if (id != 0) {
+                ids.push_back(id);
+            }
+            if (i % 500 == 0) {
+                engine.advance_time(engine.get_time() + 2000);
+            }
+            if (i == 2500) {
+                engine.start_auction("BTC-USD");
+            } else if (i == 3000) {
+                engine.uncross("BTC-USD");
+            }
+        }
+
+        std::vector<EngineEvent> events(ring.capacity());
+        events.resize(ring.poll(events.data(), events.size()));
+        ASSERT_EQ(ring.dropped(), 0);
+
+        SequenceGapDetector detector;
+        std::map<std::string, std::map<double, uint64_t>> bids, asks;
+        std::map<uint64_t, int64_t> open;  // order id -> quantity not yet filled
+        for (const EngineEvent& event : events) {
+            ASSERT_TRUE(detector.check(event));
+            std::string symbol = engine.get_symbol_name(event.symbol_id);
+            switch (event.type) {
+                case EngineEventType::BOOK_DELTA: {
+                    auto& side = event.side == Side::BUY ? bids[symbol] : asks[symbol];
+                    if (event.quantity == 0) {
+                        side.erase(event.price);
+                    } else {
+                        side[event.price] = event.quantity;
+                    }
+                    break;
+                }
+                case EngineEventType::ACCEPTED:
+                case EngineEventType::RESTED:
+                    open[event.order_id] = static_cast<int64_t>(event.quantity);
+                    break;
+                case EngineEventType::FILL:
+                    open[event.order_id] -= static_cast<int64_t>(event.quantity);
+                    open[event.contra_order_id] -= static_cast<int64_t>(event.quantity);
+                    if (event.detail & kTakerFilled) {
+                        EXPECT_EQ(open[event.order_id], 0);
+                        open.erase(event.order_id);
+                    }
+                    if (event.detail & kMakerFilled) {
+                        EXPECT_EQ(open[event.contra_order_id], 0);
+                        open.erase(event.contra_order_id);
+                    }
+                    break;
+                case EngineEventType::CANCELLED:
+                case EngineEventType::EXPIRED:
+                    EXPECT_EQ(open.erase(event.order_id), 1);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        for (const std::string& symbol : symbols) {
+            std::map<double, uint64_t> expected_bids, expected_asks;
+            for (const BookLevel& level : engine.get_bid_levels(symbol, 1000)) {
+                expected_bids[level.price] = level.quantity;
+            }
+            for (const BookLevel& level : engine.get_ask_levels(symbol, 1000)) {
+                expected_asks[level.price] = level.quantity;
+            }
+            EXPECT_EQ(bids[symbol], expected_bids) << to_string(type) << " " << symbol;
+            EXPECT_EQ(asks[symbol], expected_asks) << to_string(type) << " " << symbol;
+        }
+        EXPECT_EQ(open.size(), engine.get_stats().active_orders) << to_string(type);
+        EXPECT_GT(open.size(), 0);
+    }
+}
+
+TEST(EventStreamTest, OneBookFromTwoThreadsStaysInBookOrder) {
+    MatchingEngine engine;
+    RecordingSink sink;
+    engine.subscribe_events(sink);
+    // Pulling the rest of a partly filled maker takes the book's event lock
+    // again from the trade callback
+    engine.set_trade_callback([&engine](const Trade& trade) {
+        if (!trade.maker_filled && trade.trade_id % 3 == 0) {
+            engine.cancel_order(trade.maker_order_id);
+        }
+    });
+
+    auto trade_against_each_other = [&engine](unsigned seed) {
+        std::mt19937 rng(seed);
+        for (int i = 0; i < 5000; ++i) {
+            Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+            double price = 99.0 + 0.5 * static_cast<double>(rng() % 5);
+            engine.submit_order(seed, "BTC-USD", side, price, 1 + rng() % 10);
+        }
+    };
+    std::thread other(trade_against_each_other, 1);
+    trade_against_each_other(2);
+    other.join();
+    engine.unsubscribe_events(&sink);
+
+    std::set<uint64_t> accepted;
+    size_t fills = 0;
+    for (size_t i = 0; i < sink.events.size(); ++i) {
+        const EngineEvent& event = sink.events[i];
+        ASSERT_EQ(event.sequence, i + 1);
+        if (event.type == T::ACCEPTED) {
+            accepted.insert(event.order_id);
+        } else if (event.type == T::FILL) {
+            fills++;
+            EXPECT_EQ(accepted.count(event.order_id), 1) << "taker " << event.order_id;
+            EXPECT_EQ(accepted.count(event.contra_order_id), 1) << "maker " << event.contra_order_id;
+        }
+    }
+    EXPECT_EQ(accepted.size(), 10000);
+    EXPECT_GT(fills, 0);
+}
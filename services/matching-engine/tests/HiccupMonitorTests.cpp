@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include "common/HiccupMonitor.h"
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace quasar;
+
+TEST(HiccupMonitorTest, RecordedGapsDrivePercentiles) {
+    HiccupMonitor::Config config;
+    config.threshold_ns = 1000;
+    HiccupMonitor monitor(config);
+
+    // 990 quiet reads, 9 medium hiccups, 1 large one
+    for (int i = 0; i < 990; ++i) {
+        monitor.record(40);
+    }
+    for (int i = 0; i < 9; ++i) {
+        monitor.record(50000);
+    }
+    monitor.record(2000000);
+
+    auto report = monitor.report();
+    EXPECT_EQ(report.samples, 1000u);
+    EXPECT_EQ(report.hiccups, 10u);
+    EXPECT_EQ(report.hiccup_time_ns, 9u * 50000u + 2000000u);
+    EXPECT_EQ(report.max_ns, 2000000u);
+
+    // Bucket upper bounds are within 25% of the recorded value
+    EXPECT_GE(report.p50_ns, 40u);
+    EXPECT_LE(report.p50_ns, 50u);
+    EXPECT_GE(report.p999_ns, 50000u);
+    EXPECT_LE(report.p999_ns, 62500u);
+    EXPECT_GE(report.p9999_ns, report.p999_ns);
+
+    monitor.reset();
+    EXPECT_EQ(monitor.report().samples, 0u);
+}
+
+TEST(HiccupMonitorTest, BackgroundThreadSamplesClock) {
+    HiccupMonitor monitor;
+    monitor.start();
+    EXPECT_TRUE(monitor.is_running());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    monitor.stop();
+    EXPECT_FALSE(monitor.is_running());
+
+    auto report = monitor.report();
+    EXPECT_GT(report.samples, 0u);
+    EXPECT_GE(report.max_ns, report.p50_ns);
+
+    std::ostringstream csv;
+    HiccupMonitor::print_csv_header(csv);
+    HiccupMonitor::print_csv_row("test", report, csv);
+    EXPECT_NE(csv.str().find("test,"), std::string::npos);
+}
@@ -162,3 +162,420 @@ TEST_F(MatchingEngineTest, MultipleSymbolsIsolation) {
     // BTC: 1 active (sell @ 50001), ETH: 2 active
     EXPECT_EQ(stats.active_orders, 3);
 }
+
+TEST_F(MatchingEngineTest, OrderIdsRouteToTheirBook) {
+    MatchingEngine shard3(BookType::INTRUSIVE, 3);
+    EXPECT_EQ(shard3.get_shard(), 3);
+    uint64_t btc1 = shard3.submit_order(100, "BTC-USD", Side::BUY, 100.0, 1);
+    uint64_t eth1 = shard3.submit_order(100, "ETH-USD", Side::BUY, 10.0, 1);
+    uint64_t btc2 = shard3.submit_stop_order(100, "BTC-USD", Side::SELL, OrderType::STOP, 90.0, 0.0, 1);
+
+    // Shard, symbol id, then a sequence of the book's own
+    EXPECT_EQ(order_id_shard(btc1), 3);
+    EXPECT_EQ(shard3.get_symbol_name(order_id_symbol(btc1)), "BTC-USD");
+    EXPECT_EQ(shard3.get_symbol_name(order_id_symbol(eth1)), "ETH-USD");
+    EXPECT_EQ(order_id_sequence(btc1), 1);
+    EXPECT_EQ(order_id_sequence(eth1), 1);
+    EXPECT_EQ(order_id_sequence(btc2), 2);
+    EXPECT_EQ(btc2, make_order_id(3, order_id_symbol(btc1), 2));
+
+    // Ids of another shard, of no book, or not issued by the book route nowhere
+    uint64_t local = engine->submit_order(100, "BTC-USD", Side::BUY, 100.0, 1);
+    EXPECT_NE(local, btc1);
+    EXPECT_FALSE(engine->cancel_order(btc1));
+    EXPECT_FALSE(shard3.cancel_order(local));
+    EXPECT_FALSE(shard3.cancel_order(make_order_id(3, 99, 1)));
+    EXPECT_FALSE(shard3.cancel_order(make_order_id(3, order_id_symbol(btc1), 7)));
+
+    // A pending stop cancels through the same route
+    EXPECT_TRUE(shard3.cancel_order(btc2));
+    EXPECT_TRUE(shard3.cancel_order(eth1));
+    EXPECT_TRUE(engine->cancel_order(local));
+    EXPECT_EQ(shard3.get_stats().active_orders, 1);
+    EXPECT_EQ(shard3.get_storage_stats().order_map_entries, 1);
+}
+
+TEST_F(MatchingEngineTest, PerSymbolBookType) {
+    EXPECT_EQ(engine->get_book_type("BTC-USD"), BookType::INTRUSIVE);
+    EXPECT_TRUE(engine->set_book_type("ETH-USD", BookType::LADDER));
+    EXPECT_TRUE(engine->set_book_type("SOL-USD", BookType::HEAP));
+
+    engine->submit_order(100, "ETH-USD", Side::BUY, 4000.0, 10);
+    engine->submit_order(101, "ETH-USD", Side::SELL, 4000.0, 4);
+    engine->submit_order(200, "SOL-USD", Side::SELL, 100.0, 3);
+
+    EXPECT_EQ(engine->get_book_type("ETH-USD"), BookType::LADDER);
+    EXPECT_EQ(engine->get_book_type("SOL-USD"), BookType::HEAP);
+    EXPECT_EQ(engine->get_best_bid("ETH-USD"), 4000.0);
+    EXPECT_EQ(engine->get_best_ask("SOL-USD"), 100.0);
+
+    // Book already exists, so its type is fixed
+    EXPECT_FALSE(engine->set_book_type("ETH-USD", BookType::MAP));
+    EXPECT_EQ(engine->get_stats().total_trades, 1);
+}
+
+TEST_F(MatchingEngineTest, StorageReturnsToEmptyAfterFillsAndCancels) {
+    for (BookType type : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        MatchingEngine engine(type);
+        std::vector<uint64_t> resting;
+        for (int i = 0; i < 200; ++i) {
+            resting.push_back(engine.submit_order(1, "BTC-USD", Side::BUY, 100.0 - (i % 20), 5));
+        }
+        // Fill half of the bids, cancel the rest
+        engine.submit_order(2, "BTC-USD", Side::SELL, 1.0, 500);
+        for (uint64_t order_id : resting) {
+            engine.cancel_order(order_id);
+        }
+
+        auto storage = engine.get_storage_stats();
+        EXPECT_EQ(storage.books, 1u) << to_string(type);
+        EXPECT_EQ(storage.order_map_entries, 0u) << to_string(type);
+        EXPECT_EQ(engine.get_stats().active_orders, 0u) << to_string(type);
+        if (type == BookType::HEAP) {
+            // Lazy cancels: a bounded number of tombstones may wait for compaction
+            EXPECT_LE(storage.book_totals.indexed_orders, 64u);
+            EXPECT_EQ(storage.book_totals.side_entries, storage.book_totals.indexed_orders);
+        } else {
+            EXPECT_EQ(storage.book_totals.indexed_orders, 0u) << to_string(type);
+        }
+        if (type == BookType::MAP || type == BookType::INTRUSIVE) {
+            EXPECT_EQ(storage.book_totals.side_entries, 0u) << to_string(type);
+        }
+    }
+}
+
+TEST_F(MatchingEngineTest, StopOrdersKeepBookkeepingConsistent) {
+    engine->submit_order(100, "BTC-USD", Side::SELL, 100.0, 5);
+    uint64_t stop_id = engine->submit_stop_order(200, "BTC-USD", Side::BUY, OrderType::STOP, 100.0, 0.0, 10);
+    uint64_t cancelled_stop = engine->submit_stop_order(201, "BTC-USD", Side::SELL, OrderType::STOP_LIMIT,
+                                                        90.0, 89.0, 1);
+    EXPECT_EQ(engine->get_stats().active_orders, 3);
+    EXPECT_TRUE(engine->cancel_order(cancelled_stop));
+
+    // Trade at 100 triggers the stop; it takes the remaining 4 and its last 6 expire
+    engine->submit_order(101, "BTC-USD", Side::BUY, 100.0, 1);
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.total_trades, 2);
+    EXPECT_EQ(stats.active_orders, 0);
+    EXPECT_EQ(stats.cancelled_orders, 2);
+    EXPECT_FALSE(engine->cancel_order(stop_id));
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 0);
+}
+
+TEST_F(MatchingEngineTest, PricesOffTheGridAreRejected) {
+    BookConfig config;
+    config.tick_size = 0.5;
+    ASSERT_TRUE(engine->set_book_type("BTC-USD", BookType::LADDER, config));
+    EXPECT_NE(engine->submit_order(100, "BTC-USD", Side::BUY, 100.0, 1), 0);
+    EXPECT_EQ(engine->submit_order(100, "BTC-USD", Side::BUY, 100.25, 1), 0);
+    EXPECT_EQ(engine->submit_stop_order(100, "BTC-USD", Side::SELL, OrderType::STOP_LIMIT, 99.0, 99.75, 1), 0);
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.rejected_orders, 2);
+    EXPECT_EQ(stats.cancelled_orders, 0);
+    EXPECT_EQ(stats.active_orders, 1);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 1);
+}
+
+TEST_F(MatchingEngineTest, PegOrdersKeepBookkeepingConsistent) {
+    // No BBO yet: the peg is rejected, and holds no open order
+    EXPECT_EQ(engine->submit_peg_order(100, "BTC-USD", Side::BUY, OrderType::PEG_MIDPOINT, 0.0, 5), 0);
+    EXPECT_EQ(engine->get_stats().rejected_orders, 1);
+    EXPECT_EQ(engine->get_stats().cancelled_orders, 0);
+    EXPECT_EQ(engine->get_stats().active_orders, 0);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 0);
+
+    engine->submit_order(101, "BTC-USD", Side::BUY, 100.0, 1);
+    engine->submit_order(102, "BTC-USD", Side::SELL, 102.0, 1);
+    engine->submit_peg_order(100, "BTC-USD", Side::BUY, OrderType::PEG_MIDPOINT, 0.0, 5);
+    EXPECT_EQ(engine->get_best_bid("BTC-USD"), 100.0);
+
+    engine->submit_order(103, "BTC-USD", Side::SELL, 101.0, 5);
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.total_trades, 1);
+    EXPECT_EQ(stats.active_orders, 2);
+    EXPECT_EQ(engine->get_storage_stats().book_totals.pegged_orders, 0);
+}
+
+TEST_F(MatchingEngineTest, GtdAndDayOrdersExpireOnTheEngineClock) {
+    std::vector<std::pair<std::string, LevelUpdate>> updates;
+    engine->set_level_update_callback([&updates](const std::string& symbol, const LevelUpdate& update) {
+        updates.emplace_back(symbol, update);
+    });
+    engine->advance_time(1000000);
+    engine->set_session_close(5000000);
+
+    // Expired or missing expiry times are rejected
+    engine->submit_order(100, "BTC-USD", Side::BUY, 99.0, 1, TimeInForce::GTD, 1000000);
+    EXPECT_EQ(engine->get_stats().rejected_orders, 1);
+
+    uint64_t gtd = engine->submit_order(100, "BTC-USD", Side::BUY, 99.0, 1, TimeInForce::GTD, 2000000);
+    engine->submit_order(100, "BTC-USD", Side::BUY, 99.0, 2, TimeInForce::DAY);
+    engine->submit_order(100, "BTC-USD", Side::BUY, 99.0, 3, TimeInForce::DAY);
+    engine->submit_order(100, "BTC-USD", Side::SELL, 101.0, 4, TimeInForce::DAY);
+    engine->submit_order(100, "BTC-USD", Side::BUY, 98.0, 5);
+    uint64_t filled = engine->submit_order(100, "ETH-USD", Side::SELL, 10.0, 1, TimeInForce::DAY);
+    engine->submit_order(101, "ETH-USD", Side::BUY, 10.0, 1);
+
+    EXPECT_EQ(engine->advance_time(1999999), 0u);
+    EXPECT_EQ(engine->advance_time(2000000), 1u);
+    EXPECT_FALSE(engine->cancel_order(gtd));
+    ASSERT_EQ(updates.size(), 1u);
+    EXPECT_EQ(updates[0].second.price, 99.0);
+    EXPECT_EQ(updates[0].second.quantity, 5);
+
+    // Session close: three DAY orders on two levels, one update per level;
+    // the filled DAY order is already gone and the GTC order stays
+    updates.clear();
+    EXPECT_EQ(engine->advance_time(6000000), 3u);
+    ASSERT_EQ(updates.size(), 2u);
+    for (const auto& [symbol, update] : updates) {
+        EXPECT_EQ(symbol, "BTC-USD");
+        EXPECT_EQ(update.quantity, 0);
+    }
+    EXPECT_FALSE(engine->cancel_order(filled));
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.expired_orders, 4);
+    EXPECT_EQ(stats.active_orders, 1);
+    EXPECT_EQ(engine->get_best_bid("BTC-USD"), 98.0);
+    EXPECT_EQ(engine->get_best_ask("BTC-USD"), 0.0);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 1);
+}
+
+TEST_F(MatchingEngineTest, MassQuoteReplacesQuotesInPlace) {
+    auto ack = engine->mass_quote(500, 1, {{"BTC-USD", 99.0, 10, 101.0, 10},
+                                           {"ETH-USD", 9.0, 5, 11.0, 5},
+                                           {"SOL-USD", 2.0, 1, 1.0, 1}});
+    EXPECT_EQ(ack.quote_id, 1);
+    EXPECT_EQ(ack.entries, 3);
+    EXPECT_EQ(ack.rejected_entries, 1);
+    EXPECT_EQ(ack.sides_entered, 4);
+    EXPECT_EQ(engine->get_stats().active_orders, 4);
+    const uint64_t btc_bid = make_order_id(0, 1, 1); // first order of the first book
+
+    // Someone joins the bid behind the quote
+    engine->submit_order(100, "BTC-USD", Side::BUY, 99.0, 4);
+
+    // Shrink the bid in place, move the ask, pull ETH
+    ack = engine->mass_quote(500, 2, {{"BTC-USD", 99.0, 6, 100.5, 8},
+                                      {"ETH-USD", 0.0, 0, 0.0, 0}});
+    EXPECT_EQ(ack.sides_resized, 1);
+    EXPECT_EQ(ack.sides_reentered, 1);
+    EXPECT_EQ(ack.sides_pulled, 2);
+    EXPECT_EQ(ack.sides_entered, 0);
+    EXPECT_EQ(engine->get_best_ask("BTC-USD"), 100.5);
+    EXPECT_EQ(engine->get_best_bid("ETH-USD"), 0.0);
+
+    // The resized bid kept its place ahead of the later order
+    std::vector<Trade> trades;
+    engine->set_trade_callback([&trades](const Trade& trade) { trades.push_back(trade); });
+    engine->submit_order(101, "BTC-USD", Side::SELL, 99.0, 7);
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].maker_order_id, btc_bid);
+    EXPECT_EQ(trades[0].quantity, 6);
+
+    // The filled bid's slot gets a new order on the next quote
+    ack = engine->mass_quote(500, 3, {{"BTC-USD", 98.0, 3, 100.5, 8}});
+    EXPECT_EQ(ack.sides_entered, 1);
+    EXPECT_EQ(ack.sides_resized, 1);
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.total_orders, 7);
+    EXPECT_EQ(stats.active_orders, 3);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 3);
+}
+
+TEST_F(MatchingEngineTest, BatchAuctionsKeepBookkeepingConsistent) {
+    engine->start_auction("BTC-USD");
+    engine->submit_order(100, "BTC-USD", Side::BUY, 101.0, 10);
+    engine->submit_order(101, "BTC-USD", Side::SELL, 100.0, 4);
+    EXPECT_EQ(engine->get_stats().total_trades, 0);
+    EXPECT_EQ(engine->get_indicative_auction("BTC-USD").volume, 4);
+
+    // A batch uncross stays in auction
+    AuctionResult result = engine->uncross("BTC-USD", true);
+    EXPECT_EQ(result.volume, 4);
+    EXPECT_EQ(result.imbalance, 6);
+    engine->submit_order(102, "BTC-USD", Side::SELL, 100.0, 10);
+    EXPECT_EQ(engine->get_stats().total_trades, 1);
+
+    result = engine->uncross("BTC-USD");
+    EXPECT_EQ(result.volume, 6);
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.total_trades, 2);
+    EXPECT_EQ(stats.active_orders, 1);
+    EXPECT_EQ(engine->get_best_ask("BTC-USD"), 100.0);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 1);
+    EXPECT_EQ(engine->uncross("ETH-USD").volume, 0);
+}
+
+TEST_F(MatchingEngineTest, ProRataIsSelectedPerSymbol) {
+    BookConfig pro_rata;
+    pro_rata.matching = MatchingAlgorithm::PRO_RATA;
+    EXPECT_FALSE(engine->set_book_type("ETH-USD", BookType::HEAP, pro_rata));
+    EXPECT_TRUE(engine->set_book_type("BTC-USD", BookType::LADDER, pro_rata));
+
+    for (const std::string symbol : {"BTC-USD", "SOL-USD"}) {
+        engine->submit_order(100, symbol, Side::SELL, 100.0, 10);
+        engine->submit_order(101, symbol, Side::SELL, 100.0, 30);
+    }
+    std::vector<Trade> trades;
+    engine->set_trade_callback([&trades](const Trade& trade) { trades.push_back(trade); });
+
+    // Pro-rata: 10 and 30 share 20 as 5 and 15; FIFO: the first order fills
+    engine->submit_order(102, "BTC-USD", Side::BUY, 100.0, 20);
+    engine->submit_order(102, "SOL-USD", Side::BUY, 100.0, 20);
+    ASSERT_EQ(trades.size(), 4);
+    EXPECT_EQ(trades[0].quantity, 5);
+    EXPECT_EQ(trades[1].quantity, 15);
+    EXPECT_EQ(trades[2].quantity, 10);
+    EXPECT_TRUE(trades[2].maker_filled);
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.active_orders, 3);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, 3);
+}
+
+TEST_F(MatchingEngineTest, QueueIndexQueriesThroughEngine) {
+    BookConfig indexed;
+    indexed.queue_index = true;
+    ASSERT_TRUE(engine->set_book_type("BTC-USD", BookType::LADDER, indexed));
+
+    uint64_t first = engine->submit_order(100, "BTC-USD", Side::BUY, 100.0, 10);
+    uint64_t second = engine->submit_order(101, "BTC-USD", Side::BUY, 100.0, 15);
+    engine->submit_order(102, "BTC-USD", Side::BUY, 100.5, 5);
+    uint64_t unindexed = engine->submit_order(103, "ETH-USD", Side::BUY, 100.0, 5);
+
+    QueuePosition position;
+    ASSERT_TRUE(engine->queue_position(second, position));
+    EXPECT_EQ(position.quantity_ahead, 10);
+    EXPECT_EQ(position.better_quantity, 5);
+    EXPECT_FALSE(engine->queue_position(unindexed, position));
+
+    // Selling 12 takes 5 at 100.5 and 7 from the first order at 100
+    engine->submit_order(104, "BTC-USD", Side::SELL, 100.0, 12);
+    ASSERT_TRUE(engine->queue_position(second, position));
+    EXPECT_EQ(position.quantity_ahead, 3);
+    EXPECT_EQ(position.better_quantity, 0);
+    EXPECT_TRUE(engine->cancel_order(first));
+    ASSERT_TRUE(engine->queue_position(second, position));
+    EXPECT_EQ(position.quantity_ahead, 0);
+
+    uint64_t depth = 0;
+    FillEstimate estimate;
+    ASSERT_TRUE(engine->depth_to_price("BTC-USD", Side::BUY, 100.0, depth));
+    EXPECT_EQ(depth, 15);
+    ASSERT_TRUE(engine->cost_to_fill("BTC-USD", Side::BUY, 10, estimate));
+    EXPECT_DOUBLE_EQ(estimate.notional, 1000.0);
+    EXPECT_FALSE(engine->depth_to_price("ETH-USD", Side::BUY, 100.0, depth));
+}
+
+TEST_F(MatchingEngineTest, RiskLimitsRejectBeforeTheBook) {
+    RiskLimits limits;
+    limits.max_order_quantity = 1000;
+    limits.max_order_notional = 1000000.0;
+    limits.price_collar = 0.05;
+    engine->set_risk_limits(limits);
+    RiskLimits market_maker = limits;
+    market_maker.max_open_orders = 2;
+    engine->set_client_risk_limits(7, market_maker);
+
+    // Size and notional; the first order has no reference to collar against
+    EXPECT_EQ(engine->submit_order(100, "BTC-USD", Side::BUY, 100.0, 1000000000000ULL), 0);
+    EXPECT_EQ(engine->submit_order(100, "BTC-USD", Side::BUY, 5000.0, 201), 0);
+    EXPECT_NE(engine->submit_order(100, "BTC-USD", Side::BUY, 100.0, 10), 0);
+    EXPECT_EQ(engine->get_stats().rejected_orders, 2);
+    EXPECT_EQ(engine->get_bid_levels("BTC-USD").size(), 1);
+
+    // Collar around the best bid, then around the last trade
+    EXPECT_EQ(engine->submit_order(101, "BTC-USD", Side::SELL, 106.0, 5), 0);
+    EXPECT_NE(engine->submit_order(101, "BTC-USD", Side::SELL, 100.0, 5), 0);
+    EXPECT_EQ(engine->submit_order(101, "BTC-USD", Side::BUY, 94.0, 5), 0);
+    EXPECT_NE(engine->submit_order(101, "BTC-USD", Side::BUY, 96.0, 5), 0);
+
+    // Open orders per client: fills, cancels and expiries all free a place
+    uint64_t first = engine->submit_order(7, "BTC-USD", Side::SELL, 102.0, 5);
+    uint64_t second = engine->submit_order(7, "BTC-USD", Side::SELL, 103.0, 5);
+    EXPECT_EQ(engine->submit_order(7, "BTC-USD", Side::SELL, 104.0, 5), 0);
+    EXPECT_EQ(engine->get_open_order_count(7), 2);
+    EXPECT_TRUE(engine->cancel_order(second));
+    EXPECT_NE(engine->submit_order(7, "BTC-USD", Side::SELL, 104.0, 5), 0);
+    engine->submit_order(100, "BTC-USD", Side::BUY, 102.0, 5);
+    EXPECT_EQ(engine->get_open_order_count(7), 1);
+    EXPECT_NE(first, 0);
+
+    // Mass quotes: a side out of the collar rejects the entry
+    auto ack = engine->mass_quote(8, 1, {{"BTC-USD", 99.0, 5, 120.0, 5}});
+    EXPECT_EQ(ack.rejected_entries, 1);
+    ack = engine->mass_quote(8, 2, {{"BTC-USD", 99.0, 5, 103.0, 5}});
+    EXPECT_EQ(ack.sides_entered, 2);
+    EXPECT_EQ(engine->get_open_order_count(8), 2);
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.rejected_orders, 6);
+    EXPECT_EQ(stats.total_orders, 14);
+    EXPECT_EQ(engine->get_storage_stats().order_map_entries, stats.active_orders);
+}
+
+TEST_F(MatchingEngineTest, RejectedOrdersTakeNoSymbolId) {
+    RiskLimits limits;
+    limits.max_order_quantity = 1000;
+    limits.price_collar = 0.05;
+    limits.max_open_orders = 1;
+    engine->set_risk_limits(limits);
+
+    // Nothing to collar against yet: size and open orders still reject
+    EXPECT_EQ(engine->submit_order(1, "AAA-USD", Side::BUY, 100.0, 5000), 0);
+    EXPECT_EQ(engine->mass_quote(2, 1, {{"BBB-USD", 99.0, 5000, 101.0, 5}}).rejected_entries, 1);
+    uint64_t resting = engine->submit_order(3, "CCC-USD", Side::BUY, 100.0, 5);
+    EXPECT_EQ(engine->submit_order(3, "DDD-USD", Side::BUY, 100.0, 5), 0);
+    EXPECT_EQ(engine->get_all_symbols(), std::vector<std::string>{"CCC-USD"});
+    EXPECT_EQ(order_id_symbol(resting), 1);
+    EXPECT_EQ(order_id_symbol(engine->submit_order(4, "EEE-USD", Side::BUY, 100.0, 5)), 2);
+
+    auto stats = engine->get_stats();
+    EXPECT_EQ(stats.rejected_orders, 3);
+    EXPECT_EQ(stats.total_orders, 4);
+}
+
+TEST_F(MatchingEngineTest, WarmingLeavesNoTrace) {
+    for (BookType type : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        MatchingEngine warmed(type);
+        std::vector<EngineEvent> events;
+        struct Sink {
+            std::vector<EngineEvent>* events;
+            void on_events(const EngineEvent* begin, size_t count) { events->insert(events->end(), begin, begin + count); }
+        } sink{&events};
+        warmed.subscribe_events(sink);
+        size_t trades = 0;
+        warmed.set_trade_callback([&trades](const Trade&) { trades++; });
+
+        warmed.warm();  // no books yet
+        uint64_t first = warmed.submit_order(1, "BTC-USD", Side::SELL, 100.0, 5);
+        warmed.submit_order(1, "BTC-USD", Side::BUY, 99.0, 5);
+        warmed.submit_order(2, "ETH-USD", Side::SELL, 10.0, 5);
+        auto before = warmed.get_stats();
+        size_t events_before = events.size();
+
+        for (int i = 0; i < 10; ++i) {
+            warmed.warm(1);
+        }
+        EXPECT_EQ(warmed.get_warm_passes(), 11);
+        EXPECT_EQ(events.size(), events_before);
+        EXPECT_EQ(trades, 0);
+        auto after = warmed.get_stats();
+        EXPECT_EQ(after.total_orders, before.total_orders);
+        EXPECT_EQ(after.active_orders, before.active_orders);
+        EXPECT_EQ(after.total_trades, before.total_trades);
+        EXPECT_EQ(warmed.get_all_symbols().size(), 2);
+        EXPECT_EQ(warmed.get_ask_levels("BTC-USD").size(), 1);
+        EXPECT_EQ(warmed.get_bid_levels("BTC-USD").size(), 1);
+
+        // Ids carry on from where they were
+        uint64_t taker = warmed.submit_order(3, "BTC-USD", Side::BUY, 100.0, 5);
+        EXPECT_EQ(order_id_sequence(taker), order_id_sequence(first) + 2);
+        EXPECT_EQ(trades, 1);
+    }
+}
@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "core/OrderBook.h"
 #include "core/Order.h"
+#include <random>
+#include <type_traits>
 
 using namespace quasar;
 
@@ -65,6 +67,585 @@ TEST_F(OrderBookTest, SimpleMatch) {
     EXPECT_EQ(orderBook->get_best_ask(), 0.0); // The sell order should be fully filled
 }
 
+// Test fixture running the same scenarios against every book policy
+template<typename Book>
+class BookPolicyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        book = std::make_unique<Book>("BTC-USD");
+    }
+
+    std::unique_ptr<Book> book;
+};
+
+using BookPolicies = ::testing::Types<HeapOrderBook, MapOrderBook, IntrusiveOrderBook, LadderOrderBook>;
+TYPED_TEST_SUITE(BookPolicyTest, BookPolicies);
+
+// Test price priority across levels and time priority within a level
+TYPED_TEST(BookPolicyTest, PriceTimePriority) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 50001.0, 5));
+    this->book->add_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::SELL, 50000.0, 5));
+    this->book->add_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 50000.0, 5));
+
+    auto trades = this->book->process_order(
+        std::make_unique<Order>(4, 103, "BTC-USD", Side::BUY, 50001.0, 12));
+
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].maker_order_id, 2);
+    EXPECT_EQ(trades[1].maker_order_id, 3);
+    EXPECT_EQ(trades[2].maker_order_id, 1);
+    EXPECT_EQ(trades[2].quantity, 2);
+    EXPECT_EQ(trades[2].price, 50001.0);
+    EXPECT_EQ(this->book->get_best_ask(), 50001.0);
+    EXPECT_EQ(this->book->get_ask_volume(), 3);
+}
+
+// Test that cancelled orders are skipped and cannot be cancelled twice
+TYPED_TEST(BookPolicyTest, CancelRemovesFromMatching) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::BUY, 50000.0, 10));
+    this->book->add_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::BUY, 49999.0, 10));
+
+    EXPECT_TRUE(this->book->cancel_order(1));
+    EXPECT_FALSE(this->book->cancel_order(1));
+    EXPECT_FALSE(this->book->cancel_order(42));
+    EXPECT_EQ(this->book->get_best_bid(), 49999.0);
+    EXPECT_EQ(this->book->get_bid_volume(), 10);
+
+    auto trades = this->book->process_order(
+        std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 49000.0, 4));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].maker_order_id, 2);
+}
+
+// Test level aggregation, best level first
+TYPED_TEST(BookPolicyTest, LevelsBestFirst) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::BUY, 49998.0, 1));
+    this->book->add_order(std::make_unique<Order>(2, 100, "BTC-USD", Side::BUY, 50000.0, 2));
+    this->book->add_order(std::make_unique<Order>(3, 100, "BTC-USD", Side::BUY, 50000.0, 3));
+    this->book->add_order(std::make_unique<Order>(4, 100, "BTC-USD", Side::SELL, 50002.0, 7));
+
+    auto bids = this->book->get_bid_levels();
+    ASSERT_EQ(bids.size(), 2);
+    EXPECT_EQ(bids[0].price, 50000.0);
+    EXPECT_EQ(bids[0].quantity, 5);
+    EXPECT_EQ(bids[0].order_count, 2);
+    EXPECT_EQ(bids[1].price, 49998.0);
+
+    auto asks = this->book->get_ask_levels(1);
+    ASSERT_EQ(asks.size(), 1);
+    EXPECT_EQ(asks[0].quantity, 7);
+}
+
+std::unique_ptr<Order> make_stop(uint64_t id, Side side, OrderType type, double stop_price,
+                                 double limit_price, uint64_t quantity) {
+    auto order = std::make_unique<Order>(id, 200, "BTC-USD", side, limit_price, quantity);
+    order->type = type;
+    order->stop_price = stop_price;
+    return order;
+}
+
+// Test that a stop rests off the book until a trade prints through its stop price
+TYPED_TEST(BookPolicyTest, StopTriggersOnLastTrade) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 5));
+    this->book->add_order(std::make_unique<Order>(2, 100, "BTC-USD", Side::SELL, 101.0, 5));
+
+    auto trades = this->book->process_order(make_stop(3, Side::BUY, OrderType::STOP, 100.0, 0.0, 4));
+    EXPECT_TRUE(trades.empty());
+    EXPECT_EQ(this->book->get_bid_volume(), 0);
+    ASSERT_NE(this->book->get_order(3), nullptr);
+
+    // A trade at 100 triggers the buy stop, which lifts the rest of 100 and then 101
+    trades = this->book->process_order(std::make_unique<Order>(4, 101, "BTC-USD", Side::BUY, 100.0, 2));
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].taker_order_id, 4);
+    EXPECT_EQ(trades[1].taker_order_id, 3);
+    EXPECT_EQ(trades[1].quantity, 3);
+    EXPECT_EQ(trades[2].taker_order_id, 3);
+    EXPECT_EQ(trades[2].price, 101.0);
+    EXPECT_TRUE(trades[2].taker_filled);
+    EXPECT_EQ(this->book->get_last_trade_price(), 101.0);
+    EXPECT_EQ(this->book->get_order(3), nullptr);
+}
+
+// Test that a triggered stop-limit rests at its limit and a market remainder expires
+TYPED_TEST(BookPolicyTest, StopLimitRestsAndStopMarketRemainderExpires) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::BUY, 100.0, 5));
+    this->book->process_order(make_stop(2, Side::SELL, OrderType::STOP_LIMIT, 100.0, 99.0, 10));
+    this->book->process_order(make_stop(3, Side::SELL, OrderType::STOP, 99.5, 0.0, 10));
+
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired;
+    this->book->process_order(std::make_unique<Order>(4, 101, "BTC-USD", Side::SELL, 100.0, 5), trades, &expired);
+
+    // Stop-limit 2 finds no bids and rests at 99; stop 3 (99.5) has not triggered
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_EQ(this->book->get_best_ask(), 99.0);
+    EXPECT_EQ(this->book->get_ask_volume(), 10);
+
+    // A trade at 99 triggers stop 3, which takes the 4 bid and expires the rest
+    this->book->add_order(std::make_unique<Order>(5, 100, "BTC-USD", Side::BUY, 99.0, 4));
+    trades.clear();
+    this->book->process_order(std::make_unique<Order>(6, 101, "BTC-USD", Side::BUY, 99.0, 10), trades, &expired);
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].taker_order_id, 6);
+    EXPECT_EQ(trades[0].maker_order_id, 2);
+    EXPECT_EQ(trades[1].taker_order_id, 3);
+    EXPECT_EQ(trades[1].maker_order_id, 5);
+    ASSERT_EQ(expired.size(), 1);
+    EXPECT_EQ(expired[0], 3);
+    EXPECT_EQ(this->book->get_order(3), nullptr);
+}
+
+// Test that pending stops can be cancelled and a stop already through the last price fires at once
+TYPED_TEST(BookPolicyTest, StopCancelAndImmediateTrigger) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 10));
+    this->book->process_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::BUY, 100.0, 1));
+    this->book->process_order(make_stop(3, Side::BUY, OrderType::STOP, 105.0, 0.0, 1));
+
+    EXPECT_TRUE(this->book->cancel_order(3));
+    EXPECT_FALSE(this->book->cancel_order(3));
+    EXPECT_EQ(this->book->get_storage_stats().pending_stops, 0);
+
+    auto trades = this->book->process_order(make_stop(4, Side::BUY, OrderType::STOP_LIMIT, 99.0, 100.0, 2));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].taker_order_id, 4);
+    EXPECT_EQ(this->book->get_ask_volume(), 7);
+}
+
+// Test that a cascade releases stops batch by batch, each batch in order id order
+TYPED_TEST(BookPolicyTest, StopCascadeIsDeterministic) {
+    for (uint64_t i = 0; i < 5; ++i) {
+        this->book->add_order(std::make_unique<Order>(1 + i, 100, "BTC-USD", Side::SELL, 100.0 + i, 1));
+    }
+    // Same stop price: released in id order even though 11 arrived later than 10
+    this->book->process_order(make_stop(12, Side::BUY, OrderType::STOP, 101.0, 0.0, 1));
+    this->book->process_order(make_stop(10, Side::BUY, OrderType::STOP, 101.0, 0.0, 1));
+    this->book->process_order(make_stop(11, Side::BUY, OrderType::STOP, 100.0, 0.0, 1));
+    this->book->process_order(make_stop(13, Side::BUY, OrderType::STOP, 103.0, 0.0, 1));
+
+    auto trades = this->book->process_order(std::make_unique<Order>(20, 101, "BTC-USD", Side::BUY, 100.0, 1));
+
+    // 20 prints 100 -> stop 11 lifts 101 -> stops 10, 12 lift 102, 103 -> stop 13 lifts 104
+    std::vector<uint64_t> takers;
+    for (const auto& trade : trades) {
+        takers.push_back(trade.taker_order_id);
+    }
+    EXPECT_EQ(takers, (std::vector<uint64_t>{20, 11, 10, 12, 13}));
+    EXPECT_EQ(this->book->get_last_trade_price(), 104.0);
+    EXPECT_EQ(this->book->get_storage_stats().pending_stops, 0);
+}
+
+std::unique_ptr<Order> make_peg(uint64_t id, Side side, OrderType type, double offset, uint64_t quantity) {
+    auto order = std::make_unique<Order>(id, 300, "BTC-USD", side, 0.0, quantity);
+    order->type = type;
+    order->peg_offset = offset;
+    return order;
+}
+
+// Test that pegs are priced off the current BBO and keep arrival priority as it moves
+TYPED_TEST(BookPolicyTest, PeggedOrdersFollowBbo) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::BUY, 100.0, 1));
+    this->book->add_order(std::make_unique<Order>(2, 100, "BTC-USD", Side::SELL, 102.0, 1));
+    EXPECT_TRUE(this->book->process_order(make_peg(3, Side::BUY, OrderType::PEG_MIDPOINT, 0.0, 5)).empty());
+    EXPECT_TRUE(this->book->process_order(make_peg(4, Side::BUY, OrderType::PEG_PRIMARY, 0.0, 2)).empty());
+
+    // Pegs are not displayed
+    EXPECT_EQ(this->book->get_best_bid(), 100.0);
+    EXPECT_EQ(this->book->get_bid_volume(), 1);
+    EXPECT_EQ(this->book->get_storage_stats().pegged_orders, 2);
+
+    auto trades = this->book->process_order(std::make_unique<Order>(5, 101, "BTC-USD", Side::SELL, 101.0, 2));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].maker_order_id, 3);
+    EXPECT_EQ(trades[0].price, 101.0);
+
+    // A better bid moves the midpoint peg up with it
+    this->book->add_order(std::make_unique<Order>(6, 100, "BTC-USD", Side::BUY, 100.5, 1));
+    trades = this->book->process_order(std::make_unique<Order>(7, 101, "BTC-USD", Side::SELL, 101.0, 3));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].maker_order_id, 3);
+    EXPECT_EQ(trades[0].price, 101.25);
+    EXPECT_TRUE(trades[0].maker_filled);
+
+    // The primary peg joined the bid first, so it trades ahead of order 6 at 100.5
+    // and then follows the bid down to 100, where order 1 is older
+    trades = this->book->process_order(std::make_unique<Order>(8, 101, "BTC-USD", Side::SELL, 100.0, 10));
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].maker_order_id, 4);
+    EXPECT_EQ(trades[0].price, 100.5);
+    EXPECT_EQ(trades[0].quantity, 2);
+    EXPECT_EQ(trades[1].maker_order_id, 6);
+    EXPECT_EQ(trades[2].maker_order_id, 1);
+    EXPECT_EQ(trades[2].price, 100.0);
+    EXPECT_EQ(this->book->get_storage_stats().pegged_orders, 0);
+    EXPECT_EQ(this->book->get_best_ask(), 100.0);
+}
+
+// Test that a peg needs a reference, can be cancelled, and midpoint pegs cross each other
+TYPED_TEST(BookPolicyTest, PegReferenceCancelAndMidpointCross) {
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired;
+    EXPECT_EQ(this->book->process_order(make_peg(1, Side::BUY, OrderType::PEG_MIDPOINT, 0.0, 5), trades, &expired),
+              BookReject::UNPRICED_PEG);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_EQ(this->book->get_order(1), nullptr);
+
+    this->book->add_order(std::make_unique<Order>(2, 100, "BTC-USD", Side::BUY, 100.0, 1));
+    this->book->add_order(std::make_unique<Order>(3, 100, "BTC-USD", Side::SELL, 102.0, 1));
+    this->book->process_order(make_peg(4, Side::SELL, OrderType::PEG_PRIMARY, 0.5, 5));
+    EXPECT_TRUE(this->book->cancel_order(4));
+    EXPECT_FALSE(this->book->cancel_order(4));
+
+    this->book->process_order(make_peg(5, Side::SELL, OrderType::PEG_MIDPOINT, 0.0, 4));
+    trades = this->book->process_order(make_peg(6, Side::BUY, OrderType::PEG_MIDPOINT, 0.0, 3));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].maker_order_id, 5);
+    EXPECT_EQ(trades[0].price, 101.0);
+    EXPECT_EQ(this->book->get_storage_stats().pegged_orders, 1);
+    EXPECT_EQ(this->book->get_order(5)->remaining_quantity(), 1);
+}
+
+// Test that an iceberg shows one slice at a time and re-queues behind its level
+TYPED_TEST(BookPolicyTest, IcebergReplenishesBehindLevel) {
+    auto iceberg = std::make_unique<Order>(1, 100, "BTC-USD", Side::BUY, 100.0, 10);
+    iceberg->display_quantity = 3;
+    this->book->add_order(std::move(iceberg));
+    this->book->add_order(std::make_unique<Order>(2, 100, "BTC-USD", Side::BUY, 100.0, 2));
+
+    // Market data shows the slice, not the reserve
+    EXPECT_EQ(this->book->get_bid_volume(), 5);
+    auto levels = this->book->get_bid_levels(1);
+    ASSERT_EQ(levels.size(), 1);
+    EXPECT_EQ(levels[0].quantity, 5);
+
+    // The first slice trades, then order 2 is ahead of the replenished iceberg
+    auto trades = this->book->process_order(std::make_unique<Order>(3, 101, "BTC-USD", Side::SELL, 100.0, 4));
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].maker_order_id, 1);
+    EXPECT_EQ(trades[0].quantity, 3);
+    EXPECT_FALSE(trades[0].maker_filled);
+    EXPECT_EQ(trades[1].maker_order_id, 2);
+    EXPECT_EQ(this->book->get_bid_volume(), 4);
+
+    trades = this->book->process_order(std::make_unique<Order>(4, 101, "BTC-USD", Side::SELL, 100.0, 2));
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].maker_order_id, 2);
+    EXPECT_EQ(trades[1].maker_order_id, 1);
+
+    // Alone at its level, it keeps replenishing until the reserve is gone
+    trades = this->book->process_order(std::make_unique<Order>(5, 101, "BTC-USD", Side::SELL, 100.0, 20));
+    uint64_t filled = 0;
+    for (const auto& trade : trades) {
+        EXPECT_EQ(trade.maker_order_id, 1);
+        EXPECT_LE(trade.quantity, 3);
+        filled += trade.quantity;
+    }
+    EXPECT_EQ(filled, 6);
+    EXPECT_TRUE(trades.back().maker_filled);
+    EXPECT_EQ(this->book->get_bid_volume(), 0);
+    EXPECT_EQ(this->book->get_ask_volume(), 14);
+}
+
+// Test in-place replacement: a size cut keeps priority, anything else re-queues
+TYPED_TEST(BookPolicyTest, ReplaceKeepsPriorityOnlyWhenShrinking) {
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::BUY, 100.0, 10));
+    this->book->add_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::BUY, 100.0, 5));
+    this->book->add_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 102.0, 3));
+
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired;
+    EXPECT_EQ(this->book->replace_order(1, 100.0, 6, trades, &expired), ReplaceResult::RESIZED);
+    EXPECT_EQ(this->book->get_bid_volume(), 11);
+    auto levels = this->book->get_bid_levels(1);
+    ASSERT_EQ(levels.size(), 1);
+    EXPECT_EQ(levels[0].quantity, 11);
+    EXPECT_EQ(this->book->replace_order(42, 100.0, 6, trades, &expired), ReplaceResult::REJECTED);
+
+    trades = this->book->process_order(std::make_unique<Order>(4, 103, "BTC-USD", Side::SELL, 100.0, 2));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].maker_order_id, 1);
+
+    // Growing the size gives up priority; lazy-cancel books leave it to the caller
+    trades.clear();
+    ReplaceResult grown = this->book->replace_order(1, 100.0, 8, trades, &expired);
+    if constexpr (std::is_same_v<TypeParam, HeapOrderBook>) {
+        EXPECT_EQ(grown, ReplaceResult::REJECTED);
+        return;
+    }
+    EXPECT_EQ(grown, ReplaceResult::REENTERED);
+    EXPECT_EQ(this->book->get_bid_volume(), 13);
+
+    // A new price matches first, then rests with the same id
+    EXPECT_EQ(this->book->replace_order(2, 102.0, 5, trades, &expired), ReplaceResult::REENTERED);
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].taker_order_id, 2);
+    EXPECT_EQ(trades[0].quantity, 3);
+    EXPECT_EQ(this->book->get_best_bid(), 102.0);
+    EXPECT_EQ(this->book->get_order(2)->remaining_quantity(), 2);
+    EXPECT_EQ(this->book->get_best_ask(), 0.0);
+
+    trades = this->book->process_order(std::make_unique<Order>(5, 103, "BTC-USD", Side::SELL, 100.0, 10));
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].maker_order_id, 2);
+    EXPECT_EQ(trades[1].maker_order_id, 1);
+    EXPECT_EQ(trades[1].quantity, 8);
+}
+
+// Test that an auction accumulates a crossed book and uncrosses it at one price
+TYPED_TEST(BookPolicyTest, AuctionAccumulatesThenUncrosses) {
+    this->book->start_auction();
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired;
+    this->book->process_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 99.0, 15), trades, &expired);
+    this->book->process_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::BUY, 101.0, 10), trades, &expired);
+    this->book->process_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 100.0, 10), trades, &expired);
+    this->book->process_order(std::make_unique<Order>(4, 103, "BTC-USD", Side::BUY, 100.0, 20), trades, &expired);
+    auto market = std::make_unique<Order>(5, 104, "BTC-USD", Side::BUY, 0.0, 5);
+    market->type = OrderType::MARKET;
+    this->book->process_order(std::move(market), trades, &expired);
+
+    EXPECT_TRUE(trades.empty());
+    ASSERT_EQ(expired.size(), 1);
+    EXPECT_EQ(expired[0], 5);
+    EXPECT_EQ(this->book->get_best_bid(), 101.0);
+    EXPECT_EQ(this->book->get_best_ask(), 99.0);
+
+    AuctionResult indicative = this->book->indicative_auction();
+    EXPECT_EQ(indicative.price, 100.0);
+    EXPECT_EQ(indicative.volume, 25);
+
+    AuctionResult result = this->book->uncross(trades, &expired, false);
+    EXPECT_EQ(result.price, 100.0);
+    EXPECT_EQ(result.volume, 25);
+    EXPECT_FALSE(this->book->in_auction());
+    uint64_t traded = 0;
+    for (const auto& trade : trades) {
+        EXPECT_EQ(trade.price, 100.0);
+        traded += trade.quantity;
+    }
+    EXPECT_EQ(traded, 25);
+
+    // Bid 2 and both asks are done; bid 4 keeps the imbalance
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].taker_order_id, 2);
+    EXPECT_EQ(trades[0].maker_order_id, 1);
+    EXPECT_EQ(this->book->get_best_bid(), 100.0);
+    EXPECT_EQ(this->book->get_bid_volume(), 5);
+    EXPECT_EQ(this->book->get_best_ask(), 0.0);
+    EXPECT_EQ(this->book->get_last_trade_price(), 100.0);
+
+    // Continuous matching is back
+    trades = this->book->process_order(std::make_unique<Order>(6, 105, "BTC-USD", Side::SELL, 100.0, 5));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].maker_order_id, 4);
+}
+
+// Test that a stop entered in an auction with its trigger already met waits
+// for continuous matching instead of going in as an unmatchable market order
+TYPED_TEST(BookPolicyTest, StopEnteredInAuctionWaitsForContinuousMatching) {
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired;
+    this->book->add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 1));
+    this->book->process_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::BUY, 100.0, 1), trades, &expired);
+    ASSERT_EQ(this->book->get_last_trade_price(), 100.0);
+
+    this->book->start_auction();
+    trades.clear();
+    this->book->process_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 101.0, 10), trades, &expired);
+    this->book->process_order(make_stop(4, Side::BUY, OrderType::STOP, 99.0, 0.0, 4), trades, &expired);
+    EXPECT_TRUE(trades.empty());
+    EXPECT_TRUE(expired.empty());
+    ASSERT_NE(this->book->get_order(4), nullptr);
+    EXPECT_TRUE(this->book->get_order(4)->is_pending_stop());
+
+    AuctionResult result = this->book->uncross(trades, &expired, false);
+    EXPECT_EQ(result.volume, 0);
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].taker_order_id, 4);
+    EXPECT_EQ(trades[0].maker_order_id, 3);
+    EXPECT_EQ(trades[0].price, 101.0);
+    EXPECT_EQ(trades[0].quantity, 4);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_EQ(this->book->get_order(4), nullptr);
+}
+
+// Test that stops the uncross price triggers stay held while the book stays
+// in auction, and are released when it leaves
+TYPED_TEST(BookPolicyTest, StopsTriggeredByUncrossWaitOutContinuedAuction) {
+    std::vector<Trade> trades;
+    std::vector<uint64_t> expired;
+    this->book->start_auction();
+    this->book->process_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 10), trades, &expired);
+    this->book->process_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::BUY, 100.0, 10), trades, &expired);
+    this->book->process_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 102.0, 5), trades, &expired);
+    this->book->process_order(make_stop(4, Side::BUY, OrderType::STOP, 100.0, 0.0, 3), trades, &expired);
+    this->book->process_order(make_stop(5, Side::BUY, OrderType::STOP_LIMIT, 100.0, 101.0, 2), trades, &expired);
+
+    AuctionResult result = this->book->uncross(trades, &expired, true);
+    EXPECT_EQ(result.volume, 10);
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_TRUE(this->book->in_auction());
+    EXPECT_TRUE(expired.empty());
+    ASSERT_NE(this->book->get_order(4), nullptr);
+    EXPECT_TRUE(this->book->get_order(4)->is_pending_stop());
+    ASSERT_NE(this->book->get_order(5), nullptr);
+    EXPECT_TRUE(this->book->get_order(5)->is_pending_stop());
+    EXPECT_EQ(this->book->get_best_bid(), 0.0);
+
+    trades.clear();
+    result = this->book->uncross(trades, &expired, false);
+    EXPECT_EQ(result.volume, 0);
+    EXPECT_FALSE(this->book->in_auction());
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].taker_order_id, 4);
+    EXPECT_EQ(trades[0].price, 102.0);
+    EXPECT_EQ(trades[0].quantity, 3);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_EQ(this->book->get_best_bid(), 101.0);
+    EXPECT_EQ(this->book->get_bid_volume(), 2);
+}
+
+// Test pro-rata shares, minimum allocation, FIFO rounding and top-order priority
+TYPED_TEST(BookPolicyTest, ProRataAllocation) {
+    if constexpr (std::is_same_v<TypeParam, HeapOrderBook>) {
+        GTEST_SKIP() << "the heap book always matches FIFO";
+    } else {
+        auto run = [](MatchingAlgorithm matching, uint64_t buy_quantity) {
+            BookConfig config;
+            config.matching = matching;
+            config.pro_rata_min_allocation = 2;
+            TypeParam book("BTC-USD", config);
+            book.add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 10));
+            book.add_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::SELL, 100.0, 30));
+            book.add_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 100.0, 60));
+            book.add_order(std::make_unique<Order>(4, 103, "BTC-USD", Side::SELL, 101.0, 5));
+            auto trades = book.process_order(std::make_unique<Order>(5, 104, "BTC-USD", Side::BUY, 100.0, buy_quantity));
+            std::vector<uint64_t> fills(4, 0);
+            for (const auto& trade : trades) {
+                EXPECT_EQ(trade.price, 100.0);
+                fills[trade.maker_order_id - 1] += trade.quantity;
+            }
+            EXPECT_EQ(book.get_ask_volume(), 105 - std::min<uint64_t>(buy_quantity, 100));
+            return fills;
+        };
+
+        // Exact shares, then floors with the 0.7 share under the minimum and
+        // the one lot left over going to the first order in time
+        EXPECT_EQ(run(MatchingAlgorithm::PRO_RATA, 50), (std::vector<uint64_t>{5, 15, 30, 0}));
+        EXPECT_EQ(run(MatchingAlgorithm::PRO_RATA, 7), (std::vector<uint64_t>{1, 2, 4, 0}));
+
+        // The top order fills first; the rest share 10 of 90 (3 and 6, one left over)
+        EXPECT_EQ(run(MatchingAlgorithm::TOP_PRO_RATA, 20), (std::vector<uint64_t>{10, 4, 6, 0}));
+
+        // Covering the level fills all of it and stops at the next price
+        EXPECT_EQ(run(MatchingAlgorithm::PRO_RATA, 150), (std::vector<uint64_t>{10, 30, 60, 0}));
+    }
+}
+
+// Replay one seeded workload of adds, crosses and cancels and capture the trades
+template<typename Book>
+std::vector<Trade> replay_seeded_workload(uint32_t seed, int num_orders) {
+    Book book("BTC-USD");
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<int> tick_dist(-50, 50);
+    std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+
+    std::vector<Trade> trades;
+    for (int i = 1; i <= num_orders; ++i) {
+        if (action_dist(rng) < 2) {
+            std::uniform_int_distribution<int> id_dist(1, i);
+            book.cancel_order(id_dist(rng));
+            continue;
+        }
+        Side side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+        double price = 50000.0 + tick_dist(rng) * 0.5;
+        auto batch = book.process_order(
+            std::make_unique<Order>(i, i % 7, "BTC-USD", side, price, quantity_dist(rng)));
+        trades.insert(trades.end(), batch.begin(), batch.end());
+    }
+    return trades;
+}
+
+// Test that every policy produces the same trade stream for the same workload
+TEST(BookPolicyEquivalenceTest, IdenticalTradeStreams) {
+    auto reference = replay_seeded_workload<HeapOrderBook>(42, 20000);
+    ASSERT_GT(reference.size(), 1000);
+
+    auto check = [&reference](const std::vector<Trade>& trades) {
+        ASSERT_EQ(trades.size(), reference.size());
+        for (size_t i = 0; i < trades.size(); ++i) {
+            EXPECT_EQ(trades[i].taker_order_id, reference[i].taker_order_id);
+            EXPECT_EQ(trades[i].maker_order_id, reference[i].maker_order_id);
+            EXPECT_EQ(trades[i].price, reference[i].price);
+            EXPECT_EQ(trades[i].quantity, reference[i].quantity);
+        }
+    };
+
+    check(replay_seeded_workload<MapOrderBook>(42, 20000));
+    check(replay_seeded_workload<IntrusiveOrderBook>(42, 20000));
+    check(replay_seeded_workload<LadderOrderBook>(42, 20000));
+}
+
+// Ladder sides and queue indexes only hold prices on the tick grid and
+// within the configured band of the live levels; everything else is rejected
+// at entry instead of growing them
+TEST(BookBandTest, OffGridAndOutOfBandPricesAreRejected) {
+    BookConfig ladder_config;
+    ladder_config.tick_size = 0.5;
+    ladder_config.max_band_ticks = 100;
+    BookConfig indexed_config = ladder_config;
+    indexed_config.queue_index = true;
+    for (auto [type, config] : {std::make_pair(BookType::LADDER, ladder_config),
+                                std::make_pair(BookType::MAP, indexed_config)}) {
+        SCOPED_TRACE(to_string(type));
+        auto book = make_order_book("BTC-USD", type, config);
+        std::vector<Trade> trades;
+        std::vector<uint64_t> expired;
+        auto enter = [&](uint64_t id, Side side, double price) {
+            expired.clear();
+            BookReject reject =
+                book->process_order(std::make_unique<Order>(id, 1, "BTC-USD", side, price, 1), trades, &expired);
+            EXPECT_TRUE(expired.empty());
+            EXPECT_TRUE(reject == BookReject::NONE || reject == BookReject::INVALID_PRICE);
+            return reject == BookReject::NONE;
+        };
+
+        EXPECT_TRUE(enter(1, Side::BUY, 100.0));     // tick 200
+        EXPECT_FALSE(enter(2, Side::BUY, 100.25));   // between ticks
+        EXPECT_FALSE(enter(3, Side::BUY, 50.0));     // 101 ticks wide with 100.0
+        EXPECT_TRUE(enter(4, Side::BUY, 50.5));
+        EXPECT_EQ(book->get_bid_volume(), 2);
+        EXPECT_EQ(book->get_order(2), nullptr);
+        EXPECT_EQ(book->replace_order(4, 100.25, 1, trades, &expired), ReplaceResult::REJECTED);
+        EXPECT_EQ(book->replace_order(4, 49.5, 1, trades, &expired), ReplaceResult::REJECTED);
+
+        // A fat finger on an empty side is taken, and sets that side's band
+        EXPECT_TRUE(enter(5, Side::SELL, 1000000.0));
+        EXPECT_FALSE(enter(6, Side::SELL, 101.0));
+        EXPECT_TRUE(book->cancel_order(5));
+        EXPECT_TRUE(enter(7, Side::SELL, 101.0));
+
+        // The band follows the live levels
+        EXPECT_TRUE(book->cancel_order(1));
+        EXPECT_TRUE(enter(8, Side::BUY, 40.0));
+        EXPECT_FALSE(enter(9, Side::BUY, 100.0));
+        std::vector<BookLevel> bids = book->get_bid_levels();
+        ASSERT_EQ(bids.size(), 2);
+        EXPECT_EQ(bids[0].price, 50.5);
+        EXPECT_EQ(bids[1].price, 40.0);
+        uint64_t depth = 0;
+        if (config.queue_index) {
+            ASSERT_TRUE(book->depth_to_price(Side::BUY, 40.0, depth));
+            EXPECT_EQ(depth, 2);
+        }
+        EXPECT_LE(book->get_storage_stats().side_entries, 200);
+        EXPECT_TRUE(trades.empty());
+    }
+}
+
 // Main function to run all tests
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,375 @@
+#include "gtest/gtest.h"
+#include "core/PartitionedEngine.h"
+#include "BookLevels.h"
+#include <filesystem>
+#include <map>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+struct TradeRecord {
+    uint64_t trade_id;
+    uint64_t taker_order_id;
+    uint64_t maker_order_id;
+    double price;
+    uint64_t quantity;
+
+    bool operator==(const TradeRecord& other) const {
+        return trade_id == other.trade_id && taker_order_id == other.taker_order_id &&
+               maker_order_id == other.maker_order_id && price == other.price && quantity == other.quantity;
+    }
+};
+
+Levels bids(const MatchingEngine& engine, const std::string& symbol) {
+    return levels(engine.get_bid_levels(symbol, 100));
+}
+
+Levels asks(const MatchingEngine& engine, const std::string& symbol) {
+    return levels(engine.get_ask_levels(symbol, 100));
+}
+
+void record_trades(MatchingEngine& engine, std::vector<TradeRecord>& trades) {
+    engine.set_trade_callback([&trades](const Trade& trade) {
+        trades.push_back({trade.trade_id, trade.taker_order_id, trade.maker_order_id, trade.price, trade.quantity});
+    });
+}
+
+// The same resting book, with icebergs, pegs and pending stops
+void build_book(MatchingEngine& engine, const std::string& symbol) {
+    engine.submit_order(1, symbol, Side::BUY, 99.0, 10);
+    engine.submit_order(2, symbol, Side::BUY, 99.0, 5);
+    engine.submit_order(3, symbol, Side::BUY, 98.5, 20);
+    engine.submit_order(4, symbol, Side::SELL, 101.0, 8);
+    engine.submit_order(5, symbol, Side::SELL, 101.0, 12, TimeInForce::GTD, 50000);
+    engine.submit_iceberg_order(6, symbol, Side::SELL, 101.5, 30, 5);
+    engine.submit_iceberg_order(7, symbol, Side::BUY, 98.0, 40, 10);
+    engine.submit_peg_order(8, symbol, Side::BUY, OrderType::PEG_PRIMARY, 0.0, 6);
+    engine.submit_peg_order(9, symbol, Side::SELL, OrderType::PEG_MIDPOINT, 0.0, 4);
+    engine.submit_stop_order(10, symbol, Side::BUY, OrderType::STOP_LIMIT, 101.5, 102.0, 7);
+    engine.submit_stop_order(11, symbol, Side::SELL, OrderType::STOP, 98.0, 0.0, 9);
+    // Partly fill the front of each side so filled quantities travel too
+    engine.submit_order(12, symbol, Side::SELL, 99.0, 3);
+    engine.submit_order(13, symbol, Side::BUY, 101.0, 2);
+}
+
+void drive(MatchingEngine& engine, const std::string& symbol) {
+    engine.submit_order(20, symbol, Side::BUY, 101.5, 25);
+    engine.submit_order(21, symbol, Side::SELL, 98.0, 60);
+    engine.submit_order(22, symbol, Side::BUY, 102.0, 40);
+    engine.submit_order(23, symbol, Side::SELL, 97.0, 40);
+    engine.advance_time(60000);
+}
+
+class TempDir {
+public:
+    TempDir() {
+        path_ = std::filesystem::temp_directory_path() /
+                ("quasar_partition_" + std::to_string(::getpid()) + "_" + std::to_string(counter_++));
+        std::filesystem::create_directories(path_);
+    }
+    ~TempDir() { std::filesystem::remove_all(path_); }
+    std::string str() const { return path_.string(); }
+
+private:
+    static inline int counter_ = 0;
+    std::filesystem::path path_;
+};
+
+} // namespace
+
+TEST(HashRingTest, SpreadsSymbolsAndMovesFewWhenAPartitionJoins) {
+    HashRing ring(4, 128);
+    std::vector<std::string> symbols;
+    for (int i = 0; i < 4000; ++i) {
+        symbols.push_back("SYM-" + std::to_string(i));
+    }
+
+    std::map<uint32_t, size_t> counts;
+    std::map<std::string, uint32_t> before;
+    for (const std::string& symbol : symbols) {
+        before[symbol] = ring.partition_of(symbol);
+        counts[before[symbol]]++;
+    }
+    ASSERT_EQ(counts.size(), 4);
+    for (const auto& [partition, count] : counts) {
+        EXPECT_GT(count, 700) << partition;
+        EXPECT_LT(count, 1300) << partition;
+    }
+
+    // A fifth partition takes about a fifth of the symbols, only from the others
+    ring.add_partition(4);
+    EXPECT_EQ(ring.partition_count(), 5);
+    size_t moved = 0;
+    for (const std::string& symbol : symbols) {
+        uint32_t now = ring.partition_of(symbol);
+        if (now != before[symbol]) {
+            EXPECT_EQ(now, 4);
+            moved++;
+        }
+    }
+    EXPECT_GT(moved, 500);
+    EXPECT_LT(moved, 1100);
+
+    // And leaving puts them back
+    ring.remove_partition(4);
+    for (const std::string& symbol : symbols) {
+        EXPECT_EQ(ring.partition_of(symbol), before[symbol]);
+    }
+
+    ring.assign("SYM-1", 3);
+    EXPECT_EQ(ring.partition_of("SYM-1"), 3);
+    EXPECT_EQ(ring.ring_partition("SYM-1"), before["SYM-1"]);
+}
+
+TEST(CommandLogTest, AppendsAndReadsWholeRecords) {
+    TempDir dir;
+    CommandLog log(dir.str() + "/commands.log");
+    ASSERT_TRUE(log.is_open());
+
+    uint64_t offset = 99;
+    ASSERT_TRUE(log.append(Command::new_order(7, "BTC-USD", Side::SELL, 101.5, 3), &offset));
+    EXPECT_EQ(offset, 0);
+    ASSERT_TRUE(log.append(Command::cancel("BTC-USD", 42), &offset));
+    EXPECT_EQ(offset, 1);
+    EXPECT_FALSE(log.append(Command::handoff(std::string(40, 'X'), 1)));  // symbol too long
+    EXPECT_EQ(log.size(), 2);
+
+    // A second handle on the same file sees the same records
+    CommandLog reader(dir.str() + "/commands.log");
+    Command commands[4];
+    ASSERT_EQ(reader.read(0, commands, 4), 2);
+    EXPECT_EQ(commands[0].type, CommandType::NEW_ORDER);
+    EXPECT_EQ(commands[0].get_symbol(), "BTC-USD");
+    EXPECT_EQ(commands[0].get_side(), Side::SELL);
+    EXPECT_EQ(commands[0].price, 101.5);
+    EXPECT_EQ(commands[0].quantity, 3);
+    EXPECT_EQ(commands[0].client_id, 7);
+    EXPECT_EQ(commands[1].type, CommandType::CANCEL);
+    EXPECT_EQ(commands[1].order_id, 42);
+    EXPECT_EQ(reader.read(2, commands, 4), 0);
+}
+
+// A book handed from one engine to another through a snapshot file matches
+// exactly as the original would have: same levels, same trades, same ids
+TEST(PartitionTest, HandoffKeepsPriorityAndIds) {
+    TempDir dir;
+    for (BookType type : {BookType::HEAP, BookType::MAP, BookType::INTRUSIVE, BookType::LADDER}) {
+        MatchingEngine reference(type, 0);
+        MatchingEngine source(type, 0);
+        MatchingEngine destination(type, 1);
+        destination.submit_order(1, "OTHER", Side::BUY, 10.0, 1);  // symbol ids differ between engines
+        build_book(reference, "BTC-USD");
+        build_book(source, "BTC-USD");
+
+        BookSnapshot snapshot;
+        ASSERT_TRUE(source.hand_off_symbol("BTC-USD", snapshot)) << to_string(type);
+        EXPECT_EQ(source.get_stats().active_orders, 0);
+        EXPECT_TRUE(source.get_bid_levels("BTC-USD").empty());
+        EXPECT_FALSE(source.cancel_order(snapshot.orders.front().order_id));
+
+        std::string path = PartitionedEngine::snapshot_path(dir.str(), "BTC-USD", 0);
+        ASSERT_TRUE(PartitionedEngine::write_snapshot(path, snapshot, true));
+        BookSnapshot loaded;
+        bool has_book = false;
+        ASSERT_TRUE(PartitionedEngine::read_snapshot(path, loaded, has_book));
+        EXPECT_TRUE(has_book);
+        EXPECT_EQ(loaded.orders.size(), snapshot.orders.size());
+        ASSERT_TRUE(destination.adopt_symbol(loaded)) << to_string(type);
+        EXPECT_FALSE(destination.adopt_symbol(loaded));  // the book is no longer empty
+
+        EXPECT_EQ(destination.get_stats().active_orders, reference.get_stats().active_orders + 1);
+        EXPECT_EQ(bids(destination, "BTC-USD"), bids(reference, "BTC-USD"));
+        EXPECT_EQ(asks(destination, "BTC-USD"), asks(reference, "BTC-USD"));
+
+        // Orders entered on the source cancel on the destination
+        uint64_t resting = loaded.orders.front().order_id;
+        EXPECT_EQ(order_id_shard(resting), 0);
+        EXPECT_TRUE(destination.cancel_order(resting)) << to_string(type);
+        EXPECT_TRUE(reference.cancel_order(resting));
+
+        std::vector<TradeRecord> expected, actual;
+        record_trades(reference, expected);
+        record_trades(destination, actual);
+        drive(reference, "BTC-USD");
+        drive(destination, "BTC-USD");
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(actual, expected) << to_string(type);
+        EXPECT_EQ(bids(destination, "BTC-USD"), bids(reference, "BTC-USD"));
+        EXPECT_EQ(asks(destination, "BTC-USD"), asks(reference, "BTC-USD"));
+
+        // New orders continue the source's sequence
+        EXPECT_EQ(destination.submit_order(1, "BTC-USD", Side::BUY, 50.0, 1),
+                  reference.submit_order(1, "BTC-USD", Side::BUY, 50.0, 1));
+    }
+}
+
+// Three partitions on one log, with symbols moved while orders and cancels
+// keep arriving, end up with the books of one engine applying everything
+TEST(PartitionTest, PartitionsMatchASingleEngineAcrossHandoffs) {
+    TempDir dir;
+    CommandLog log(dir.str() + "/commands.log");
+    ASSERT_TRUE(log.is_open());
+
+    PartitionConfig config;
+    config.partitions = 3;
+    config.snapshot_dir = dir.str();
+    std::vector<std::unique_ptr<PartitionedEngine>> partitions;
+    std::map<uint64_t, uint64_t> acked;  // log offset -> order id
+    for (uint32_t p = 0; p < 3; ++p) {
+        config.partition = p;
+        partitions.push_back(std::make_unique<PartitionedEngine>(log, config));
+        partitions.back()->set_ack_callback([&acked](uint64_t offset, uint64_t order_id) { acked[offset] = order_id; });
+    }
+
+    MatchingEngine reference;
+    std::map<uint64_t, uint64_t> reference_ids;  // log offset -> reference order id
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < 12; ++i) {
+        symbols.push_back("SYM-" + std::to_string(i));
+    }
+    std::mt19937 rng(11);
+    std::vector<std::pair<std::string, uint64_t>> orders;  // symbol, offset of its new order
+    uint64_t handoffs = 0;
+    auto step = [&]() {
+        for (auto& partition : partitions) {
+            partition->poll();
+        }
+    };
+
+    for (int i = 0; i < 4000; ++i) {
+        const std::string& symbol = symbols[rng() % symbols.size()];
+        uint64_t offset = 0;
+        if (i % 400 == 399) {
+            // The destination is polled first, so it waits for the snapshot
+            uint32_t to = static_cast<uint32_t>(rng() % 3);
+            ASSERT_TRUE(log.append(Command::handoff(symbol, to)));
+            handoffs++;
+            partitions[to]->poll();
+            EXPECT_TRUE(partitions[to]->waiting() || partitions[to]->owner_of(symbol) == to);
+            step();
+            step();
+            for (auto& partition : partitions) {
+                EXPECT_FALSE(partition->waiting());
+                EXPECT_EQ(partition->owner_of(symbol), to);
+            }
+            continue;
+        }
+        if (rng() % 4 == 0 && !orders.empty()) {
+            auto [cancel_symbol, order_offset] = orders[rng() % orders.size()];
+            ASSERT_TRUE(log.append(Command::cancel(cancel_symbol, acked[order_offset])));
+            reference.cancel_order(reference_ids[order_offset]);
+        } else {
+            Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+            double price = 100.0 + static_cast<int>(rng() % 21 - 10) * 0.5;
+            uint64_t quantity = 1 + rng() % 30;
+            ASSERT_TRUE(log.append(Command::new_order(1 + i % 7, symbol, side, price, quantity), &offset));
+            reference_ids[offset] = reference.submit_order(1 + i % 7, symbol, side, price, quantity);
+            orders.emplace_back(symbol, offset);
+        }
+        step();
+    }
+
+    uint64_t trades = 0;
+    uint64_t active = 0;
+    uint64_t applied = 0;
+    uint64_t handed_off = 0;
+    for (auto& partition : partitions) {
+        EXPECT_EQ(partition->offset(), log.size());
+        PartitionedEngine::PartitionStats stats = partition->get_stats();
+        applied += stats.applied;
+        handed_off += stats.handed_off;
+        EXPECT_EQ(stats.applied + stats.skipped + handoffs, log.size());
+        trades += partition->engine().get_stats().total_trades;
+        active += partition->engine().get_stats().active_orders;
+    }
+    EXPECT_EQ(applied + handoffs, log.size());
+    EXPECT_GT(handed_off, 0);
+    EXPECT_EQ(trades, reference.get_stats().total_trades);
+    EXPECT_EQ(active, reference.get_stats().active_orders);
+    for (const std::string& symbol : symbols) {
+        MatchingEngine& owner = partitions[partitions[0]->owner_of(symbol)]->engine();
+        EXPECT_EQ(bids(owner, symbol), bids(reference, symbol)) << symbol;
+        EXPECT_EQ(asks(owner, symbol), asks(reference, symbol)) << symbol;
+    }
+
+    // A partition started late replays the log, handoffs included, from the
+    // snapshot files and arrives at the same books
+    config.partition = 1;
+    PartitionedEngine replay(log, config);
+    while (replay.poll(1000) > 0) {}
+    EXPECT_EQ(replay.offset(), log.size());
+    EXPECT_EQ(replay.engine().get_stats().active_orders, partitions[1]->engine().get_stats().active_orders);
+    for (const std::string& symbol : symbols) {
+        if (replay.owns(symbol)) {
+            EXPECT_EQ(bids(replay.engine(), symbol), bids(reference, symbol));
+            EXPECT_EQ(asks(replay.engine(), symbol), asks(reference, symbol));
+        }
+    }
+}
+
+// A handoff whose snapshot cannot be written, or cannot be adopted, stops
+// its partition at the handoff with the book as it was, and goes through
+// once the cause is gone
+TEST(PartitionTest, FailedHandoffKeepsTheBookAndHolds) {
+    TempDir dir;
+    CommandLog log(dir.str() + "/commands.log");
+    ASSERT_TRUE(log.is_open());
+
+    PartitionConfig config;
+    config.partitions = 2;
+    config.snapshot_dir = dir.str() + "/snapshots";  // not there yet
+    config.partition = 0;
+    PartitionedEngine source(log, config);
+    config.partition = 1;
+    PartitionedEngine destination(log, config);
+
+    std::string symbol;
+    for (int i = 0; symbol.empty(); ++i) {
+        std::string candidate = "SYM-" + std::to_string(i);
+        if (source.owns(candidate)) {
+            symbol = candidate;
+        }
+    }
+    ASSERT_TRUE(log.append(Command::new_order(1, symbol, Side::BUY, 99.0, 10)));
+    ASSERT_TRUE(log.append(Command::handoff(symbol, 1)));
+    ASSERT_TRUE(log.append(Command::new_order(2, symbol, Side::SELL, 99.0, 4)));
+
+    EXPECT_EQ(source.poll(), 1);
+    EXPECT_TRUE(source.failed());
+    EXPECT_FALSE(source.error().empty());
+    EXPECT_EQ(source.offset(), 1);
+    EXPECT_EQ(source.get_stats().handed_off, 0);
+    EXPECT_EQ(source.get_stats().failed_handoffs, 1);
+    EXPECT_TRUE(source.owns(symbol));
+    EXPECT_EQ(source.engine().get_stats().active_orders, 1);
+    EXPECT_EQ(source.engine().get_bid_volume(symbol), 10);
+
+    // An order already resting here for the symbol keeps the destination
+    // from adopting it
+    ASSERT_TRUE(std::filesystem::create_directories(config.snapshot_dir));
+    EXPECT_EQ(source.poll(), 2);
+    EXPECT_FALSE(source.failed());
+    EXPECT_FALSE(source.owns(symbol));
+    EXPECT_EQ(source.engine().get_stats().active_orders, 0);
+    uint64_t stray = destination.engine().submit_order(3, symbol, Side::BUY, 90.0, 1);
+    EXPECT_EQ(destination.poll(), 1);
+    EXPECT_TRUE(destination.failed());
+    EXPECT_EQ(destination.offset(), 1);
+    EXPECT_EQ(destination.get_stats().adopted, 0);
+    EXPECT_FALSE(destination.owns(symbol));
+    EXPECT_EQ(destination.poll(), 0);
+    EXPECT_TRUE(destination.failed());
+    EXPECT_EQ(destination.get_stats().failed_handoffs, 2);
+
+    ASSERT_TRUE(destination.engine().cancel_order(stray));
+    EXPECT_EQ(destination.poll(), 2);
+    EXPECT_FALSE(destination.failed());
+    EXPECT_EQ(destination.get_stats().adopted, 1);
+    EXPECT_TRUE(destination.owns(symbol));
+    EXPECT_EQ(destination.engine().get_bid_volume(symbol), 6);
+}
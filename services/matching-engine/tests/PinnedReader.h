@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core/Epoch.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace quasar {
+
+// Test helper: holds a guard on an epoch domain from its own thread until
+// told to leave (or destroyed), holding back whatever waits on the domain
+class PinnedReader {
+public:
+    explicit PinnedReader(EpochDomain& domain)
+        : thread_([this, &domain] {
+              EpochGuard guard(domain);
+              std::unique_lock<std::mutex> lock(mutex_);
+              pinned_ = true;
+              cv_.notify_all();
+              cv_.wait(lock, [this] { return leave_; });
+          }) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return pinned_; });
+    }
+
+    ~PinnedReader() { leave(); }
+
+    PinnedReader(const PinnedReader&) = delete;
+    PinnedReader& operator=(const PinnedReader&) = delete;
+
+    void leave() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            leave_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pinned_{false};
+    bool leave_{false};
+    std::thread thread_;
+};
+
+} // namespace quasar
@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+#include "core/MatchingEngine.h"
+#include "core/PositionTracker.h"
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+Trade make_trade(uint64_t taker, uint64_t maker, Side taker_side, const std::string& symbol, double price,
+                 uint64_t quantity) {
+    Trade trade(0, 0, 0, taker, maker, symbol, price, quantity);
+    trade.taker_side = taker_side;
+    return trade;
+}
+
+} // namespace
+
+TEST(PositionTrackerTest, AveragePriceAndRealizedPnl) {
+    PositionTracker tracker;
+    // Client 1 buys 10 @ 100 and 10 @ 110, sells 15 @ 120, then sells 10 @ 90 (flat and 5 short)
+    tracker.on_trade(make_trade(1, 2, Side::BUY, "BTC-USD", 100.0, 10));
+    tracker.on_trade(make_trade(3, 1, Side::SELL, "BTC-USD", 110.0, 10));
+    tracker.flush();
+
+    PositionTracker::Position position;
+    ASSERT_TRUE(tracker.get_position(1, "BTC-USD", position));
+    EXPECT_EQ(position.net_quantity, 20);
+    EXPECT_DOUBLE_EQ(position.average_price, 105.0);
+    EXPECT_DOUBLE_EQ(position.realized_pnl, 0.0);
+    ASSERT_TRUE(tracker.get_position(3, "BTC-USD", position));
+    EXPECT_EQ(position.net_quantity, -10);
+    EXPECT_DOUBLE_EQ(position.average_price, 110.0);
+
+    tracker.on_trade(make_trade(1, 2, Side::SELL, "BTC-USD", 120.0, 15));
+    tracker.on_trade(make_trade(1, 2, Side::SELL, "BTC-USD", 90.0, 10));
+    tracker.flush();
+    ASSERT_TRUE(tracker.get_position(1, "BTC-USD", position));
+    EXPECT_EQ(position.net_quantity, -5);
+    EXPECT_DOUBLE_EQ(position.average_price, 90.0);
+    EXPECT_DOUBLE_EQ(position.realized_pnl, 15 * 15.0 + 5 * -15.0);
+    EXPECT_EQ(position.bought, 20);
+    EXPECT_EQ(position.sold, 25);
+
+    // Client 2 bought 10 @ 100 first, then 15 @ 120 and 10 @ 90 onto a short of 10
+    ASSERT_TRUE(tracker.get_position(2, "BTC-USD", position));
+    EXPECT_EQ(position.net_quantity, 15);
+    EXPECT_DOUBLE_EQ(position.realized_pnl, 10 * (100.0 - 120.0));
+    EXPECT_DOUBLE_EQ(position.average_price, (5 * 120.0 + 10 * 90.0) / 15);
+
+    EXPECT_FALSE(tracker.get_position(1, "ETH-USD", position));
+    EXPECT_FALSE(tracker.get_position(9, "BTC-USD", position));
+    EXPECT_EQ(tracker.fills_processed(), 8);
+}
+
+TEST(PositionTrackerTest, MarksLongsToTheBidAndShortsToTheAsk) {
+    PositionTracker tracker;
+    tracker.on_trade(make_trade(1, 2, Side::BUY, "BTC-USD", 100.0, 10));
+    tracker.flush();
+
+    // Without a quote both sides mark to the last fill
+    PositionTracker::Position position;
+    ASSERT_TRUE(tracker.get_position(1, "BTC-USD", position));
+    EXPECT_EQ(position.mark_price, 100.0);
+    EXPECT_DOUBLE_EQ(position.unrealized_pnl, 0.0);
+
+    tracker.update_mark("BTC-USD", 104.0, 106.0);
+    tracker.flush();
+    ASSERT_TRUE(tracker.get_position(1, "BTC-USD", position));
+    EXPECT_EQ(position.mark_price, 104.0);
+    EXPECT_DOUBLE_EQ(position.unrealized_pnl, 40.0);
+    ASSERT_TRUE(tracker.get_position(2, "BTC-USD", position));
+    EXPECT_EQ(position.mark_price, 106.0);
+    EXPECT_DOUBLE_EQ(position.unrealized_pnl, -60.0);
+    EXPECT_DOUBLE_EQ(tracker.get_unrealized_pnl(2), -60.0);
+}
+
+TEST(PositionTrackerTest, PositionsSurviveTableGrowth) {
+    PositionTracker tracker;
+    // More positions than the first table holds, symbols added after the clients exist
+    for (int symbol = 0; symbol < 40; ++symbol) {
+        for (uint64_t client = 1; client <= 5; ++client) {
+            tracker.on_trade(make_trade(client, 100 + client, Side::BUY, "S" + std::to_string(symbol), 10.0 + symbol,
+                                        client * 10 + symbol));
+        }
+    }
+    tracker.flush();
+    EXPECT_EQ(tracker.symbol_count(), 40);
+    EXPECT_EQ(tracker.client_count(), 10);
+    EXPECT_EQ(tracker.snapshot().size(), 400);
+    for (uint64_t client = 1; client <= 5; ++client) {
+        auto positions = tracker.get_positions(client);
+        ASSERT_EQ(positions.size(), 40);
+        for (int symbol = 0; symbol < 40; ++symbol) {
+            EXPECT_EQ(positions[symbol].symbol, "S" + std::to_string(symbol));
+            EXPECT_EQ(positions[symbol].net_quantity, static_cast<int64_t>(client * 10 + symbol));
+            EXPECT_EQ(positions[symbol].average_price, 10.0 + symbol);
+        }
+    }
+}
+
+TEST(PositionTrackerTest, FollowsTheEngineFromItsOwnThread) {
+    MatchingEngine engine;
+    PositionTracker tracker;
+    std::vector<Trade> trades;
+    engine.set_trade_callback([&](const Trade& trade) { trades.push_back(trade); });
+    tracker.follow(engine);
+    tracker.start();
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint64_t> client_dist(1, 20);
+    std::uniform_int_distribution<int> tick_dist(-20, 20);
+    std::uniform_int_distribution<uint64_t> quantity_dist(1, 50);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+    const std::vector<std::string> symbols{"BTC-USD", "ETH-USD", "SOL-USD"};
+    for (int i = 0; i < 20000; ++i) {
+        const std::string& symbol = symbols[i % symbols.size()];
+        engine.submit_order(client_dist(rng), symbol, side_dist(rng) == 0 ? Side::BUY : Side::SELL,
+                            100.0 + tick_dist(rng) * 0.5, quantity_dist(rng));
+        if (i % 500 == 0) {
+            uint64_t order_id = engine.submit_order(client_dist(rng), symbol, Side::BUY, 90.0, 5);
+            engine.cancel_order(order_id);
+        }
+    }
+    tracker.flush();
+    ASSERT_FALSE(trades.empty());
+    EXPECT_EQ(tracker.fills_processed(), 2 * trades.size());
+
+    // Net quantities from a replay of the trades; every symbol nets to zero
+    std::map<std::pair<uint64_t, std::string>, int64_t> expected;
+    for (const Trade& trade : trades) {
+        int64_t quantity = static_cast<int64_t>(trade.quantity);
+        expected[{trade.taker_client_id, trade.symbol}] += trade.taker_side == Side::BUY ? quantity : -quantity;
+        expected[{trade.maker_client_id, trade.symbol}] += trade.taker_side == Side::BUY ? -quantity : quantity;
+    }
+    std::map<std::string, int64_t> symbol_net;
+    auto snapshot = tracker.snapshot();
+    EXPECT_EQ(snapshot.size(), expected.size());
+    for (const auto& position : snapshot) {
+        EXPECT_EQ(position.net_quantity, (expected[{position.client_id, position.symbol}]));
+        EXPECT_EQ(static_cast<int64_t>(position.bought) - static_cast<int64_t>(position.sold), position.net_quantity);
+        symbol_net[position.symbol] += position.net_quantity;
+    }
+    for (const auto& [symbol, net] : symbol_net) {
+        EXPECT_EQ(net, 0) << symbol;
+    }
+
+    // Marks follow the books: a long at the bid, a short at the ask
+    for (const auto& position : snapshot) {
+        double bid = engine.get_best_bid(position.symbol);
+        double ask = engine.get_best_ask(position.symbol);
+        if (position.net_quantity > 0 && bid > 0.0) {
+            EXPECT_EQ(position.mark_price, bid);
+        } else if (position.net_quantity < 0 && ask > 0.0) {
+            EXPECT_EQ(position.mark_price, ask);
+        }
+    }
+
+    // Trading is zero-sum at any one mark: realized plus unrealized across clients
+    // nets out when every open position marks to the same price
+    for (const std::string& symbol : symbols) {
+        tracker.update_mark(symbol, 100.0, 100.0);
+    }
+    tracker.stop();
+    double total = 0.0;
+    for (const auto& position : tracker.snapshot()) {
+        total += position.realized_pnl + position.unrealized_pnl;
+    }
+    EXPECT_NEAR(total, 0.0, 1e-3);
+}
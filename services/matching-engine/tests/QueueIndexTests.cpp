@@ -0,0 +1,243 @@
+#include "gtest/gtest.h"
+#include "core/OrderBook.h"
+#include "core/QueueIndex.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace quasar;
+
+TEST(FenwickTreeTest, PrefixSumsAndSearchAfterAppendsAndUpdates) {
+    std::vector<uint64_t> values{5, 0, 3, 7, 1, 0, 4, 2, 6};
+    FenwickTree<uint64_t> appended;
+    for (uint64_t value : values) {
+        appended.push_back(value);
+    }
+    FenwickTree<uint64_t> built;
+    built.assign(values);
+
+    values[3] -= 4;
+    values[7] += 9;
+    for (auto* tree : {&appended, &built}) {
+        tree->subtract(3, 4);
+        tree->add(7, 9);
+        uint64_t running = 0;
+        for (size_t count = 0; count <= values.size(); ++count) {
+            EXPECT_EQ(tree->prefix(count), running);
+            if (count < values.size()) {
+                running += values[count];
+            }
+        }
+
+        // Longest prefix under 12: 5 + 0 + 3 + 3 = 11, the next value takes it to 12
+        uint64_t sum = 0;
+        EXPECT_EQ(tree->count_while([](uint64_t total) { return total < 12; }, sum), 4);
+        EXPECT_EQ(sum, 11);
+    }
+}
+
+TEST(QueueIndexTest, QueuePositionDepthAndSweepCost) {
+    BookConfig config;
+    config.tick_size = 0.5;
+    config.queue_index = true;
+    IntrusiveOrderBook book("BTC-USD", config);
+    book.add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 10));
+    book.add_order(std::make_unique<Order>(2, 101, "BTC-USD", Side::SELL, 100.0, 20));
+    book.add_order(std::make_unique<Order>(3, 102, "BTC-USD", Side::SELL, 100.0, 30));
+    book.add_order(std::make_unique<Order>(4, 103, "BTC-USD", Side::SELL, 101.5, 40));
+    book.add_order(std::make_unique<Order>(5, 104, "BTC-USD", Side::BUY, 99.0, 25));
+
+    QueuePosition position;
+    ASSERT_TRUE(book.queue_position(3, position));
+    EXPECT_EQ(position.price, 100.0);
+    EXPECT_EQ(position.quantity_ahead, 30);
+    EXPECT_EQ(position.orders_ahead, 2);
+    EXPECT_EQ(position.level_quantity, 60);
+    EXPECT_EQ(position.better_quantity, 0);
+    ASSERT_TRUE(book.queue_position(4, position));
+    EXPECT_EQ(position.quantity_ahead, 0);
+    EXPECT_EQ(position.better_quantity, 60);
+
+    // A partial fill of the front and a cancel in the middle both move order 3 up
+    book.process_order(std::make_unique<Order>(6, 105, "BTC-USD", Side::BUY, 100.0, 4));
+    book.cancel_order(2);
+    ASSERT_TRUE(book.queue_position(3, position));
+    EXPECT_EQ(position.quantity_ahead, 6);
+    EXPECT_EQ(position.orders_ahead, 1);
+
+    uint64_t depth = 0;
+    ASSERT_TRUE(book.depth_to_price(Side::SELL, 101.0, depth));
+    EXPECT_EQ(depth, 36);
+    ASSERT_TRUE(book.depth_to_price(Side::SELL, 200.0, depth));
+    EXPECT_EQ(depth, 76);
+    ASSERT_TRUE(book.depth_to_price(Side::BUY, 99.5, depth));
+    EXPECT_EQ(depth, 0);
+    ASSERT_TRUE(book.depth_to_price(Side::BUY, 50.0, depth));
+    EXPECT_EQ(depth, 25);
+
+    // Buying 50 takes 36 at 100 and 14 at 101.5
+    FillEstimate estimate;
+    ASSERT_TRUE(book.cost_to_fill(Side::SELL, 50, estimate));
+    EXPECT_EQ(estimate.filled_quantity, 50);
+    EXPECT_DOUBLE_EQ(estimate.notional, 36 * 100.0 + 14 * 101.5);
+    EXPECT_DOUBLE_EQ(estimate.average_price, estimate.notional / 50);
+    EXPECT_EQ(estimate.worst_price, 101.5);
+
+    // More than the side holds fills what there is
+    ASSERT_TRUE(book.cost_to_fill(Side::SELL, 500, estimate));
+    EXPECT_EQ(estimate.filled_quantity, 76);
+    EXPECT_EQ(estimate.worst_price, 101.5);
+
+    // Gone orders and books without an index answer nothing
+    EXPECT_FALSE(book.queue_position(2, position));
+    IntrusiveOrderBook plain("BTC-USD");
+    plain.add_order(std::make_unique<Order>(1, 100, "BTC-USD", Side::SELL, 100.0, 10));
+    EXPECT_FALSE(plain.queue_position(1, position));
+    EXPECT_FALSE(plain.depth_to_price(Side::SELL, 100.0, depth));
+}
+
+TEST(QueueIndexTest, PositionsFollowFillOrderAfterChurn) {
+    BookConfig config;
+    config.queue_index = true;
+    LadderOrderBook book("BTC-USD", config);
+
+    // Enough departures to renumber the level's slots more than once
+    uint64_t id = 0;
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 40; ++i) {
+            ++id;
+            auto order = std::make_unique<Order>(id, 100, "BTC-USD", Side::SELL, 100.0, 1 + id % 5);
+            if (id % 9 == 0) {
+                order->display_quantity = 2;
+            }
+            book.add_order(std::move(order));
+        }
+        for (uint64_t cancel = id - 39; cancel <= id; cancel += 2) {
+            book.cancel_order(cancel);
+        }
+        book.process_order(std::make_unique<Order>(1000 + round, 101, "BTC-USD", Side::BUY, 100.0, 7));
+    }
+
+    // Predicted fill order by queue position, then the fills themselves
+    std::vector<std::pair<uint32_t, uint64_t>> queue;
+    uint64_t level_quantity = 0;
+    for (uint64_t order_id = 1; order_id <= id; ++order_id) {
+        QueuePosition position;
+        if (book.queue_position(order_id, position)) {
+            queue.emplace_back(position.orders_ahead, order_id);
+            level_quantity = position.level_quantity;
+        }
+    }
+    std::sort(queue.begin(), queue.end());
+    ASSERT_GT(queue.size(), 50);
+
+    auto trades = book.process_order(std::make_unique<Order>(2000, 101, "BTC-USD", Side::BUY, 100.0, level_quantity));
+    ASSERT_GE(trades.size(), queue.size());
+    for (size_t i = 0; i < queue.size(); ++i) {
+        EXPECT_EQ(trades[i].maker_order_id, queue[i].second);
+    }
+}
+
+// Drive a book with adds, crosses, cancels and icebergs over a band wider than
+// the index's first ladder, and check every answer against the book's levels
+template<typename Book>
+void check_index_against_levels(uint32_t seed) {
+    BookConfig config;
+    config.tick_size = 0.5;
+    config.queue_index = true;
+    Book book("BTC-USD", config);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> tick_dist(-150, 150);
+    std::uniform_int_distribution<uint64_t> quantity_dist(1, 100);
+    std::uniform_int_distribution<int> action_dist(0, 9);
+    std::uniform_int_distribution<int> side_dist(0, 1);
+
+    auto check = [&book](uint64_t last_id) {
+        for (Side side : {Side::BUY, Side::SELL}) {
+            std::vector<BookLevel> levels = side == Side::BUY ? book.get_bid_levels(1000) : book.get_ask_levels(1000);
+            std::map<double, std::vector<std::pair<QueuePosition, uint64_t>>> positions;
+            for (uint64_t id = 1; id <= last_id; ++id) {
+                const Order* order = book.get_order(id);
+                QueuePosition position;
+                if (order && order->is_active() && order->side == side) {
+                    ASSERT_TRUE(book.queue_position(id, position));
+                    positions[position.price].emplace_back(position, order->displayed_quantity());
+                }
+            }
+
+            uint64_t better = 0;
+            for (const BookLevel& level : levels) {
+                uint64_t depth = 0;
+                ASSERT_TRUE(book.depth_to_price(side, level.price, depth));
+                EXPECT_EQ(depth, better + level.quantity);
+
+                // Orders of a level line up 0..n-1 with quantities that add up
+                auto& queue = positions[level.price];
+                ASSERT_EQ(queue.size(), level.order_count);
+                std::sort(queue.begin(), queue.end(), [](const auto& a, const auto& b) {
+                    return a.first.orders_ahead < b.first.orders_ahead;
+                });
+                uint64_t ahead = 0;
+                for (size_t i = 0; i < queue.size(); ++i) {
+                    EXPECT_EQ(queue[i].first.orders_ahead, i);
+                    EXPECT_EQ(queue[i].first.quantity_ahead, ahead);
+                    EXPECT_EQ(queue[i].first.level_quantity, level.quantity);
+                    EXPECT_EQ(queue[i].first.better_quantity, better);
+                    ahead += queue[i].second;
+                }
+                better += level.quantity;
+            }
+
+            // A sweep of half the side against a walk of its levels
+            FillEstimate estimate;
+            ASSERT_TRUE(book.cost_to_fill(side, better / 2 + 1, estimate));
+            uint64_t wanted = better / 2 + 1;
+            double notional = 0.0;
+            double worst = 0.0;
+            for (const BookLevel& level : levels) {
+                uint64_t take = std::min(wanted, level.quantity);
+                notional += static_cast<double>(take) * level.price;
+                wanted -= take;
+                worst = level.price;
+                if (wanted == 0) {
+                    break;
+                }
+            }
+            EXPECT_EQ(estimate.filled_quantity, better / 2 + 1 - wanted);
+            EXPECT_NEAR(estimate.notional, notional, 1e-6 * notional);
+            EXPECT_EQ(estimate.worst_price, levels.empty() ? 0.0 : worst);
+        }
+    };
+
+    uint64_t id = 0;
+    for (int step = 1; step <= 4000; ++step) {
+        int action = action_dist(rng);
+        if (action < 3 && id > 0) {
+            std::uniform_int_distribution<uint64_t> id_dist(1, id);
+            book.cancel_order(id_dist(rng));
+        } else {
+            Side side = side_dist(rng) == 0 ? Side::BUY : Side::SELL;
+            double price = 50000.0 + tick_dist(rng) * 0.5 + (side == Side::BUY ? -10.0 : 10.0);
+            if (action >= 8) {
+                price += side == Side::BUY ? 40.0 : -40.0;
+            }
+            ++id;
+            auto order = std::make_unique<Order>(id, id % 7, "BTC-USD", side, price, quantity_dist(rng));
+            if (action == 7) {
+                order->display_quantity = 7;
+            }
+            book.process_order(std::move(order));
+        }
+        if (step % 500 == 0) {
+            check(id);
+        }
+    }
+}
+
+TEST(QueueIndexTest, AgreesWithLevelsForEveryPolicy) {
+    check_index_against_levels<HeapOrderBook>(7);
+    check_index_against_levels<MapOrderBook>(7);
+    check_index_against_levels<IntrusiveOrderBook>(7);
+    check_index_against_levels<LadderOrderBook>(7);
+}
@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+#include "core/RiskCheck.h"
+#include <random>
+#include <unordered_map>
+
+using namespace quasar;
+
+TEST(RiskTableTest, ChecksOrderLimits) {
+    RiskLimits limits;
+    limits.max_order_quantity = 1000;
+    limits.max_order_notional = 50000.0;
+    limits.price_collar = 0.05;
+
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::LIMIT, 100.0, 1001, 100.0), RiskReject::ORDER_QUANTITY);
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::LIMIT, 100.0, 501, 100.0), RiskReject::ORDER_NOTIONAL);
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::LIMIT, 105.5, 10, 100.0), RiskReject::PRICE_COLLAR);
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::LIMIT, 94.0, 10, 100.0), RiskReject::PRICE_COLLAR);
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::LIMIT, 104.5, 10, 100.0), RiskReject::NONE);
+
+    // Without a reference there is no collar; unpriced orders use the reference for notional
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::LIMIT, 500.0, 10, 0.0), RiskReject::NONE);
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::MARKET, 0.0, 600, 100.0), RiskReject::ORDER_NOTIONAL);
+    EXPECT_EQ(RiskTable::check_order(limits, OrderType::MARKET, 0.0, 600, 0.0), RiskReject::NONE);
+    EXPECT_EQ(RiskTable::check_order(RiskLimits{}, OrderType::LIMIT, 1e9, 1000000000000ULL, 1.0), RiskReject::NONE);
+}
+
+TEST(RiskTableTest, OpenOrderCountsSurviveChurn) {
+    RiskTable table;
+    RiskLimits capped;
+    capped.max_open_orders = 3;
+    table.set_client_limits(42, capped);
+
+    Order order(1, 42, "BTC-USD", Side::BUY, 100.0, 1);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(table.open(order, 0.0), RiskReject::NONE);
+    }
+    EXPECT_EQ(table.open(order, 0.0), RiskReject::OPEN_ORDERS);
+    EXPECT_EQ(table.check(order), RiskReject::OPEN_ORDERS);
+    table.close(42);
+    EXPECT_EQ(table.check(order), RiskReject::NONE);
+    EXPECT_EQ(table.open_orders(42), 2);
+    EXPECT_EQ(table.open(order, 0.0), RiskReject::NONE);
+
+    // Many clients opening and closing at random, against a plain map; idle
+    // clients give their slots back
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint64_t> client_dist(0, 2000);
+    std::unordered_map<uint64_t, uint32_t> expected;
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t client = client_dist(rng) * 1024;
+        if (client == 42) {
+            continue;
+        }
+        if (rng() % 2 == 0) {
+            Order entry(i, client, "BTC-USD", Side::BUY, 100.0, 1);
+            ASSERT_EQ(table.open(entry, 0.0), RiskReject::NONE);
+            expected[client]++;
+        } else if (expected[client] > 0) {
+            table.close(client);
+            expected[client]--;
+        }
+    }
+    size_t active = 1;
+    for (const auto& [client, count] : expected) {
+        EXPECT_EQ(table.open_orders(client), count);
+        active += count > 0 ? 1 : 0;
+    }
+    EXPECT_EQ(table.clients(), active);
+    EXPECT_EQ(table.open_orders(42), 3);
+}
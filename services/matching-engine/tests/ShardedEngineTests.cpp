@@ -0,0 +1,214 @@
+#include "gtest/gtest.h"
+#include "core/ShardedEngine.h"
+#include "BookLevels.h"
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+std::vector<std::string> make_symbols(size_t count) {
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < count; ++i) {
+        symbols.push_back("SYM-" + std::to_string(i));
+    }
+    return symbols;
+}
+
+// Feed the same random orders and cancels to the sharded engine and to one
+// reference engine, moving symbols between shards along the way, and check
+// that every symbol's book ends up the same
+void run_against_reference(ShardedEngine& sharded, int commands, int move_every) {
+    MatchingEngine reference;
+    std::mutex acks_mutex;
+    std::map<uint64_t, uint64_t> acks;  // token -> sharded order id
+    sharded.set_ack_callback([&](uint64_t token, uint64_t order_id) {
+        std::lock_guard<std::mutex> lock(acks_mutex);
+        acks[token] = order_id;
+    });
+
+    std::vector<std::string> symbols = make_symbols(16);
+    std::vector<std::tuple<std::string, uint64_t, uint64_t>> orders;  // symbol, token, reference id
+    std::mt19937 rng(3);
+    for (int i = 0; i < commands; ++i) {
+        const std::string& symbol = symbols[rng() % symbols.size()];
+        if (i % move_every == move_every - 1) {
+            sharded.move_symbol(symbol, static_cast<uint32_t>(rng() % sharded.shard_count()));
+        }
+        if (rng() % 4 == 0 && !orders.empty()) {
+            const auto& [cancel_symbol, token, reference_id] = orders[rng() % orders.size()];
+            uint64_t order_id = 0;
+            {
+                std::lock_guard<std::mutex> lock(acks_mutex);
+                auto it = acks.find(token);
+                order_id = it != acks.end() ? it->second : 0;
+            }
+            if (order_id != 0) {  // not applied yet: skip it on both sides
+                sharded.cancel_order(cancel_symbol, order_id);
+                reference.cancel_order(reference_id);
+            }
+            continue;
+        }
+        Side side = rng() % 2 == 0 ? Side::BUY : Side::SELL;
+        double price = 100.0 + static_cast<int>(rng() % 21 - 10) * 0.5;
+        uint64_t quantity = 1 + rng() % 30;
+        uint64_t token = sharded.submit_order(1 + i % 7, symbol, side, price, quantity);
+        orders.emplace_back(symbol, token, reference.submit_order(1 + i % 7, symbol, side, price, quantity));
+    }
+    sharded.flush();
+
+    uint64_t trades = 0;
+    uint64_t active = 0;
+    for (uint32_t shard = 0; shard < sharded.shard_count(); ++shard) {
+        trades += sharded.engine(shard).get_stats().total_trades;
+        active += sharded.engine(shard).get_stats().active_orders;
+    }
+    EXPECT_EQ(trades, reference.get_stats().total_trades);
+    EXPECT_EQ(active, reference.get_stats().active_orders);
+    for (const std::string& symbol : symbols) {
+        const MatchingEngine& owner = sharded.engine(sharded.shard_of(symbol));
+        EXPECT_EQ(levels(owner.get_bid_levels(symbol, 100)), levels(reference.get_bid_levels(symbol, 100))) << symbol;
+        EXPECT_EQ(levels(owner.get_ask_levels(symbol, 100)), levels(reference.get_ask_levels(symbol, 100))) << symbol;
+    }
+    EXPECT_GT(sharded.get_moves(), 0);
+}
+
+} // namespace
+
+TEST(ShardedEngineTest, QueuedCommandsFollowAMovedSymbol) {
+    ShardedEngine sharded;  // not started: flush() applies on this thread
+    uint32_t from = sharded.shard_of("BTC-USD");
+    uint32_t to = 1 - from;
+
+    std::vector<uint64_t> ids;
+    sharded.set_ack_callback([&ids](uint64_t, uint64_t order_id) { ids.push_back(order_id); });
+    sharded.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+    sharded.submit_order(1, "BTC-USD", Side::SELL, 100.0, 5);
+    EXPECT_FALSE(sharded.move_symbol("BTC-USD", from));
+    ASSERT_TRUE(sharded.move_symbol("BTC-USD", to));
+    EXPECT_FALSE(sharded.move_symbol("BTC-USD", from));  // still moving
+    EXPECT_EQ(sharded.shard_of("BTC-USD"), to);
+    sharded.submit_order(2, "BTC-USD", Side::BUY, 100.0, 12);
+
+    // Whichever shard drains first, the buy waits for the book and fills
+    sharded.flush();
+    ASSERT_EQ(ids.size(), 3);
+    EXPECT_EQ(order_id_shard(ids[0]), from);
+    EXPECT_EQ(sharded.engine(to).get_stats().total_trades, 2);
+    EXPECT_EQ(sharded.engine(from).get_stats().active_orders, 0);
+    std::vector<BookLevel> asks = sharded.engine(to).get_ask_levels("BTC-USD");
+    ASSERT_EQ(asks.size(), 1);
+    EXPECT_EQ(asks[0].quantity, 3);
+
+    // The order entered on the old shard cancels on the new one
+    sharded.cancel_order("BTC-USD", ids[1]);
+    sharded.flush();
+    EXPECT_TRUE(sharded.engine(to).get_ask_levels("BTC-USD").empty());
+    EXPECT_TRUE(sharded.move_symbol("BTC-USD", from));
+    sharded.flush();
+    EXPECT_EQ(sharded.shard_of("BTC-USD"), from);
+}
+
+TEST(ShardedEngineTest, InlineMovesMatchASingleEngine) {
+    ShardedEngineConfig config;
+    config.shards = 3;
+    ShardedEngine sharded(config);
+    run_against_reference(sharded, 6000, 50);
+}
+
+TEST(ShardedEngineTest, ThreadedMovesMatchASingleEngine) {
+    ShardedEngineConfig config;
+    config.shards = 4;
+    ShardedEngine sharded(config);
+    sharded.start();
+    run_against_reference(sharded, 20000, 100);
+    sharded.stop();
+}
+
+TEST(ShardedEngineTest, RebalanceMovesColdSymbolsOffTheHotShard) {
+    ShardedEngineConfig config;
+    config.shards = 2;
+    config.hot_utilization = 0.0;
+    config.min_imbalance = 0.0;
+    config.max_moves_per_pass = 8;
+    ShardedEngine sharded(config);
+
+    // Load only shard 0: one hot symbol and several cold ones
+    std::vector<std::string> cold;
+    std::string hot;
+    for (const std::string& symbol : make_symbols(64)) {
+        if (sharded.shard_of(symbol) != 0) {
+            continue;
+        }
+        if (hot.empty()) {
+            hot = symbol;
+        } else if (cold.size() < 6) {
+            cold.push_back(symbol);
+        }
+    }
+    ASSERT_EQ(cold.size(), 6);
+    for (int i = 0; i < 3000; ++i) {
+        sharded.submit_order(1, hot, i % 2 == 0 ? Side::BUY : Side::SELL, 100.0 + (i % 5), 1);
+        if (i % 10 == 0) {
+            sharded.submit_order(2, cold[(i / 10) % cold.size()], Side::BUY, 50.0, 1);
+        }
+    }
+    sharded.flush();
+
+    std::vector<ShardedEngine::ShardLoad> loads = sharded.get_loads();
+    ASSERT_EQ(loads.size(), 2);
+    EXPECT_GT(loads[0].busy_ns, 0);
+    EXPECT_EQ(loads[1].busy_ns, 0);
+    EXPECT_EQ(loads[0].commands, 3300);
+    EXPECT_EQ(loads[0].queue_depth, 0);
+    EXPECT_EQ(loads[0].symbols, 7);
+
+    size_t moved = sharded.rebalance();
+    EXPECT_GT(moved, 0);
+    EXPECT_EQ(sharded.shard_of(hot), 0);
+    sharded.flush();
+    size_t on_cold_shard = 0;
+    for (const std::string& symbol : cold) {
+        if (sharded.shard_of(symbol) == 1) {
+            on_cold_shard++;
+            EXPECT_EQ(sharded.engine(1).get_bid_levels(symbol).size(), 1) << symbol;
+        }
+    }
+    EXPECT_EQ(on_cold_shard, moved);
+
+    // No commands since the last pass, so nothing to move
+    EXPECT_EQ(sharded.rebalance(), 0);
+}
+
+TEST(ShardedEngineTest, IdleShardsWarmWithoutCountingBusy) {
+    ShardedEngineConfig config;
+    config.shards = 2;
+    config.warm_interval_us = 500;
+    ShardedEngine sharded(config);
+    sharded.start();
+    sharded.submit_order(1, "BTC-USD", Side::SELL, 100.0, 10);
+    sharded.flush();
+
+    uint32_t shard = sharded.shard_of("BTC-USD");
+    uint64_t busy = sharded.get_loads()[shard].busy_ns;
+    for (int i = 0; i < 200 && sharded.get_loads()[shard].warm_passes < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::vector<ShardedEngine::ShardLoad> loads = sharded.get_loads();
+    EXPECT_GE(loads[shard].warm_passes, 3);
+    EXPECT_EQ(loads[shard].busy_ns, busy);
+
+    // The book is untouched and the next order matches against it
+    sharded.submit_order(2, "BTC-USD", Side::BUY, 100.0, 4);
+    sharded.flush();
+    sharded.stop();
+    EXPECT_EQ(sharded.engine(shard).get_stats().total_trades, 1);
+    std::vector<BookLevel> asks = sharded.engine(shard).get_ask_levels("BTC-USD");
+    ASSERT_EQ(asks.size(), 1);
+    EXPECT_EQ(asks[0].quantity, 6);
+}
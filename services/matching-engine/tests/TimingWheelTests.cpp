@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "core/TimingWheel.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace quasar;
+
+namespace {
+
+// Advance in steps and record the tick every id fired on
+std::map<uint64_t, uint64_t> run_until(TimingWheel<uint64_t>& wheel, uint64_t target, uint64_t step) {
+    std::map<uint64_t, uint64_t> fired;
+    for (uint64_t tick = wheel.current_tick(); tick < target;) {
+        tick = std::min(target, tick + step);
+        wheel.advance(tick, [&fired](uint64_t now, const std::vector<uint64_t>& ids) {
+            for (uint64_t id : ids) {
+                fired[id] = now;
+            }
+        });
+    }
+    return fired;
+}
+
+} // namespace
+
+TEST(TimingWheelTest, FiresEachIdOnItsDeadlineAcrossLevels) {
+    TimingWheel<uint64_t> wheel(1000);
+    // Deadlines in level 0, cascading through levels 1 to 3, and in overflow
+    std::vector<uint64_t> deadlines = {1001, 1255, 1256, 1300, 66000, 70000, 16777300,
+                                       16777216 + 1000, 4294967296ULL + 5000};
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        wheel.schedule(i, deadlines[i]);
+    }
+    EXPECT_EQ(wheel.size(), deadlines.size());
+
+    auto fired = run_until(wheel, 4294967296ULL + 10000, 4294967296ULL);
+    ASSERT_EQ(fired.size(), deadlines.size());
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        EXPECT_EQ(fired[i], deadlines[i]) << "id " << i;
+    }
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimingWheelTest, SharedDeadlineFiresAsOneBatch) {
+    TimingWheel<uint64_t> wheel;
+    for (uint64_t id = 0; id < 1000; ++id) {
+        wheel.schedule(id, 500000);
+    }
+    wheel.schedule(1000, 10);
+
+    std::vector<size_t> batch_sizes;
+    wheel.advance(1000000, [&batch_sizes](uint64_t, const std::vector<uint64_t>& ids) {
+        batch_sizes.push_back(ids.size());
+    });
+    EXPECT_EQ(batch_sizes, (std::vector<size_t>{1, 1000}));
+}
+
+TEST(TimingWheelTest, MatchesReferenceForRandomSchedules) {
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<uint64_t> delay(1, 20000000);
+    std::uniform_int_distribution<uint64_t> step(1, 50000);
+
+    TimingWheel<uint64_t> wheel(12345);
+    std::map<uint64_t, uint64_t> expected;
+    std::map<uint64_t, uint64_t> fired;
+    uint64_t next_id = 0;
+    while (wheel.current_tick() < 30000000) {
+        for (int i = 0; i < 5; ++i) {
+            uint64_t deadline = wheel.current_tick() + delay(rng);
+            expected[next_id] = deadline;
+            wheel.schedule(next_id++, deadline);
+        }
+        wheel.advance(wheel.current_tick() + step(rng), [&fired](uint64_t now, const std::vector<uint64_t>& ids) {
+            for (uint64_t id : ids) {
+                fired[id] = now;
+            }
+        });
+    }
+    for (const auto& [id, deadline] : expected) {
+        if (deadline <= wheel.current_tick()) {
+            ASSERT_EQ(fired.count(id), 1u) << "id " << id;
+            EXPECT_EQ(fired[id], deadline) << "id " << id;
+        } else {
+            EXPECT_EQ(fired.count(id), 0u) << "id " << id;
+        }
+    }
+}
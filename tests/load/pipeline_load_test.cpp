@@ -11,7 +11,10 @@
 #include <sstream>
 #include <mutex>
 #include <queue>
+#include <functional>
 #include <unordered_map>
+#include <numeric>
+#include <cmath>
 
 // Mock network client for testing
 #include <sys/socket.h>
@@ -31,6 +34,31 @@ public:
         uint32_t warmup_orders = 1000;
         bool measure_latency = true;
         std::string output_file = "pipeline_load_test_results.csv";
+
+        // Soak mode: send for duration_seconds (ignoring total_orders) and
+        // write one time series row per sample interval
+        double duration_seconds = 0.0;
+        double sample_seconds = 60.0;
+        std::string timeseries_file = "pipeline_soak_timeseries.csv";
+        // Processes (gateway, consumer) whose RSS is sampled alongside our own
+        std::vector<int> watch_pids;
+        // Leading samples left out of drift detection
+        size_t warmup_samples = 2;
+
+        bool soak() const { return duration_seconds > 0.0; }
+    };
+
+    struct SoakSample {
+        double elapsed_seconds = 0.0;
+        uint64_t orders_sent = 0;
+        uint64_t errors = 0;
+        double actual_rate = 0.0;
+        double p50_latency_us = 0.0;
+        double p99_latency_us = 0.0;
+        double p999_latency_us = 0.0;
+        double max_latency_us = 0.0;
+        uint64_t client_rss_kb = 0;
+        std::vector<uint64_t> watched_rss_kb;
     };
 
     struct LatencyMeasurement {
@@ -73,6 +101,11 @@ private:
 
     std::mt19937 rng_;
 
+    // Soak mode keeps only the current interval's latencies
+    std::mutex window_mutex_;
+    std::vector<double> window_latencies_us_;
+    std::vector<SoakSample> soak_samples_;
+
 public:
     FullPipelineLoadTest(const LoadTestConfig& config)
         : config_(config)
@@ -82,7 +115,12 @@ public:
     LoadTestResults run_load_test() {
         std::cout << "=== Full Pipeline Load Test ===" << std::endl;
         std::cout << "Target: " << config_.gateway_host << ":" << config_.gateway_port << std::endl;
-        std::cout << "Orders: " << config_.total_orders << std::endl;
+        if (config_.soak()) {
+            std::cout << "Soak: " << config_.duration_seconds << " s, sample every "
+                      << config_.sample_seconds << " s" << std::endl;
+        } else {
+            std::cout << "Orders: " << config_.total_orders << std::endl;
+        }
         std::cout << "Clients: " << config_.concurrent_clients << std::endl;
         std::cout << "Rate: " << config_.target_rate << " orders/sec" << std::endl;
         std::cout << "================================" << std::endl;
@@ -113,9 +151,13 @@ public:
             });
         }
 
-        // Progress monitoring thread
+        // Progress monitoring thread (the soak sampler also ends the run)
         std::thread progress_thread([this]() {
-            monitor_progress();
+            if (config_.soak()) {
+                run_soak_sampler();
+            } else {
+                monitor_progress();
+            }
         });
 
         // Wait for all clients to finish
@@ -150,14 +192,14 @@ private:
             }
 
             // Send orders
-            for (uint32_t i = 0; i < orders_to_send && running_; ++i) {
+            for (uint32_t i = 0; (config_.soak() || i < orders_to_send) && running_; ++i) {
                 uint64_t order_id = (static_cast<uint64_t>(client_id) << 32) | i;
 
                 auto order_data = generate_order_message(order_id);
                 auto send_time = std::chrono::high_resolution_clock::now();
 
                 // Record latency measurement start
-                if (config_.measure_latency) {
+                if (config_.measure_latency && !config_.soak()) {
                     std::lock_guard<std::mutex> lock(latency_mutex_);
                     latency_measurements_[order_id] = {send_time, {}, order_id, false};
                 }
@@ -165,8 +207,10 @@ private:
                 if (send_order(sock, order_data)) {
                     orders_sent_.fetch_add(1);
 
-                    // Simulate immediate acknowledgment (in real test, this would come from gateway)
-                    if (config_.measure_latency) {
+                    if (config_.soak()) {
+                        record_window_latency(send_time);
+                    } else if (config_.measure_latency) {
+                        // Simulate immediate acknowledgment (in real test, this would come from gateway)
                         simulate_order_acknowledgment(order_id);
                     }
                 } else {
@@ -174,7 +218,7 @@ private:
                 }
 
                 // Rate limiting
-                if (i < orders_to_send - 1) {
+                if (config_.soak() || i < orders_to_send - 1) {
                     std::this_thread::sleep_for(inter_order_delay);
                 }
             }
@@ -187,6 +231,146 @@ private:
         }
     }
 
+    void record_window_latency(std::chrono::high_resolution_clock::time_point send_time) {
+        double latency_us = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::high_resolution_clock::now() - send_time).count() / 1000.0;
+        std::lock_guard<std::mutex> lock(window_mutex_);
+        window_latencies_us_.push_back(latency_us);
+    }
+
+    static uint64_t read_rss_kb(const std::string& pid) {
+        std::ifstream status("/proc/" + pid + "/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) {
+                return std::stoull(line.substr(6));
+            }
+        }
+        return 0;
+    }
+
+    static double percentile(const std::vector<double>& sorted, double pct) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t index = static_cast<size_t>(pct / 100.0 * sorted.size());
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    // Samples every interval until the soak duration has elapsed, then stops the clients
+    void run_soak_sampler() {
+        std::ofstream file(config_.timeseries_file);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open time series file: " << config_.timeseries_file << std::endl;
+        }
+        file << "elapsed_seconds,orders_sent,errors,actual_rate,p50_latency_us,p99_latency_us,"
+             << "p999_latency_us,max_latency_us,client_rss_kb";
+        for (int pid : config_.watch_pids) {
+            file << ",rss_kb_pid_" << pid;
+        }
+        file << "\n";
+
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(config_.duration_seconds));
+        auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(config_.sample_seconds));
+        auto interval_start = start;
+        uint64_t last_sent = 0;
+        uint64_t last_errors = 0;
+        std::vector<double> latencies;
+
+        while (running_) {
+            auto next = std::min(interval_start + interval, end);
+            while (running_ && std::chrono::steady_clock::now() < next) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            auto now = std::chrono::steady_clock::now();
+
+            latencies.clear();
+            {
+                std::lock_guard<std::mutex> lock(window_mutex_);
+                latencies.swap(window_latencies_us_);
+            }
+            std::sort(latencies.begin(), latencies.end());
+
+            SoakSample sample;
+            sample.elapsed_seconds = std::chrono::duration<double>(now - start).count();
+            uint64_t sent = orders_sent_.load();
+            uint64_t errors = connection_errors_.load() + send_errors_.load();
+            sample.orders_sent = sent - last_sent;
+            sample.errors = errors - last_errors;
+            last_sent = sent;
+            last_errors = errors;
+            double window_seconds = std::chrono::duration<double>(now - interval_start).count();
+            sample.actual_rate = window_seconds > 0 ? sample.orders_sent / window_seconds : 0.0;
+            sample.p50_latency_us = percentile(latencies, 50.0);
+            sample.p99_latency_us = percentile(latencies, 99.0);
+            sample.p999_latency_us = percentile(latencies, 99.9);
+            sample.max_latency_us = latencies.empty() ? 0.0 : latencies.back();
+            sample.client_rss_kb = read_rss_kb("self");
+            for (int pid : config_.watch_pids) {
+                sample.watched_rss_kb.push_back(read_rss_kb(std::to_string(pid)));
+            }
+            soak_samples_.push_back(sample);
+
+            file << std::fixed << std::setprecision(1) << sample.elapsed_seconds << ","
+                 << sample.orders_sent << ","
+                 << sample.errors << ","
+                 << std::fixed << std::setprecision(0) << sample.actual_rate << ","
+                 << std::fixed << std::setprecision(2) << sample.p50_latency_us << ","
+                 << sample.p99_latency_us << ","
+                 << sample.p999_latency_us << ","
+                 << sample.max_latency_us << ","
+                 << sample.client_rss_kb;
+            for (uint64_t rss : sample.watched_rss_kb) {
+                file << "," << rss;
+            }
+            file << std::endl;
+
+            std::cout << "t=" << std::fixed << std::setprecision(0) << sample.elapsed_seconds
+                      << "s rate=" << sample.actual_rate
+                      << std::setprecision(2) << " p99=" << sample.p99_latency_us
+                      << "us client_rss=" << sample.client_rss_kb << "kB" << std::endl;
+
+            interval_start = now;
+            if (now >= end) {
+                running_ = false;
+            }
+        }
+        std::cout << "Time series saved to: " << config_.timeseries_file << std::endl;
+    }
+
+    // Same criterion as the engine benchmark's soak: Kendall's tau against
+    // time >= 0.6 and a least-squares change over the run >= 10% of the mean
+    static bool is_drifting(const std::vector<double>& series, double& tau, double& change) {
+        size_t n = series.size();
+        tau = 0.0;
+        change = 0.0;
+        if (n < 4) {
+            return false;
+        }
+        int64_t concordant = 0;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                concordant += (series[j] > series[i]) - (series[j] < series[i]);
+            }
+        }
+        tau = static_cast<double>(concordant) / (n * (n - 1) / 2.0);
+
+        double sum_t = 0, sum_v = 0, sum_tt = 0, sum_tv = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum_t += i;
+            sum_v += series[i];
+            sum_tt += static_cast<double>(i) * i;
+            sum_tv += i * series[i];
+        }
+        double mean = sum_v / n;
+        double slope = (n * sum_tv - sum_t * sum_v) / (n * sum_tt - sum_t * sum_t);
+        change = mean != 0.0 ? slope * (n - 1) / mean : 0.0;
+        return tau >= 0.6 && change >= 0.10;
+    }
+
     int create_connection() {
         int sock = socket(AF_INET, SOCK_STREAM, 0);
         if (sock < 0) {
@@ -341,6 +525,43 @@ private:
     }
 
 public:
+    // Drift verdict per soak metric; true if any of them drifts
+    bool print_drift_report() {
+        std::cout << "\n=== SOAK DRIFT REPORT ===" << std::endl;
+        if (soak_samples_.size() < config_.warmup_samples + 4) {
+            std::cout << "Not enough samples after warm-up (" << soak_samples_.size() << ")" << std::endl;
+            return false;
+        }
+
+        std::vector<std::pair<std::string, std::function<double(const SoakSample&)>>> metrics = {
+            {"p50_latency_us", [](const SoakSample& s) { return s.p50_latency_us; }},
+            {"p99_latency_us", [](const SoakSample& s) { return s.p99_latency_us; }},
+            {"p999_latency_us", [](const SoakSample& s) { return s.p999_latency_us; }},
+            {"client_rss_kb", [](const SoakSample& s) { return static_cast<double>(s.client_rss_kb); }},
+        };
+        for (size_t p = 0; p < config_.watch_pids.size(); ++p) {
+            metrics.push_back({"rss_kb_pid_" + std::to_string(config_.watch_pids[p]),
+                               [p](const SoakSample& s) { return static_cast<double>(s.watched_rss_kb[p]); }});
+        }
+
+        bool any_drift = false;
+        for (const auto& [name, value] : metrics) {
+            std::vector<double> series;
+            for (size_t i = config_.warmup_samples; i < soak_samples_.size(); ++i) {
+                series.push_back(value(soak_samples_[i]));
+            }
+            double tau = 0.0;
+            double change = 0.0;
+            bool drifting = is_drifting(series, tau, change);
+            any_drift = any_drift || drifting;
+            std::cout << "  " << std::left << std::setw(22) << name << std::right
+                      << " tau=" << std::fixed << std::setprecision(2) << tau
+                      << " change=" << std::setprecision(1) << change * 100.0 << "%"
+                      << (drifting ? "  [DRIFT]" : "") << std::endl;
+        }
+        return any_drift;
+    }
+
     void print_results(const LoadTestResults& results) {
         std::cout << "\n=== FULL PIPELINE LOAD TEST RESULTS ===" << std::endl;
 
@@ -414,6 +635,10 @@ void print_usage(const char* program_name) {
     std::cout << "  --rate N              Target orders/sec (default: 1000)" << std::endl;
     std::cout << "  --output FILE         Output CSV file (default: pipeline_load_test_results.csv)" << std::endl;
     std::cout << "  --no-latency          Disable latency measurements" << std::endl;
+    std::cout << "  --duration S          Soak mode: send for S seconds instead of --orders" << std::endl;
+    std::cout << "  --sample-interval S   Soak sample interval in seconds (default: 60)" << std::endl;
+    std::cout << "  --timeseries FILE     Soak time series CSV (default: pipeline_soak_timeseries.csv)" << std::endl;
+    std::cout << "  --watch-pid PID       Also sample RSS of PID (repeatable, e.g. gateway and consumer)" << std::endl;
     std::cout << "  --help                Show this help" << std::endl;
 }
 
@@ -441,6 +666,14 @@ int main(int argc, char* argv[]) {
             config.output_file = argv[++i];
         } else if (arg == "--no-latency") {
             config.measure_latency = false;
+        } else if (arg == "--duration" && i + 1 < argc) {
+            config.duration_seconds = std::stod(argv[++i]);
+        } else if (arg == "--sample-interval" && i + 1 < argc) {
+            config.sample_seconds = std::stod(argv[++i]);
+        } else if (arg == "--timeseries" && i + 1 < argc) {
+            config.timeseries_file = argv[++i];
+        } else if (arg == "--watch-pid" && i + 1 < argc) {
+            config.watch_pids.push_back(std::stoi(argv[++i]));
         }
     }
 
@@ -457,6 +690,11 @@ int main(int argc, char* argv[]) {
         // Performance validation
         bool performance_ok = true;
 
+        if (config.soak() && test.print_drift_report()) {
+            std::cout << "WARNING: Monotonic drift detected during soak" << std::endl;
+            performance_ok = false;
+        }
+
         if (results.actual_rate < config.target_rate * 0.8) {
             std::cout << "WARNING: Actual rate significantly below target" << std::endl;
             performance_ok = false;